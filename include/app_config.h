@@ -19,7 +19,14 @@ static constexpr uint8_t CORE_CONTROL = 1;   // Real-time control + IO
 // ===== Control timing =====
 static constexpr uint32_t CONTROL_HZ       = 600;            // main loop @ 600 Hz
 static constexpr float    CONTROL_DT_S     = 1.0f / CONTROL_HZ;
+static constexpr uint32_t CONTROL_PERIOD_US= 1000000UL / CONTROL_HZ; // esp_timer tick period (1666 µs)
 static constexpr uint32_t SSE_HZ           = 60;             // stream at fixed 60 Hz
+static constexpr uint16_t SSE_REPLAY_N     = 600;            // frames kept for Last-Event-ID resume (10 s)
+static constexpr uint16_t SSE_REPLAY_BATCH = 40;             // frames per "replay" event
+static constexpr uint8_t  WEB_JSON_SLOTS   = 4;              // concurrent API requests with JSON state
+static constexpr uint16_t WEB_JSON_BUF     = 1536;           // reply buffer per slot
+static constexpr uint8_t  WS_CLIENTS       = 4;              // open /ws control connections kept
+static constexpr uint8_t  BATCH_RESULTS_N  = 4;              // applied /api/batch results kept for GET ?id=
 static constexpr uint32_t FLOW_MIN_WIN_MS  = 1000 / 60;      // 1/60 s lower clamp
 static constexpr uint32_t FLOW_MAX_WIN_MS  = 1000 / 6;       // 1/6  s upper clamp
 static constexpr float    FLOW_TARGET_EDGES= 10.0f * 2.0f;   // aim ~10 pulses → ~20 edges
@@ -57,12 +64,82 @@ static constexpr uint8_t ADC_BITS = 12;
 static constexpr uint8_t PRESS_SMOOTH_N = 10;
 
 // ===== Mode numbers =====
-enum : int { MODE_FWD=0, MODE_REV=1, MODE_BEAT=2 };
+enum : int { MODE_FWD=0, MODE_REV=1, MODE_BEAT=2, MODE_PRESS=3, MODE_FLOW=4 };
+// PRESS: FWD, PWM closed on vent mmHg. FLOW: PWM from the pump map + slow trim on L/min (sign = dir).
 
 // ===== Ramps & beat sequencing =====
+static constexpr int      BPM_MIN      = 1;
+static constexpr int      BPM_MAX      = 200;  // tachycardia; ramps/dead scale down above ~75 BPM
 static constexpr uint32_t RAMP_MS      = 150;  // set→0 and 0→set ramps
 static constexpr uint32_t DEAD_MS      = 100;  // dead time on flips
-// Beat half-period T/2 = 60000/(2*BPM) ms. Sequence: Ramp(150) → Dead(100) → Ramp(150) → Hold(remaining).
+static constexpr bool     RAMP_JERK_LIMITED = true; // S-curve ramps (false = linear)
+// Beat half-period T/2 = 60000/(2*BPM) ms: Dead/2 → Ramp(150) → Hold → Ramp(150) → Dead/2, valve flips
+// mid dead-time. Rendered into a per-beat lookup table by lib/beat (see beat.h).
+
+// ===== Closed-loop pressure (MODE_PRESS, beat peak tracking) =====
+// PWM = feed-forward(target) + PID(target − vent). The PWM setpoint acts as the output ceiling.
+static constexpr float PRESS_TARGET_DEFAULT = 80.0f;   // mmHg
+static constexpr float PRESS_TARGET_MAX     = 180.0f;
+static constexpr float PRESS_KP = 4.0f, PRESS_KI = 16.0f, PRESS_KD = 0.0f;   // per tick (PWM per mmHg, /s, ·s)
+static constexpr float PRESS_BEAT_KP = 0.6f, PRESS_BEAT_KI = 0.6f;          // per beat, on peak pressure
+static constexpr float PRESS_FF_GAIN = 1.25f, PRESS_FF_OFFSET = 40.0f;      // PWM ≈ gain·mmHg + offset
+// /api/press/tune bounds (gains below 0 clamp to 0; non-finite values are rejected). All fit
+// PidQ's Q16/Q24 constants: kd/dt ≤ 600·65536, beat ki·2^24 < 2^31.
+static constexpr float PRESS_KP_MAX = 100.0f, PRESS_KI_MAX = 2000.0f, PRESS_KD_MAX = 1.0f;
+static constexpr float PRESS_BEAT_KP_MAX = 50.0f, PRESS_BEAT_KI_MAX = 50.0f;
+static constexpr float PRESS_FF_GAIN_MAX = 10.0f, PRESS_FF_OFFSET_MAX = 255.0f;   // offset ± max
+
+// ===== Per-beat analytics =====
+static constexpr uint8_t HEMO_RING_N = 32;        // beats kept for /api/beats
+static constexpr float   TEMPLATE_MEMORY_BEATS = 16.0f;   // ensemble template forgetting (≈ 1/α per beat)
+
+// ===== Protection (raw ADC, every tick; see protect.h) =====
+static constexpr float    PROTECT_OVER_MMHG  = 200.0f;   // either chamber
+static constexpr float    PROTECT_UNDER_MMHG = -40.0f;   // suction / line off
+static constexpr float    PROTECT_HYST_MMHG  = 10.0f;
+static constexpr uint16_t PROTECT_DEBOUNCE_TICKS = 3;    // 5 ms at 600 Hz
+static constexpr uint8_t  PROTECT_DRIVE_PWM  = 90;       // well above the pump dead band
+static constexpr uint32_t PROTECT_NO_FLOW_MS = 1500;     // driving without a flow edge
+
+// ===== Flight recorder (raw "reclog" partition, see recorder.h / logfmt.h / partitions.csv) =====
+static constexpr const char* LOG_PART_NAME  = "reclog";
+static constexpr uint8_t  LOG_PART_SUBTYPE = 0x40;        // custom data subtype
+static constexpr uint32_t LOG_FILE_BYTES = 256u * 1024u;  // one slot: 64 blocks (~2 min at 600 Hz, 1.7-1.9 s a block)
+static constexpr uint8_t  LOG_FILES_MAX  = 5;             // slots (fit permitting); one kept erased
+static constexpr bool     LOG_AUTOSTART  = false;         // on demand: flash writes stall Core 1
+static constexpr uint32_t LOG_TASK_MS    = 20;            // writer drain period
+
+// ===== Serial telemetry (COBS frames on the console UART, see tlmfmt.h / tools/tlmrec.cpp) =====
+static constexpr uint32_t SERIAL_BAUD         = 921600;   // matches monitor_speed
+static constexpr uint16_t SERIAL_TX_BUFFER    = 2048;     // bytes; lets the writer never block
+static constexpr bool     TLM_SERIAL_AUTOSTART = false;   // stream from boot
+static constexpr uint32_t TLM_TASK_MS         = 10;       // writer period (~6 ticks per pass)
+
+// ===== Windowed statistics (/api/stats, see winstats.h) =====
+static constexpr uint8_t  STATS_WINDOWS = 3;
+static constexpr uint32_t STATS_WINDOW_MS[STATS_WINDOWS] = { 1000, 10000, 60000 };   // defaults; runtime settable
+static constexpr uint32_t STATS_WINDOW_MAX_MS = 600000;
+static constexpr uint32_t STATS_PUBLISH_MS = 100;
+
+// ===== Chart history (/api/history, see history.h) =====
+static constexpr uint16_t HIST_MAX_POINTS = 1000;      // per request
+
+// ===== Beat waveform learning (ILC, see ilc.h) =====
+static constexpr float   ILC_GAIN    = 0.3f;    // PWM counts per mmHg error, per beat
+static constexpr float   ILC_FORGET  = 0.002f;  // leak per beat
+static constexpr float   ILC_LEAD_MS = 40.0f;   // error look-ahead ≈ pump→pressure delay
+static constexpr int16_t ILC_LIMIT   = 96;      // |correction| PWM counts
+
+// ===== Pump characterization & flow setpoint (MODE_FLOW) =====
+static constexpr uint32_t SWEEP_SETTLE_MS  = 800;    // wait after each PWM step (≫ RAMP_MS)
+static constexpr uint32_t SWEEP_WINDOW_MS  = 500;    // flow must stay within tolerance this long
+static constexpr uint32_t SWEEP_TIMEOUT_MS = 5000;   // per point; recorded anyway and counted
+static constexpr float    SWEEP_TOL_LPM = 0.05f, SWEEP_TOL_PCT = 0.02f;
+static constexpr float    PUMP_DEFAULT_MAX_LPM = 6.0f;   // straight-line map until a sweep is stored
+static constexpr uint8_t  PUMP_DEFAULT_DEADBAND = 40;
+static constexpr float    FLOW_TARGET_MAX = 7.5f;        // |L/min|
+static constexpr float    FLOW_KI = 15.0f;               // PWM per (L/min·s) trim on top of the map
+static constexpr uint32_t FLOW_TRIM_HOLD_MS = 500;       // let the windowed estimate catch up after a ramp
 
 // ===== PWM range =====
 static constexpr uint8_t  PWM_MIN = 0;
@@ -85,5 +162,16 @@ static constexpr float UI_FLOW_MIN  = 0.0f,   UI_FLOW_MAX  = 7.5f;     // L/min
 static constexpr float UI_PWM_MIN   = 0.0f,   UI_PWM_MAX   = 256.0f;
 static constexpr float UI_VALVE_MIN = 0.0f,   UI_VALVE_MAX = 1.0f;
 
+// ===== RAM budget (ESP32: ~320 KB DRAM, of which WiFi AP + lwIP + AsyncTCP use ~60-80 KB of heap) =====
+// Fixed .bss, largest first (sizeof on the host, not a map file): winstats ≈ 13-17 KB, Capture 16 KB,
+// recorder ring 16 KB, SSE replay 14 KB, JSON slots 7 KB, spectral ring + snapshot 6 KB, telemetry
+// ring, ensemble template 3 KB, beat tables 2 KB, beat rings, sysmon snapshots 2 KB ≈ 90 KB of ours,
+// plus roughly 40 KB for the Arduino core, WiFi and lwIP.
+// Heap at boot: History ≈ 81 KB (control_start, before WiFi so it finds one contiguous block).
+// sysmon_ram_report() logs both against these limits once WiFi is up; /api/sys and /metrics
+// carry the same figures.
+static constexpr uint32_t RAM_STATIC_BUDGET = 144u * 1024u;   // .data + .bss of the whole image
+static constexpr uint32_t RAM_HEAP_FLOOR    = 40u * 1024u;    // free heap after WiFi and all tasks are up
+
 // ===== Build-time helpers =====
 static inline float hz_to_lpm(float hz){ return hz / FLOW_HZ_PER_LPM; }
@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+
+/* ==========================================================================================
+   beat.h — Table-driven beat waveform engine
+   ------------------------------------------------------------------------------------------
+   • One beat = one cycle of a 32-bit phase accumulator; each control tick adds a fixed
+     increment and looks the output up in a BEAT_TABLE_N-step table (level + valve).
+   • Tables are resampled only when the shape or BPM changes, into the inactive buffer, and
+     swapped in at the next valve flip (a zero-drive dead-time point) — never mid-stroke.
+   • Cycle layout: [dead/2 FWD][powered FWD][dead/2 FWD] | flip | [dead/2 REV][powered REV]
+     [dead/2 REV] | wrap. Levels are 0..255 normalized drive, scaled by the PWM setpoint.
+   • Ticks inside a dead window are zero drive whatever the table holds: at low BPM one table
+     step is longer than dead/2, and interpolating across it would drive into the flip.
+   • When a half is shorter than ramp+dead+ramp, ramps and dead time shrink proportionally
+     (hold → 0) instead of stretching the period, so BPM stays exact up to BPM_MAX.
+   • Pure logic (no Arduino/FreeRTOS) so it also builds in host tests.
+   ==========================================================================================*/
+
+static constexpr uint16_t BEAT_TABLE_BITS   = 9;
+static constexpr uint16_t BEAT_TABLE_N      = 1u << BEAT_TABLE_BITS;   // steps per beat
+static constexpr uint8_t  BEAT_SHAPE_MAX_PTS= 64;                      // uploaded points per half
+
+enum BeatShapeKind : uint8_t { BEAT_SHAPE_TRAPEZOID=0, BEAT_SHAPE_CUSTOM=1 };
+
+// Normalized shape description. TRAPEZOID reproduces the classic ramp/hold/ramp stroke with
+// ramps of rampMs; CUSTOM points (0..255) are stretched over each powered span.
+struct BeatShape {
+  uint8_t kind = BEAT_SHAPE_TRAPEZOID;
+  uint8_t splitPct = 50;                    // share of the cycle spent in FWD (10..90)
+  uint8_t nFwd = 0, nRev = 0;               // nRev=0 → REV half reuses the FWD points
+  uint8_t fwd[BEAT_SHAPE_MAX_PTS]{};
+  uint8_t rev[BEAT_SHAPE_MAX_PTS]{};
+};
+
+struct BeatStep { uint8_t level; uint8_t valve; };
+
+// Effective split of one beat (after scaling), for status reporting. Custom shapes report
+// their whole powered span as hold.
+struct BeatDuty { float periodMs, rampPct, holdPct, deadPct; };
+
+struct BeatTable {
+  BeatStep step[BEAT_TABLE_N];
+  uint32_t inc = 0;          // phase increment per tick (2^32 per beat)
+  uint32_t splitPhase = 0;   // phase of the FWD→REV flip
+  uint32_t fwdOn = 0, fwdOff = 0;   // powered phases: [fwdOn, fwdOff) FWD, [revOn, revOff) REV
+  uint32_t revOn = 0, revOff = 0;   // (revOff 0 = up to the wrap); dead/2 either side of each flip
+  BeatDuty duty{};
+};
+
+// Timing inputs for resampling (ticks at the control rate)
+struct BeatTiming { uint32_t bpm, hz, rampMs, deadMs; };
+
+uint32_t beat_phase_inc(uint32_t bpm, uint32_t hz);                         // 2^32·bpm/(60·hz)
+void     beat_build_table(const BeatShape& s, const BeatTiming& t, BeatTable& out);
+
+struct BeatOut { uint8_t level; uint8_t valve; bool flipped; };
+
+class BeatEngine {
+public:
+  // Resample into the inactive table; it goes live at the next flip (or restart()).
+  void    prepare(const BeatShape& s, const BeatTiming& t);
+  void    restart();                 // phase 0, adopting any pending table
+  BeatOut step();                    // advance one tick
+  uint32_t phase() const { return phase_; }
+  const BeatTable& active() const { return tab_[cur_]; }
+  bool    pending() const { return pending_; }
+
+private:
+  BeatTable tab_[2];
+  uint8_t  cur_ = 0;
+  bool     pending_ = false;
+  uint32_t phase_ = 0;
+  uint8_t  valve_ = 0;
+};
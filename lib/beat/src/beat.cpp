@@ -0,0 +1,105 @@
+#include "beat.h"
+
+static constexpr uint32_t IDX_SHIFT  = 32 - BEAT_TABLE_BITS;
+static constexpr uint32_t FRAC_SHIFT = IDX_SHIFT - 8;
+
+uint32_t beat_phase_inc(uint32_t bpm, uint32_t hz){
+  uint64_t den = 60ull * hz;
+  return (uint32_t)((((uint64_t)bpm << 32) + den/2) / den);
+}
+
+// Normalized drive (0..1) at time x within a powered span of length p (ms)
+static float trapezoid_at(float x, float p, float r){
+  if (r <= 0.0f) return 1.0f;
+  if (x < r) return x / r;
+  if (x > p - r) return (p - x) / r;
+  return 1.0f;
+}
+
+static float points_at(const uint8_t* pts, uint8_t n, float u){   // u in [0,1]
+  if (n == 0) return 0.0f;
+  if (n == 1) return pts[0] / 255.0f;
+  float f = u * (n - 1);
+  int i = (int)f; if (i >= n-1) return pts[n-1] / 255.0f;
+  float w = f - i;
+  return (pts[i]*(1.0f-w) + pts[i+1]*w) / 255.0f;
+}
+
+void beat_build_table(const BeatShape& s, const BeatTiming& t, BeatTable& out){
+  uint32_t bpm = t.bpm ? t.bpm : 1;
+  float T  = 60000.0f / bpm;                          // beat period (ms)
+  uint8_t sp = s.splitPct; if (sp < 10) sp = 10; if (sp > 90) sp = 90;
+  float Hf = T * sp / 100.0f, Hr = T - Hf;
+  // Per-half ramp/dead budget, scaled by H/(ramp+dead+ramp) once the half gets too short
+  float R[2], D[2], H[2] = { Hf, Hr };
+  float rampSum = 0, holdSum = 0, deadSum = 0;
+  for (int h=0; h<2; h++){
+    float used = 2.0f*t.rampMs + t.deadMs;
+    float k = (used > H[h]) ? H[h] / used : 1.0f;
+    R[h] = (s.kind == BEAT_SHAPE_TRAPEZOID) ? k * t.rampMs : 0.0f;
+    D[h] = k * t.deadMs;
+    rampSum += 2.0f*R[h]; deadSum += D[h];
+    float hold = H[h] - D[h] - 2.0f*R[h]; holdSum += (hold > 0) ? hold : 0;
+  }
+  out.duty = BeatDuty{ T, 100.0f*rampSum/T, 100.0f*holdSum/T, 100.0f*deadSum/T };
+  out.splitPhase = 0;
+  for (uint32_t i=0; i<BEAT_TABLE_N; i++){
+    float tm = T * i / BEAT_TABLE_N;
+    int h = (tm >= Hf) ? 1 : 0;
+    bool rev = (h == 1);
+    float u = rev ? (tm - Hf) : tm;
+    float p = H[h] - D[h], x = u - 0.5f*D[h];
+    float lv = 0.0f;
+    if (x >= 0.0f && x < p){
+      if (s.kind == BEAT_SHAPE_TRAPEZOID) lv = trapezoid_at(x, p, R[h]);
+      else if (rev && s.nRev) lv = points_at(s.rev, s.nRev, x / p);
+      else                    lv = points_at(s.fwd, s.nFwd, x / p);
+    }
+    int l = (int)(lv * 255.0f + 0.5f); if (l < 0) l = 0; if (l > 255) l = 255;
+    out.step[i].level = (uint8_t)l;
+    out.step[i].valve = rev ? 1 : 0;
+    if (rev && !out.splitPhase) out.splitPhase = i << IDX_SHIFT;
+  }
+  // Dead windows measured from the flips as the engine sees them (step boundaries)
+  auto ph = [&](float ms) -> uint32_t { double v = (double)ms / T * 4294967296.0; return v >= 4294967295.0 ? 0xFFFFFFFFu : (uint32_t)v; };
+  const uint32_t d0 = ph(0.5f*D[0]), d1 = ph(0.5f*D[1]);
+  out.fwdOn = d0; out.fwdOff = out.splitPhase - d0;
+  out.revOn = out.splitPhase + d1; out.revOff = 0u - d1;
+  out.inc = beat_phase_inc(bpm, t.hz);
+}
+
+static bool powered(const BeatTable& T, uint32_t ph){
+  if (ph < T.splitPhase) return ph >= T.fwdOn && ph < T.fwdOff;
+  return ph >= T.revOn && (T.revOff == 0 || ph < T.revOff);
+}
+
+void BeatEngine::prepare(const BeatShape& s, const BeatTiming& t){
+  beat_build_table(s, t, tab_[cur_ ^ 1]);
+  pending_ = true;
+}
+
+void BeatEngine::restart(){
+  if (pending_){ cur_ ^= 1; pending_ = false; }
+  phase_ = 0;
+  valve_ = tab_[cur_].step[0].valve;
+}
+
+BeatOut BeatEngine::step(){
+  BeatOut o;
+  uint32_t idx = phase_ >> IDX_SHIFT;
+  o.valve = tab_[cur_].step[idx].valve;
+  o.flipped = (o.valve != valve_);
+  if (o.flipped && pending_){
+    // Flip points sit mid dead-time (zero drive): adopt the new table at its matching flip.
+    cur_ ^= 1; pending_ = false;
+    phase_ = o.valve ? tab_[cur_].splitPhase : 0;
+    idx = phase_ >> IDX_SHIFT;
+  }
+  const BeatTable& T = tab_[cur_];
+  int a = T.step[idx].level, b = T.step[(idx + 1) & (BEAT_TABLE_N - 1)].level;
+  int frac = (phase_ >> FRAC_SHIFT) & 0xFF;
+  o.level = powered(T, phase_) ? (uint8_t)(a + (((b - a) * frac) >> 8)) : 0;
+  valve_ = o.valve;
+  phase_ += T.inc;
+  return o;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include "cfgblob.h"
+
+/* ==========================================================================================
+   calprof.h — Calibration profiles: tear-free publication and the named profile table
+   ------------------------------------------------------------------------------------------
+   • CalPool keeps CALP_POOL immutable profile slots and an atomic pointer to the live one.
+     publish() fills the least recently published slot and swaps the pointer, so every
+     reader sees one complete profile: never a new atr_m with an old atr_b.
+   • Each slot carries a sequence count (odd while being filled). read() copies the profile
+     and retries only if its slot was refilled during the copy, which takes CALP_POOL − 1
+     further publishes inside those few hundred nanoseconds. Readers never lock and never
+     wait for the writer; the writer never waits for readers.
+   • One writer task; any number of readers on either core.
+   • calp_*() edit the named table stored in Config (add/clone, find, remove).
+   • Pure logic (no Arduino/FreeRTOS) so it also builds in host tests.
+   ==========================================================================================*/
+
+static constexpr uint8_t CALP_POOL = 4;
+
+class CalPool {
+public:
+  void     publish(const CfgProfile& p);     // writer only
+  void     read(CfgProfile& out) const;      // any task
+  uint32_t version() const { return ver_.load(std::memory_order_acquire); }   // publishes so far
+
+private:
+  struct Slot { std::atomic<uint32_t> seq{0}; CfgProfile p{}; };
+  Slot slots_[CALP_POOL];
+  std::atomic<const Slot*> cur_{&slots_[0]};
+  uint8_t next_ = 1;
+  std::atomic<uint32_t> ver_{0};
+};
+
+// Profile names: 1..CFG_NAME_LEN−1 characters of [A-Za-z0-9 _.-]
+bool   calp_valid_name(const char* name);
+int8_t calp_find(const Config& c, const char* name);                       // index or −1
+// Append a profile; index, or −1 if the name is invalid or taken, −2 if the table is full
+int8_t calp_add(Config& c, const char* name, const CfgCal& atr, const CfgCal& vent, const CfgCal& flow);
+bool   calp_remove(Config& c, uint8_t idx);                                // refuses the active one
@@ -0,0 +1,61 @@
+#include "calprof.h"
+#include <string.h>
+
+void CalPool::publish(const CfgProfile& p){
+  Slot& s = slots_[next_];                           // never the live slot: next_ trails it
+  next_ = (uint8_t)((next_ + 1) % CALP_POOL);
+  const uint32_t q = s.seq.load(std::memory_order_relaxed);
+  s.seq.store(q + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  s.p = p;
+  s.seq.store(q + 2, std::memory_order_release);
+  cur_.store(&s, std::memory_order_release);
+  ver_.fetch_add(1, std::memory_order_release);
+}
+
+void CalPool::read(CfgProfile& out) const {
+  for (;;){
+    const Slot* s = cur_.load(std::memory_order_acquire);
+    const uint32_t q = s->seq.load(std::memory_order_acquire);
+    if (q & 1) continue;                             // refilled under us: take the new pointer
+    out = s->p;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (s->seq.load(std::memory_order_relaxed) == q) return;
+  }
+}
+
+bool calp_valid_name(const char* n){
+  const size_t len = strlen(n);
+  if (!len || len >= CFG_NAME_LEN) return false;
+  for (size_t i = 0; i < len; i++){
+    const char ch = n[i];
+    if (!((ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') ||
+          ch == ' ' || ch == '_' || ch == '.' || ch == '-')) return false;
+  }
+  return true;
+}
+
+int8_t calp_find(const Config& c, const char* name){
+  for (uint8_t i = 0; i < c.nProfiles && i < CFG_PROFILES; i++)
+    if (strncmp(c.profiles[i].name, name, CFG_NAME_LEN) == 0) return (int8_t)i;
+  return -1;
+}
+
+int8_t calp_add(Config& c, const char* name, const CfgCal& atr, const CfgCal& vent, const CfgCal& flow){
+  if (!calp_valid_name(name) || calp_find(c, name) >= 0) return -1;
+  if (c.nProfiles >= CFG_PROFILES) return -2;
+  CfgProfile& p = c.profiles[c.nProfiles];
+  memset(&p, 0, sizeof(p));                          // zero the name tail: blobs compare bytewise
+  strncpy(p.name, name, CFG_NAME_LEN - 1);
+  p.atr = atr; p.vent = vent; p.flow = flow;
+  return (int8_t)c.nProfiles++;
+}
+
+bool calp_remove(Config& c, uint8_t idx){
+  if (idx >= c.nProfiles || idx == c.activeProfile) return false;
+  for (uint8_t i = idx; i + 1 < c.nProfiles; i++) c.profiles[i] = c.profiles[i + 1];
+  c.nProfiles--;
+  memset(&c.profiles[c.nProfiles], 0, sizeof(CfgProfile));
+  if (c.activeProfile > idx) c.activeProfile--;
+  return true;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+/* ==========================================================================================
+   capture.h — Oscilloscope-style triggered capture at full control rate
+   ------------------------------------------------------------------------------------------
+   • A fixed ring of CAP_N samples fills continuously while armed. A trigger is accepted once
+     `pre` samples of history exist; the engine then records CAP_N − pre more and freezes,
+     so the capture is always CAP_N samples with the trigger at index `pre`.
+   • Triggers: valve edge, atrial/ventricular level crossing with slope (re-armed only after
+     the signal has been back beyond the level by `hyst`, so noise cannot chatter), mode
+     change, or a new fault bit. force() triggers by hand.
+   • Single mode stays frozen until armed again; auto mode re-arms once the capture has been
+     read, or after holdTicks if nobody reads it.
+   • tick()/arm()/stop() run on the producer (control core); beginRead()/endRead() on the
+     reader. The state word is the only shared field: the reader may only look at samples
+     and info() while it holds CAP_READING, which the producer never leaves or overwrites.
+     config() belongs to the producer.
+   • Pure logic (no Arduino/FreeRTOS) so it also builds in host tests.
+   ==========================================================================================*/
+
+static constexpr uint16_t CAP_N = 2048;          // ≈ 3.4 s at 600 Hz, 16 KB
+
+enum CapSource : uint8_t { CAP_SRC_VALVE, CAP_SRC_VENT, CAP_SRC_ATR, CAP_SRC_MODE, CAP_SRC_FAULT };
+enum CapSlope  : uint8_t { CAP_RISING, CAP_FALLING, CAP_EITHER };
+enum CapState  : uint8_t { CAP_IDLE, CAP_ARMED, CAP_POST, CAP_FROZEN, CAP_READING, CAP_READ };
+
+struct CapConfig {
+  CapSource src = CAP_SRC_VALVE;
+  CapSlope  slope = CAP_EITHER;
+  float     level = 0, hyst = 2.0f;     // mmHg, level sources only
+  uint16_t  pre = CAP_N / 4;            // samples before the trigger
+  bool      autoRearm = false;
+  uint32_t  holdTicks = 600;            // auto: re-arm an unread capture after this long
+};
+
+// mmHg×10, mmHg×10, L/min×100, PWM, valve | paused<<1 | mode<<3 (as log_state)
+struct CapSample { int16_t atr, vent, flow; uint8_t pwm, state; };
+
+// Trigger settings are copied at the trigger, so a held capture carries its own
+struct CapInfo { uint32_t seq, triggerTick; uint16_t pre; CapSource src; CapSlope slope; float level; };
+
+class Capture {
+public:
+  // ---- producer ----
+  void configure(const CapConfig& c);   // stops; arm() to start
+  void arm();                           // deferred while a read is in progress
+  void stop();
+  void force();                         // trigger now if armed with enough history
+  void tick(const CapSample& s, uint8_t fault, uint32_t tick);
+
+  // ---- reader ----
+  bool beginRead();                     // true if a frozen capture is now held for reading
+  void endRead(bool complete);          // complete: auto mode may re-arm
+  const CapSample& at(uint16_t i) const { return buf_[(start_ + i) % CAP_N]; }   // 0 = oldest
+  const CapInfo& info() const { return info_; }
+
+  CapState state() const { return (CapState)state_.load(); }
+  const CapConfig& config() const { return cfg_; }
+
+private:
+  bool triggered(const CapSample& s, uint8_t fault);
+  bool crossing(float prev, float cur);
+  void doArm();
+
+  CapSample buf_[CAP_N];
+  CapConfig cfg_;
+  CapInfo   info_{0, 0, 0, CAP_SRC_VALVE, CAP_EITHER, 0};
+  std::atomic<uint8_t> state_{CAP_IDLE};
+  uint16_t  head_ = 0, fill_ = 0, post_ = 0, start_ = 0;
+  uint32_t  frozenTicks_ = 0, tick_ = 0;
+  CapSample prev_{0, 0, 0, 0, 0};
+  uint8_t   prevFault_ = 0;
+  bool      havePrev_ = false, ready_ = false, pendingArm_ = false, forced_ = false;
+};
@@ -0,0 +1,101 @@
+#include "capture.h"
+
+void Capture::configure(const CapConfig& c){
+  cfg_ = c;
+  if (cfg_.pre >= CAP_N) cfg_.pre = CAP_N - 1;
+  if (cfg_.hyst < 0) cfg_.hyst = 0;
+  stop();
+}
+
+void Capture::stop(){
+  pendingArm_ = false;
+  uint8_t s = state_.load();
+  while (s != CAP_READING && s != CAP_IDLE && !state_.compare_exchange_weak(s, CAP_IDLE)) {}
+}
+
+void Capture::arm(){
+  uint8_t s = state_.load();
+  if (s == CAP_READING || !state_.compare_exchange_strong(s, CAP_ARMED)){ pendingArm_ = true; return; }
+  doArm();
+}
+
+// Fresh history; only called once the state is ARMED (the reader is locked out)
+void Capture::doArm(){
+  pendingArm_ = false; forced_ = false;
+  head_ = 0; fill_ = 0; post_ = 0; havePrev_ = false; ready_ = false;
+}
+
+void Capture::force(){ forced_ = true; }
+
+bool Capture::crossing(float prev, float cur){
+  // level crossings need the signal to have been `hyst` on the far side first (ready_)
+  bool up = cur >= cfg_.level, wasUp = prev >= cfg_.level;
+  if (!ready_){
+    bool below = cur <= cfg_.level - cfg_.hyst, above = cur >= cfg_.level + cfg_.hyst;
+    if ((cfg_.slope != CAP_FALLING && below) || (cfg_.slope != CAP_RISING && above)) ready_ = true;
+    return false;
+  }
+  if (up == wasUp) return false;
+  bool hit = (up && cfg_.slope != CAP_FALLING) || (!up && cfg_.slope != CAP_RISING);
+  if (!hit) return false;
+  ready_ = false;
+  return true;
+}
+
+bool Capture::triggered(const CapSample& s, uint8_t fault){
+  if (forced_){ forced_ = false; return true; }
+  if (!havePrev_) return false;
+  switch (cfg_.src){
+    case CAP_SRC_VALVE: {
+      uint8_t a = prev_.state & 1, b = s.state & 1;
+      if (a == b) return false;
+      return cfg_.slope == CAP_EITHER || (cfg_.slope == CAP_RISING) == (b == 1);   // rising = FWD→REV
+    }
+    case CAP_SRC_VENT: return crossing(prev_.vent * 0.1f, s.vent * 0.1f);
+    case CAP_SRC_ATR:  return crossing(prev_.atr * 0.1f, s.atr * 0.1f);
+    case CAP_SRC_MODE: return (prev_.state >> 3) != (s.state >> 3);
+    case CAP_SRC_FAULT: return (fault & ~prevFault_) != 0;
+  }
+  return false;
+}
+
+void Capture::tick(const CapSample& s, uint8_t fault, uint32_t tick){
+  uint8_t st = state_.load();
+  if (pendingArm_ && st != CAP_READING){ arm(); st = state_.load(); }
+  if (st == CAP_ARMED || st == CAP_POST){
+    buf_[head_] = s; head_ = (head_ + 1) % CAP_N;
+    if (fill_ < CAP_N) fill_++;
+    if (st == CAP_ARMED){
+      bool t = triggered(s, fault);
+      if (t && fill_ > cfg_.pre){
+        info_.triggerTick = tick; info_.pre = cfg_.pre;
+        info_.src = cfg_.src; info_.slope = cfg_.slope; info_.level = cfg_.level;
+        post_ = CAP_N - cfg_.pre - 1;                        // the trigger sample is stored
+        state_.store(CAP_POST); st = CAP_POST;
+      }
+    } else if (post_) {
+      post_--;
+    }
+    if (st == CAP_POST && !post_){
+      start_ = head_;                                        // ring is full: oldest is next
+      info_.seq++; frozenTicks_ = 0;
+      state_.store(CAP_FROZEN);
+    }
+  } else if (cfg_.autoRearm && (st == CAP_READ || (st == CAP_FROZEN && ++frozenTicks_ >= cfg_.holdTicks))){
+    arm();
+  }
+  prev_ = s; prevFault_ = fault; havePrev_ = true; tick_ = tick;
+}
+
+bool Capture::beginRead(){
+  uint8_t s = state_.load();
+  while (s == CAP_FROZEN || s == CAP_READ){
+    if (state_.compare_exchange_weak(s, CAP_READING)) return true;
+  }
+  return false;
+}
+
+void Capture::endRead(bool complete){
+  uint8_t s = CAP_READING;
+  state_.compare_exchange_strong(s, complete ? CAP_READ : CAP_FROZEN);
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/* ==========================================================================================
+   cfgblob.h — Persistent configuration as one versioned, CRC-checked blob
+   ------------------------------------------------------------------------------------------
+   • Blob = header + payload (little endian):
+       magic u32 "SCFG" | schema u16 | payload bytes u16 | generation u32 | crc32 u32
+     crc32 covers the header (crc field zero) and the payload. The payload is the Config
+     struct as laid out by the firmware.
+   • Config is append-only: each new setting goes at the end with CFG_SCHEMA bumped, and the
+     caller fills in defaults before decoding. A shorter payload from an older schema fills the prefix it
+     has and keeps the defaults for the rest, and a longer one from a newer firmware (after
+     a downgrade) contributes the prefix this firmware knows. Changes that are not plain
+     additions get a case in cfg_decode().
+   • Two slots, written alternately with an increasing generation; the valid slot with the
+     highest generation wins, so a torn write can only lose the newest save.
+   • Pure logic (no Arduino/FreeRTOS) so it also builds in host tests.
+   ==========================================================================================*/
+
+static constexpr uint32_t CFG_MAGIC     = 0x47464353u;   // "SCFG"
+static constexpr uint16_t CFG_SCHEMA    = 2;
+static constexpr uint8_t  CFG_HDR_BYTES = 16;
+static constexpr uint8_t  CFG_PROFILES  = 6;
+static constexpr uint8_t  CFG_NAME_LEN  = 16;      // including the terminator
+
+struct CfgCal { float m, b; };
+
+// Named calibration set (the live one is published through CalPool, see calprof.h)
+struct CfgProfile {
+  char   name[CFG_NAME_LEN];
+  CfgCal atr, vent, flow;            // mmHg = m·raw + b, L/min = m·Hz + b
+};
+
+// Laid out without padding so equal content compares equal byte for byte
+struct Config {
+  // schema 1
+  CfgCal     atr, vent, flow;        // live calibration
+  // schema 2
+  uint8_t    nProfiles, activeProfile;
+  uint16_t   reserved;
+  CfgProfile profiles[CFG_PROFILES];
+};
+
+static_assert(sizeof(Config) == 3 * sizeof(CfgCal) + 4 + CFG_PROFILES * sizeof(CfgProfile), "Config has padding");
+static constexpr size_t CFG_BLOB_BYTES = CFG_HDR_BYTES + sizeof(Config);
+
+struct CfgInfo { uint16_t schema = 0; uint32_t gen = 0; };
+
+// Config → blob (CFG_BLOB_BYTES)
+size_t cfg_encode(const Config& c, uint32_t gen, uint8_t* out);
+// blob → c, which must hold the defaults on entry; false (c untouched) on bad magic, size or CRC
+bool   cfg_decode(const uint8_t* blob, size_t len, Config& c, CfgInfo& info);
+// Slot to load from (0/1), or -1 if neither is valid; valid[i] from cfg_decode
+int8_t cfg_pick(const bool valid[2], const uint32_t gen[2]);
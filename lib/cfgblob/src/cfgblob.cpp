@@ -0,0 +1,38 @@
+#include "cfgblob.h"
+#include <string.h>
+#include "crc.h"
+
+static void le16(uint8_t* p, uint16_t v){ p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void le32(uint8_t* p, uint32_t v){ for (uint8_t i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8*i)); }
+static uint16_t rd16(const uint8_t* p){ return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t rd32(const uint8_t* p){ return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+static uint32_t blob_crc(const uint8_t* b, size_t len){
+  static const uint8_t zero[4] = { 0, 0, 0, 0 };
+  uint32_t c = crc32_update(0, b, 12);
+  c = crc32_update(c, zero, 4);
+  return crc32_update(c, b + CFG_HDR_BYTES, len - CFG_HDR_BYTES);
+}
+
+size_t cfg_encode(const Config& c, uint32_t gen, uint8_t* out){
+  le32(out, CFG_MAGIC); le16(out + 4, CFG_SCHEMA); le16(out + 6, (uint16_t)sizeof(Config));
+  le32(out + 8, gen); le32(out + 12, 0);
+  memcpy(out + CFG_HDR_BYTES, &c, sizeof(Config));
+  le32(out + 12, blob_crc(out, CFG_BLOB_BYTES));
+  return CFG_BLOB_BYTES;
+}
+
+bool cfg_decode(const uint8_t* b, size_t len, Config& c, CfgInfo& info){
+  if (len < CFG_HDR_BYTES || rd32(b) != CFG_MAGIC) return false;
+  const uint16_t schema = rd16(b + 4), size = rd16(b + 6);
+  if (schema == 0 || len != (size_t)CFG_HDR_BYTES + size || rd32(b + 12) != blob_crc(b, len)) return false;
+  // Migration: every schema so far only appended fields, so the common prefix carries over
+  memcpy(&c, b + CFG_HDR_BYTES, size < sizeof(Config) ? size : sizeof(Config));
+  info.schema = schema; info.gen = rd32(b + 8);
+  return true;
+}
+
+int8_t cfg_pick(const bool valid[2], const uint32_t gen[2]){
+  if (valid[0] && valid[1]) return (int32_t)(gen[1] - gen[0]) > 0 ? 1 : 0;   // wrap-safe
+  return valid[0] ? 0 : (valid[1] ? 1 : -1);
+}
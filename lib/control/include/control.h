@@ -1,7 +1,110 @@
 #pragma once
 #include <Arduino.h>
+#include <atomic>
+#include "app_config.h"
+#include "beat.h"
+#include "protocol.h"
+#include "pid.h"
+#include "pumpmap.h"
+#include "ilc.h"
+#include "hemo.h"
+#include "ensemble.h"
+#include "winstats.h"
+#include "protect.h"
+#include "capture.h"
+#include "history.h"
+#include "runbatch.h"
 
 /* ==========================================================================================
    control.h — Real-time 600 Hz control loop on Core 1
    ==========================================================================================*/
 void control_start();
+
+// Hand a new beat shape to Core 1 (copied; resampled there and swapped in at the next valve
+// flip). Returns false while a previous upload is still pending or the queue is full.
+bool control_post_shape(const BeatShape& s);
+
+// Hand a parsed protocol to Core 1 (replaces any loaded one, aborting it if running).
+// Start/stop with CMD_PROTO_START / CMD_PROTO_STOP.
+bool control_post_protocol(const Protocol& p);
+
+// Compound run-state change (see runbatch.h), applied whole in one tick before that tick's
+// outputs. Returns the batch id, 0 while a previous batch is still pending or the queue is
+// full. control_batch_result() looks the id up without waiting: the last BATCH_RESULTS_N
+// applied batches are kept.
+struct BatchResult { uint32_t id, tick; uint8_t actions; RunState state; };
+enum BatchStatus : uint8_t { BATCH_PENDING, BATCH_APPLIED, BATCH_UNKNOWN };   // UNKNOWN: never issued, or aged out
+BatchLimits control_batch_limits();
+uint32_t control_post_batch(const RunBatch& b);
+BatchStatus control_batch_result(uint32_t id, BatchResult& out);
+
+// Pressure loop tuning (MODE_PRESS per tick, beat mode per beat); applied on Core 1 with the
+// integrators kept, so retuning while running does not bump the output.
+struct PressTuning {
+  PidGains tick{ PRESS_KP, PRESS_KI, PRESS_KD };
+  PidGains beat{ PRESS_BEAT_KP, PRESS_BEAT_KI, 0.0f };
+  float    ffGain = PRESS_FF_GAIN, ffOffset = PRESS_FF_OFFSET;
+};
+bool control_post_press_tuning(const PressTuning& t);
+
+// Beat pressure target for the ILC, one value per phase bin (see ilc_resample)
+struct IlcTarget { float mmHg[ILC_BINS]; };
+bool control_post_ilc_target(const IlcTarget& t);
+// Target and learned correction per bin, copied as Core 1 last published them (beat update,
+// new target or reset), so both arrays come from the same beat
+void control_ilc_bins(float* target, float* corr);
+
+// Per-beat analytics (BEAT mode, closed at each beat wrap). Copies beats with seq > after,
+// oldest first; returns how many were copied.
+uint8_t control_beats(uint32_t after, BeatStats* out, uint8_t max);
+
+// Ensemble-averaged atrium/ventricle/flow templates (bin 0 = FWD→REV flip). Updated every
+// beat-mode tick on Core 1 and published once per beat; this copies the last published set.
+void control_template(EnsembleAvg& out);
+
+// Protection limits (mmHg / ticks); applied on Core 1 without clearing a latched fault.
+// Defaults come from PROTECT_* in app_config.h.
+ProtectCfg control_protect_defaults();
+bool control_post_protect(const ProtectCfg& c);
+struct ProtectInfo { ProtectCfg cfg; uint8_t fault; uint32_t trips, latencyTicks; int32_t tripRaw[PROT_CH]; };
+void control_protect_info(ProtectInfo& out);
+
+// Triggered capture of unsmoothed atr/vent, flow, PWM and state at full rate. Core 1 feeds
+// it every tick; readers hold it with beginRead()/endRead() (see capture.h). Arm/stop/force
+// with CMD_CAPTURE; a new configuration stops the capture (arm again to start).
+Capture& control_capture();
+bool control_post_capture(const CapConfig& c);
+// Configuration and last frozen capture's info, published by Core 1 when either changes
+struct CaptureInfo { CapConfig cfg; CapInfo info; };
+void control_capture_info(CaptureInfo& out);
+
+// Sliding-window min/max/mean/SD of every control-rate sample, per channel and window;
+// published by Core 1 every STATS_PUBLISH_MS. Resize a window with CMD_STATS_WINDOW.
+enum StatsChannel : uint8_t { STATS_ATR, STATS_VENT, STATS_FLOW, STATS_PWM, STATS_CH };
+struct StatsSnapshot {
+  uint32_t  seq = 0;
+  uint32_t  windowMs[STATS_WINDOWS]{};
+  WinResult r[STATS_WINDOWS][STATS_CH];
+};
+void control_stats(StatsSnapshot& out);
+
+// Min/max history tiers of the same channels (StatsChannel order), pushed every tick as
+// value × HIST_SCALE; readers call query() directly (see history.h). Heap-allocated in
+// control_start(); nullptr if that failed.
+static_assert(HIST_CH == STATS_CH, "history keeps the stats channels");
+static constexpr float HIST_SCALE[HIST_CH] = { 10.0f, 10.0f, 100.0f, 1.0f };
+const History* control_history();
+
+// Copy of the PWM→flow map in use (stored in NVS after a sweep; default estimate otherwise)
+void control_pump_map(PumpMap& out);
+// Core 0, periodically: write a newly swept map to NVS once the pump is paused at PWM 0
+void control_pump_map_persist();
+
+// ---- Counters (Core 1 writes, relaxed; read by /metrics on Core 0) ----
+struct ControlCounters {
+  std::atomic<uint32_t> ticks{0};          // control iterations since boot
+  std::atomic<uint32_t> overruns{0};       // timer ticks missed because an iteration ran long
+  std::atomic<uint32_t> overrideGates{0};  // override gate inactive→active transitions seen by the loop
+  std::atomic<uint32_t> protectTrips{0};   // protection faults latched
+};
+extern ControlCounters control_ctr;
@@ -1,10 +1,188 @@
+#include <esp_timer.h>
+#include <new>
+#include <Preferences.h>
 #include "control.h"
 #include "shared.h"
 #include "buttons.h"
 #include "io.h"
+#include "flow.h"
 #include "app_config.h"
+#include "motion.h"
+#include "beat.h"
+#include "pid.h"
+#include "pumpmap.h"
+#include "ilc.h"
+#include "hemo.h"
+#include "ensemble.h"
+#include "spectral.h"
+#include "recorder.h"
+#include "telemetry.h"
 
-static uint8_t clamp8(int v){ if(v<0) v=0; if(v>255) v=255; return (uint8_t)v; }
+ControlCounters control_ctr;
+
+static TaskHandle_t s_task = nullptr;
+
+// Large payloads from Core 0 (consumed on CMD_SET_SHAPE / CMD_PROTO_LOAD)
+static Mailbox<BeatShape> s_shapeMail;
+static Mailbox<Protocol>  s_protoMail;
+static Mailbox<PressTuning> s_pressMail;
+static Mailbox<IlcTarget>   s_ilcMail;
+static Mailbox<ProtectCfg>  s_protMail;
+static Mailbox<CapConfig>   s_capMail;
+static Mailbox<RunBatch>    s_batchMail;
+static IlcTable s_ilc;          // Core 1 only; /api/ilc reads the published copy below
+
+template <typename T>
+static bool post_mail(Mailbox<T>& mb, const T& v, CmdType t){
+  if (!mb.put(v)) return false;                  // previous upload not consumed yet
+  if (!shared_post(Cmd{t, 0})){ mb.drop(); return false; }
+  return true;
+}
+bool control_post_shape(const BeatShape& s){   return post_mail(s_shapeMail, s, CMD_SET_SHAPE); }
+bool control_post_protocol(const Protocol& p){ return post_mail(s_protoMail, p, CMD_PROTO_LOAD); }
+bool control_post_press_tuning(const PressTuning& t){ return post_mail(s_pressMail, t, CMD_PRESS_TUNE); }
+bool control_post_ilc_target(const IlcTarget& t){ return post_mail(s_ilcMail, t, CMD_ILC_TARGET); }
+bool control_post_protect(const ProtectCfg& c){ return post_mail(s_protMail, c, CMD_PROTECT_CFG); }
+bool control_post_capture(const CapConfig& c){ return post_mail(s_capMail, c, CMD_CAPTURE_CFG); }
+
+static_assert(BATCH_MODE_FLOW == MODE_FLOW, "runbatch.h mirrors the mode numbering");
+BatchLimits control_batch_limits(){ return BatchLimits{ MODE_FLOW, BPM_MIN, BPM_MAX, PRESS_TARGET_MAX, FLOW_TARGET_MAX }; }
+
+// Batch ids come from the AsyncTCP task only; results of the last BATCH_RESULTS_N applied
+// batches are copied out under a lock (Core 1 writes once per batch)
+static uint32_t s_batchId = 0;
+static BatchResult s_batchRes[BATCH_RESULTS_N]{};   // slot id % BATCH_RESULTS_N
+static portMUX_TYPE s_batchMux = portMUX_INITIALIZER_UNLOCKED;
+uint32_t control_post_batch(const RunBatch& b){
+  if (!s_batchMail.put(b)) return 0;
+  const uint32_t id = (s_batchId >= 0x7FFFFFFF) ? 1 : s_batchId + 1;   // Cmd.i is an int
+  if (!shared_post(Cmd{CMD_BATCH, (int)id})){ s_batchMail.drop(); return 0; }
+  s_batchId = id;
+  return id;
+}
+BatchStatus control_batch_result(uint32_t id, BatchResult& out){
+  if (id == 0) return BATCH_UNKNOWN;
+  portENTER_CRITICAL(&s_batchMux); out = s_batchRes[id % BATCH_RESULTS_N]; portEXIT_CRITICAL(&s_batchMux);
+  if (out.id == id) return BATCH_APPLIED;
+  // one batch in flight at a time (the mailbox holds one), so only the newest can be pending
+  return id == s_batchId ? BATCH_PENDING : BATCH_UNKNOWN;
+}
+
+static Capture s_cap;           // CAP_N samples, fixed at compile time
+Capture& control_capture(){ return s_cap; }
+static CaptureInfo  s_capInfo;
+static portMUX_TYPE s_capMux = portMUX_INITIALIZER_UNLOCKED;
+static void publish_capture(){
+  const CaptureInfo ci{ s_cap.config(), s_cap.info() };
+  portENTER_CRITICAL(&s_capMux); s_capInfo = ci; portEXIT_CRITICAL(&s_capMux);
+}
+void control_capture_info(CaptureInfo& out){
+  portENTER_CRITICAL(&s_capMux); out = s_capInfo; portEXIT_CRITICAL(&s_capMux);
+}
+static History* s_hist = nullptr;   // ~81 KB of tiers, allocated once in control_start()
+const History* control_history(){ return s_hist; }
+
+ProtectCfg control_protect_defaults(){
+  ProtectCfg c;
+  c.overMmHg = PROTECT_OVER_MMHG; c.underMmHg = PROTECT_UNDER_MMHG; c.hystMmHg = PROTECT_HYST_MMHG;
+  c.debounceTicks = PROTECT_DEBOUNCE_TICKS; c.drivePwm = PROTECT_DRIVE_PWM;
+  c.noFlowTicks = motion_ms_to_ticks(PROTECT_NO_FLOW_MS, CONTROL_HZ);
+  return c;
+}
+
+// Protection state for /api/protect (Core 1 copies after every change)
+static ProtectInfo s_protInfo;
+static portMUX_TYPE s_protMux = portMUX_INITIALIZER_UNLOCKED;
+void control_protect_info(ProtectInfo& out){
+  portENTER_CRITICAL(&s_protMux); out = s_protInfo; portEXIT_CRITICAL(&s_protMux);
+}
+
+// Target and correction per bin as of the last beat update, target change or reset
+static float s_ilcTarget[ILC_BINS], s_ilcCorr[ILC_BINS];
+static portMUX_TYPE s_ilcMux = portMUX_INITIALIZER_UNLOCKED;
+static void publish_ilc(){
+  float tg[ILC_BINS], co[ILC_BINS];
+  for (uint8_t b = 0; b < ILC_BINS; b++){ tg[b] = s_ilc.binTarget(b); co[b] = s_ilc.binCorrection(b); }
+  portENTER_CRITICAL(&s_ilcMux); memcpy(s_ilcTarget, tg, sizeof(tg)); memcpy(s_ilcCorr, co, sizeof(co)); portEXIT_CRITICAL(&s_ilcMux);
+}
+void control_ilc_bins(float* target, float* corr){
+  portENTER_CRITICAL(&s_ilcMux);
+  memcpy(target, s_ilcTarget, sizeof(s_ilcTarget)); memcpy(corr, s_ilcCorr, sizeof(s_ilcCorr));
+  portEXIT_CRITICAL(&s_ilcMux);
+}
+
+// PWM→flow map: loaded before the task starts, replaced by a finished sweep (Core 1) and
+// copied out for /api/pump/map (Core 0) under a short critical section. A new map is marked
+// dirty and written to NVS from Core 0 (control_pump_map_persist), never from control_task.
+static PumpMap     s_map;
+static bool        s_mapDirty = false;
+static portMUX_TYPE s_mapMux = portMUX_INITIALIZER_UNLOCKED;
+static const char* NS_PUMP = "pump";
+
+void control_pump_map(PumpMap& out){
+  portENTER_CRITICAL(&s_mapMux); out = s_map; portEXIT_CRITICAL(&s_mapMux);
+}
+
+static void pump_map_load(){
+  pumpmap_default(s_map, PUMP_DEFAULT_MAX_LPM, PUMP_DEFAULT_DEADBAND);
+  Preferences p;
+  if (!p.begin(NS_PUMP, false)) return;
+  PumpMap m;
+  if (p.getBytesLength("map") == sizeof(m) && p.getBytes("map", &m, sizeof(m)) == sizeof(m)
+      && m.version == PUMPMAP_VERSION) s_map = m;
+  p.end();
+}
+
+static bool pump_map_save(const PumpMap& m){
+  Preferences p;
+  if (!p.begin(NS_PUMP, false)) return false;
+  const bool ok = p.putBytes("map", &m, sizeof(m)) == sizeof(m);
+  p.end();
+  return ok;
+}
+
+void control_pump_map_persist(){
+  // flash writes stall both cores: only once the pump has stopped
+  if (G.paused.load() != 1 || G.pwmOut.load() != 0) return;
+  PumpMap m; bool dirty;
+  portENTER_CRITICAL(&s_mapMux); dirty = s_mapDirty; m = s_map; s_mapDirty = false; portEXIT_CRITICAL(&s_mapMux);
+  if (dirty && !pump_map_save(m)){ portENTER_CRITICAL(&s_mapMux); s_mapDirty = true; portEXIT_CRITICAL(&s_mapMux); }
+}
+
+// Completed beats (Core 1 pushes at each wrap; Core 0 copies for the stream and /api/beats)
+static BeatRing<HEMO_RING_N> s_beats;
+static portMUX_TYPE s_beatMux = portMUX_INITIALIZER_UNLOCKED;
+
+uint8_t control_beats(uint32_t after, BeatStats* out, uint8_t max){
+  portENTER_CRITICAL(&s_beatMux);
+  uint8_t n = s_beats.since(after, out, max);
+  portEXIT_CRITICAL(&s_beatMux);
+  return n;
+}
+
+static WindowStats s_win[STATS_WINDOWS][STATS_CH];
+static StatsSnapshot s_stats;
+static portMUX_TYPE s_statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+void control_stats(StatsSnapshot& out){
+  portENTER_CRITICAL(&s_statsMux); out = s_stats; portEXIT_CRITICAL(&s_statsMux);
+}
+
+static EnsembleAvg s_tmpl;                 // Core 1 only
+static EnsembleAvg s_tmplPub;              // copy at the last beat wrap (or reset), under s_tmplMux
+static portMUX_TYPE s_tmplMux = portMUX_INITIALIZER_UNLOCKED;
+static_assert(CONTROL_HZ * 60 / BPM_MAX >= ENS_BINS, "every template bin needs a sample per beat");
+static void publish_template(){
+  portENTER_CRITICAL(&s_tmplMux); s_tmplPub = s_tmpl; portEXIT_CRITICAL(&s_tmplMux);
+}
+void control_template(EnsembleAvg& out){
+  portENTER_CRITICAL(&s_tmplMux); out = s_tmplPub; portEXIT_CRITICAL(&s_tmplMux);
+}
+
+// FreeRTOS ticks are 1 ms, which cannot pace 600 Hz; an esp_timer notifies the task instead.
+// Without the timer the task waits whole ticks for each deadline: same mean rate, up to 1 ms jitter.
+static bool s_tickTimer = false;
+static void control_tick_cb(void*){ if (s_task) xTaskNotifyGive(s_task); }
 
 static inline bool override_active(){
   if (!G.overrideOutputs.load()) return false;
@@ -39,25 +217,32 @@ static void control_task(void* /*arg*/){
   pinMode(PIN_STATUS_LED, OUTPUT);
 
   // local state
+  int64_t nextUs = esp_timer_get_time();  // next deadline when pacing without the tick timer
   uint8_t pwm_out = 0;                   // current hardware PWM
-  float pwm_out_f = 0.0f;               // fractional accumulator for smooth ramping
   uint8_t pwm_set = 0;                   // desired setpoint (snapshot of G.pwmSet)
   uint8_t valve_dir = VALVE_FWD;         // current hardware valve
 
-  // Beat timing helpers
-  auto compute_half_hold_ms = [&]()->uint32_t{
-    int bpm = G.bpm.load(); if (bpm<1) bpm=1; if (bpm>60) bpm=60;
-    uint32_t half_ms = (uint32_t)(60000.0f/(2.0f*bpm));
-    // used = ramp_up + dead + ramp_down
-    uint32_t used = RAMP_MS + DEAD_MS + RAMP_MS;
-    return (half_ms>used)? (half_ms-used) : 0u;
+  // Beat waveform: table lookup per tick; tables are rebuilt only on BPM/shape changes
+  static BeatEngine beat;                // two tables — keep off the task stack
+  static BeatShape  beatShape;           // current shape (trapezoid until an upload)
+  auto rebuild_beat = [&](){
+    BeatTiming bt{ (uint32_t)G.bpm.load(), CONTROL_HZ, RAMP_MS, DEAD_MS };
+    beat.prepare(beatShape, bt);
   };
+  IlcTable& ilc = s_ilc;
+  ilc.configure(IlcConfig{ ILC_GAIN, ILC_FORGET, ILC_LEAD_MS, ILC_LIMIT });
+  auto publishDuty = [&](){              // also called whenever a new table goes live
+    ilc.setBeat(beat.active(), CONTROL_HZ);
+    s_tmpl.configure(TEMPLATE_MEMORY_BEATS, 4294967296.0f / beat.active().inc);
+    const BeatDuty& d = beat.active().duty;
+    G.beatPeriodMs.store(d.periodMs); G.beatRampPct.store(d.rampPct);
+    G.beatHoldPct.store(d.holdPct);   G.beatDeadPct.store(d.deadPct);
+  };
+  rebuild_beat(); beat.restart(); publishDuty();
 
   // timing
   float loopEmaMs = 1000.0f/CONTROL_HZ;
   uint32_t lastUs = micros();
-  const TickType_t period = pdMS_TO_TICKS(1000/CONTROL_HZ);
-  TickType_t wake = xTaskGetTickCount();
 
   // Buttons
   BtnState bs{};
@@ -68,41 +253,230 @@ static void control_task(void* /*arg*/){
 
   // Sequencers
   uint8_t seq = 0;           // direction change seq: 0=idle,1=down,2=dead,3=flip,4=up
-  uint32_t seqT = 0;
-
-  // Beat substate
-  uint8_t bstate = 0;        // 0=up,1=hold,2=down,3=dead1,4=dead2
-  uint32_t bstateT = 0;
-  uint32_t beatHoldMs = compute_half_hold_ms();
+  uint32_t seqTicks = 0;     // ticks spent in the current seq step
+  const uint32_t deadTicks = motion_ms_to_ticks(DEAD_MS, CONTROL_HZ);
 
   // previous paused for edge detection
   uint8_t prevPaused = (uint8_t)G.paused.load();
+  bool prevOverride = false;
 
   // helper lambdas
   auto setValveIfChanged = [&](uint8_t d){
     if (valve_dir != d){ valve_dir = d; io_write_valve(valve_dir); }
   };
-  auto setPwmIfChanged = [&](uint8_t d){
-    if (pwm_out != d){ pwm_out = d; pwm_out_f = (float)pwm_out; io_write_pwm(pwm_out); }
+  auto requestPause = [&](){ if (G.paused.load()==0) G.paused.store(2); };  // ramp to zero, then pause
+  // All PWM ramps go through one fixed-point profile; each ramp lasts exactly RAMP_MS.
+  const uint32_t rampTicks = motion_ms_to_ticks(RAMP_MS, CONTROL_HZ);
+  const RampShape rampShape = RAMP_JERK_LIMITED ? RAMP_SCURVE : RAMP_LINEAR;
+  MotionProfile prof; prof.reset(0);
+  // rampToward: (re)start a profile when the target changes, then advance one tick
+  auto rampToward = [&](uint8_t target){
+    if (prof.target() != target || (!prof.active() && pwm_out != target)){
+      prof.start(target, rampTicks, rampShape);
+    }
+    uint8_t next = prof.step();
+    if (next != pwm_out){ pwm_out = next; io_write_pwm(pwm_out); }
+  };
+  // Closed-loop pressure: per tick in MODE_PRESS, per beat on peak pressure in BEAT mode
+  PressTuning tune;
+  PidQ pressPid, peakPid;
+  auto configurePress = [&](){
+    pressPid.configure(tune.tick, CONTROL_DT_S, PWM_MIN, PWM_MAX);
+    peakPid.configure(tune.beat, 1.0f, PWM_MIN, PWM_MAX);      // one step per beat
+  };
+  configurePress();
+  auto pressFF = [&](float mmHg){
+    float u = tune.ffGain*mmHg + tune.ffOffset; if (u<0) u=0; if (u>PWM_MAX) u=PWM_MAX;
+    return pid_q16(u);
+  };
+  bool pressActive = false, pressRan = false;   // PID owns the output (edge → bumpless start)
+  auto pressTick = [&](){
+    float sp = G.pressTarget.load(), meas = G.vent_mmHg.load();
+    int32_t ff = pressFF(sp);
+    pressPid.setLimits(0, (int32_t)pwm_set << 16);                // POWER setpoint = ceiling
+    if (!pressActive) pressPid.reset((int32_t)pwm_out << 16, pid_q8(sp), pid_q8(meas), ff);
+    pressRan = true;
+    setValveIfChanged(VALVE_FWD);
+    uint8_t next = (uint8_t)((pressPid.step(pid_q8(sp), pid_q8(meas), ff) + 0x8000) >> 16);
+    if (next != pwm_out){ pwm_out = next; io_write_pwm(pwm_out); }
+    prof.reset(pwm_out);
+  };
+  // Beat boundary (phase wrap): per-beat analytics, ILC update, and with pressBeat set the
+  // beat drive follows the systolic peak
+  BeatAnalyzer hemo; hemo.begin(CONTROL_HZ);
+  uint32_t prevPhase = 0;
+  uint8_t beatDrive = 0;
+  auto restartPeak = [&](){
+    prevPhase = 0;
+    float sp = G.pressTarget.load(); int32_t ff = pressFF(sp);
+    peakPid.setLimits(0, (int32_t)pwm_set << 16);
+    if (ff > ((int32_t)pwm_set << 16)) ff = (int32_t)pwm_set << 16;
+    peakPid.reset(ff, pid_q8(sp), pid_q8(sp), ff);
+    beatDrive = (uint8_t)((ff + 0x8000) >> 16);
+  };
+  // Delivered volume: exact edge counts per valve direction; beats (or 1 s slices outside
+  // BEAT mode) close the segments behind stroke volume and cardiac output
+  FlowTotalizer vol;
+  vol.begin(CONTROL_HZ, FLOW_COUNT_BOTH_EDGES ? 2 : 1, motion_ms_to_ticks(FLOW_MAX_WIN_MS, CONTROL_HZ));
+  bool beatRan = false;
+
+  // Windowed statistics (buffers are file-static; the snapshot is built here then copied)
+  for (uint8_t w=0;w<STATS_WINDOWS;w++) for (uint8_t c=0;c<STATS_CH;c++) s_win[w][c].configure(motion_ms_to_ticks(STATS_WINDOW_MS[w], CONTROL_HZ));
+  static StatsSnapshot statsNext;
+  const uint32_t statsPubTicks = motion_ms_to_ticks(STATS_PUBLISH_MS, CONTROL_HZ);
+  uint32_t statsTicks = 0;
+  CfgProfile cal; uint32_t calVer = G.cal.version(); G.cal.read(cal);   // refreshed each tick when republished
+  auto flowCal = [&](){ return FlowCal{ cal.flow.m, cal.flow.b }; };
+  auto closeBeat = [&](){
+    uint32_t ph = beat.phase();
+    bool wrapped = ph < prevPhase;
+    prevPhase = ph;
+    if (!wrapped) return;
+    publish_template();
+    BeatStats st;
+    VolumeSeg vs = vol.endSegment(flowCal());
+    st.svMl = vs.netMl; st.fwdMl = vs.fwdMl; st.revMl = vs.revMl; st.coLpm = vol.coLpm();
+    if (hemo.endBeat(millis(), st)){
+      portENTER_CRITICAL(&s_beatMux); s_beats.push(st); portEXIT_CRITICAL(&s_beatMux);
+      G.pressPeak.store(st.sys);
+      if (G.pressBeat.load()){
+        float sp = G.pressTarget.load();
+        peakPid.setLimits(0, (int32_t)pwm_set << 16);
+        beatDrive = (uint8_t)((peakPid.step(pid_q8(sp), pid_q8(st.sys), pressFF(sp)) + 0x8000) >> 16);
+      }
+    }
+    if (G.ilcOn.load() && ilc.endBeat()){ G.ilcRms.store(ilc.rms()); G.ilcBeats.store(ilc.beats()); publish_ilc(); }
+  };
+  // Flow setpoint: one ramp to the map's PWM (+ current trim), then a slow integral trim
+  PidQ flowPid;
+  flowPid.configure(PidGains{0.0f, FLOW_KI, 0.0f}, CONTROL_DT_S, PWM_MIN, PWM_MAX);
+  const uint32_t trimHoldTicks = motion_ms_to_ticks(FLOW_TRIM_HOLD_MS, CONTROL_HZ);
+  bool flowActive = false, flowRan = false;
+  float flowLast = 0; uint32_t flowHold = 0;
+  auto flowTick = [&](){
+    float tgt = G.flowTarget.load(), meas = G.flow_L_min.load();
+    uint8_t dir = (tgt < 0) ? 1 : 0; float mag = fabsf(tgt);
+    int32_t ff = pid_q16(pumpmap_pwm_for(s_map, dir, mag));
+    int32_t lim = (int32_t)pwm_set << 16;
+    flowPid.setLimits(0, lim);
+    flowRan = true;
+    if (!flowActive) flowPid.reset(ff > lim ? lim : ff, 0, 0, ff);
+    if (!flowActive || tgt != flowLast){
+      flowLast = tgt; flowHold = trimHoldTicks;
+      int32_t u = ff + flowPid.integrator(); if (u < 0) u = 0; if (u > lim) u = lim;
+      prof.start((uint8_t)((u + 0x8000) >> 16), rampTicks, rampShape);
+    }
+    if (prof.active() || flowHold){            // ramping or waiting for the estimate: no trim
+      if (!prof.active()) flowHold--;
+      uint8_t next = prof.step();
+      if (next != pwm_out){ pwm_out = next; io_write_pwm(pwm_out); }
+      return;
+    }
+    uint8_t next = (uint8_t)((flowPid.step(pid_q8(mag), pid_q8(meas), ff) + 0x8000) >> 16);
+    if (next != pwm_out){ pwm_out = next; io_write_pwm(pwm_out); }
+    prof.reset(pwm_out);
   };
-  // rampToward: move pwm_out toward target in RAMP_MS across CONTROL_HZ ticks
-  auto rampToward = [&](uint8_t target, bool allowRampUp=true){
-    if (pwm_out == target) return;
-    if (!allowRampUp && target > pwm_out) return; // don't ramp up when disallowed
-    float ticks = (float)RAMP_MS / (1000.0f/CONTROL_HZ);
-    if (ticks < 1.0f) ticks = 1.0f;
-    // compute fractional step using the fractional accumulator so small steps accumulate over ticks
-    float step = ((float)target - pwm_out_f) / ticks;
-    pwm_out_f += step;
-    // clamp accumulator to target to avoid overshoot
-    if (step > 0.0f && pwm_out_f > (float)target) pwm_out_f = (float)target;
-    if (step < 0.0f && pwm_out_f < (float)target) pwm_out_f = (float)target;
-    int next = (int)roundf(pwm_out_f);
-    if ((step>0 && next>target) || (step<0 && next<target)) next = target;
-    pwm_out = clamp8(next);
-    io_write_pwm(pwm_out);
+
+  // Pump characterization sweep: owns the outputs while running; valve flips only at PWM 0
+  PumpSweep sweep;
+  const SweepCfg sweepCfg{ motion_ms_to_ticks(SWEEP_SETTLE_MS, CONTROL_HZ), motion_ms_to_ticks(SWEEP_WINDOW_MS, CONTROL_HZ),
+                           motion_ms_to_ticks(SWEEP_TIMEOUT_MS, CONTROL_HZ), SWEEP_TOL_LPM, SWEEP_TOL_PCT };
+  uint32_t flipTicks = 0;
+  auto sweepTick = [&](){
+    SweepOut o{0, 0};
+    SweepEvent ev = sweep.tick(G.flow_L_min.load(), o);
+    uint8_t v = o.valve ? VALVE_REV : VALVE_FWD;
+    if (v != valve_dir){
+      rampToward(0);
+      if (pwm_out==0 && !prof.active() && ++flipTicks >= deadTicks){ setValveIfChanged(v); flipTicks = 0; }
+    } else {
+      rampToward(o.pwm);
+    }
+    G.sweepPct.store(sweep.progressPct());
+    if (ev == SWEEP_DONE){
+      portENTER_CRITICAL(&s_mapMux); s_map = sweep.result(); s_mapDirty = true; portEXIT_CRITICAL(&s_mapMux);
+      G.sweepState.store(2); requestPause();
+    }
+  };
+
+  // Beat drive = table level × setpoint; the setpoint itself is ramped so edits never step
+  MotionProfile beatScale; beatScale.reset(0);
+  auto beatTick = [&](){
+    beatRan = true;
+    uint8_t drive = G.pressBeat.load() ? beatDrive : pwm_set;
+    if (beatScale.target() != drive) beatScale.start(drive, rampTicks, rampShape);
+    uint8_t sc = beatScale.step();
+    uint32_t ph = beat.phase();
+    BeatOut o = beat.step();
+    bool learn = G.ilcOn.load();
+    float vent = G.vent_mmHg.load();
+    const float ch[ENS_CH] = { G.atr_mmHg.load(), vent, G.flow_L_min.load() };
+    s_tmpl.sample(ph - beat.active().splitPhase, ch);
+    hemo.sample(vent);
+    if (learn) ilc.sample(ph, vent);
+    closeBeat();
+    if (o.flipped) publishDuty();        // a pending table may have gone live
+    setValveIfChanged(o.valve ? VALVE_REV : VALVE_FWD);   // flips land mid dead-time (level 0)
+    int lv = ((uint16_t)o.level * sc + 127) / 255;
+    if (learn && o.level){ lv += ilc.correction(ph); lv = lv < 0 ? 0 : (lv > PWM_MAX ? PWM_MAX : lv); }
+    uint8_t next = (uint8_t)lv;
+    if (next != pwm_out){ pwm_out = next; io_write_pwm(pwm_out); }
+    prof.reset(pwm_out);                 // keep the ramp generator in sync for leaving beat
+  };
+  auto startBeat = [&](){
+    beat.restart(); restartPeak(); publishDuty(); ilc.clearBeat(); hemo.clear(); vol.restartSegment();
+    beatScale.reset(G.pressBeat.load() ? beatDrive : pwm_set);
+  };
+  // Run-state helpers shared by commands and the protocol runner
+  auto unpause = [&](){
+    bool pending = (G.paused.load()==2);   // still ramping down: re-enter through the safe seq
+    G.paused.store(0);
+    // Restart the beat at phase 0 so a low-BPM beat begins immediately
+    // instead of waiting out a long hold period.
+    pwm_set = (uint8_t)G.pwmSet.load(); startBeat();
+    if (pending) seq = 1;
+    // valve and ramp-up handled below on running path using need_dir/pwm_set
+  };
+  auto setPwm  = [&](int v){ if (v<0) v=0; if (v>255) v=255; G.pwmSet.store(v); };
+  auto setBpm  = [&](int b){ if (b<BPM_MIN) b=BPM_MIN; if (b>BPM_MAX) b=BPM_MAX; if (b!=G.bpm.load()){ G.bpm.store(b); rebuild_beat(); } };
+  auto setMode = [&](int m){
+    if (m<MODE_FWD||m>MODE_FLOW) m = MODE_FWD;
+    // do not auto-unpause on mode change; just update mode
+    G.mode.store(m);
+    // if running, ramp down and change valve safely first; beat starts after the flip
+    if (G.paused.load()==0){ seq = 1; }
+  };
+
+  // Protocol runner (tick-exact segment transitions)
+  static Protocol proto;
+  ProtoRunner runner;
+  auto publishProto = [&](){
+    G.protoStep.store(runner.stepIndex()); G.protoIter.store(runner.iteration());
+    G.protoTicks.store((uint32_t)runner.elapsed(), std::memory_order_relaxed);
+  };
+
+  auto forceOutputsOff = [&](){ pwm_out = 0; prof.reset(0); io_write_pwm(0); valve_dir = VALVE_FWD; io_write_valve(valve_dir); };
+
+  // Protection: checked on the raw ADC counts right after they are read; a trip turns the
+  // outputs off on that same tick (even under the calibration override) and holds them off
+  static Protection prot;
+  ProtectCfg protCfg = control_protect_defaults();
+  prot.configure(protCfg);
+  auto publishProt = [&](){
+    ProtectInfo pi{ protCfg, prot.latched(), prot.trips(), prot.latencyTicks(), { prot.tripRaw(PROT_ATR), prot.tripRaw(PROT_VENT) } };
+    portENTER_CRITICAL(&s_protMux); s_protInfo = pi; portEXIT_CRITICAL(&s_protMux);
+    G.fault.store(prot.latched());
+  };
+  publishProt();
+  publish_capture();
+  auto tripFault = [&](){
+    forceOutputsOff();
+    G.paused.store(1); seq = 0;
+    if (runner.running()){ runner.stop(); G.protoState.store(4); }
+    if (sweep.running()){ sweep.stop(); G.sweepState.store(3); }
+    control_ctr.protectTrips.fetch_add(1, std::memory_order_relaxed);
+    publishProt();
   };
-  auto forceOutputsOff = [&](){ pwm_out = 0; pwm_out_f = (float)pwm_out; io_write_pwm(0); valve_dir = VALVE_FWD; io_write_valve(valve_dir); };
 
   for(;;){
     // timing
@@ -111,56 +485,126 @@ static void control_task(void* /*arg*/){
     loopEmaMs = loopEmaMs*0.9f + dtMs*0.1f;
     G.loopMs.store(loopEmaMs, std::memory_order_relaxed);
 
+    // calibration: the whole profile changes between ticks, never within one
+    if (G.cal.version() != calVer){ calVer = G.cal.version(); G.cal.read(cal); }
+
     // consume commands
     Cmd cmd;
     while (shared_cmdq() && xQueueReceive(shared_cmdq(), &cmd, 0) == pdTRUE){
       if (cmd.t == CMD_TOGGLE){
-        int paused = G.paused.load();
-        if (paused){
-          // unpause -> immediate valve direction set and begin ramp up
-          G.paused.store(0);
-          // Ensure beat state machine starts from ramp-up so a low-BPM beat
-          // begins immediately instead of waiting out a long hold period.
-          // bstate and bstateT are local to this task, so update them here.
-          bstate = 0; bstateT = millis();
-          // valve and ramp-up handled below on running path using need_dir/pwm_set
-        } else {
-          // request pending pause: finish ramp to zero then set paused
-          G.paused.store(2);
-        }
+        if (G.fault.load() && G.paused.load()) continue;        // latched fault: clear it first
+        // a manual play/pause takes over from a running protocol or sweep
+        if (runner.running()){ runner.stop(); G.protoState.store(4); }
+        if (sweep.running()){ sweep.stop(); G.sweepState.store(3); requestPause(); continue; }
+        if (G.paused.load()) unpause(); else requestPause();
       } else if (cmd.t == CMD_SET_PWM){
-        int v = cmd.i; if (v<0) v=0; if (v>255) v=255; G.pwmSet.store(v);
-        // If we're currently running in BEAT mode, start the beat state machine
-        // from ramp-up so the hardware begins moving to the new setpoint
-        // immediately instead of waiting out the current hold/dead interval.
-        if (G.mode.load() == MODE_BEAT && G.paused.load() == 0){
-          bstate = 0; bstateT = millis();
-        }
+        // In BEAT mode the drive scale ramps to the new setpoint from the current stroke.
+        setPwm(cmd.i);
       } else if (cmd.t == CMD_SET_BPM){
-        int b = cmd.i; if (b<1) b=1; if (b>60) b=60; G.bpm.store(b); beatHoldMs = compute_half_hold_ms();
+        setBpm(cmd.i);
       } else if (cmd.t == CMD_SET_MODE){
-        int m = cmd.i; if (m<MODE_FWD||m>MODE_BEAT) m = MODE_FWD;
-        // do not auto-unpause on mode change; just update mode
-        G.mode.store(m);
-        // recompute beat budget if needed
-        if (m==MODE_BEAT) {
-          beatHoldMs = compute_half_hold_ms();
-          // reset beat substate so beat starts cleanly when running
-          bstate = 0; bstateT = millis();
+        setMode(cmd.i);
+      } else if (cmd.t == CMD_SET_PRESS){
+        float t = cmd.i * 0.1f; if (t<0) t=0; if (t>PRESS_TARGET_MAX) t=PRESS_TARGET_MAX;
+        G.pressTarget.store(t);
+      } else if (cmd.t == CMD_SET_PRESS_BEAT){
+        int on = cmd.i ? 1 : 0;
+        if (on && !G.pressBeat.load()) restartPeak();               // start from feed-forward
+        G.pressBeat.store(on);
+      } else if (cmd.t == CMD_PRESS_TUNE){
+        if (s_pressMail.take(tune)) configurePress();
+      } else if (cmd.t == CMD_SET_FLOW){
+        float t = cmd.i * 0.01f; if (t<-FLOW_TARGET_MAX) t=-FLOW_TARGET_MAX; if (t>FLOW_TARGET_MAX) t=FLOW_TARGET_MAX;
+        bool flip = (t<0) != (G.flowTarget.load()<0);
+        G.flowTarget.store(t);
+        if (flip && G.mode.load()==MODE_FLOW && G.paused.load()==0) seq = 1;   // reverse through the safe seq
+      } else if (cmd.t == CMD_SWEEP){
+        if (cmd.i && !sweep.running() && !G.fault.load()){
+          if (runner.running()){ runner.stop(); G.protoState.store(4); }
+          sweep.start(sweepCfg); flipTicks = 0; seq = 0;
+          G.paused.store(0); G.sweepState.store(1); G.sweepPct.store(0);
+        } else if (!cmd.i && sweep.running()){
+          sweep.stop(); G.sweepState.store(3); requestPause();
         }
-        // if running, start direction-change sequence (or start beat immediately)
-        if (G.paused.load()==0){
-          if (m==MODE_BEAT){
-            // ensure beat starts from a ramp-up
-            bstate = 0; bstateT = millis();
-          } else {
-            // start seq to change valve safely for FWD<->REV
-            seq = 1; seqT = millis();
-          }
+      } else if (cmd.t == CMD_ILC){
+        if (cmd.i == 2){ ilc.reset(); G.ilcRms.store(0); G.ilcBeats.store(0); publish_ilc(); }
+        else { int on = (cmd.i && ilc.hasTarget()) ? 1 : 0; if (on && !G.ilcOn.load()) ilc.clearBeat(); G.ilcOn.store(on); }
+      } else if (cmd.t == CMD_ILC_TARGET){
+        IlcTarget t;
+        if (s_ilcMail.take(t)){ ilc.setTarget(t.mmHg); ilc.clearBeat(); publish_ilc(); }
+      } else if (cmd.t == CMD_TEMPLATE_RESET){
+        s_tmpl.reset(); publish_template();
+      } else if (cmd.t == CMD_VOLUME_RESET){
+        vol.reset();
+      } else if (cmd.t == CMD_FAULT_CLEAR){
+        if (prot.clear()) publishProt();
+      } else if (cmd.t == CMD_PROTECT_CFG){
+        if (s_protMail.take(protCfg)){ prot.configure(protCfg); publishProt(); }
+      } else if (cmd.t == CMD_CAPTURE){
+        if (cmd.i == 1) s_cap.arm(); else if (cmd.i == 2) s_cap.force(); else s_cap.stop();
+      } else if (cmd.t == CMD_CAPTURE_CFG){
+        CapConfig c;
+        if (s_capMail.take(c)){ s_cap.configure(c); publish_capture(); }
+      } else if (cmd.t == CMD_STATS_WINDOW){
+        uint8_t w = (uint8_t)(cmd.i >> 24);
+        uint32_t ms = cmd.i & 0xFFFFFF; ms = ms < STATS_PUBLISH_MS ? STATS_PUBLISH_MS : (ms > STATS_WINDOW_MAX_MS ? STATS_WINDOW_MAX_MS : ms);
+        if (w < STATS_WINDOWS) for (uint8_t c=0;c<STATS_CH;c++) s_win[w][c].configure(motion_ms_to_ticks(ms, CONTROL_HZ));
+      } else if (cmd.t == CMD_SET_SHAPE){
+        if (s_shapeMail.take(beatShape)){ rebuild_beat(); G.beatShape.store(beatShape.kind); }
+      } else if (cmd.t == CMD_PROTO_LOAD){
+        if (s_protoMail.take(proto)){
+          if (runner.running()) requestPause();
+          runner.start(nullptr);           // forget any progress on the old protocol
+          G.protoState.store(1); G.protoStep.store(0); G.protoIter.store(0);
+          G.protoTicks.store(0); G.protoTotal.store((uint32_t)protocol_total_ticks(proto));
         }
+      } else if (cmd.t == CMD_PROTO_START){
+        if (proto.n && !G.fault.load()){ runner.start(&proto); G.protoState.store(2); G.protoTotal.store((uint32_t)runner.total()); }
+      } else if (cmd.t == CMD_PROTO_STOP){
+        if (runner.running()){ runner.stop(); G.protoState.store(4); requestPause(); }
+      } else if (cmd.t == CMD_BATCH){
+        RunBatch b;
+        if (!s_batchMail.take(b)) continue;
+        if ((b.has & RB_RUN) && !(G.fault.load() && G.paused.load())){
+          // play/pause takes over like CMD_TOGGLE; a sweep ramps down and re-enters through the seq
+          if (runner.running()){ runner.stop(); G.protoState.store(4); }
+          if (sweep.running()){ sweep.stop(); G.sweepState.store(3); requestPause(); }
+        }
+        RunState st;
+        st.mode = G.mode.load(); st.pwm = G.pwmSet.load(); st.bpm = G.bpm.load();
+        st.press = G.pressTarget.load(); st.flow = G.flowTarget.load(); st.pressBeat = G.pressBeat.load() != 0;
+        st.paused = (uint8_t)G.paused.load(); st.fault = G.fault.load() != 0;
+        const uint8_t act = batch_plan(b, st);
+        // every setting first, so the side effects below (and this tick's outputs) see them all
+        G.mode.store(st.mode); G.pwmSet.store(st.pwm); G.bpm.store(st.bpm);
+        G.pressTarget.store(st.press); G.pressBeat.store(st.pressBeat ? 1 : 0); G.flowTarget.store(st.flow);
+        if (act & BA_REBUILD_BEAT) rebuild_beat();
+        if (act & BA_RESTART_PEAK) restartPeak();
+        if (act & BA_PAUSE) requestPause();
+        if (act & BA_UNPAUSE) unpause();
+        if (act & BA_SEQ) seq = 1;
+        const BatchResult res{ (uint32_t)cmd.i, control_ctr.ticks.load(std::memory_order_relaxed), act, st };
+        portENTER_CRITICAL(&s_batchMux); s_batchRes[res.id % BATCH_RESULTS_N] = res; portEXIT_CRITICAL(&s_batchMux);
       }
     }
 
+    // protocol: apply a segment on the exact tick it begins
+    ProtoStep seg;
+    ProtoEvent pev = runner.tick(seg);
+    if (pev == PROTO_ENTER){
+      if (seg.op == PROTO_PAUSE){
+        requestPause();
+      } else {
+        setPwm(seg.pwm);
+        if (seg.bpm) setBpm(seg.bpm);
+        if (seg.mode != G.mode.load()) setMode(seg.mode);
+        if (G.paused.load()) unpause();
+      }
+    } else if (pev == PROTO_DONE){
+      requestPause(); G.protoState.store(3);
+    }
+    if (pev != PROTO_IDLE) publishProto();
+
     // buttons
     buttons_read(bs);
     if (bs.aRise) aRiseTs = millis();
@@ -175,8 +619,8 @@ static void control_task(void* /*arg*/){
     }
     if (chord_now && !chord_gated){
       chord_gated = 1;
-      int m = G.mode.load(); m = (m==MODE_BEAT)?MODE_FWD:(m+1); G.mode.store(m);
-      if (G.paused.load()==0){ seq = 1; seqT = millis(); }
+      int m = G.mode.load(); m = (m>=MODE_BEAT)?MODE_FWD:(m+1); G.mode.store(m);   // PRESS via web only
+      if (G.paused.load()==0){ seq = 1; }
     }
     if (!bs.aPressed || !bs.bPressed) {
       chord_gated = 0;
@@ -188,10 +632,14 @@ static void control_task(void* /*arg*/){
 
     // outputs
     pwm_set = (uint8_t)G.pwmSet.load();
-    uint8_t need_dir = (G.mode.load()==MODE_REV)?VALVE_REV:VALVE_FWD;
+    int mode = G.mode.load();
+    uint8_t need_dir = (mode==MODE_REV || (mode==MODE_FLOW && G.flowTarget.load()<0)) ? VALVE_REV : VALVE_FWD;
 
     bool isOverride = override_active();
+    if (isOverride && !prevOverride) control_ctr.overrideGates.fetch_add(1, std::memory_order_relaxed);
+    prevOverride = isOverride;
     int paused = G.paused.load(); // 0=run,1=paused,2=pending
+    pressRan = false; flowRan = false; beatRan = false;
 
     // override gate: still enforce safety (pause) writes
     if (isOverride){
@@ -204,12 +652,8 @@ static void control_task(void* /*arg*/){
       // handle pending pause
       if (paused==2){
         // finish ramping to zero
-        if (pwm_out>0){
-          // decrement per-tick roughly
-          int next = (int)pwm_out - (int)roundf(255.0f / (RAMP_MS/(1000.0f/CONTROL_HZ)));
-          pwm_out = clamp8(next);
-          pwm_out_f = (float)pwm_out;
-          io_write_pwm(pwm_out);
+        if (pwm_out>0 || prof.active()){
+          rampToward(0);
         } else {
           // reached zero: mark paused and force valve off
           G.paused.store(1);
@@ -223,60 +667,95 @@ static void control_task(void* /*arg*/){
         // if user just unpaused (edge), ensure valve immediately set to need_dir
         if (prevPaused==1 && paused==0){ setValveIfChanged(need_dir); }
 
-        if (seq != 0){
+        if (sweep.running()){
+          sweepTick();
+        } else if (seq != 0){
           // direction change seq: ramp down -> dead -> flip -> ramp up
           if (seq==1){ // ramp down
-            rampToward(0, true);
-            if (pwm_out==0 && (millis()-seqT)>=0){ seq=2; seqT=millis(); }
+            rampToward(0);
+            if (pwm_out==0){ seq=2; seqTicks=0; }
           } else if (seq==2){ // dead wait
-            if (millis()-seqT >= DEAD_MS){ seq=3; }
+            if (++seqTicks >= deadTicks){ seq=3; }
           } else if (seq==3){ // flip
             setValveIfChanged(need_dir);
-            seq = 4; seqT = millis();
+            if (G.mode.load()==MODE_BEAT){ seq = 0; startBeat(); }   // beat opens with its own dead/ramp
+            else if (G.mode.load()==MODE_PRESS || G.mode.load()==MODE_FLOW){ seq = 0; }   // loops take over from 0
+            else { seq = 4; }
           } else if (seq==4){ // ramp up
-            rampToward(pwm_set, true);
+            rampToward(pwm_set);
             if (pwm_out==pwm_set) seq = 0;
           }
         } else if (G.mode.load()==MODE_BEAT){
-          // beat mode state machine (per half-period)
-          if (bstate==0){ // ramp up
-            rampToward(pwm_set, true);
-            if (pwm_out==pwm_set){ bstate=1; bstateT=millis(); }
-          } else if (bstate==1){ // hold
-            if (millis()-bstateT >= beatHoldMs){ bstate=2; }
-          } else if (bstate==2){ // ramp down
-            rampToward(0, true);
-            if (pwm_out==0){ bstate=3; bstateT=millis(); }
-          } else if (bstate==3){ // dead half 1
-            if (millis()-bstateT >= (DEAD_MS/2)){ // flip in middle
-              // use helper so writes and local state are consistent
-              setValveIfChanged((valve_dir==VALVE_FWD)?VALVE_REV:VALVE_FWD);
-              bstate = 4; bstateT = millis();
-            }
-          } else if (bstate==4){ // dead half 2
-            if (millis()-bstateT >= (DEAD_MS/2)){ bstate = 0; }
-          }
+          beatTick();
+        } else if (G.mode.load()==MODE_PRESS){
+          pressTick();
+        } else if (G.mode.load()==MODE_FLOW){
+          setValveIfChanged(need_dir);
+          flowTick();
         } else {
           // steady FWD or REV
           setValveIfChanged(need_dir);
-          rampToward(pwm_set, true);
+          rampToward(pwm_set);
         }
       }
     }
 
+    pressActive = pressRan; flowActive = flowRan;
+
   // publish: expose both setpoint and actual hardware PWM
   G.valve.store(valve_dir);
   G.pwmSet.store(pwm_set);
   G.pwmOut.store(pwm_out);
 
+    // delivered volume: edges since the last tick belong to the valve state just published
+    vol.sample(flow_ctr.edgesAccepted.load(std::memory_order_relaxed), valve_dir == VALVE_REV);
+    if (!beatRan && vol.segTicks() >= CONTROL_HZ) vol.endSegment(flowCal());
+    { FlowCal fc = flowCal(); G.volFwdMl.store(vol.totalMl(0, fc)); G.volRevMl.store(vol.totalMl(1, fc)); G.coLpm.store(vol.coLpm()); }
+
     // ADC + smoothing
     int atr_r = io_read_atr(); int vent_r = io_read_vent();
     G.atr_raw.store(atr_r); G.vent_raw.store(vent_r);
+    prot.setCal(PROT_ATR, cal.atr.m, cal.atr.b); prot.setCal(PROT_VENT, cal.vent.m, cal.vent.b);
+    const int32_t praw[PROT_CH] = { atr_r, vent_r };
+    if (prot.step(praw, pwm_out, flow_ctr.edgesAccepted.load(std::memory_order_relaxed))){
+      tripFault(); G.pwmOut.store(pwm_out); G.valve.store(valve_dir);
+    }
+    const uint32_t tickNo = control_ctr.ticks.load(std::memory_order_relaxed);
+    const uint8_t  lstate = log_state(valve_dir, (uint8_t)G.paused.load(), (uint8_t)G.mode.load());
+    recorder_push(LogSample{ tickNo, (int16_t)atr_r, (int16_t)vent_r, flow_ctr.edgesAccepted.load(std::memory_order_relaxed),
+                             pwm_out, lstate, (uint8_t)G.fault.load() });
     // push smoothing (reuse MA local instances)
     static MA atr_ma{}, vent_ma{}; atr_ma.push((float)atr_r); vent_ma.push((float)vent_r);
-    float atr_cal = apply_cal(atr_ma.mean(), G.atr_m.load(), G.atr_b.load());
-    float vent_cal = apply_cal(vent_ma.mean(), G.vent_m.load(), G.vent_b.load());
+    float atr_cal = apply_cal(atr_ma.mean(), cal.atr.m, cal.atr.b);
+    float vent_cal = apply_cal(vent_ma.mean(), cal.vent.m, cal.vent.b);
     G.atr_mmHg.store(atr_cal); G.vent_mmHg.store(vent_cal);
+    const float atr_u = apply_cal((float)atr_r, cal.atr.m, cal.atr.b);      // unsmoothed
+    const float vent_u = apply_cal((float)vent_r, cal.vent.m, cal.vent.b);
+    spectral_push(atr_u, vent_u);
+    auto q = [](float v, float k){ float x = v * k; return (int16_t)(x > 32767.0f ? 32767 : (x < -32768.0f ? -32768 : lroundf(x))); };
+    const int16_t qa = q(atr_u, 10), qv = q(vent_u, 10), qf = q(G.flow_L_min.load(), 100);
+    const uint8_t fault = (uint8_t)G.fault.load();
+    const uint32_t capSeq = s_cap.info().seq;
+    s_cap.tick(CapSample{ qa, qv, qf, pwm_out, lstate }, fault, tickNo);
+    if (s_cap.info().seq != capSeq) publish_capture();
+    telemetry_push(tickNo, TlmSample{ qa, qv, qf, pwm_out, lstate }, fault);
+
+    // windowed statistics over every tick; published at STATS_PUBLISH_MS
+    const float sx[STATS_CH] = { atr_cal, vent_cal, G.flow_L_min.load(), (float)pwm_out };
+    for (uint8_t w=0;w<STATS_WINDOWS;w++) for (uint8_t c=0;c<STATS_CH;c++) s_win[w][c].push(sx[c]);
+    int16_t hx[HIST_CH];
+    for (uint8_t c=0;c<HIST_CH;c++) hx[c] = q(sx[c], HIST_SCALE[c]);
+    if (s_hist) s_hist->push(hx);
+    if (++statsTicks >= statsPubTicks){
+      statsTicks = 0;
+      StatsSnapshot& st = statsNext;
+      st.seq++;
+      for (uint8_t w=0;w<STATS_WINDOWS;w++){
+        st.windowMs[w] = (uint32_t)((uint64_t)s_win[w][0].windowTicks() * 1000 / CONTROL_HZ);
+        for (uint8_t c=0;c<STATS_CH;c++) st.r[w][c] = s_win[w][c].result();
+      }
+      portENTER_CRITICAL(&s_statsMux); s_stats = st; portEXIT_CRITICAL(&s_statsMux);
+    }
 
     // heartbeat LED ~1Hz
     static uint32_t ledT=0; static bool led=false;
@@ -284,14 +763,48 @@ static void control_task(void* /*arg*/){
 
     // update prevPaused and delay
     prevPaused = (uint8_t)G.paused.load();
-    vTaskDelayUntil(&wake, period);
+    control_ctr.ticks.fetch_add(1, std::memory_order_relaxed);
+    // wait for the next timer tick; more than one pending notification means we missed a deadline
+    if (s_tickTimer){
+      uint32_t pending = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      if (pending > 1) control_ctr.overruns.fetch_add(pending-1, std::memory_order_relaxed);
+    } else {
+      nextUs += CONTROL_PERIOD_US;
+      const int64_t late = esp_timer_get_time() - nextUs;
+      if (late >= (int64_t)CONTROL_PERIOD_US){
+        control_ctr.overruns.fetch_add((uint32_t)(late / CONTROL_PERIOD_US), std::memory_order_relaxed);
+        nextUs += late / CONTROL_PERIOD_US * CONTROL_PERIOD_US;
+      }
+      TickType_t wake = xTaskGetTickCount();
+      while (esp_timer_get_time() < nextUs) vTaskDelayUntil(&wake, 1);
+    }
   }
 }
 
 void control_start(){
+  pump_map_load();
+  // History is the largest buffer: take it from the heap before WiFi fragments it. Without it
+  // the loop runs as before and /api/history answers 503.
+  s_hist = new (std::nothrow) History();
+  if (!s_hist) Serial.printf("[CTRL] no heap for history (%u bytes)\n", (unsigned)sizeof(History));
+
+  // Periodic tick source at CONTROL_HZ (callback runs in the esp_timer task and only notifies).
+  // Started before the task exists so the task knows how it is paced; ticks until then are no-ops.
+  esp_timer_create_args_t args{};
+  args.callback = control_tick_cb;
+  args.name = "control_tick";
+  esp_timer_handle_t h = nullptr;
+  esp_err_t err = esp_timer_create(&args, &h);
+  if (err == ESP_OK){
+    err = esp_timer_start_periodic(h, CONTROL_PERIOD_US);
+    if (err != ESP_OK) esp_timer_delete(h);
+  }
+  s_tickTimer = (err == ESP_OK);
+  if (!s_tickTimer) Serial.printf("[CTRL] tick timer failed (%s); pacing on 1 ms ticks\n", esp_err_to_name(err));
+
   // Create the control task pinned to CORE_CONTROL. Stack and priority chosen
   // to give the 600 Hz loop enough headroom; adjust if needed.
   const uint32_t stack = 8192; // bytes
   const UBaseType_t prio = 3;
-  xTaskCreatePinnedToCore(control_task, "control", stack/sizeof(portSTACK_TYPE), nullptr, prio, nullptr, CORE_CONTROL);
+  xTaskCreatePinnedToCore(control_task, "control", stack/sizeof(portSTACK_TYPE), nullptr, prio, &s_task, CORE_CONTROL);
 }
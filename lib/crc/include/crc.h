@@ -0,0 +1,14 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/* ==========================================================================================
+   crc.h — CRC-32 (IEEE 802.3, reflected, as zlib/PNG) for stored and transmitted blocks
+   ------------------------------------------------------------------------------------------
+   • Table-driven (1 KB table built on first use); crc32_update() chains over several
+     buffers: crc32_update(crc32_update(0, a, n), b, m) == crc32 of a‖b.
+   • Pure logic (no Arduino/FreeRTOS) so it also builds in host tests and host tools.
+   ==========================================================================================*/
+
+uint32_t crc32_update(uint32_t crc, const void* data, size_t len);
+static inline uint32_t crc32(const void* data, size_t len){ return crc32_update(0, data, len); }
@@ -0,0 +1,21 @@
+#include "crc.h"
+
+static uint32_t s_table[256];
+static bool s_ready = false;
+
+static void build(){
+  for (uint32_t i = 0; i < 256; i++){
+    uint32_t c = i;
+    for (uint8_t k = 0; k < 8; k++) c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+    s_table[i] = c;
+  }
+  s_ready = true;
+}
+
+uint32_t crc32_update(uint32_t crc, const void* data, size_t len){
+  if (!s_ready) build();
+  const uint8_t* p = (const uint8_t*)data;
+  crc = ~crc;
+  while (len--) crc = s_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/* ==========================================================================================
+   ctlmsg.h — WebSocket control messages and per-session replay protection
+   ------------------------------------------------------------------------------------------
+   • Client → device, one JSON object per text message:
+       {"c":"hello","sid":<31-bit session id>}          once per connection
+       {"s":<seq>,"c":"pwm","v":120}                    acked: device answers {"t":"ack","s":seq}
+                                                        (before hello: {"t":"err","s":seq,"err":"need hello"})
+       {"c":"pwm","v":121}                              fire-and-forget (no "s", no reply)
+     c = toggle | pwm | bpm | mode | press | pressBeat | flow; v is required except for toggle.
+   • seq counts up from 1 per session, not per connection. After a reconnect the client sends
+     hello again, learns the last seq the device applied ({"t":"hello","last":n}) and replays
+     only its unacked messages after that. CtlSessions::accept() refuses anything at or below
+     the last applied seq, so a replayed toggle never flips twice; the duplicate is still acked.
+   • Fire-and-forget carries absolute setpoints only (slider drags), so losing one is harmless
+     and applying one twice is too.
+   • Pure logic (no Arduino/FreeRTOS) so it builds in host tests.
+   ==========================================================================================*/
+
+static constexpr uint8_t CTL_MSG_MAX  = 128;      // bytes per message
+static constexpr uint8_t CTL_SESSIONS = 8;        // remembered sessions (least recently used evicted)
+
+enum CtlOp : uint8_t { CTL_NONE, CTL_HELLO, CTL_TOGGLE, CTL_PWM, CTL_BPM, CTL_MODE, CTL_PRESS, CTL_PRESS_BEAT, CTL_FLOW };
+enum CtlErr : uint8_t { CTL_OK, CTL_BAD_JSON, CTL_BAD_OP, CTL_NEED_VALUE, CTL_BAD_SEQ };
+
+struct CtlMsg {
+  CtlOp    op = CTL_NONE;
+  bool     hasSeq = false;        // false: fire-and-forget
+  uint32_t seq = 0;
+  float    v = 0;
+  uint32_t sid = 0;               // CTL_HELLO only
+};
+
+CtlErr      ctl_parse(const char* p, size_t n, CtlMsg& m);
+const char* ctl_err_name(CtlErr e);
+
+class CtlSessions {
+public:
+  uint32_t hello(uint32_t sid, uint32_t now);                  // last applied seq (0 = none yet)
+  bool     accept(uint32_t sid, uint32_t seq, uint32_t now);   // true: new, now recorded as applied
+private:
+  struct Session { uint32_t sid = 0, last = 0, usedAt = 0; };
+  Session* find(uint32_t sid);
+  Session s_[CTL_SESSIONS];
+};
@@ -0,0 +1,83 @@
+#include "ctlmsg.h"
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
+#include "jsonio.h"
+
+struct CtlBody { int32_t s, sid; float v; char c[12]; };
+static const JsonField CTL_FIELDS[] = {
+  { "s", JK_INT, offsetof(CtlBody, s), 0 }, { "sid", JK_INT, offsetof(CtlBody, sid), 0 },
+  { "v", JK_FLOAT, offsetof(CtlBody, v), 0 }, { "c", JK_STR, offsetof(CtlBody, c), sizeof(CtlBody::c) },
+};
+enum : uint32_t { F_S = 1, F_SID = 2, F_V = 4, F_C = 8 };
+
+static const struct { const char* name; CtlOp op; } CTL_OPS[] = {
+  { "hello", CTL_HELLO }, { "toggle", CTL_TOGGLE }, { "pwm", CTL_PWM }, { "bpm", CTL_BPM }, { "mode", CTL_MODE },
+  { "press", CTL_PRESS }, { "pressBeat", CTL_PRESS_BEAT }, { "flow", CTL_FLOW },
+};
+
+CtlErr ctl_parse(const char* p, size_t n, CtlMsg& m){
+  m = CtlMsg{};
+  if (n > CTL_MSG_MAX) return CTL_BAD_JSON;
+  CtlBody b{};
+  JsonBind bind{ CTL_FIELDS, 4, &b, 0, 0, 0 };
+  if (json_bind(bind, p, n) != JSON_DONE || bind.bad) return CTL_BAD_JSON;
+  if (!(bind.seen & F_C)) return CTL_BAD_OP;
+  for (const auto& o : CTL_OPS) if (strcmp(o.name, b.c) == 0) m.op = o.op;
+  if (m.op == CTL_NONE) return CTL_BAD_OP;
+  if (bind.seen & F_S){
+    if (b.s <= 0) return CTL_BAD_SEQ;
+    m.hasSeq = true; m.seq = (uint32_t)b.s;
+  }
+  if (m.op == CTL_HELLO){
+    if (!(bind.seen & F_SID) || b.sid <= 0) return CTL_NEED_VALUE;
+    m.sid = (uint32_t)b.sid;
+    return CTL_OK;
+  }
+  if (m.op == CTL_TOGGLE){
+    if (!m.hasSeq) return CTL_BAD_SEQ;             // not idempotent: must be acked and deduplicated
+    return CTL_OK;
+  }
+  if (!(bind.seen & F_V) || !isfinite(b.v)) return CTL_NEED_VALUE;
+  m.v = b.v;
+  return CTL_OK;
+}
+
+const char* ctl_err_name(CtlErr e){
+  switch (e){
+    case CTL_OK:         return "ok";
+    case CTL_BAD_JSON:   return "bad json";
+    case CTL_BAD_OP:     return "unknown c";
+    case CTL_NEED_VALUE: return "missing value";
+    case CTL_BAD_SEQ:    return "bad or missing s";
+  }
+  return "?";
+}
+
+CtlSessions::Session* CtlSessions::find(uint32_t sid){
+  for (Session& s : s_) if (s.sid == sid) return &s;
+  return nullptr;
+}
+
+uint32_t CtlSessions::hello(uint32_t sid, uint32_t now){
+  Session* s = find(sid);
+  if (!s){
+    s = &s_[0];                                    // free slot, else least recently used
+    for (Session& x : s_){
+      if (!x.sid){ s = &x; break; }
+      if ((int32_t)(x.usedAt - s->usedAt) < 0) s = &x;
+    }
+    *s = Session{ sid, 0, now };
+  }
+  s->usedAt = now;
+  return s->last;
+}
+
+bool CtlSessions::accept(uint32_t sid, uint32_t seq, uint32_t now){
+  Session* s = find(sid);
+  if (!s){ hello(sid, now); s = find(sid); }
+  s->usedAt = now;
+  if ((int32_t)(seq - s->last) <= 0) return false;
+  s->last = seq;
+  return true;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <stdint.h>
+
+/* ==========================================================================================
+   dsp.h — Fixed-size real FFT, Hann-windowed spectra and Goertzel harmonic trackers
+   ------------------------------------------------------------------------------------------
+   • RealFft: SPEC_N-point real transform computed as an SPEC_N/2-point complex radix-2 FFT
+     plus the usual split step. Twiddle, bit-reverse and window tables are built once.
+   • SpecChannel: sliding sample window; every SPEC_HOP samples it yields a Hann-windowed
+     amplitude spectrum (bin k = k·fs/SPEC_N, scaled so a tone of amplitude A reads ≈ A).
+   • GoertzelBank: DFT at h·f0 (h = 1..SPEC_HARMONICS) over blocks of exactly one f0 period,
+     so the harmonics fall on integer bins without windowing. O(SPEC_HARMONICS) per sample.
+   • Pure logic (no Arduino/FreeRTOS) so it also builds in host tests and benchmarks.
+   ==========================================================================================*/
+
+static constexpr uint16_t SPEC_N         = 512;            // 0.85 s at 600 Hz, 1.17 Hz bins
+static constexpr uint16_t SPEC_BINS      = SPEC_N / 2 + 1;
+static constexpr uint16_t SPEC_HOP       = SPEC_N / 2;     // 50% overlap
+static constexpr uint8_t  SPEC_HARMONICS = 6;
+
+class RealFft {
+public:
+  RealFft();
+  // x: SPEC_N samples (already windowed). Writes |X[k]| for k = 0..SPEC_N/2.
+  void magnitude(const float* x, float* mag);
+  const float* hann() const { return win_; }
+  float hannSum() const { return winSum_; }
+
+private:
+  static constexpr uint16_t M = SPEC_N / 2;       // complex length
+  float    cos_[M], sin_[M];                      // e^{-2πik/SPEC_N}, k < M
+  uint16_t rev_[M];
+  float    re_[M], im_[M];
+  float    win_[SPEC_N];
+  float    winSum_ = 0;
+};
+
+class SpecChannel {
+public:
+  bool push(float x);                              // true when a new frame is due
+  void frame(RealFft& fft, float* mag);            // amplitude spectrum of the last SPEC_N samples
+private:
+  float    buf_[SPEC_N]{};
+  float    tmp_[SPEC_N];
+  uint16_t head_ = 0, hop_ = 0;
+  uint32_t n_ = 0;
+};
+
+class GoertzelBank {
+public:
+  void  setPeriod(uint32_t samples);              // one fundamental period (≥ 2·SPEC_HARMONICS)
+  uint32_t period() const { return len_; }
+  bool  push(float x);                            // true when a block completed
+  float amplitude(uint8_t h) const { return amp_[h-1]; }   // h = 1..SPEC_HARMONICS, last block
+  float ratio(uint8_t h) const { return amp_[0] > 0 ? amp_[h-1] / amp_[0] : 0; }
+  float thd() const;                              // sqrt(Σ_{h≥2} A_h²) / A_1
+
+private:
+  uint32_t len_ = 0, n_ = 0;
+  float    coef_[SPEC_HARMONICS]{}, s1_[SPEC_HARMONICS]{}, s2_[SPEC_HARMONICS]{};
+  float    amp_[SPEC_HARMONICS]{};
+};
@@ -0,0 +1,97 @@
+#include "dsp.h"
+#include <math.h>
+
+static constexpr float TWO_PI = 6.28318530718f;
+
+RealFft::RealFft(){
+  for (uint16_t k = 0; k < M; k++){
+    cos_[k] =  cosf(TWO_PI * k / SPEC_N);
+    sin_[k] = -sinf(TWO_PI * k / SPEC_N);
+  }
+  uint16_t bits = 0; while ((1u << bits) < M) bits++;
+  for (uint16_t i = 0; i < M; i++){
+    uint16_t r = 0; for (uint16_t b = 0; b < bits; b++) if (i & (1u << b)) r |= 1u << (bits - 1 - b);
+    rev_[i] = r;
+  }
+  winSum_ = 0;
+  for (uint16_t i = 0; i < SPEC_N; i++){ win_[i] = 0.5f - 0.5f * cosf(TWO_PI * i / SPEC_N); winSum_ += win_[i]; }
+}
+
+void RealFft::magnitude(const float* x, float* mag){
+  // pack even/odd samples as one complex sequence, bit-reversed
+  for (uint16_t i = 0; i < M; i++){ re_[rev_[i]] = x[2*i]; im_[rev_[i]] = x[2*i+1]; }
+  // radix-2 DIT; the M-point twiddle W_M^j is W_N^{2j}
+  for (uint16_t len = 2; len <= M; len <<= 1){
+    uint16_t half = len >> 1, step = (uint16_t)(SPEC_N / len);
+    for (uint16_t i = 0; i < M; i += len){
+      for (uint16_t j = 0; j < half; j++){
+        float wr = cos_[j*step], wi = sin_[j*step];
+        uint16_t a = i + j, b = a + half;
+        float tr = re_[b]*wr - im_[b]*wi, ti = re_[b]*wi + im_[b]*wr;
+        re_[b] = re_[a] - tr; im_[b] = im_[a] - ti;
+        re_[a] += tr;         im_[a] += ti;
+      }
+    }
+  }
+  // split: X[k] = E[k] + W^k·O[k], E = (Z[k] + Z*[M−k])/2, O = (Z[k] − Z*[M−k])/2i
+  mag[0] = fabsf(re_[0] + im_[0]);
+  mag[M] = fabsf(re_[0] - im_[0]);
+  for (uint16_t k = 1; k < M; k++){
+    float zr = re_[k], zi = im_[k], cr = re_[M-k], ci = -im_[M-k];
+    float er = 0.5f*(zr + cr), ei = 0.5f*(zi + ci);
+    float dr = zr - cr, di = zi - ci;             // O·2i = d  →  O = (di, −dr)/2
+    float orr = 0.5f*di, oi = -0.5f*dr;
+    float xr = er + orr*cos_[k] - oi*sin_[k];
+    float xi = ei + orr*sin_[k] + oi*cos_[k];
+    mag[k] = sqrtf(xr*xr + xi*xi);
+  }
+}
+
+bool SpecChannel::push(float x){
+  buf_[head_] = x; head_ = (head_ + 1) % SPEC_N;
+  if (n_ < SPEC_N){ n_++; if (n_ < SPEC_N) return false; hop_ = 0; return true; }
+  if (++hop_ < SPEC_HOP) return false;
+  hop_ = 0; return true;
+}
+
+void SpecChannel::frame(RealFft& fft, float* mag){
+  const float* w = fft.hann();
+  for (uint16_t i = 0; i < SPEC_N; i++) tmp_[i] = buf_[(head_ + i) % SPEC_N] * w[i];   // oldest first
+  fft.magnitude(tmp_, mag);
+  float s = 2.0f / fft.hannSum();                  // one-sided amplitude, Hann coherent gain
+  mag[0] *= 0.5f * s;
+  for (uint16_t k = 1; k < SPEC_BINS - 1; k++) mag[k] *= s;
+  mag[SPEC_BINS-1] *= 0.5f * s;
+}
+
+void GoertzelBank::setPeriod(uint32_t samples){
+  if (samples < 2u * SPEC_HARMONICS) samples = 2u * SPEC_HARMONICS;
+  if (samples == len_) return;
+  len_ = samples; n_ = 0;
+  for (uint8_t h = 0; h < SPEC_HARMONICS; h++){
+    coef_[h] = 2.0f * cosf(TWO_PI * (h + 1) / len_);
+    s1_[h] = s2_[h] = 0;
+  }
+}
+
+bool GoertzelBank::push(float x){
+  if (!len_) return false;
+  for (uint8_t h = 0; h < SPEC_HARMONICS; h++){
+    float s0 = x + coef_[h]*s1_[h] - s2_[h];
+    s2_[h] = s1_[h]; s1_[h] = s0;
+  }
+  if (++n_ < len_) return false;
+  for (uint8_t h = 0; h < SPEC_HARMONICS; h++){
+    float p = s1_[h]*s1_[h] + s2_[h]*s2_[h] - coef_[h]*s1_[h]*s2_[h];
+    amp_[h] = 2.0f * sqrtf(p > 0 ? p : 0) / len_;
+    s1_[h] = s2_[h] = 0;
+  }
+  n_ = 0;
+  return true;
+}
+
+float GoertzelBank::thd() const {
+  if (amp_[0] <= 0) return 0;
+  float s = 0; for (uint8_t h = 1; h < SPEC_HARMONICS; h++) s += amp_[h]*amp_[h];
+  return sqrtf(s) / amp_[0];
+}
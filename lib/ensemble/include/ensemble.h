@@ -0,0 +1,37 @@
+#pragma once
+#include <stdint.h>
+
+/* ==========================================================================================
+   ensemble.h — Beat-synchronous ensemble-averaged waveform templates
+   ------------------------------------------------------------------------------------------
+   • Samples are binned by beat phase measured from the FWD→REV valve flip (bin 0 = flip),
+     so templates line up even when the split or BPM changes.
+   • Each bin keeps an exponentially weighted mean and variance per channel, updated in O(1)
+     per sample (no per-beat pass, no allocation):
+         d = x − m;  m += α·d;  v = (1 − α)·(v + α·d²)
+   • α per sample is derived from a memory in beats and the samples a bin gets per beat, so
+     the forgetting is the same at any BPM. Needs ≥ ENS_BINS ticks per beat.
+   • Pure logic (no Arduino/FreeRTOS) so it also builds in host tests.
+   ==========================================================================================*/
+
+static constexpr uint8_t ENS_BITS = 7;
+static constexpr uint8_t ENS_BINS = 1u << ENS_BITS;
+static constexpr uint8_t ENS_CH   = 3;           // atrium, ventricle, flow
+
+class EnsembleAvg {
+public:
+  // memoryBeats ≈ 1/α per beat; ticksPerBeat from the live beat table
+  void     configure(float memoryBeats, float ticksPerBeat);
+  void     reset();
+  void     sample(uint32_t phaseFromFlip, const float* x);     // x[ENS_CH]
+  float    mean(uint8_t ch, uint8_t bin) const { return m_[ch][bin]; }
+  float    var(uint8_t ch, uint8_t bin) const { return v_[ch][bin]; }
+  uint16_t count(uint8_t bin) const { return n_[bin]; }         // samples seen (saturating)
+  float    alpha() const { return a_; }
+
+private:
+  float    a_ = 0.01f;
+  float    m_[ENS_CH][ENS_BINS]{};
+  float    v_[ENS_CH][ENS_BINS]{};
+  uint16_t n_[ENS_BINS]{};
+};
@@ -0,0 +1,30 @@
+#include "ensemble.h"
+
+void EnsembleAvg::configure(float memoryBeats, float ticksPerBeat){
+  float perBin = ticksPerBeat / ENS_BINS; if (perBin < 1.0f) perBin = 1.0f;
+  float n = memoryBeats * perBin;         if (n < 1.0f) n = 1.0f;
+  a_ = 1.0f / n;
+}
+
+void EnsembleAvg::reset(){
+  for (uint8_t b = 0; b < ENS_BINS; b++){
+    n_[b] = 0;
+    for (uint8_t c = 0; c < ENS_CH; c++){ m_[c][b] = 0; v_[c][b] = 0; }
+  }
+}
+
+void EnsembleAvg::sample(uint32_t phase, const float* x){
+  uint8_t b = phase >> (32 - ENS_BITS);
+  if (!n_[b]){                            // first visit: start from the sample itself
+    for (uint8_t c = 0; c < ENS_CH; c++){ m_[c][b] = x[c]; v_[c][b] = 0; }
+    n_[b] = 1; return;
+  }
+  if (n_[b] != 0xFFFF) n_[b]++;
+  // early samples use 1/n so a fresh template is a plain average until α takes over
+  float a = (n_[b] * a_ < 1.0f) ? 1.0f / n_[b] : a_;
+  for (uint8_t c = 0; c < ENS_CH; c++){
+    float d = x[c] - m_[c][b];
+    m_[c][b] += a * d;
+    v_[c][b] = (1.0f - a) * (v_[c][b] + a * d * d);
+  }
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <Arduino.h>
+#include <atomic>
 
 /* ==========================================================================================
    flow.h — Flow pulse counting
@@ -9,3 +10,10 @@
    ==========================================================================================*/
 
 void flow_begin();          // attach ISR, start background computation task on Core 1
+
+// ---- Counters (ISR writes, relaxed; read by /metrics on Core 0) ----
+struct FlowCounters {
+  std::atomic<uint32_t> edgesAccepted{0};  // edges counted by flow_isr
+  std::atomic<uint32_t> edgesRejected{0};  // edges dropped by the 50 µs deglitch
+};
+extern FlowCounters flow_ctr;
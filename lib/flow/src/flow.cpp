@@ -2,6 +2,8 @@
 #include "shared.h"
 #include "app_config.h"
 
+FlowCounters flow_ctr;
+
 static volatile uint32_t s_edges = 0;
 static volatile uint32_t s_lastIsrUs = 0;
 
@@ -11,6 +13,9 @@ static void IRAM_ATTR flow_isr(){
   if ((now - s_lastIsrUs) >= 50){
     s_edges++;
     s_lastIsrUs = now;
+    flow_ctr.edgesAccepted.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    flow_ctr.edgesRejected.fetch_add(1, std::memory_order_relaxed);
   }
 }
 
@@ -32,7 +37,8 @@ static void flow_task(void*){
       G.flow_hz.store(hz, std::memory_order_relaxed);
 
       // L/min = m*Hz + b (runtime cal)
-      float lpm = G.flow_m.load()*hz + G.flow_b.load();
+      CfgProfile cal; G.cal.read(cal);
+      float lpm = cal.flow.m*hz + cal.flow.b;
       if (lpm < 0) lpm = 0;
       G.flow_L_min.store(lpm, std::memory_order_relaxed);
 
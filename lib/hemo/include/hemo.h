@@ -0,0 +1,96 @@
+#pragma once
+#include <stdint.h>
+
+/* ==========================================================================================
+   hemo.h — Per-beat hemodynamic analytics
+   ------------------------------------------------------------------------------------------
+   • BeatAnalyzer is fed every control-tick sample of the ventricular pressure and closed at
+     each beat boundary (the caller syncs to the beat phase wrap). It reports systolic (max),
+     diastolic (min), mean (time average), pulse pressure and the steepest rise dP/dt taken
+     over HEMO_DPDT_TICKS ticks to stay above the ADC noise.
+   • BeatRing keeps the last N results with a running sequence number so consumers can ask
+     for "everything after seq" (stream events) or "the last n" (REST).
+   • FlowTotalizer integrates the flow sensor's exact edge count per control tick, split by
+     the valve direction active when the edges arrived. Counts stay integers; volume is
+     derived on demand from the flow calibration (L/min = m·Hz + b), with the offset b only
+     integrated while pulses are arriving so a stopped pump accumulates nothing. Beats (or
+     fixed slices outside BEAT mode) close segments that feed stroke volume and a rolling
+     cardiac output over the last HEMO_CO_SEGS segments.
+   • Pure logic (no Arduino/FreeRTOS) so it also builds in host tests.
+   ==========================================================================================*/
+
+static constexpr uint8_t HEMO_DPDT_TICKS = 3;
+static constexpr uint8_t HEMO_CO_SEGS = 8;
+
+struct BeatStats {
+  uint32_t seq = 0;          // 1-based, increments per completed beat
+  uint32_t tMs = 0;          // time the beat closed
+  float    periodMs = 0;
+  float    sys = 0, dia = 0, map = 0, pp = 0;   // mmHg
+  float    dpdtMax = 0;      // mmHg/s
+  float    svMl = 0;         // net stroke volume (forward − reverse)
+  float    fwdMl = 0, revMl = 0;
+  float    coLpm = 0;        // rolling cardiac output at the end of this beat
+};
+
+class BeatAnalyzer {
+public:
+  void begin(uint32_t hz) { hz_ = hz; clear(); }
+  void clear();                                  // drop a partial beat (keeps dP/dt history)
+  void sample(float mmHg);
+  bool endBeat(uint32_t nowMs, BeatStats& out);  // false if the beat had < 2 samples
+
+private:
+  uint32_t hz_ = 600, n_ = 0, seq_ = 0;
+  float    sum_ = 0, max_ = 0, min_ = 0, dmax_ = 0;
+  float    hist_[HEMO_DPDT_TICKS + 1]{};
+  uint8_t  hIdx_ = 0, hN_ = 0;
+};
+
+struct FlowCal { float m = 0, b = 0; };                 // L/min = m·Hz + b, Hz = pulses/s
+
+struct VolumeSeg { float fwdMl = 0, revMl = 0, netMl = 0, periodS = 0; };
+
+class FlowTotalizer {
+public:
+  // edgesPerPulse: 2 when both edges are counted; holdTicks: how long after an edge the
+  // flow still counts as "present" for the offset term (the Hz estimator's longest window)
+  void begin(uint32_t hz, uint8_t edgesPerPulse, uint32_t holdTicks);
+  void reset();                                   // zero totals, the open segment and the CO window
+  void restartSegment();                          // drop a partial beat (totals keep its counts)
+  void sample(uint32_t edgeCount, uint8_t dir);   // cumulative edge counter; dir 0 = FWD, 1 = REV
+  VolumeSeg endSegment(const FlowCal& c);         // close a beat/slice and push it into the CO window
+  float    totalMl(uint8_t dir, const FlowCal& c) const;
+  float    netMl(const FlowCal& c) const { return totalMl(0, c) - totalMl(1, c); }
+  float    coLpm() const;                         // net L/min over the CO window
+  uint64_t edges(uint8_t dir) const { return totEdges_[dir & 1]; }
+  uint32_t segTicks() const { return segTicks_; }
+
+private:
+  float ml(uint64_t edges, uint64_t active, const FlowCal& c) const;
+  uint32_t hz_ = 600, hold_ = 100, sinceEdge_ = 0xFFFFFFFFu, last_ = 0, segTicks_ = 0;
+  uint8_t  epp_ = 2;
+  bool     primed_ = false;
+  uint64_t totEdges_[2]{}, totActive_[2]{};
+  uint32_t segEdges_[2]{}, segActive_[2]{};
+  float    coMl_[HEMO_CO_SEGS]{}, coS_[HEMO_CO_SEGS]{};
+  uint8_t  coIdx_ = 0, coN_ = 0;
+};
+
+template <uint8_t N>
+class BeatRing {
+public:
+  void push(const BeatStats& b){ buf_[head_] = b; head_ = (head_ + 1) % N; if (count_ < N) count_++; }
+  uint8_t size() const { return count_; }
+  uint32_t lastSeq() const { return count_ ? at(count_ - 1).seq : 0; }
+  const BeatStats& at(uint8_t i) const { return buf_[(head_ + N - count_ + i) % N]; }   // 0 = oldest
+  // Copy beats with seq > after (oldest first, at most max); returns the count
+  uint8_t since(uint32_t after, BeatStats* out, uint8_t max) const {
+    uint8_t k = 0;
+    for (uint8_t i = 0; i < count_ && k < max; i++) if (at(i).seq > after) out[k++] = at(i);
+    return k;
+  }
+private:
+  BeatStats buf_[N];
+  uint8_t head_ = 0, count_ = 0;
+};
@@ -0,0 +1,85 @@
+#include "hemo.h"
+
+void BeatAnalyzer::clear(){
+  n_ = 0; sum_ = 0; dmax_ = 0;
+}
+
+void BeatAnalyzer::sample(float p){
+  if (!n_){ max_ = p; min_ = p; }
+  if (p > max_) max_ = p;
+  if (p < min_) min_ = p;
+  sum_ += p; n_++;
+  // dP/dt over HEMO_DPDT_TICKS: compare with the sample that many ticks ago
+  hist_[hIdx_] = p; hIdx_ = (hIdx_ + 1) % (HEMO_DPDT_TICKS + 1);
+  if (hN_ < HEMO_DPDT_TICKS + 1){ hN_++; if (hN_ <= HEMO_DPDT_TICKS) return; }
+  float d = (p - hist_[hIdx_]) * hz_ / HEMO_DPDT_TICKS;        // hIdx_ now holds the oldest
+  if (d > dmax_) dmax_ = d;
+}
+
+bool BeatAnalyzer::endBeat(uint32_t nowMs, BeatStats& out){
+  bool ok = n_ >= 2;
+  if (ok){
+    out.seq = ++seq_; out.tMs = nowMs;
+    out.periodMs = n_ * 1000.0f / hz_;
+    out.sys = max_; out.dia = min_; out.map = sum_ / n_; out.pp = max_ - min_;
+    out.dpdtMax = dmax_;
+  }
+  clear();
+  return ok;
+}
+
+void FlowTotalizer::begin(uint32_t hz, uint8_t edgesPerPulse, uint32_t holdTicks){
+  hz_ = hz; epp_ = edgesPerPulse ? edgesPerPulse : 1; hold_ = holdTicks;
+  primed_ = false; reset();
+}
+
+void FlowTotalizer::reset(){
+  for (uint8_t d = 0; d < 2; d++){ totEdges_[d] = 0; totActive_[d] = 0; }
+  coIdx_ = 0; coN_ = 0; restartSegment();
+}
+
+void FlowTotalizer::restartSegment(){
+  for (uint8_t d = 0; d < 2; d++){ segEdges_[d] = 0; segActive_[d] = 0; }
+  segTicks_ = 0;
+}
+
+void FlowTotalizer::sample(uint32_t edgeCount, uint8_t dir){
+  dir &= 1;
+  uint32_t e = primed_ ? edgeCount - last_ : 0;     // unsigned difference survives counter wrap
+  last_ = edgeCount; primed_ = true;
+  if (e){ sinceEdge_ = 0; totEdges_[dir] += e; segEdges_[dir] += e; }
+  else if (sinceEdge_ != 0xFFFFFFFFu) sinceEdge_++;
+  if (sinceEdge_ <= hold_){ totActive_[dir]++; segActive_[dir]++; }
+  segTicks_++;
+}
+
+float FlowTotalizer::ml(uint64_t edges, uint64_t active, const FlowCal& c) const {
+  // ∫(m·Hz + b) dt = m·pulses + b·t  [L·min/min·s] → /60 s/min × 1000 mL/L
+  float l = (c.m * ((float)edges / epp_) + c.b * ((float)active / hz_)) / 60.0f;
+  return l > 0 ? l * 1000.0f : 0.0f;
+}
+
+float FlowTotalizer::totalMl(uint8_t dir, const FlowCal& c) const {
+  dir &= 1;
+  return ml(totEdges_[dir], totActive_[dir], c);
+}
+
+VolumeSeg FlowTotalizer::endSegment(const FlowCal& c){
+  VolumeSeg v;
+  v.fwdMl = ml(segEdges_[0], segActive_[0], c);
+  v.revMl = ml(segEdges_[1], segActive_[1], c);
+  v.netMl = v.fwdMl - v.revMl;
+  v.periodS = (float)segTicks_ / hz_;
+  if (segTicks_){
+    coMl_[coIdx_] = v.netMl; coS_[coIdx_] = v.periodS;
+    coIdx_ = (coIdx_ + 1) % HEMO_CO_SEGS; if (coN_ < HEMO_CO_SEGS) coN_++;
+  }
+  restartSegment();
+  return v;
+}
+
+float FlowTotalizer::coLpm() const {
+  float mlSum = 0, s = 0;
+  for (uint8_t i = 0; i < coN_; i++){ mlSum += coMl_[i]; s += coS_[i]; }
+  return s > 0 ? mlSum * 0.06f / s : 0.0f;        // mL/s → L/min
+}
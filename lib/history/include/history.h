@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+/* ==========================================================================================
+   history.h — Multi-resolution min/max history for long chart windows
+   ------------------------------------------------------------------------------------------
+   • Tier 0 keeps every control tick; each later tier keeps one min/max pair per HIST_DECIM[k]
+     entries of the tier before it (600 Hz × 5 s, 30 Hz × 60 s, 0.5 Hz × 1 h at 600 Hz).
+   • push() is O(channels) per tick: it writes tier 0 and folds the value into one running
+     min/max accumulator per later tier, which is written out when its bucket completes. All
+     storage is sized at compile time (~81 KB); the firmware puts its one History on the heap.
+   • query() picks the finest tier that covers the requested span and merges adjacent entries
+     so at most maxPoints min/max pairs come back, newest last.
+   • Single writer (control core), any number of readers. A reader snapshots the per-tier
+     write counters and never touches the HIST_GUARD oldest slots, which the writer may be
+     overwriting while the reader copies.
+   • Values are int16 in caller units (the caller picks the scale per channel).
+   • Pure logic (no Arduino/FreeRTOS) so it also builds in host tests.
+   ==========================================================================================*/
+
+static constexpr uint8_t  HIST_CH    = 4;
+static constexpr uint8_t  HIST_TIERS = 3;
+static constexpr uint16_t HIST_GUARD = 32;
+static constexpr uint16_t HIST_LEN[HIST_TIERS]   = { 3000 + HIST_GUARD, 1800 + HIST_GUARD, 1800 + HIST_GUARD };
+static constexpr uint16_t HIST_DECIM[HIST_TIERS] = { 1, 20, 60 };      // relative to the tier before
+
+struct HistPoint { int16_t lo, hi; };
+
+struct HistQuery {
+  uint8_t  tier = 0;
+  uint16_t n = 0;                // points written to out
+  uint32_t stepTicks = 0;        // ticks covered by each point
+  uint32_t endTick = 0;          // ticks pushed when the newest point closed
+};
+
+class History {
+public:
+  void reset();
+  void push(const int16_t v[HIST_CH]);
+  uint32_t ticks() const { return written_[0].load(std::memory_order_acquire); }
+  // Newest spanTicks of channel ch in at most maxPoints points (clipped to what is stored)
+  HistQuery query(uint8_t ch, uint32_t spanTicks, uint16_t maxPoints, HistPoint* out) const;
+
+  static uint32_t tierTicks(uint8_t k);                // control ticks per entry of tier k
+  static uint32_t tierSpanTicks(uint8_t k){ return tierTicks(k) * (HIST_LEN[k] - HIST_GUARD); }
+
+private:
+  HistPoint entry(uint8_t k, uint8_t ch, uint32_t idx) const;
+
+  int16_t   t0_[HIST_CH][HIST_LEN[0]];
+  HistPoint t1_[HIST_CH][HIST_LEN[1]];
+  HistPoint t2_[HIST_CH][HIST_LEN[2]];
+  HistPoint acc_[HIST_TIERS][HIST_CH];                  // bucket in progress, tiers 1..
+  uint16_t  accN_[HIST_TIERS] = {};
+  std::atomic<uint32_t> written_[HIST_TIERS] = {};      // entries ever written per tier
+};
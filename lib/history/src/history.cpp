@@ -0,0 +1,83 @@
+#include "history.h"
+
+static_assert(HIST_TIERS == 3, "storage below is laid out for three tiers");
+
+uint32_t History::tierTicks(uint8_t k){
+  uint32_t t = 1;
+  for (uint8_t i=0;i<=k;i++) t *= HIST_DECIM[i];
+  return t;
+}
+
+void History::reset(){
+  for (uint8_t k=0;k<HIST_TIERS;k++){ accN_[k] = 0; written_[k].store(0, std::memory_order_release); }
+}
+
+void History::push(const int16_t v[HIST_CH]){
+  uint32_t w = written_[0].load(std::memory_order_relaxed);
+  const uint16_t i0 = w % HIST_LEN[0];
+  for (uint8_t c=0;c<HIST_CH;c++) t0_[c][i0] = v[c];
+  written_[0].store(w + 1, std::memory_order_release);
+
+  // fold into tier 1, and tier 1's completed bucket into tier 2
+  for (uint8_t c=0;c<HIST_CH;c++){
+    HistPoint& a = acc_[1][c];
+    if (accN_[1] == 0) a = HistPoint{ v[c], v[c] };
+    else { if (v[c] < a.lo) a.lo = v[c]; if (v[c] > a.hi) a.hi = v[c]; }
+  }
+  if (++accN_[1] < HIST_DECIM[1]) return;
+  accN_[1] = 0;
+  w = written_[1].load(std::memory_order_relaxed);
+  const uint16_t i1 = w % HIST_LEN[1];
+  for (uint8_t c=0;c<HIST_CH;c++){
+    const HistPoint p = acc_[1][c];
+    t1_[c][i1] = p;
+    HistPoint& a = acc_[2][c];
+    if (accN_[2] == 0) a = p;
+    else { if (p.lo < a.lo) a.lo = p.lo; if (p.hi > a.hi) a.hi = p.hi; }
+  }
+  written_[1].store(w + 1, std::memory_order_release);
+  if (++accN_[2] < HIST_DECIM[2]) return;
+  accN_[2] = 0;
+  w = written_[2].load(std::memory_order_relaxed);
+  const uint16_t i2 = w % HIST_LEN[2];
+  for (uint8_t c=0;c<HIST_CH;c++) t2_[c][i2] = acc_[2][c];
+  written_[2].store(w + 1, std::memory_order_release);
+}
+
+HistPoint History::entry(uint8_t k, uint8_t ch, uint32_t idx) const {
+  const uint16_t i = idx % HIST_LEN[k];
+  if (k == 0) return HistPoint{ t0_[ch][i], t0_[ch][i] };
+  return k == 1 ? t1_[ch][i] : t2_[ch][i];
+}
+
+HistQuery History::query(uint8_t ch, uint32_t spanTicks, uint16_t maxPoints, HistPoint* out) const {
+  HistQuery q;
+  if (ch >= HIST_CH || maxPoints == 0 || spanTicks == 0) return q;
+  uint8_t k = 0;
+  while (k + 1 < HIST_TIERS && tierSpanTicks(k) < spanTicks) k++;
+  const uint32_t tt = tierTicks(k);
+  const uint32_t w = written_[k].load(std::memory_order_acquire);
+  uint32_t avail = w < (uint32_t)(HIST_LEN[k] - HIST_GUARD) ? w : (uint32_t)(HIST_LEN[k] - HIST_GUARD);
+  uint32_t want = (spanTicks + tt - 1) / tt;
+  if (want > avail) want = avail;
+  q.tier = k; q.endTick = w * tt;
+  if (want == 0) return q;
+
+  // group from the newest entry back so the newest point is always a full bucket
+  const uint32_t per = (want + maxPoints - 1) / maxPoints;
+  const uint16_t n = (uint16_t)((want + per - 1) / per);
+  const uint32_t first = w - want;                       // oldest entry index used
+  for (uint16_t p=0;p<n;p++){
+    const uint32_t hiIdx = w - (uint32_t)(n - 1 - p) * per;     // one past this point's newest entry
+    const uint32_t loIdx = hiIdx < first + per ? first : hiIdx - per;
+    HistPoint m = entry(k, ch, loIdx);
+    for (uint32_t i = loIdx + 1; i < hiIdx; i++){
+      const HistPoint e = entry(k, ch, i);
+      if (e.lo < m.lo) m.lo = e.lo;
+      if (e.hi > m.hi) m.hi = e.hi;
+    }
+    out[p] = m;
+  }
+  q.n = n; q.stepTicks = per * tt;
+  return q;
+}
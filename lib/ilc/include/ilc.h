@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+#include "beat.h"
+
+/* ==========================================================================================
+   ilc.h — Iterative learning control of the beat pressure waveform
+   ------------------------------------------------------------------------------------------
+   • One beat is split into ILC_BINS phase bins (top bits of the beat phase accumulator).
+   • Each tick sample() accumulates the measured vent pressure into its bin; at the beat wrap
+     endBeat() forms e[b] = target[b] − mean[b] and updates the per-bin PWM correction
+         u[b] ← (1 − forget)·Q(u[b] + sign[b]·gain·e[b + lead])
+     where lead compensates the plant lag, Q is a 1-2-1 smoothing filter and sign is +1 on
+     FWD bins, −1 on REV bins (more drive in REV lowers the pressure).
+   • Bins not fully powered (dead time around the flips) are masked: no correction there.
+   • Corrections are int16 Q4 PWM counts; correction() interpolates between bin centres.
+   • Pure logic (no Arduino/FreeRTOS) so it also builds in host tests.
+   ==========================================================================================*/
+
+static constexpr uint8_t ILC_BITS = 6;
+static constexpr uint8_t ILC_BINS = 1u << ILC_BITS;
+
+struct IlcConfig {
+  float   gain;      // PWM counts per mmHg of error, per beat
+  float   forget;    // 0..1 leak per beat (robustness against non-repeating disturbances)
+  float   leadMs;    // error look-ahead ≈ plant delay
+  int16_t limit;     // |correction| in PWM counts
+};
+
+class IlcTable {
+public:
+  void    configure(const IlcConfig& c) { cfg_ = c; }
+  void    setTarget(const float* mmHg);                // ILC_BINS values
+  bool    hasTarget() const { return hasTarget_; }
+  void    setBeat(const BeatTable& t, uint32_t hz);    // mask, signs and lead for the live table
+  void    reset();                                     // clear corrections and accumulators
+  void    clearBeat();                                 // drop a partial beat (restart mid-cycle)
+  void    sample(uint32_t phase, float mmHg);
+  bool    endBeat();                                   // false if the beat was incomplete
+  int16_t correction(uint32_t phase) const;            // PWM counts
+  float   rms() const { return rms_; }                 // of the last complete beat's error
+  uint32_t beats() const { return beats_; }
+  float   binCorrection(uint8_t b) const { return corr_[b] / 16.0f; }
+  float   binTarget(uint8_t b) const { return target_[b]; }
+
+private:
+  IlcConfig cfg_{ 0.3f, 0.002f, 40.0f, 96 };
+  float    target_[ILC_BINS]{};
+  float    sum_[ILC_BINS]{};
+  uint16_t n_[ILC_BINS]{};
+  int16_t  corr_[ILC_BINS]{};      // Q4
+  int8_t   sign_[ILC_BINS]{};      // 0 = masked
+  uint8_t  lead_ = 0;
+  bool     hasTarget_ = false;
+  float    rms_ = 0;
+  uint32_t beats_ = 0;
+};
+
+// Resample n points spread over one beat (n ≥ 2) into ILC_BINS bin-centre targets
+void ilc_resample(const float* pts, uint8_t n, float* out);
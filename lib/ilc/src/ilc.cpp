@@ -0,0 +1,84 @@
+#include "ilc.h"
+#include <math.h>
+
+static constexpr uint32_t BIN_SHIFT = 32 - ILC_BITS;
+
+void ilc_resample(const float* pts, uint8_t n, float* out){
+  for (uint8_t b = 0; b < ILC_BINS; b++){
+    float f = (b + 0.5f) / ILC_BINS * (n - 1);
+    uint8_t i = (uint8_t)f; if (i >= n - 1){ out[b] = pts[n-1]; continue; }
+    float w = f - i;
+    out[b] = pts[i] * (1.0f - w) + pts[i+1] * w;
+  }
+}
+
+void IlcTable::setTarget(const float* mmHg){
+  for (uint8_t b = 0; b < ILC_BINS; b++) target_[b] = mmHg[b];
+  hasTarget_ = true;
+}
+
+void IlcTable::setBeat(const BeatTable& t, uint32_t hz){
+  const uint16_t per = BEAT_TABLE_N / ILC_BINS;
+  for (uint8_t b = 0; b < ILC_BINS; b++){
+    bool powered = true;
+    for (uint16_t k = 0; k < per; k++) if (!t.step[b*per + k].level){ powered = false; break; }
+    sign_[b] = !powered ? 0 : (t.step[b*per].valve ? -1 : 1);
+    if (!powered) corr_[b] = 0;
+  }
+  float periodMs = t.inc ? 4294967296.0f / t.inc * 1000.0f / hz : 1000.0f;
+  float lead = cfg_.leadMs * ILC_BINS / periodMs + 0.5f;
+  lead_ = (uint8_t)(lead > ILC_BINS / 4 ? ILC_BINS / 4 : lead);
+}
+
+void IlcTable::reset(){
+  for (uint8_t b = 0; b < ILC_BINS; b++) corr_[b] = 0;
+  clearBeat(); rms_ = 0; beats_ = 0;
+}
+
+void IlcTable::clearBeat(){
+  for (uint8_t b = 0; b < ILC_BINS; b++){ sum_[b] = 0; n_[b] = 0; }
+}
+
+void IlcTable::sample(uint32_t phase, float mmHg){
+  uint8_t b = phase >> BIN_SHIFT;
+  sum_[b] += mmHg; n_[b]++;
+}
+
+bool IlcTable::endBeat(){
+  float e[ILC_BINS]; bool complete = true; float ss = 0;
+  for (uint8_t b = 0; b < ILC_BINS; b++){
+    if (!n_[b]){ complete = false; e[b] = 0; continue; }
+    e[b] = target_[b] - sum_[b] / n_[b];
+    ss += e[b] * e[b];
+  }
+  clearBeat();
+  if (!complete || !hasTarget_) return false;            // e.g. first beat after a restart
+  rms_ = sqrtf(ss / ILC_BINS); beats_++;
+
+  float u[ILC_BINS];
+  for (uint8_t b = 0; b < ILC_BINS; b++){
+    uint8_t src = (b + lead_) & (ILC_BINS - 1);
+    u[b] = corr_[b] / 16.0f + sign_[b] * cfg_.gain * e[src];
+  }
+  // Q filter: 1-2-1 within a powered span of the same sign (never across the dead time)
+  const float keep = 1.0f - cfg_.forget, lim = cfg_.limit;
+  for (uint8_t b = 0; b < ILC_BINS; b++){
+    if (!sign_[b]){ corr_[b] = 0; continue; }
+    uint8_t l = (b - 1) & (ILC_BINS - 1), r = (b + 1) & (ILC_BINS - 1);
+    float ul = sign_[l] == sign_[b] ? u[l] : u[b];
+    float ur = sign_[r] == sign_[b] ? u[r] : u[b];
+    float v = keep * 0.25f * (ul + 2.0f*u[b] + ur);
+    v = v > lim ? lim : (v < -lim ? -lim : v);
+    corr_[b] = (int16_t)lroundf(v * 16.0f);
+  }
+  return true;
+}
+
+int16_t IlcTable::correction(uint32_t phase) const {
+  // linear between bin centres; masked bins contribute 0 so edges taper into the dead time
+  uint32_t p = phase - (1u << (BIN_SHIFT - 1));
+  uint8_t  a = p >> BIN_SHIFT, b = (a + 1) & (ILC_BINS - 1);
+  int32_t  fr = (p >> (BIN_SHIFT - 8)) & 0xFF;
+  int32_t  v = corr_[a] + (((int32_t)(corr_[b] - corr_[a]) * fr) >> 8);   // Q4
+  return (int16_t)((v + (v >= 0 ? 8 : -8)) / 16);
+}
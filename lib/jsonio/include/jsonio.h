@@ -0,0 +1,136 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/* ==========================================================================================
+   jsonio.h — Streaming JSON reader and fixed-buffer JSON writer (no heap)
+   ------------------------------------------------------------------------------------------
+   • JsonReader is a push parser: feed() it body chunks as they arrive (any split, even inside
+     a string or number) and it calls back once per value with the innermost object key.
+     Keys longer than JSON_KEY_MAX−1 and strings longer than JSON_STR_MAX−1 bytes, nesting
+     deeper than JSON_DEPTH and anything after the top-level value are errors, not
+     truncations. \uXXXX escapes are stored as UTF-8 (surrogate halves become '?').
+   • JsonBind + json_bind_cb fill a fixed struct from the top-level members of an object
+     through a const field table (offsetof); `seen` has bit i set for every field i present
+     with a usable value, `bad` for every field i present with the wrong type or too long,
+     and `other` counts top-level members not in the table (strict callers reject them).
+   • JsonWriter formats into a caller buffer, inserting commas itself. Overflow sets a flag
+     and stops writing; the text is always terminated.
+   • Pure logic (no Arduino/FreeRTOS) so it builds in host tests.
+   ==========================================================================================*/
+
+static constexpr uint8_t JSON_KEY_MAX = 24;
+static constexpr uint8_t JSON_STR_MAX = 64;
+static constexpr uint8_t JSON_DEPTH   = 8;
+
+enum JsonType : uint8_t { JSON_NULL, JSON_BOOL, JSON_NUM, JSON_STR, JSON_OBJECT, JSON_ARRAY, JSON_END };
+
+struct JsonValue {
+  JsonType    type;
+  bool        b;
+  double      num;
+  const char* str;          // JSON_STR: terminated, valid only during the callback
+  uint8_t     len;
+};
+
+// depth: 1 for members of the top-level container. key: "" for array elements and the top
+// level. JSON_OBJECT/JSON_ARRAY open a container, JSON_END closes the innermost one.
+typedef void (*JsonOnValue)(void* ctx, uint8_t depth, const char* key, const JsonValue& v);
+
+enum JsonStatus : int8_t { JSON_ERROR = -1, JSON_MORE = 0, JSON_DONE = 1 };
+
+class JsonReader {
+public:
+  void       begin(JsonOnValue cb, void* ctx);
+  JsonStatus feed(const char* p, size_t n);
+  JsonStatus finish();                           // end of input: a bare top-level number completes here
+  JsonStatus status() const { return st_ == S_DONE ? JSON_DONE : (st_ == S_ERR ? JSON_ERROR : JSON_MORE); }
+  size_t     offset() const { return off_; }     // bytes consumed (error position)
+
+private:
+  enum State : uint8_t { S_VALUE, S_FIRST_KEY, S_KEY, S_COLON, S_FIRST_VALUE, S_NEXT, S_STR, S_ESC, S_HEX,
+                         S_NUM, S_LIT, S_DONE, S_ERR };
+  bool step(char ch);
+  bool fail(){ st_ = S_ERR; return false; }
+  bool emit(JsonType t, bool b = false, double num = 0);
+  bool put(char ch);
+  bool endValue();
+  bool inObject() const { return depth_ && (objMask_ >> (depth_ - 1)) & 1; }
+
+  JsonOnValue cb_ = nullptr;
+  void*       ctx_ = nullptr;
+  State    st_ = S_VALUE;
+  bool     isKey_ = false;
+  uint8_t  depth_ = 0, objMask_ = 0;
+  uint8_t  len_ = 0, hexN_ = 0;
+  uint16_t hex_ = 0;
+  const char* lit_ = nullptr;
+  size_t   off_ = 0;
+  char     key_[JSON_KEY_MAX] = {};
+  char     buf_[JSON_STR_MAX] = {};
+};
+
+// ---- Field binding for flat request objects ----
+enum JsonKind : uint8_t { JK_FLOAT, JK_INT, JK_BOOL, JK_STR };
+
+struct JsonField {
+  const char* key;
+  JsonKind    kind;
+  uint16_t    off;          // offsetof the float / int32_t / bool / char[cap] member
+  uint8_t     cap;          // JK_STR only, including the terminator
+};
+
+struct JsonBind {
+  const JsonField* fields;
+  uint8_t  n;               // ≤ 32
+  void*    dst;             // the struct being filled
+  uint32_t seen, bad;
+  uint8_t  other;           // members with no matching field (saturates)
+};
+
+void json_bind_cb(void* ctx, uint8_t depth, const char* key, const JsonValue& v);
+// Whole body at once (form fields, WebSocket messages): DONE only if it parsed completely
+JsonStatus json_bind(JsonBind& b, const char* p, size_t n);
+
+// ---- Writer ----
+class JsonWriter {
+public:
+  void begin(char* buf, size_t cap);
+  JsonWriter& obj();                       // {  (as a value)
+  JsonWriter& arr();                       // [
+  JsonWriter& end();                       // } or ]
+  JsonWriter& key(const char* k);
+  JsonWriter& num(double v, uint8_t decimals);   // non-finite → null
+  JsonWriter& num(int v){ return num((long)v); }
+  JsonWriter& num(unsigned v){ return num((unsigned long)v); }
+  JsonWriter& num(long v);
+  JsonWriter& num(unsigned long v);
+  JsonWriter& boolean(bool v);
+  JsonWriter& null();
+  JsonWriter& str(const char* s);
+  // key + value shorthands (floats always take an explicit number of decimals)
+  JsonWriter& kv(const char* k, double v, uint8_t decimals){ return key(k).num(v, decimals); }
+  JsonWriter& kv(const char* k, int v){ return key(k).num(v); }
+  JsonWriter& kv(const char* k, unsigned v){ return key(k).num(v); }
+  JsonWriter& kv(const char* k, long v){ return key(k).num(v); }
+  JsonWriter& kv(const char* k, unsigned long v){ return key(k).num(v); }
+  JsonWriter& kv(const char* k, bool v){ return key(k).boolean(v); }
+  JsonWriter& kv(const char* k, const char* v){ return key(k).str(v); }
+
+  bool        ok() const { return !over_ && depth_ == 0; }   // complete and not truncated
+  bool        overflow() const { return over_; }
+  size_t      len() const { return len_; }
+  const char* c_str() const { return buf_; }
+
+private:
+  void sep();
+  void raw(const char* s, size_t n);
+  void rawc(char c){ raw(&c, 1); }
+
+  char*   buf_ = nullptr;
+  size_t  cap_ = 0, len_ = 0;
+  bool    over_ = false, afterKey_ = false;
+  uint8_t depth_ = 0;
+  uint8_t firstMask_ = 0;                  // bit d−1: container at depth d has no element yet
+  uint8_t objMask_ = 0;
+};
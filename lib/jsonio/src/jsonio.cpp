@@ -0,0 +1,287 @@
+#include "jsonio.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// ---- Reader ----
+static bool is_ws(char c){ return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+static bool is_digit(char c){ return c >= '0' && c <= '9'; }
+
+// JSON number grammar: -?digits(.digits)?([eE][+-]?digits)?
+static bool num_ok(const char* s){
+  if (*s == '-') s++;
+  if (!is_digit(*s)) return false;
+  while (is_digit(*s)) s++;
+  if (*s == '.'){ s++; if (!is_digit(*s)) return false; while (is_digit(*s)) s++; }
+  if (*s == 'e' || *s == 'E'){
+    s++; if (*s == '+' || *s == '-') s++;
+    if (!is_digit(*s)) return false;
+    while (is_digit(*s)) s++;
+  }
+  return *s == 0;
+}
+
+void JsonReader::begin(JsonOnValue cb, void* ctx){
+  cb_ = cb; ctx_ = ctx;
+  st_ = S_VALUE; isKey_ = false; depth_ = 0; objMask_ = 0; len_ = 0; hexN_ = 0; hex_ = 0;
+  lit_ = nullptr; off_ = 0; key_[0] = 0; buf_[0] = 0;
+}
+
+bool JsonReader::emit(JsonType t, bool b, double num){
+  if (!cb_) return true;
+  JsonValue v{ t, b, num, t == JSON_STR ? buf_ : "", t == JSON_STR ? len_ : (uint8_t)0 };
+  cb_(ctx_, depth_, t != JSON_END && inObject() ? key_ : "", v);
+  return true;
+}
+
+bool JsonReader::put(char ch){
+  if (len_ >= JSON_STR_MAX - 1) return fail();
+  buf_[len_++] = ch;
+  return true;
+}
+
+bool JsonReader::endValue(){
+  st_ = depth_ ? S_NEXT : S_DONE;
+  return true;
+}
+
+bool JsonReader::step(char ch){
+  switch (st_){
+    case S_FIRST_VALUE:
+      if (ch == ']'){ depth_--; emit(JSON_END); return endValue(); }
+      // fall through
+    case S_VALUE:
+      if (is_ws(ch)) return true;
+      if (ch == '{' || ch == '['){
+        if (depth_ >= JSON_DEPTH) return fail();
+        const bool o = ch == '{';
+        emit(o ? JSON_OBJECT : JSON_ARRAY);
+        if (o) objMask_ |= (uint8_t)(1u << depth_); else objMask_ &= (uint8_t)~(1u << depth_);
+        depth_++;
+        st_ = o ? S_FIRST_KEY : S_FIRST_VALUE;
+        return true;
+      }
+      if (ch == '"'){ isKey_ = false; len_ = 0; st_ = S_STR; return true; }
+      if (ch == '-' || is_digit(ch)){ len_ = 0; st_ = S_NUM; return put(ch); }
+      if (ch == 't' || ch == 'f' || ch == 'n'){
+        lit_ = ch == 't' ? "true" : (ch == 'f' ? "false" : "null"); len_ = 1; st_ = S_LIT; return true;
+      }
+      return fail();
+    case S_FIRST_KEY:
+      if (ch == '}'){ depth_--; emit(JSON_END); return endValue(); }
+      // fall through
+    case S_KEY:
+      if (is_ws(ch)) return true;
+      if (ch == '"'){ isKey_ = true; len_ = 0; st_ = S_STR; return true; }
+      return fail();
+    case S_COLON:
+      if (is_ws(ch)) return true;
+      if (ch == ':'){ st_ = S_VALUE; return true; }
+      return fail();
+    case S_NEXT:
+      if (is_ws(ch)) return true;
+      if (ch == ','){ st_ = inObject() ? S_KEY : S_VALUE; return true; }
+      if (ch == (inObject() ? '}' : ']')){ depth_--; emit(JSON_END); return endValue(); }
+      return fail();
+    case S_STR:
+      if (ch == '"'){
+        buf_[len_] = 0;
+        if (!isKey_){ emit(JSON_STR); return endValue(); }
+        if (len_ >= JSON_KEY_MAX) return fail();
+        memcpy(key_, buf_, len_ + 1);
+        st_ = S_COLON;
+        return true;
+      }
+      if (ch == '\\'){ st_ = S_ESC; return true; }
+      if ((uint8_t)ch < 0x20) return fail();
+      return put(ch);
+    case S_ESC: {
+      static const char from[] = "\"\\/bfnrt", to[] = "\"\\/\b\f\n\r\t";
+      if (ch == 'u'){ hexN_ = 0; hex_ = 0; st_ = S_HEX; return true; }
+      const char* k = strchr(from, ch);
+      if (!ch || !k) return fail();
+      st_ = S_STR;
+      return put(to[k - from]);
+    }
+    case S_HEX: {
+      uint8_t d;
+      if (is_digit(ch)) d = (uint8_t)(ch - '0');
+      else if (ch >= 'a' && ch <= 'f') d = (uint8_t)(ch - 'a' + 10);
+      else if (ch >= 'A' && ch <= 'F') d = (uint8_t)(ch - 'A' + 10);
+      else return fail();
+      hex_ = (uint16_t)((hex_ << 4) | d);
+      if (++hexN_ < 4) return true;
+      st_ = S_STR;
+      if (hex_ >= 0xD800 && hex_ <= 0xDFFF) return put('?');
+      if (hex_ < 0x80) return put((char)hex_);
+      if (hex_ < 0x800) return put((char)(0xC0 | (hex_ >> 6))) && put((char)(0x80 | (hex_ & 0x3F)));
+      return put((char)(0xE0 | (hex_ >> 12))) && put((char)(0x80 | ((hex_ >> 6) & 0x3F))) && put((char)(0x80 | (hex_ & 0x3F)));
+    }
+    case S_NUM:
+      if (is_digit(ch) || ch == '.' || ch == 'e' || ch == 'E' || ch == '+' || ch == '-') return put(ch);
+      buf_[len_] = 0;
+      if (!num_ok(buf_)) return fail();
+      emit(JSON_NUM, false, strtod(buf_, nullptr));
+      endValue();
+      return step(ch);                             // the delimiter belongs to the next state
+    case S_LIT:
+      if (ch != lit_[len_]) return fail();
+      if (lit_[++len_]) return true;
+      if (lit_[0] == 'n') emit(JSON_NULL); else emit(JSON_BOOL, lit_[0] == 't');
+      return endValue();
+    case S_DONE:
+      return is_ws(ch) ? true : fail();
+    case S_ERR:
+    default:
+      return false;
+  }
+}
+
+JsonStatus JsonReader::feed(const char* p, size_t n){
+  for (size_t i = 0; i < n && st_ != S_ERR; i++){
+    if (step(p[i])) off_++;
+  }
+  return status();
+}
+
+JsonStatus JsonReader::finish(){
+  if (st_ == S_NUM){
+    buf_[len_] = 0;
+    if (!num_ok(buf_)) fail();
+    else { emit(JSON_NUM, false, strtod(buf_, nullptr)); endValue(); }
+  }
+  if (st_ != S_DONE) st_ = S_ERR;
+  return status();
+}
+
+// ---- Binding ----
+void json_bind_cb(void* ctx, uint8_t depth, const char* key, const JsonValue& v){
+  JsonBind& b = *(JsonBind*)ctx;
+  uint8_t* base = (uint8_t*)b.dst;
+  if (depth != 1 || !key[0] || v.type == JSON_END) return;
+  for (uint8_t i = 0; i < b.n && i < 32; i++){
+    const JsonField& f = b.fields[i];
+    if (strcmp(f.key, key) != 0) continue;
+    bool ok = false;
+    switch (f.kind){
+      case JK_FLOAT:
+        if (v.type == JSON_NUM){ *(float*)(base + f.off) = (float)v.num; ok = true; }
+        break;
+      case JK_INT:
+        if (v.type == JSON_NUM && v.num == floor(v.num) && v.num >= -2147483648.0 && v.num <= 2147483647.0){
+          *(int32_t*)(base + f.off) = (int32_t)v.num; ok = true;
+        }
+        break;
+      case JK_BOOL:
+        if (v.type == JSON_BOOL){ *(bool*)(base + f.off) = v.b; ok = true; }
+        break;
+      case JK_STR:
+        if (v.type == JSON_STR && v.len < f.cap){ memcpy(base + f.off, v.str, v.len + 1); ok = true; }
+        break;
+    }
+    if (ok) b.seen |= 1u << i; else b.bad |= 1u << i;
+    return;
+  }
+  if (b.other < 255) b.other++;
+}
+
+JsonStatus json_bind(JsonBind& b, const char* p, size_t n){
+  JsonReader r;
+  r.begin(json_bind_cb, &b);
+  r.feed(p, n);
+  return r.finish();
+}
+
+// ---- Writer ----
+void JsonWriter::begin(char* buf, size_t cap){
+  buf_ = buf; cap_ = cap; len_ = 0; over_ = cap == 0; afterKey_ = false;
+  depth_ = 0; firstMask_ = 0; objMask_ = 0;
+  if (cap) buf[0] = 0;
+}
+
+void JsonWriter::raw(const char* s, size_t n){
+  if (over_) return;
+  if (len_ + n >= cap_){ over_ = true; return; }
+  memcpy(buf_ + len_, s, n);
+  len_ += n;
+  buf_[len_] = 0;
+}
+
+void JsonWriter::sep(){
+  if (afterKey_){ afterKey_ = false; return; }
+  if (!depth_) return;
+  const uint8_t bit = (uint8_t)(1u << (depth_ - 1));
+  if (firstMask_ & bit) firstMask_ &= (uint8_t)~bit;
+  else rawc(',');
+}
+
+JsonWriter& JsonWriter::obj(){
+  sep(); rawc('{');
+  if (depth_ >= 8){ over_ = true; return *this; }
+  firstMask_ |= (uint8_t)(1u << depth_); objMask_ |= (uint8_t)(1u << depth_);
+  depth_++;
+  return *this;
+}
+
+JsonWriter& JsonWriter::arr(){
+  sep(); rawc('[');
+  if (depth_ >= 8){ over_ = true; return *this; }
+  firstMask_ |= (uint8_t)(1u << depth_); objMask_ &= (uint8_t)~(1u << depth_);
+  depth_++;
+  return *this;
+}
+
+JsonWriter& JsonWriter::end(){
+  if (!depth_) return *this;
+  depth_--;
+  rawc((objMask_ >> depth_) & 1 ? '}' : ']');
+  return *this;
+}
+
+JsonWriter& JsonWriter::key(const char* k){
+  str(k); rawc(':');
+  afterKey_ = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::num(double v, uint8_t decimals){
+  if (!isfinite(v)) return null();
+  sep();
+  char t[32];
+  const int n = fabs(v) < 1e15 ? snprintf(t, sizeof(t), "%.*f", decimals, v) : snprintf(t, sizeof(t), "%.6g", v);
+  raw(t, n > 0 && n < (int)sizeof(t) ? (size_t)n : 0);
+  return *this;
+}
+
+JsonWriter& JsonWriter::num(long v){
+  sep();
+  char t[24]; const int n = snprintf(t, sizeof(t), "%ld", v);
+  raw(t, (size_t)n);
+  return *this;
+}
+
+JsonWriter& JsonWriter::num(unsigned long v){
+  sep();
+  char t[24]; const int n = snprintf(t, sizeof(t), "%lu", v);
+  raw(t, (size_t)n);
+  return *this;
+}
+
+JsonWriter& JsonWriter::boolean(bool v){ sep(); if (v) raw("true", 4); else raw("false", 5); return *this; }
+JsonWriter& JsonWriter::null(){ sep(); raw("null", 4); return *this; }
+
+JsonWriter& JsonWriter::str(const char* s){
+  sep(); rawc('"');
+  for (; *s; s++){
+    const char c = *s;
+    if (c == '"' || c == '\\'){ rawc('\\'); rawc(c); }
+    else if (c == '\n') raw("\\n", 2);
+    else if (c == '\r') raw("\\r", 2);
+    else if (c == '\t') raw("\\t", 2);
+    else if ((uint8_t)c < 0x20){ char t[8]; snprintf(t, sizeof(t), "\\u%04x", (unsigned)(uint8_t)c); raw(t, 6); }
+    else rawc(c);
+  }
+  rawc('"');
+  return *this;
+}
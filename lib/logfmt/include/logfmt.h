@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/* ==========================================================================================
+   logfmt.h — Flight-recorder block format (per-tick samples, delta encoded)
+   ------------------------------------------------------------------------------------------
+   • A log file is a sequence of LOG_BLOCK_BYTES blocks (one flash sector each). Every block
+     is self-contained: header (calibration included) + samples + zero padding, so a torn
+     or corrupt block only loses itself.
+   • Header (little endian, LOG_HDR_BYTES):
+       magic u32 "SLOG" | version u16 | count u16 | seq u32 | firstTick u32 | tMs u32 |
+       payload u16 | hz u16 | cal 6×f32 (atr m,b · vent m,b · flow m,b) | crc32 u32
+     crc32 covers the header (crc field zero) and the payload.
+   • Sample: one mask byte naming the fields that differ from the previous sample, then
+     those fields: Δtick (uvarint, omitted when 1), Δatr/Δvent/Δpwm (zigzag varint), Δedges
+     (uvarint), state and fault (raw byte). The first sample is coded against zero.
+     Typical cost ≈ 3–4 bytes per tick.
+   • Pure logic (no Arduino/FreeRTOS) so it builds in host tests and the log2csv tool.
+   ==========================================================================================*/
+
+static constexpr uint16_t LOG_BLOCK_BYTES = 4096;
+static constexpr uint16_t LOG_HDR_BYTES   = 52;
+static constexpr uint32_t LOG_MAGIC       = 0x474F4C53u;   // "SLOG"
+static constexpr uint16_t LOG_VERSION     = 1;
+static constexpr uint8_t  LOG_SAMPLE_MAX  = 1 + 5 * 5 + 2; // worst-case encoded sample
+
+struct LogCal { float atr_m = 0, atr_b = 0, vent_m = 0, vent_b = 0, flow_m = 0, flow_b = 0; };
+
+struct LogSample {
+  uint32_t tick = 0;         // control tick counter
+  int16_t  atr = 0, vent = 0;   // raw ADC counts
+  uint32_t edges = 0;        // cumulative flow edges
+  uint8_t  pwm = 0;          // hardware PWM
+  uint8_t  state = 0;        // log_state()
+  uint8_t  fault = 0;        // latched protection bits
+};
+
+// valve (bit 0) | paused 0..2 (bits 1-2) | mode (bits 3-5)
+static inline uint8_t log_state(uint8_t valve, uint8_t paused, uint8_t mode){
+  return (uint8_t)((valve & 1) | ((paused & 3) << 1) | ((mode & 7) << 3));
+}
+
+struct LogBlockInfo {
+  uint32_t seq = 0, firstTick = 0, tMs = 0;
+  uint16_t count = 0, hz = 0;
+  LogCal   cal;
+};
+
+class LogBlockWriter {
+public:
+  void begin(uint32_t seq, uint16_t hz, const LogCal& cal, uint32_t nowMs);   // empty block
+  bool add(const LogSample& s);            // false when the block is full (sample not added)
+  uint16_t count() const { return n_; }
+  const uint8_t* seal();                   // fills header + CRC + padding; LOG_BLOCK_BYTES long
+
+private:
+  uint8_t   buf_[LOG_BLOCK_BYTES];
+  uint16_t  len_ = LOG_HDR_BYTES, n_ = 0;
+  LogSample prev_;
+  LogBlockInfo info_;
+};
+
+class LogBlockReader {
+public:
+  bool open(const uint8_t* block, size_t len);   // false on bad magic, version, size or CRC
+  const LogBlockInfo& info() const { return info_; }
+  bool next(LogSample& out);                     // false after the last sample
+
+private:
+  const uint8_t* p_ = nullptr; const uint8_t* end_ = nullptr;
+  uint16_t  left_ = 0;
+  LogSample prev_;
+  LogBlockInfo info_;
+};
@@ -0,0 +1,93 @@
+#include "logfmt.h"
+#include <string.h>
+#include "crc.h"
+
+enum : uint8_t { LM_TICK = 1, LM_ATR = 2, LM_VENT = 4, LM_EDGES = 8, LM_PWM = 16, LM_STATE = 32, LM_FAULT = 64 };
+
+static uint8_t* put_u(uint8_t* p, uint32_t v){ while (v >= 0x80){ *p++ = (uint8_t)(v | 0x80); v >>= 7; } *p++ = (uint8_t)v; return p; }
+static uint8_t* put_s(uint8_t* p, int32_t v){ return put_u(p, ((uint32_t)v << 1) ^ (uint32_t)(v >> 31)); }
+static void le16(uint8_t* p, uint16_t v){ p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void le32(uint8_t* p, uint32_t v){ for (uint8_t i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8*i)); }
+static void lef(uint8_t* p, float f){ uint32_t v; memcpy(&v, &f, 4); le32(p, v); }
+static uint16_t rd16(const uint8_t* p){ return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t rd32(const uint8_t* p){ return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+static float rdf(const uint8_t* p){ uint32_t v = rd32(p); float f; memcpy(&f, &v, 4); return f; }
+
+static bool get_u(const uint8_t*& p, const uint8_t* end, uint32_t& v){
+  v = 0;
+  for (uint8_t sh = 0; sh < 35 && p < end; sh += 7){ uint8_t b = *p++; v |= (uint32_t)(b & 0x7F) << sh; if (!(b & 0x80)) return true; }
+  return false;
+}
+static bool get_s(const uint8_t*& p, const uint8_t* end, int32_t& v){
+  uint32_t u; if (!get_u(p, end, u)) return false;
+  v = (int32_t)(u >> 1) ^ -(int32_t)(u & 1); return true;
+}
+
+void LogBlockWriter::begin(uint32_t seq, uint16_t hz, const LogCal& cal, uint32_t nowMs){
+  len_ = LOG_HDR_BYTES; n_ = 0; prev_ = LogSample();
+  info_ = LogBlockInfo(); info_.seq = seq; info_.hz = hz; info_.cal = cal; info_.tMs = nowMs;
+}
+
+bool LogBlockWriter::add(const LogSample& s){
+  if (len_ + LOG_SAMPLE_MAX > LOG_BLOCK_BYTES || n_ == 0xFFFF) return false;
+  if (!n_) info_.firstTick = s.tick;
+  uint8_t* p = buf_ + len_;
+  uint8_t* m = p++;
+  uint8_t mask = 0;
+  uint32_t dt = s.tick - prev_.tick;
+  if (dt != 1 || !n_){ mask |= LM_TICK;  p = put_u(p, dt); }
+  if (s.atr != prev_.atr){ mask |= LM_ATR;  p = put_s(p, s.atr - prev_.atr); }
+  if (s.vent != prev_.vent){ mask |= LM_VENT; p = put_s(p, s.vent - prev_.vent); }
+  if (s.edges != prev_.edges){ mask |= LM_EDGES; p = put_u(p, s.edges - prev_.edges); }
+  if (s.pwm != prev_.pwm){ mask |= LM_PWM; p = put_s(p, (int32_t)s.pwm - prev_.pwm); }
+  if (s.state != prev_.state){ mask |= LM_STATE; *p++ = s.state; }
+  if (s.fault != prev_.fault){ mask |= LM_FAULT; *p++ = s.fault; }
+  *m = mask;
+  len_ = (uint16_t)(p - buf_); n_++; prev_ = s;
+  return true;
+}
+
+const uint8_t* LogBlockWriter::seal(){
+  uint8_t* h = buf_;
+  le32(h, LOG_MAGIC); le16(h + 4, LOG_VERSION); le16(h + 6, n_);
+  le32(h + 8, info_.seq); le32(h + 12, info_.firstTick); le32(h + 16, info_.tMs);
+  le16(h + 20, (uint16_t)(len_ - LOG_HDR_BYTES)); le16(h + 22, info_.hz);
+  const LogCal& c = info_.cal;
+  lef(h + 24, c.atr_m); lef(h + 28, c.atr_b); lef(h + 32, c.vent_m); lef(h + 36, c.vent_b); lef(h + 40, c.flow_m); lef(h + 44, c.flow_b);
+  le32(h + 48, 0);
+  le32(h + 48, crc32(buf_, len_));
+  memset(buf_ + len_, 0, LOG_BLOCK_BYTES - len_);
+  return buf_;
+}
+
+bool LogBlockReader::open(const uint8_t* b, size_t len){
+  p_ = end_ = nullptr; left_ = 0;
+  if (len < LOG_HDR_BYTES || rd32(b) != LOG_MAGIC || rd16(b + 4) != LOG_VERSION) return false;
+  uint16_t payload = rd16(b + 20);
+  if ((size_t)LOG_HDR_BYTES + payload > len) return false;
+  uint8_t zero[4] = {0, 0, 0, 0};
+  uint32_t crc = crc32_update(crc32_update(crc32_update(0, b, 48), zero, 4), b + LOG_HDR_BYTES, payload);
+  if (crc != rd32(b + 48)) return false;
+  info_.count = rd16(b + 6); info_.seq = rd32(b + 8); info_.firstTick = rd32(b + 12); info_.tMs = rd32(b + 16);
+  info_.hz = rd16(b + 22);
+  LogCal& c = info_.cal;
+  c.atr_m = rdf(b + 24); c.atr_b = rdf(b + 28); c.vent_m = rdf(b + 32); c.vent_b = rdf(b + 36); c.flow_m = rdf(b + 40); c.flow_b = rdf(b + 44);
+  p_ = b + LOG_HDR_BYTES; end_ = p_ + payload; left_ = info_.count; prev_ = LogSample();
+  return true;
+}
+
+bool LogBlockReader::next(LogSample& s){
+  if (!left_ || p_ >= end_) return false;
+  uint8_t mask = *p_++;
+  s = prev_;
+  uint32_t u; int32_t d;
+  if (mask & LM_TICK){ if (!get_u(p_, end_, u)) return false; s.tick += u; } else s.tick += 1;
+  if (mask & LM_ATR){ if (!get_s(p_, end_, d)) return false; s.atr = (int16_t)(s.atr + d); }
+  if (mask & LM_VENT){ if (!get_s(p_, end_, d)) return false; s.vent = (int16_t)(s.vent + d); }
+  if (mask & LM_EDGES){ if (!get_u(p_, end_, u)) return false; s.edges += u; }
+  if (mask & LM_PWM){ if (!get_s(p_, end_, d)) return false; s.pwm = (uint8_t)(s.pwm + d); }
+  if (mask & LM_STATE){ if (p_ >= end_) return false; s.state = *p_++; }
+  if (mask & LM_FAULT){ if (p_ >= end_) return false; s.fault = *p_++; }
+  prev_ = s; left_--;
+  return true;
+}
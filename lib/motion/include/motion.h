@@ -0,0 +1,37 @@
+#pragma once
+#include <stdint.h>
+
+/* ==========================================================================================
+   motion.h — Fixed-point ramp generator for the pump PWM (linear or jerk-limited S-curve)
+   ------------------------------------------------------------------------------------------
+   • Pure integer logic (no Arduino/FreeRTOS) so it also builds in host tests.
+   • start() precomputes the per-tick increments once; step() is a handful of integer adds.
+   • A ramp of N ticks lands exactly on its target at tick N, whatever the distance.
+   • S-curve: jerk +J, −J, (coast), −J, +J in equal quarters → zero velocity and zero
+     acceleration at both ends, so the pump sees no step in drive slope.
+   ==========================================================================================*/
+
+enum RampShape : uint8_t { RAMP_LINEAR=0, RAMP_SCURVE=1 };
+
+// Round ms → ticks at the given loop rate (150 ms @ 600 Hz = 90 ticks)
+static inline uint32_t motion_ms_to_ticks(uint32_t ms, uint32_t hz){ return (ms*hz + 500u)/1000u; }
+
+class MotionProfile {
+public:
+  void    reset(uint8_t v);                                     // snap to v, cancel any ramp
+  void    start(uint8_t target, uint32_t ticks, RampShape shape); // ramp from current position
+  uint8_t step();                                               // advance one tick; returns output
+  bool    active() const { return left_ > 0; }
+  uint8_t value()  const { return out_; }
+  uint8_t target() const { return target_; }
+
+private:
+  int8_t jerk_sign(uint32_t t) const { return (t < b1_) ? 1 : (t < b2_) ? -1 : (t < bc_) ? 0 : (t < b3_) ? -1 : 1; }
+
+  // Q32.32 position and its per-tick derivatives
+  int64_t  pos_=0, vel_=0, acc_=0, jerk_=0;
+  uint32_t t_=0, left_=0;
+  uint32_t b1_=0, b2_=0, bc_=0, b3_=0;   // S-curve phase ends: +J, −J, coast, −J (then +J)
+  uint8_t  out_=0, target_=0;
+  RampShape shape_=RAMP_LINEAR;
+};
@@ -0,0 +1,46 @@
+#include "motion.h"
+
+static constexpr int64_t ONE = (int64_t)1 << 32;   // Q32.32 unit (one PWM count)
+
+static inline uint8_t round_out(int64_t p){
+  int64_t v = (p + (ONE>>1)) >> 32;
+  if (v < 0) v = 0;
+  if (v > 255) v = 255;
+  return (uint8_t)v;
+}
+
+void MotionProfile::reset(uint8_t v){
+  pos_ = (int64_t)v << 32; vel_ = acc_ = jerk_ = 0;
+  t_ = left_ = 0; out_ = target_ = v;
+}
+
+void MotionProfile::start(uint8_t target, uint32_t ticks, RampShape shape){
+  target_ = target;
+  int64_t delta = ((int64_t)target << 32) - pos_;
+  if (ticks == 0 || delta == 0){ reset(target); return; }
+  t_ = 0; left_ = ticks; acc_ = 0; jerk_ = 0;
+  uint32_t q = ticks / 4;
+  shape_ = (shape == RAMP_SCURVE && q > 0) ? RAMP_SCURVE : RAMP_LINEAR;  // <4 ticks: linear
+  if (shape_ == RAMP_LINEAR){ vel_ = delta / (int64_t)ticks; return; }
+
+  // Phase layout: [q: +J][q: −J][coast][q: −J][q: +J]; coast absorbs ticks % 4 at peak velocity.
+  b1_ = q; b2_ = 2*q; bc_ = ticks - 2*q; b3_ = ticks - q;
+  // Displacement of the discrete profile for unit jerk, then scale J so it covers delta.
+  int64_t a = 0, v = 0, p = 0;
+  for (uint32_t t=0; t<ticks; t++){ a += jerk_sign(t); v += a; p += v; }
+  vel_ = 0;
+  jerk_ = delta / p;
+}
+
+uint8_t MotionProfile::step(){
+  if (!left_) return out_;
+  if (shape_ == RAMP_SCURVE){
+    acc_ += jerk_sign(t_) * jerk_;
+    vel_ += acc_;
+  }
+  pos_ += vel_;
+  t_++;
+  if (--left_ == 0){ pos_ = (int64_t)target_ << 32; vel_ = acc_ = 0; }   // land exactly
+  out_ = round_out(pos_);
+  return out_;
+}
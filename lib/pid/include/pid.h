@@ -0,0 +1,39 @@
+#pragma once
+#include <stdint.h>
+
+/* ==========================================================================================
+   pid.h — Fixed-point PID with feed-forward and anti-windup
+   ------------------------------------------------------------------------------------------
+   • Measurement/setpoint in Q8 (1/256 unit, e.g. mmHg), output in Q16 (1/65536 PWM count).
+   • Gains are given in physical units (per second) and converted once per configure() to
+     per-step fixed-point constants, so step() is integer multiply/shift/add only. Constants
+     that do not fit saturate (NaN → 0); callers bound gains to something sensible first.
+   • Derivative acts on the measurement (no kick on setpoint changes).
+   • Anti-windup: the integrator is clamped so ff + P + I + D never exceeds the output
+     limits (back-calculation to the limit), so recovery from saturation is immediate.
+   • Pure logic (no Arduino/FreeRTOS) so it also builds in host tests.
+   ==========================================================================================*/
+
+struct PidGains { float kp, ki, kd; };     // out/unit, out/(unit·s), out·s/unit
+
+static inline int32_t pid_q8(float v)  { return (int32_t)(v * 256.0f + (v >= 0 ? 0.5f : -0.5f)); }
+static inline int32_t pid_q16(float v) { return (int32_t)(v * 65536.0f + (v >= 0 ? 0.5f : -0.5f)); }
+static inline float   pid_from_q16(int32_t v) { return v / 65536.0f; }
+
+class PidQ {
+public:
+  // dtS = time between step() calls; outputs are limited to [outMin, outMax]
+  void    configure(const PidGains& g, float dtS, float outMin, float outMax);
+  void    setLimits(int32_t minQ16, int32_t maxQ16);               // e.g. follow a PWM ceiling
+  // Bumpless start: choose the integrator so the next output equals outQ16
+  void    reset(int32_t outQ16, int32_t spQ8, int32_t measQ8, int32_t ffQ16);
+  int32_t step(int32_t spQ8, int32_t measQ8, int32_t ffQ16);   // returns Q16 output
+  int32_t output() const { return out_; }
+  int32_t integrator() const { return integ_; }
+
+private:
+  int32_t kp_=0, ki_=0, kd_=0;           // per step: kp/kd Q16, ki Q24
+  int32_t min_=0, max_=0;                // Q16
+  int32_t integ_=0, prev_=0, out_=0;     // Q16, Q8, Q16
+  bool    primed_=false;
+};
@@ -0,0 +1,48 @@
+#include "pid.h"
+
+static inline int32_t sat(int64_t v, int32_t lo, int32_t hi){ return (int32_t)(v < lo ? lo : (v > hi ? hi : v)); }
+
+// v × scale rounded to int32, saturated; NaN → 0. Gains come from the web API, so a value
+// that does not fit must not reach a float→int cast.
+static int32_t q_sat(double v, double scale){
+  const double x = v * scale;
+  if (!(x == x)) return 0;
+  if (x >= 2147483647.0) return INT32_MAX;
+  if (x <= -2147483647.0) return -INT32_MAX;
+  return (int32_t)(x + (x >= 0 ? 0.5 : -0.5));
+}
+
+void PidQ::configure(const PidGains& g, float dtS, float outMin, float outMax){
+  kp_ = q_sat(g.kp, 65536.0);
+  ki_ = q_sat((double)g.ki * dtS, 16777216.0);        // Q24: per-step gains are tiny
+  kd_ = (dtS > 0) ? q_sat((double)g.kd / dtS, 65536.0) : 0;
+  min_ = q_sat(outMin, 65536.0); max_ = q_sat(outMax, 65536.0);
+  integ_ = sat(integ_, min_, max_);
+}
+
+void PidQ::setLimits(int32_t minQ16, int32_t maxQ16){
+  if (maxQ16 < minQ16) maxQ16 = minQ16;
+  min_ = minQ16; max_ = maxQ16;
+}
+
+void PidQ::reset(int32_t outQ16, int32_t spQ8, int32_t measQ8, int32_t ffQ16){
+  int64_t p = ((int64_t)kp_ * (spQ8 - measQ8)) >> 8;
+  integ_ = sat((int64_t)outQ16 - ffQ16 - p, min_ - max_, max_ - min_);
+  prev_ = measQ8; primed_ = true; out_ = outQ16;
+}
+
+int32_t PidQ::step(int32_t spQ8, int32_t measQ8, int32_t ffQ16){
+  if (!primed_){ prev_ = measQ8; primed_ = true; }
+  int32_t e = spQ8 - measQ8;
+  int64_t p = ((int64_t)kp_ * e) >> 8;                    // Q16·Q8 >> 8 → Q16
+  int64_t d = -(((int64_t)kd_ * (measQ8 - prev_)) >> 8);
+  prev_ = measQ8;
+  int64_t i = (int64_t)integ_ + (((int64_t)ki_ * e) >> 16);  // Q24·Q8 >> 16 → Q16
+  int64_t u = (int64_t)ffQ16 + p + i + d;
+  // anti-windup: pull the integrator back so the unsaturated sum sits on the limit
+  if (u > max_ && i > 0){ i -= (u - max_); if (i < 0) i = 0; }
+  else if (u < min_ && i < 0){ i += (min_ - u); if (i > 0) i = 0; }
+  integ_ = sat(i, min_ - max_, max_ - min_);
+  out_ = sat((int64_t)ffQ16 + p + integ_ + d, min_, max_);
+  return out_;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <stdint.h>
+
+/* ==========================================================================================
+   protect.h — Per-tick over/under-pressure and flow-loss protection
+   ------------------------------------------------------------------------------------------
+   • Runs on the raw ADC counts of both pressure channels, before any smoothing. Thresholds
+     are given in mmHg and converted to counts whenever the calibration changes, so a tick
+     is integer compares only.
+   • Each limit trips after debounceTicks consecutive samples beyond it; a sample back inside
+     by the hysteresis band resets the count, one in between holds it (noise at the limit
+     neither trips nor clears).
+   • No-flow: driving ticks (pwm ≥ drivePwm) accumulate without a flow edge; any edge
+     resets them, and so does an idle stretch as long as the limit itself.
+   • Faults latch until clear(), which only succeeds once every input is back inside.
+   • Pure logic (no Arduino/FreeRTOS) so it also builds in host tests.
+   ==========================================================================================*/
+
+enum ProtChannel : uint8_t { PROT_ATR, PROT_VENT, PROT_CH };
+enum ProtFault : uint8_t {
+  PF_OVER_ATR  = 1 << 0, PF_OVER_VENT  = 1 << 1,
+  PF_UNDER_ATR = 1 << 2, PF_UNDER_VENT = 1 << 3,
+  PF_NO_FLOW   = 1 << 4,
+};
+
+struct ProtectCfg {
+  float    overMmHg = 200.0f, underMmHg = -40.0f, hystMmHg = 10.0f;
+  uint16_t debounceTicks = 3;
+  uint8_t  drivePwm = 90;            // PWM above which the pump must move fluid
+  uint32_t noFlowTicks = 900;        // driving ticks without a flow edge
+};
+
+class Protection {
+public:
+  void    configure(const ProtectCfg& c);          // keeps any latched fault
+  void    setCal(uint8_t ch, float m, float b);    // mmHg = m·raw + b; cheap when unchanged
+  // One control tick. Returns the faults that tripped on this tick (0 almost always).
+  uint8_t step(const int32_t raw[PROT_CH], uint8_t pwm, uint32_t edgeCount);
+  uint8_t latched() const { return latched_; }
+  bool    clear();                                 // false while a condition is still present
+  uint32_t trips() const { return trips_; }
+  uint32_t latencyTicks() const { return latency_; }   // first sample beyond → trip, last trip
+  int32_t tripRaw(uint8_t ch) const { return tripRaw_[ch]; }
+
+private:
+  struct Limit {
+    int32_t  on = 0, off = 0;         // counts, already multiplied by the channel sign
+    uint16_t n = 0;                   // consecutive samples beyond
+    uint32_t since = 0;               // ticks since the first sample beyond (while counting)
+    bool     beyond = false;
+  };
+  bool runLimit(Limit& l, int32_t v);   // true when the limit trips on this sample
+  void recompute(uint8_t ch);
+
+  ProtectCfg cfg_;
+  float   m_[PROT_CH]{}, b_[PROT_CH]{};
+  int8_t  sign_[PROT_CH]{1, 1};
+  Limit   over_[PROT_CH], under_[PROT_CH];
+  uint32_t dry_ = 0, idle_ = 0, lastEdges_ = 0;
+  bool    primed_ = false;
+  uint8_t latched_ = 0;
+  uint32_t trips_ = 0, latency_ = 0;
+  int32_t tripRaw_[PROT_CH]{};
+};
@@ -0,0 +1,70 @@
+#include "protect.h"
+#include <math.h>
+
+void Protection::configure(const ProtectCfg& c){
+  cfg_ = c;
+  if (!cfg_.debounceTicks) cfg_.debounceTicks = 1;
+  if (cfg_.hystMmHg < 0) cfg_.hystMmHg = 0;
+  for (uint8_t ch = 0; ch < PROT_CH; ch++){ over_[ch] = Limit(); under_[ch] = Limit(); recompute(ch); }
+  dry_ = 0; idle_ = 0;
+}
+
+void Protection::setCal(uint8_t ch, float m, float b){
+  if (ch >= PROT_CH || (m == m_[ch] && b == b_[ch])) return;
+  m_[ch] = m; b_[ch] = b; recompute(ch);
+}
+
+void Protection::recompute(uint8_t ch){
+  // counts = (mmHg − b)/m; with a negative slope higher pressure means fewer counts, so all
+  // compares run on sign·counts
+  float m = m_[ch];
+  if (m == 0){ over_[ch].on = over_[ch].off = INT32_MAX; under_[ch].on = under_[ch].off = INT32_MAX; return; }
+  int8_t s = m > 0 ? 1 : -1; sign_[ch] = s;
+  auto cnt = [&](float mmHg){ return (int32_t)lroundf(s * (mmHg - b_[ch]) / m); };
+  over_[ch].on   = cnt(cfg_.overMmHg);                     // beyond: v ≥ on
+  over_[ch].off  = cnt(cfg_.overMmHg - cfg_.hystMmHg);     // inside: v < off
+  under_[ch].on  = -cnt(cfg_.underMmHg);                   // mirrored so "beyond" is v ≥ on
+  under_[ch].off = -cnt(cfg_.underMmHg + cfg_.hystMmHg);
+}
+
+bool Protection::runLimit(Limit& l, int32_t v){
+  if (v >= l.on){
+    if (!l.n) l.since = 0;
+    if (l.n < 0xFFFF) l.n++;
+    l.beyond = true;
+  } else if (v < l.off){
+    l.n = 0; l.beyond = false;
+  } else {
+    l.beyond = false;                     // in the band: hold the count
+  }
+  if (l.n) l.since++;
+  if (l.n == cfg_.debounceTicks){ latency_ = l.since; return true; }   // once per excursion
+  return false;
+}
+
+uint8_t Protection::step(const int32_t raw[PROT_CH], uint8_t pwm, uint32_t edgeCount){
+  uint8_t t = 0;
+  for (uint8_t ch = 0; ch < PROT_CH; ch++){
+    int32_t v = sign_[ch] * raw[ch];
+    if (runLimit(over_[ch], v))   t |= (ch == PROT_ATR) ? PF_OVER_ATR : PF_OVER_VENT;
+    if (runLimit(under_[ch], -v)) t |= (ch == PROT_ATR) ? PF_UNDER_ATR : PF_UNDER_VENT;
+  }
+  bool edge = primed_ && edgeCount != lastEdges_;
+  lastEdges_ = edgeCount; primed_ = true;
+  if (edge){ dry_ = 0; idle_ = 0; }
+  else if (pwm >= cfg_.drivePwm){ idle_ = 0; if (++dry_ >= cfg_.noFlowTicks){ latency_ = dry_; dry_ = 0; t |= PF_NO_FLOW; } }
+  else if (++idle_ >= cfg_.noFlowTicks) dry_ = 0;
+  t &= ~latched_;                         // report each fault once until cleared
+  if (t){
+    latched_ |= t; trips_++;
+    for (uint8_t ch = 0; ch < PROT_CH; ch++) tripRaw_[ch] = raw[ch];
+  }
+  return t;
+}
+
+bool Protection::clear(){
+  for (uint8_t ch = 0; ch < PROT_CH; ch++)
+    if (over_[ch].n || over_[ch].beyond || under_[ch].n || under_[ch].beyond) return false;
+  latched_ = 0; dry_ = 0;
+  return true;
+}
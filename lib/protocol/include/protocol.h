@@ -0,0 +1,72 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/* ==========================================================================================
+   protocol.h — Scripted run protocols: compact text format, parser and tick-exact runner
+   ------------------------------------------------------------------------------------------
+   Format (one statement per line or ';'-separated, '#' starts a comment, case-insensitive):
+       fwd  <pwm> <dur>            steady forward at pwm
+       rev  <pwm> <dur>            steady reverse at pwm
+       beat <pwm> <bpm> <dur>      beat mode
+       pause <dur>                 outputs off (ramped), clock keeps running
+       loop <n> ... end            repeat the enclosed statements n times (nesting ≤ 4)
+   <dur> = number with optional unit ms|s|m (default s). Durations are converted to control
+   ticks once at parse time; the runner then steps exactly one tick per call.
+   • Pure logic (no Arduino/FreeRTOS) so protocols can be validated/simulated on the host.
+   ==========================================================================================*/
+
+static constexpr uint8_t PROTO_MAX_STEPS = 64;
+static constexpr uint8_t PROTO_MAX_DEPTH = 4;
+
+enum ProtoOp : uint8_t { PROTO_SEG=0, PROTO_PAUSE=1, PROTO_LOOP=2, PROTO_END=3 };
+
+struct ProtoStep {
+  uint8_t  op;
+  uint8_t  mode;       // MODE_FWD/REV/BEAT numbering (0/1/2)
+  uint8_t  pwm;
+  uint8_t  match;      // LOOP ↔ END partner index
+  uint16_t bpm;        // beat only (0 = keep current)
+  uint16_t count;      // LOOP repeat count
+  uint32_t ticks;      // SEG/PAUSE duration
+};
+
+struct Protocol {
+  uint8_t   n = 0;
+  ProtoStep step[PROTO_MAX_STEPS];
+};
+
+struct ProtoError { uint16_t line; const char* msg; };
+struct ProtoLimits { uint32_t hz; uint16_t bpmMin, bpmMax; };   // control rate, BPM range
+
+// Parse text into out. Returns false with err.line (1-based) / err.msg on failure.
+bool     protocol_parse(const char* text, size_t len, const ProtoLimits& lim, Protocol& out, ProtoError& err);
+uint64_t protocol_total_ticks(const Protocol& p);
+
+enum ProtoEvent : uint8_t { PROTO_IDLE=0, PROTO_HOLD, PROTO_ENTER, PROTO_DONE };
+
+class ProtoRunner {
+public:
+  void start(const Protocol* p);
+  void stop()                 { p_ = nullptr; }
+  bool running() const        { return p_ != nullptr; }
+  // Advance one control tick. PROTO_ENTER: `seg` begins on this tick (apply it now);
+  // PROTO_HOLD: keep going; PROTO_DONE: the last segment just ended (runner stops).
+  ProtoEvent tick(ProtoStep& seg);
+
+  // Progress
+  uint8_t  stepIndex() const  { return idx_; }
+  uint16_t iteration() const  { return depth_ ? (uint16_t)(stack_[depth_-1].count - stack_[depth_-1].left + 1) : 1; }
+  uint64_t elapsed() const    { return elapsed_; }
+  uint64_t total() const      { return total_; }
+
+private:
+  bool next_segment();
+  struct Frame { uint8_t start; uint16_t count, left; };
+  const Protocol* p_ = nullptr;
+  Frame    stack_[PROTO_MAX_DEPTH];
+  uint8_t  depth_ = 0, pc_ = 0, idx_ = 0;
+  uint32_t left_ = 0;
+  uint64_t elapsed_ = 0, total_ = 0;
+  ProtoStep cur_{};
+};
@@ -0,0 +1,146 @@
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "protocol.h"
+
+static constexpr uint8_t MAX_TOK = 6;
+static constexpr uint8_t TOK_LEN = 16;
+
+static bool tok_eq(const char* a, const char* b){
+  while (*a && *b){ if (tolower((unsigned char)*a) != *b) return false; a++; b++; }
+  return *a == *b;
+}
+
+static bool parse_uint(const char* s, long lo, long hi, long& v){
+  char* end = nullptr;
+  v = strtol(s, &end, 10);
+  return end != s && *end == 0 && v >= lo && v <= hi;
+}
+
+// "<number>[ms|s|m]" → ticks (at least one)
+static bool parse_dur(const char* s, uint32_t hz, uint32_t& ticks){
+  char* end = nullptr;
+  double v = strtod(s, &end);
+  if (end == s || v <= 0) return false;
+  double ms;
+  if (*end == 0 || tok_eq(end, "s")) ms = v * 1000.0;
+  else if (tok_eq(end, "ms"))        ms = v;
+  else if (tok_eq(end, "m"))         ms = v * 60000.0;
+  else return false;
+  double t = ms * hz / 1000.0 + 0.5;
+  if (t > 4.0e9) return false;
+  ticks = (t < 1.0) ? 1u : (uint32_t)t;
+  return true;
+}
+
+bool protocol_parse(const char* text, size_t len, const ProtoLimits& lim, Protocol& out, ProtoError& err){
+  out.n = 0;
+  uint8_t open[PROTO_MAX_DEPTH]; uint8_t depth = 0;
+  uint16_t line = 1, at = 0;      // current line / line of the statement being parsed
+  size_t i = 0;
+  auto fail = [&](const char* m){ err.line = at; err.msg = m; return false; };
+  while (i <= len){
+    // collect one statement: up to '\n', ';' or end; '#' comments out the rest of the line
+    char tok[MAX_TOK][TOK_LEN]; uint8_t nt = 0, tl = 0; bool comment = false, overflow = false;
+    at = line;
+    for (; i < len && text[i] != '\n' && text[i] != ';'; i++){
+      char c = text[i];
+      if (c == '#') comment = true;
+      if (comment) continue;
+      if (isspace((unsigned char)c)){ if (tl){ tok[nt-1][tl] = 0; tl = 0; } continue; }
+      if (!tl){ if (nt == MAX_TOK){ overflow = true; continue; } nt++; }
+      if (tl < TOK_LEN-1) tok[nt-1][tl++] = c; else overflow = true;
+    }
+    if (tl) tok[nt-1][tl] = 0;
+    if (i < len && text[i] == '\n') line++;
+    i++;
+    if (!nt) continue;
+    if (overflow) return fail("statement too long");
+    if (out.n >= PROTO_MAX_STEPS) return fail("too many statements");
+    ProtoStep st{}; long v;
+    const char* k = tok[0];
+    if (tok_eq(k, "fwd") || tok_eq(k, "rev")){
+      if (nt != 3) return fail("expected: fwd|rev <pwm> <dur>");
+      if (!parse_uint(tok[1], 0, 255, v)) return fail("pwm must be 0..255");
+      st.op = PROTO_SEG; st.mode = tok_eq(k, "fwd") ? 0 : 1; st.pwm = (uint8_t)v;
+      if (!parse_dur(tok[2], lim.hz, st.ticks)) return fail("bad duration");
+    } else if (tok_eq(k, "beat")){
+      if (nt != 4) return fail("expected: beat <pwm> <bpm> <dur>");
+      if (!parse_uint(tok[1], 0, 255, v)) return fail("pwm must be 0..255");
+      st.op = PROTO_SEG; st.mode = 2; st.pwm = (uint8_t)v;
+      if (!parse_uint(tok[2], lim.bpmMin, lim.bpmMax, v)) return fail("bpm out of range");
+      st.bpm = (uint16_t)v;
+      if (!parse_dur(tok[3], lim.hz, st.ticks)) return fail("bad duration");
+    } else if (tok_eq(k, "pause")){
+      if (nt != 2) return fail("expected: pause <dur>");
+      st.op = PROTO_PAUSE;
+      if (!parse_dur(tok[1], lim.hz, st.ticks)) return fail("bad duration");
+    } else if (tok_eq(k, "loop")){
+      if (nt != 2 || !parse_uint(tok[1], 1, 10000, v)) return fail("expected: loop <1..10000>");
+      if (depth == PROTO_MAX_DEPTH) return fail("loops nested too deep");
+      st.op = PROTO_LOOP; st.count = (uint16_t)v;
+      open[depth++] = out.n;
+    } else if (tok_eq(k, "end")){
+      if (nt != 1) return fail("expected: end");
+      if (!depth) return fail("end without loop");
+      uint8_t lp = open[--depth];
+      st.op = PROTO_END; st.match = lp; out.step[lp].match = out.n;
+      if (lp + 1 == out.n) return fail("empty loop");
+    } else {
+      return fail("unknown statement");
+    }
+    out.step[out.n++] = st;
+  }
+  at = 0;
+  if (depth) return fail("loop without end");
+  bool any = false;
+  for (uint8_t j=0;j<out.n;j++) if (out.step[j].op == PROTO_SEG || out.step[j].op == PROTO_PAUSE) any = true;
+  if (!any) return fail("no segments");
+  return true;
+}
+
+static uint64_t total_range(const Protocol& p, uint8_t from, uint8_t to){
+  uint64_t t = 0;
+  for (uint8_t i=from; i<to; i++){
+    const ProtoStep& s = p.step[i];
+    if (s.op == PROTO_LOOP){ t += (uint64_t)s.count * total_range(p, i+1, s.match); i = s.match; }
+    else if (s.op != PROTO_END) t += s.ticks;
+  }
+  return t;
+}
+
+uint64_t protocol_total_ticks(const Protocol& p){ return total_range(p, 0, p.n); }
+
+void ProtoRunner::start(const Protocol* p){
+  p_ = p; depth_ = 0; pc_ = 0; idx_ = 0; left_ = 0; elapsed_ = 0;
+  total_ = p ? protocol_total_ticks(*p) : 0;
+}
+
+bool ProtoRunner::next_segment(){
+  while (pc_ < p_->n){
+    const ProtoStep& s = p_->step[pc_];
+    if (s.op == PROTO_LOOP){
+      stack_[depth_++] = Frame{ pc_, s.count, s.count };
+      pc_++;
+    } else if (s.op == PROTO_END){
+      Frame& f = stack_[depth_-1];
+      if (--f.left > 0) pc_ = f.start + 1;
+      else { depth_--; pc_++; }
+    } else {
+      cur_ = s; left_ = s.ticks; idx_ = pc_; pc_++;
+      return true;
+    }
+  }
+  return false;
+}
+
+ProtoEvent ProtoRunner::tick(ProtoStep& seg){
+  if (!p_) return PROTO_IDLE;
+  ProtoEvent ev = PROTO_HOLD;
+  if (left_ == 0){
+    if (!next_segment()){ p_ = nullptr; return PROTO_DONE; }
+    seg = cur_; ev = PROTO_ENTER;
+  }
+  left_--; elapsed_++;
+  return ev;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+
+/* ==========================================================================================
+   pumpmap.h — Pump characterization: PWM → flow lookup and the sweep that measures it
+   ------------------------------------------------------------------------------------------
+   • PumpMap holds PUMPMAP_N evenly spaced PWM points per valve direction with the measured
+     flow (L/min, magnitude). Tables are made monotonic (pool-adjacent-violators) so the
+     inverse lookup (flow → PWM, used as feed-forward) is single-valued.
+   • PumpSweep steps the PWM through every point, FWD then REV, and records the mean flow
+     once the estimate has settled (window max−min within tolerance) or a timeout expires.
+     It only requests a valve change together with PWM 0; the caller ramps and flips.
+   • Pure logic (no Arduino/FreeRTOS) so it also builds in host tests.
+   ==========================================================================================*/
+
+static constexpr uint8_t PUMPMAP_N       = 16;   // points per direction (0, 17, … 255)
+static constexpr uint8_t PUMPMAP_VERSION = 1;    // bump when the stored layout changes
+
+struct PumpMap {
+  uint8_t version = PUMPMAP_VERSION;
+  uint8_t measured = 0;                  // 0 = default estimate, 1 = from a sweep
+  uint8_t timeouts = 0;                  // points recorded on timeout instead of settling
+  uint8_t reserved = 0;
+  float   lpm[2][PUMPMAP_N]{};           // [valve][point], valve 0=FWD, 1=REV
+};
+
+static inline uint8_t pumpmap_pwm(uint8_t i){ return (uint8_t)((uint16_t)i * 255u / (PUMPMAP_N - 1)); }
+
+// Straight-line estimate used until a sweep has been stored
+void  pumpmap_default(PumpMap& m, float maxLpm, uint8_t deadbandPwm);
+// Isotonic (non-decreasing) fit in place; negative readings clamp to 0
+void  pumpmap_monotonic(float* lpm, uint8_t n);
+float pumpmap_flow(const PumpMap& m, uint8_t valve, float pwm);     // interpolated L/min
+float pumpmap_pwm_for(const PumpMap& m, uint8_t valve, float lpm);  // inverse, 0..255
+
+struct SweepCfg {
+  uint32_t settleTicks;    // minimum wait after each PWM step (covers the ramp)
+  uint32_t windowTicks;    // stability window
+  uint32_t timeoutTicks;   // give up waiting and record the latest window mean
+  float    tolLpm;         // window max−min must be ≤ max(tolLpm, tolPct·mean)
+  float    tolPct;
+};
+struct SweepOut { uint8_t pwm; uint8_t valve; };
+enum SweepEvent : uint8_t { SWEEP_IDLE, SWEEP_RUN, SWEEP_DONE };
+
+class PumpSweep {
+public:
+  void       start(const SweepCfg& c);
+  void       stop() { run_ = false; }
+  bool       running() const { return run_; }
+  SweepEvent tick(float flowLpm, SweepOut& out);       // one control tick
+  uint8_t    progressPct() const;
+  const PumpMap& result() const { return map_; }       // monotonic after SWEEP_DONE
+
+private:
+  void       nextWindow() { wN_ = 0; wSum_ = 0; wMin_ = 1e9f; wMax_ = -1e9f; }
+  SweepCfg   cfg_{};
+  PumpMap    map_{};
+  bool       run_ = false;
+  uint8_t    dir_ = 0, idx_ = 0;
+  uint32_t   t_ = 0, wN_ = 0;
+  float      wSum_ = 0, wMin_ = 0, wMax_ = 0, lastMean_ = 0;
+};
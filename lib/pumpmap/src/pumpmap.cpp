@@ -0,0 +1,88 @@
+#include "pumpmap.h"
+
+void pumpmap_default(PumpMap& m, float maxLpm, uint8_t deadbandPwm){
+  m = PumpMap{};
+  for (uint8_t d = 0; d < 2; d++)
+    for (uint8_t i = 0; i < PUMPMAP_N; i++){
+      float p = pumpmap_pwm(i);
+      m.lpm[d][i] = (p <= deadbandPwm) ? 0.0f : maxLpm * (p - deadbandPwm) / (255.0f - deadbandPwm);
+    }
+}
+
+void pumpmap_monotonic(float* y, uint8_t n){
+  // pool adjacent violators: blocks of (mean, weight), merged while a block is below its predecessor
+  float mean[PUMPMAP_N]; uint8_t w[PUMPMAP_N]; uint8_t b = 0;
+  if (n > PUMPMAP_N) n = PUMPMAP_N;
+  for (uint8_t i = 0; i < n; i++){
+    mean[b] = y[i] < 0 ? 0 : y[i]; w[b] = 1; b++;
+    while (b > 1 && mean[b-2] > mean[b-1]){
+      mean[b-2] = (mean[b-2]*w[b-2] + mean[b-1]*w[b-1]) / (w[b-2] + w[b-1]);
+      w[b-2] += w[b-1]; b--;
+    }
+  }
+  uint8_t k = 0;
+  for (uint8_t j = 0; j < b; j++) for (uint8_t r = 0; r < w[j]; r++) y[k++] = mean[j];
+}
+
+float pumpmap_flow(const PumpMap& m, uint8_t valve, float pwm){
+  const float* f = m.lpm[valve ? 1 : 0];
+  if (pwm <= 0) return f[0];
+  if (pwm >= 255) return f[PUMPMAP_N-1];
+  float x = pwm * (PUMPMAP_N - 1) / 255.0f;
+  uint8_t i = (uint8_t)x; float fr = x - i;
+  return f[i] + (f[i+1] - f[i]) * fr;
+}
+
+float pumpmap_pwm_for(const PumpMap& m, uint8_t valve, float lpm){
+  const float* f = m.lpm[valve ? 1 : 0];
+  if (lpm <= f[0]) return 0;
+  for (uint8_t i = 0; i + 1 < PUMPMAP_N; i++){
+    if (f[i+1] >= lpm && f[i+1] > f[i]){
+      float p0 = pumpmap_pwm(i), p1 = pumpmap_pwm(i+1);
+      return p0 + (lpm - f[i]) / (f[i+1] - f[i]) * (p1 - p0);
+    }
+  }
+  return 255;                              // beyond the measured range: full drive
+}
+
+void PumpSweep::start(const SweepCfg& c){
+  cfg_ = c; map_ = PumpMap{}; map_.measured = 1;
+  run_ = true; dir_ = 0; idx_ = 0; t_ = 0; lastMean_ = 0;
+  nextWindow();
+}
+
+uint8_t PumpSweep::progressPct() const {
+  if (!run_) return 100;
+  return (uint8_t)((dir_ * PUMPMAP_N + idx_) * 100u / (2u * PUMPMAP_N));
+}
+
+SweepEvent PumpSweep::tick(float flow, SweepOut& out){
+  if (!run_) return SWEEP_IDLE;
+  out.pwm = pumpmap_pwm(idx_); out.valve = dir_;
+  if (++t_ <= cfg_.settleTicks) return SWEEP_RUN;
+
+  // block statistics over windowTicks; accept the first quiet window
+  wSum_ += flow; wN_++;
+  if (flow < wMin_) wMin_ = flow;
+  if (flow > wMax_) wMax_ = flow;
+  bool record = false;
+  if (wN_ >= cfg_.windowTicks){
+    lastMean_ = wSum_ / wN_;
+    float tol = cfg_.tolPct * lastMean_; if (tol < cfg_.tolLpm) tol = cfg_.tolLpm;
+    record = (wMax_ - wMin_) <= tol;
+    if (!record && t_ >= cfg_.timeoutTicks){ record = true; map_.timeouts++; }
+    nextWindow();
+  }
+  if (!record) return SWEEP_RUN;
+
+  map_.lpm[dir_][idx_] = lastMean_;
+  t_ = 0;
+  if (++idx_ < PUMPMAP_N){ out.pwm = pumpmap_pwm(idx_); return SWEEP_RUN; }
+  idx_ = 0;
+  if (++dir_ < 2){ out.pwm = 0; out.valve = dir_; return SWEEP_RUN; }   // point 0 covers ramp-down + flip
+  pumpmap_monotonic(map_.lpm[0], PUMPMAP_N);
+  pumpmap_monotonic(map_.lpm[1], PUMPMAP_N);
+  run_ = false; dir_ = 0;
+  out.pwm = 0; out.valve = 0;
+  return SWEEP_DONE;
+}
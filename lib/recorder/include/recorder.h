@@ -0,0 +1,57 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "app_config.h"
+#include "logfmt.h"
+
+/* ==========================================================================================
+   recorder.h — Flight recorder: per-tick samples to a pre-erased flash partition
+   Ownership:
+     • Core 1 (control) pushes one LogSample per tick into an SPSC ring while recording; it
+       never blocks and counts drops if the writer falls behind.
+     • A low-priority task on Core 0 drains the ring and delta-encodes into LOG_BLOCK_BYTES
+       blocks (logfmt.h). The "reclog" partition (partitions.csv) is split into LOG_FILES_MAX
+       slots of LOG_FILE_BYTES; a recording fills one slot, block by block.
+     • Web handlers list recordings and stream them from the memory-mapped partition. A
+       download pins its slot, so neither a delete nor the writer retires it mid-stream.
+   Flash stalls: any SPI flash erase or write turns the cache off on both cores, and the
+   control loop runs from flash, so it stops for the whole operation. Hence:
+     • Sectors are erased only while the pump is paused with PWM 0 (outputs off), one per
+       writer pass. One slot is kept erased for the next recording; the oldest recording is
+       retired to make room, so LOG_FILES_MAX − 1 are kept. Unpausing during an erase waits
+       for that sector, with the pump still off.
+     • While running, blocks go into already-erased sectors as 256-byte page programs with a
+       1 ms gap between pages, so Core 1 loses at most the tick(s) under one page program.
+     • Expected cost, from the flash datasheets (not yet measured on this board): page
+       program ≈ 0.4–0.8 ms (0–1 missed tick at 600 Hz, 16 per block); 4 KB sector erase
+       ≈ 45 ms typical, up to 400 ms (≈ 27 ticks typical). rec_ctr records the worst write
+       and erase times and the control overruns seen during each; read them at /metrics.
+     • Recording starts on demand (LOG_AUTOSTART false). When the slots fill while running,
+       samples are dropped (counted) until the pump pauses and a slot can be erased.
+   ==========================================================================================*/
+
+struct RecFile { char name[16]; uint32_t size; bool active; };
+
+struct RecCounters {
+  std::atomic<uint32_t> blocks{0};          // blocks written
+  std::atomic<uint32_t> dropped{0};         // samples lost (ring full, no erased slot or write failure)
+  std::atomic<uint32_t> files{0};           // recordings started since boot
+  std::atomic<uint32_t> erases{0};          // sectors erased
+  std::atomic<uint32_t> writeUsMax{0};      // slowest block write (all pages, gaps excluded)
+  std::atomic<uint32_t> eraseUsMax{0};      // slowest sector erase
+  std::atomic<uint32_t> writeOverruns{0};   // control overruns counted during block writes
+  std::atomic<uint32_t> eraseOverruns{0};   // control overruns counted during sector erases
+};
+extern RecCounters rec_ctr;
+
+void    recorder_begin();                        // map the partition, scan slots, start the writer (Core 0)
+void    recorder_push(const LogSample& s);       // Core 1, every tick; no-op when stopped
+bool    recorder_start();                        // false: no partition, or no erased slot yet (pause first)
+void    recorder_stop();                         // flush the partial block and close
+bool    recorder_recording();
+uint8_t recorder_list(RecFile* out, uint8_t max);   // oldest first
+// Mapped bytes of a listed recording (whole blocks written so far) and a pin that keeps its
+// slot from being retired or erased until recorder_close(); -1 if unknown
+int8_t  recorder_open(const char* name, const uint8_t** data, uint32_t* size);
+void    recorder_close(int8_t pin);
+bool    recorder_remove(const char* name);       // refuses the file being written or downloaded; erased once paused
@@ -0,0 +1,253 @@
+#include "recorder.h"
+#include <esp_partition.h>
+#include "shared.h"
+#include "control.h"
+
+RecCounters rec_ctr;
+
+static constexpr uint16_t SLOT_BLOCKS = LOG_FILE_BYTES / LOG_BLOCK_BYTES;   // one block per sector
+static constexpr uint16_t PAGE_BYTES  = 256;                                // one flash page program
+static_assert(LOG_FILE_BYTES % LOG_BLOCK_BYTES == 0 && LOG_FILE_BYTES / LOG_BLOCK_BYTES <= 0xFFFF, "whole blocks per slot");
+static_assert(LOG_BLOCK_BYTES % PAGE_BYTES == 0, "whole pages per block");
+
+// A block's seq is file << 16 | index within the recording, so a slot names itself after a reboot
+enum SlotState : uint8_t { SLOT_ERASED, SLOT_USED, SLOT_RETIRED /*waiting for erase*/ };
+struct Slot { uint16_t file = 0, blocks = 0, erased = 0; SlotState st = SLOT_RETIRED; };
+
+static SpscRing<LogSample, 1024> s_ring;           // ~1.7 s of slack at 600 Hz
+static std::atomic<bool> s_want{LOG_AUTOSTART};    // recording requested
+static std::atomic<uint16_t> s_active{0};          // file number being written, 0 = none
+static const esp_partition_t* s_part = nullptr;
+static const uint8_t* s_map = nullptr;             // whole partition, read through the cache
+static spi_flash_mmap_handle_t s_mapHandle;
+static uint8_t s_nSlots = 0;
+static Slot s_slot[LOG_FILES_MAX];                 // writer task; web handlers copy under s_mux
+static uint8_t s_pins[LOG_FILES_MAX];              // downloads streaming each slot (under s_mux)
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint16_t s_nextFile = 1;                    // writer task only
+
+static bool newer(uint16_t a, uint16_t b){ return (int16_t)(a - b) > 0; }
+static Slot slot_get(uint8_t k){ portENTER_CRITICAL(&s_mux); Slot s = s_slot[k]; portEXIT_CRITICAL(&s_mux); return s; }
+static void slot_set(uint8_t k, const Slot& s){ portENTER_CRITICAL(&s_mux); s_slot[k] = s; portEXIT_CRITICAL(&s_mux); }
+static void note_max(std::atomic<uint32_t>& m, uint32_t v){ if (v > m.load(std::memory_order_relaxed)) m.store(v, std::memory_order_relaxed); }
+
+// Outputs off and nothing else driving them: a flash stall cannot hurt
+static bool pump_off(){ return G.paused.load() == 1 && G.pwmOut.load() == 0 && !G.overrideOutputs.load(); }
+
+void recorder_push(const LogSample& s){
+  if (!s_want.load(std::memory_order_relaxed)) return;
+  if (!s_ring.push(s)) rec_ctr.dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+static int8_t erased_slot(){
+  for (uint8_t k = 0; k < s_nSlots; k++) if (slot_get(k).st == SLOT_ERASED) return (int8_t)k;
+  return -1;
+}
+
+bool recorder_start(){
+  if (!s_part || (!s_active.load() && erased_slot() < 0)) return false;
+  s_want.store(true);
+  return true;
+}
+void recorder_stop(){ s_want.store(false); }
+bool recorder_recording(){ return s_active.load() != 0; }
+
+// "r00012.slg" → 12, anything else → 0
+static uint16_t file_number(const char* name){
+  if (name[0] != 'r' || strlen(name) != 10 || strcmp(name + 6, ".slg") != 0) return 0;
+  uint32_t n = 0;
+  for (uint8_t i = 1; i < 6; i++){ if (name[i] < '0' || name[i] > '9') return 0; n = n*10 + (name[i] - '0'); }
+  return n <= 0xFFFF ? (uint16_t)n : 0;
+}
+
+// Caller holds s_mux
+static int8_t find_file_locked(uint16_t num){
+  for (uint8_t k = 0; num && k < s_nSlots; k++) if (s_slot[k].st == SLOT_USED && s_slot[k].file == num) return (int8_t)k;
+  return -1;
+}
+
+// Retire slot k unless a download is streaming it
+static bool retire_unpinned(uint8_t k){
+  portENTER_CRITICAL(&s_mux);
+  const bool ok = s_pins[k] == 0;
+  if (ok) s_slot[k] = Slot{};
+  portEXIT_CRITICAL(&s_mux);
+  return ok;
+}
+
+uint8_t recorder_list(RecFile* out, uint8_t max){
+  uint8_t n = 0;
+  for (uint8_t k = 0; k < s_nSlots && n < max; k++){
+    const Slot s = slot_get(k);
+    if (s.st != SLOT_USED) continue;
+    RecFile r; snprintf(r.name, sizeof(r.name), "r%05u.slg", (unsigned)s.file);
+    r.size = (uint32_t)s.blocks * LOG_BLOCK_BYTES; r.active = (s.file == s_active.load());
+    uint8_t i = n++;                                   // insertion sort, oldest first
+    while (i && newer(file_number(out[i-1].name), s.file)){ out[i] = out[i-1]; i--; }
+    out[i] = r;
+  }
+  return n;
+}
+
+int8_t recorder_open(const char* name, const uint8_t** data, uint32_t* size){
+  const uint16_t num = file_number(name);
+  portENTER_CRITICAL(&s_mux);
+  const int8_t k = find_file_locked(num);
+  if (k >= 0){ s_pins[k]++; *size = (uint32_t)s_slot[k].blocks * LOG_BLOCK_BYTES; }
+  portEXIT_CRITICAL(&s_mux);
+  if (k >= 0) *data = s_map + (uint32_t)k * LOG_FILE_BYTES;
+  return k;
+}
+
+void recorder_close(int8_t k){
+  if (k < 0 || k >= (int8_t)s_nSlots) return;
+  portENTER_CRITICAL(&s_mux);
+  if (s_pins[k]) s_pins[k]--;
+  portEXIT_CRITICAL(&s_mux);
+}
+
+bool recorder_remove(const char* name){
+  const uint16_t num = file_number(name);
+  if (!num || num == s_active.load()) return false;
+  portENTER_CRITICAL(&s_mux);
+  const int8_t k = find_file_locked(num);
+  const bool ok = k >= 0 && s_pins[k] == 0;
+  if (ok) s_slot[k] = Slot{};                          // retired: erased by the writer once paused
+  portEXIT_CRITICAL(&s_mux);
+  return ok;
+}
+
+// ---- Writer task (Core 0) ----
+static bool write_block(uint32_t off, const uint8_t* b){
+  const uint32_t ov0 = control_ctr.overruns.load(std::memory_order_relaxed);
+  uint32_t us = 0;
+  for (uint16_t p = 0; p < LOG_BLOCK_BYTES; p += PAGE_BYTES){
+    const uint32_t t0 = micros();
+    const bool ok = esp_partition_write(s_part, off + p, b + p, PAGE_BYTES) == ESP_OK;
+    us += micros() - t0;
+    if (!ok) return false;
+    vTaskDelay(1);                                     // Core 1 runs between page programs
+  }
+  note_max(rec_ctr.writeUsMax, us);
+  rec_ctr.writeOverruns.fetch_add(control_ctr.overruns.load(std::memory_order_relaxed) - ov0, std::memory_order_relaxed);
+  return true;
+}
+
+// One sector per call, pump off only: finish a retired slot, or retire the oldest recording
+// that no download is reading when no erased slot is left
+static void erase_step(int8_t cur){
+  int8_t k = -1;
+  for (uint8_t i = 0; i < s_nSlots && k < 0; i++) if (slot_get(i).st == SLOT_RETIRED) k = (int8_t)i;
+  if (k < 0){
+    if (erased_slot() >= 0) return;
+    for (uint8_t i = 0; i < s_nSlots; i++){
+      const Slot s = slot_get(i);
+      if ((int8_t)i != cur && s.st == SLOT_USED && (k < 0 || newer(slot_get(k).file, s.file))) k = (int8_t)i;
+    }
+    if (k < 0 || !retire_unpinned((uint8_t)k)) return;   // pinned: try again once it is closed
+  }
+  Slot s = slot_get(k);
+  const uint32_t ov0 = control_ctr.overruns.load(std::memory_order_relaxed);
+  const uint32_t t0 = micros();
+  const bool ok = esp_partition_erase_range(s_part, (uint32_t)k * LOG_FILE_BYTES + (uint32_t)s.erased * LOG_BLOCK_BYTES,
+                                            LOG_BLOCK_BYTES) == ESP_OK;
+  note_max(rec_ctr.eraseUsMax, micros() - t0);
+  rec_ctr.eraseOverruns.fetch_add(control_ctr.overruns.load(std::memory_order_relaxed) - ov0, std::memory_order_relaxed);
+  if (!ok) return;                                     // retried on the next pass
+  rec_ctr.erases.fetch_add(1, std::memory_order_relaxed);
+  if (++s.erased == SLOT_BLOCKS) s.st = SLOT_ERASED;
+  slot_set(k, s);
+}
+
+static LogCal cal_now(){
+  CfgProfile c; G.cal.read(c);
+  return LogCal{ c.atr.m, c.atr.b, c.vent.m, c.vent.b, c.flow.m, c.flow.b };
+}
+
+static void recorder_task(void*){
+  static LogBlockWriter w;                         // 4 KB block buffer, off the task stack
+  int8_t cur = -1;                                 // slot being written
+  bool begun = false;
+  auto close = [&](){ s_active.store(0); cur = -1; begun = false; };
+  auto open = [&]() -> bool {
+    const int8_t k = erased_slot();
+    if (k < 0) return false;
+    s_active.store(s_nextFile);                    // before it is listed: never removable
+    slot_set(k, Slot{ s_nextFile, 0, 0, SLOT_USED });
+    cur = k;
+    if (++s_nextFile == 0) s_nextFile = 1;
+    rec_ctr.files.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  };
+  auto begin = [&](){
+    const Slot s = slot_get(cur);
+    w.begin((uint32_t)s.file << 16 | s.blocks, CONTROL_HZ, cal_now(), millis()); begun = true;
+  };
+  auto flush = [&](){
+    Slot s = slot_get(cur);
+    if (!write_block((uint32_t)cur * LOG_FILE_BYTES + (uint32_t)s.blocks * LOG_BLOCK_BYTES, w.seal())){
+      rec_ctr.dropped.fetch_add(w.count(), std::memory_order_relaxed);
+      s.st = SLOT_RETIRED; s.erased = 0; slot_set(cur, s); close(); return;
+    }
+    s.blocks++; slot_set(cur, s);
+    rec_ctr.blocks.fetch_add(1, std::memory_order_relaxed);
+    begun = false;
+    if (s.blocks >= SLOT_BLOCKS) close();          // the next sample moves to the erased slot
+  };
+  for(;;){
+    vTaskDelay(pdMS_TO_TICKS(LOG_TASK_MS));
+    const bool want = s_want.load();
+    if (want && cur < 0) open();
+    LogSample s;
+    while (s_ring.pop(s)){
+      if (cur < 0 && !(want && open())){ rec_ctr.dropped.fetch_add(1, std::memory_order_relaxed); continue; }
+      if (!begun) begin();
+      if (!w.add(s)){
+        flush();
+        if (cur < 0 && !open()){ rec_ctr.dropped.fetch_add(1, std::memory_order_relaxed); continue; }
+        begin(); w.add(s);
+      }
+    }
+    if (!want && cur >= 0){ if (begun && w.count()) flush(); if (cur >= 0) close(); }
+    if (pump_off()) erase_step(cur);
+  }
+}
+
+static bool all_erased(const uint8_t* p, uint32_t n){
+  const uint32_t* w = (const uint32_t*)p;
+  for (uint32_t i = 0; i < n / 4; i++) if (w[i] != 0xFFFFFFFFu) return false;
+  return true;
+}
+
+// Rebuild the slot table from the blocks themselves (reads only: no flash stall)
+static void scan(){
+  bool any = false; uint16_t newest = 0;
+  for (uint8_t k = 0; k < s_nSlots; k++){
+    const uint8_t* base = s_map + (uint32_t)k * LOG_FILE_BYTES;
+    Slot s;
+    LogBlockReader rd;
+    if (rd.open(base, LOG_BLOCK_BYTES) && (rd.info().seq & 0xFFFF) == 0 && (rd.info().seq >> 16)){
+      s.file = (uint16_t)(rd.info().seq >> 16); s.st = SLOT_USED;
+      while (s.blocks < SLOT_BLOCKS && rd.open(base + (uint32_t)s.blocks * LOG_BLOCK_BYTES, LOG_BLOCK_BYTES) &&
+             rd.info().seq == ((uint32_t)s.file << 16 | s.blocks)) s.blocks++;
+      if (!any || newer(s.file, newest)){ newest = s.file; any = true; }
+    } else if (all_erased(base, LOG_FILE_BYTES)){
+      s.st = SLOT_ERASED; s.erased = SLOT_BLOCKS;
+    }
+    s_slot[k] = s;
+  }
+  if (any) s_nextFile = newest == 0xFFFF ? 1 : newest + 1;   // continue after the newest
+}
+
+void recorder_begin(){
+  s_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)LOG_PART_SUBTYPE, LOG_PART_NAME);
+  const uint32_t fit = s_part ? s_part->size / LOG_FILE_BYTES : 0;
+  s_nSlots = fit < LOG_FILES_MAX ? (uint8_t)fit : LOG_FILES_MAX;
+  if (s_nSlots < 2 || esp_partition_mmap(s_part, 0, (uint32_t)s_nSlots * LOG_FILE_BYTES, SPI_FLASH_MMAP_DATA,
+                                         (const void**)&s_map, &s_mapHandle) != ESP_OK){
+    Serial.println("[REC] no usable \"reclog\" partition; recorder off");
+    s_part = nullptr; s_nSlots = 0; s_want.store(false); return;
+  }
+  scan();
+  xTaskCreatePinnedToCore(recorder_task, "rec", 4096, nullptr, 1, nullptr, CORE_WEB);
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "jsonio.h"
+
+/* ==========================================================================================
+   runbatch.h — Compound run-state change applied by the control loop in one tick
+   ------------------------------------------------------------------------------------------
+   • Body (POST /api/batch), any non-empty subset, unknown keys rejected:
+       {"mode":2,"pwm":180,"bpm":60,"press":90,"pressBeat":true,"flow":-3.5,"run":true}
+     Values outside the limits are errors, not clamps, and nothing is applied.
+   • batch_plan() turns a batch plus the current run state into the next state and the side
+     effects the loop must run once each (restart the direction-change seq, rebuild the beat
+     table, …). The loop stores every field before it computes outputs, so a tick sees either
+     all of the old settings or all of the new ones.
+   • Same rules as the single commands: a mode change (or a flow sign flip in FLOW) while
+     running goes through one seq; starting from a full pause opens directly in the new mode;
+     "run":true is refused while a fault is latched, the other fields still apply.
+   • Pure logic (no Arduino/FreeRTOS) so it builds in host tests.
+   ==========================================================================================*/
+
+static constexpr int32_t BATCH_MODE_FLOW = 4;      // MODE_FLOW: the flow sign picks the valve
+
+// RunBatch::has bits, in BATCH_FIELDS order
+enum : uint8_t { RB_MODE = 1, RB_PWM = 2, RB_BPM = 4, RB_PRESS = 8, RB_PRESS_BEAT = 16, RB_FLOW = 32, RB_RUN = 64 };
+
+struct RunBatch {
+  int32_t mode = 0, pwm = 0, bpm = 0;
+  float   press = 0, flow = 0;
+  bool    pressBeat = false, run = false;
+  uint8_t has = 0;                 // RB_* of the fields present
+};
+
+struct BatchLimits { uint8_t modeMax; uint16_t bpmMin, bpmMax; float pressMax, flowMax; };
+
+enum BatchErr : uint8_t { BATCH_OK, BATCH_BAD_JSON, BATCH_UNKNOWN_KEY, BATCH_EMPTY, BATCH_RANGE };
+
+// Bind table over RunBatch, for bodies fed chunk by chunk (see web_json_body)
+static constexpr uint8_t BATCH_NFIELDS = 7;
+extern const JsonField BATCH_FIELDS[BATCH_NFIELDS];
+
+// Validate a finished bind into b (bind.dst): fills b.has. On an error tied to one member,
+// *field is its key, otherwise "".
+BatchErr    batch_check(JsonStatus st, const JsonBind& bind, const BatchLimits& lim, RunBatch& b, const char** field);
+// Whole body at once
+BatchErr    batch_parse(const char* p, size_t n, const BatchLimits& lim, RunBatch& b, const char** field);
+const char* batch_err_name(BatchErr e);
+
+// Run state the batch applies to (the UI-level settings in Shared)
+struct RunState {
+  int32_t mode = 0, pwm = 0, bpm = 0;
+  float   press = 0, flow = 0;
+  bool    pressBeat = false;
+  uint8_t paused = 1;              // 0 = run, 1 = paused, 2 = ramping down to pause
+  bool    fault = false;
+};
+
+// Side effects, each at most once per batch
+enum : uint8_t { BA_SEQ = 1, BA_REBUILD_BEAT = 2, BA_RESTART_PEAK = 4, BA_UNPAUSE = 8, BA_PAUSE = 16,
+                 BA_RUN_REFUSED = 32 };
+
+uint8_t batch_plan(const RunBatch& b, RunState& s);   // s becomes the next state; returns BA_*
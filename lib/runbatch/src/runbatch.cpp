@@ -0,0 +1,82 @@
+#include "runbatch.h"
+#include <math.h>
+
+const JsonField BATCH_FIELDS[BATCH_NFIELDS] = {
+  { "mode", JK_INT, offsetof(RunBatch, mode), 0 },       { "pwm", JK_INT, offsetof(RunBatch, pwm), 0 },
+  { "bpm", JK_INT, offsetof(RunBatch, bpm), 0 },         { "press", JK_FLOAT, offsetof(RunBatch, press), 0 },
+  { "pressBeat", JK_BOOL, offsetof(RunBatch, pressBeat), 0 }, { "flow", JK_FLOAT, offsetof(RunBatch, flow), 0 },
+  { "run", JK_BOOL, offsetof(RunBatch, run), 0 },
+};
+
+static uint8_t first_bit(uint32_t m){ uint8_t i = 0; while (!(m & 1u)){ m >>= 1; i++; } return i; }
+
+BatchErr batch_check(JsonStatus st, const JsonBind& bind, const BatchLimits& lim, RunBatch& b, const char** field){
+  *field = "";
+  if (bind.bad){ *field = BATCH_FIELDS[first_bit(bind.bad)].key; return BATCH_BAD_JSON; }
+  if (st != JSON_DONE) return BATCH_BAD_JSON;
+  if (bind.other) return BATCH_UNKNOWN_KEY;
+  b.has = (uint8_t)bind.seen;
+  if (!b.has) return BATCH_EMPTY;
+  uint8_t out = 0;
+  if ((b.has & RB_MODE) && (b.mode < 0 || b.mode > lim.modeMax)) out |= RB_MODE;
+  if ((b.has & RB_PWM) && (b.pwm < 0 || b.pwm > 255)) out |= RB_PWM;
+  if ((b.has & RB_BPM) && (b.bpm < lim.bpmMin || b.bpm > lim.bpmMax)) out |= RB_BPM;
+  if ((b.has & RB_PRESS) && !(b.press >= 0 && b.press <= lim.pressMax)) out |= RB_PRESS;      // NaN fails too
+  if ((b.has & RB_FLOW) && !(fabsf(b.flow) <= lim.flowMax)) out |= RB_FLOW;
+  if (out){ *field = BATCH_FIELDS[first_bit(out)].key; return BATCH_RANGE; }
+  return BATCH_OK;
+}
+
+BatchErr batch_parse(const char* p, size_t n, const BatchLimits& lim, RunBatch& b, const char** field){
+  b = RunBatch{};
+  JsonBind bind{ BATCH_FIELDS, BATCH_NFIELDS, &b, 0, 0, 0 };
+  const JsonStatus st = json_bind(bind, p, n);
+  return batch_check(st, bind, lim, b, field);
+}
+
+const char* batch_err_name(BatchErr e){
+  switch (e){
+    case BATCH_OK:          return "ok";
+    case BATCH_BAD_JSON:    return "bad json";
+    case BATCH_UNKNOWN_KEY: return "unknown key";
+    case BATCH_EMPTY:       return "nothing to apply";
+    case BATCH_RANGE:       return "out of range";
+  }
+  return "?";
+}
+
+uint8_t batch_plan(const RunBatch& b, RunState& s){
+  uint8_t act = 0;
+  const bool wasRunning = s.paused == 0;
+  const int32_t oldMode = s.mode;
+  const bool oldRev = s.flow < 0;
+
+  if (b.has & RB_PWM) s.pwm = b.pwm;
+  if ((b.has & RB_BPM) && b.bpm != s.bpm){ s.bpm = b.bpm; act |= BA_REBUILD_BEAT; }
+  if (b.has & RB_PRESS) s.press = b.press;
+  if (b.has & RB_PRESS_BEAT){
+    if (b.pressBeat && !s.pressBeat) act |= BA_RESTART_PEAK;   // start from feed-forward
+    s.pressBeat = b.pressBeat;
+  }
+  if (b.has & RB_FLOW) s.flow = b.flow;
+  if (b.has & RB_MODE) s.mode = b.mode;
+
+  if (b.has & RB_RUN){
+    if (b.run && s.paused){
+      if (s.fault) act |= BA_RUN_REFUSED;                       // latched fault: clear it first
+      else {
+        if (s.paused == 2) act |= BA_SEQ;                       // still ramping down: re-enter through the seq
+        s.paused = 0; act |= BA_UNPAUSE;
+      }
+    } else if (!b.run && s.paused == 0){
+      s.paused = 2; act |= BA_PAUSE;                            // ramp to zero, then pause
+    }
+  }
+
+  // Running before and after: one direction-change seq covers every change in the batch
+  if (wasRunning && s.paused == 0){
+    const bool flip = s.mode == BATCH_MODE_FLOW && oldMode == BATCH_MODE_FLOW && (s.flow < 0) != oldRev;
+    if (((b.has & RB_MODE) && s.mode != oldMode) || flip) act |= BA_SEQ;
+  }
+  return act;
+}
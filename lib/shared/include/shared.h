@@ -4,6 +4,7 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/queue.h>
 #include "app_config.h"
+#include "calprof.h"
 
 /* ==========================================================================================
    shared.h — Cross-core shared state & commands
@@ -16,12 +17,13 @@
 
 struct Shared {
   // ---- Settings / state (UI-level) ----
-  std::atomic<int>   mode{MODE_FWD};        // 0=FWD,1=REV,2=BEAT  (Core0 write via cmd → Core1 consumes)
+  std::atomic<int>   mode{MODE_FWD};        // 0=FWD,1=REV,2=BEAT,3=PRESS,4=FLOW(Core0 write via cmd → Core1 consumes)
   std::atomic<int>   paused{1};             // 0/1               (Core0 cmd / buttons on Core1)
   std::atomic<int>   pwmSet{180};           // 0..255 setpoint (Core0 cmd / buttons; Core1 ramps to this)
   std::atomic<int>   pwmOut{0};             // 0..255 actual hardware PWM (Core1 writes)
   std::atomic<int>   valve{VALVE_FWD};      // 0/1 current direction (Core1 writes; also raw override updates)
-  std::atomic<int>   bpm{30};               // [1..60]           (Core0 cmd)
+  std::atomic<int>   bpm{30};               // [BPM_MIN..BPM_MAX] (Core0 cmd)
+  std::atomic<int>   beatShape{0};          // 0=trapezoid,1=custom (Core1 writes when a shape goes live)
 
   // ---- Telemetry (calibrated where noted) ----
   std::atomic<float> atr_mmHg{0};           // calibrated (Core1 write)
@@ -29,15 +31,47 @@ struct Shared {
   std::atomic<float> flow_L_min{0};         // computed from flow Hz (Core1 write)
   std::atomic<float> loopMs{0};             // control loop EMA (Core1 write)
 
+  // ---- Beat timing (effective, after ramp/dead scaling; Core1 writes when a table goes live) ----
+  std::atomic<float> beatPeriodMs{0};
+  std::atomic<float> beatRampPct{0}, beatHoldPct{0}, beatDeadPct{0};
+
+  // ---- Closed-loop pressure (Core1 writes on CMD_SET_PRESS*) ----
+  std::atomic<float> pressTarget{PRESS_TARGET_DEFAULT}; // mmHg, MODE_PRESS setpoint and beat peak target
+  std::atomic<int>   pressBeat{0};          // 1 = beat drive tracks per-beat peak → pressTarget
+  std::atomic<float> pressPeak{0};          // peak vent mmHg of the last completed beat
+
+  // ---- Beat waveform learning (Core1 writes) ----
+  std::atomic<int>      ilcOn{0};           // 1 = per-phase corrections applied and learned
+  std::atomic<float>    ilcRms{0};          // mmHg, last complete beat vs target
+  std::atomic<uint32_t> ilcBeats{0};        // beats learned since the last reset
+
+  // ---- Flow setpoint & pump characterization (Core1 writes) ----
+  std::atomic<float> flowTarget{0};         // L/min for MODE_FLOW; negative = REV
+  std::atomic<int>   sweepState{0};         // 0=idle,1=running,2=done,3=aborted
+  std::atomic<int>   sweepPct{0};
+
+  // ---- Protection (Core1 writes) ----
+  std::atomic<int>   fault{0};              // latched ProtFault bits; outputs held off until cleared
+
+  // ---- Delivered volume (Core1 writes; calibrated from exact edge counts) ----
+  std::atomic<float> volFwdMl{0};           // cumulative mL with the valve FWD
+  std::atomic<float> volRevMl{0};           // cumulative mL with the valve REV
+  std::atomic<float> coLpm{0};              // rolling net output over the last HEMO_CO_SEGS beats/seconds
+
+  // ---- Protocol progress (Core1 writes) ----
+  std::atomic<int>      protoState{0};      // 0=none loaded,1=loaded,2=running,3=finished,4=aborted
+  std::atomic<int>      protoStep{0};       // statement index of the current segment
+  std::atomic<int>      protoIter{0};       // innermost loop iteration (1-based)
+  std::atomic<uint32_t> protoTicks{0};      // elapsed control ticks
+  std::atomic<uint32_t> protoTotal{0};      // total control ticks
+
   // ---- Raw diagnostics ----
   std::atomic<int>   atr_raw{0};            // ADC counts (Core1 write)
   std::atomic<int>   vent_raw{0};           // ADC counts (Core1 write)
   std::atomic<float> flow_hz{0};            // edges/sec/2 (Core1 write)
 
-  // ---- Calibration coefficients (runtime) ----
-  std::atomic<float> atr_m{CAL_ATR_DEFAULT.m},  atr_b{CAL_ATR_DEFAULT.b};
-  std::atomic<float> vent_m{CAL_VENT_DEFAULT.m},vent_b{CAL_VENT_DEFAULT.b};
-  std::atomic<float> flow_m{CAL_FLOW_DEFAULT.m},flow_b{CAL_FLOW_DEFAULT.b};
+  // ---- Calibration (runtime): the live profile, published whole (AsyncTCP writes) ----
+  CalPool cal;
 
   // ---- Calibration override gate (Core0 /cal writes; Core1 respects) ----
   std::atomic<int>      overrideOutputs{0};      // 1 = do not write to hardware from control loop
@@ -46,12 +80,63 @@ struct Shared {
 extern Shared G;
 
 // ---- Commands (Core0 → Core1) ----
-enum CmdType : uint8_t { CMD_TOGGLE, CMD_SET_PWM, CMD_SET_BPM, CMD_SET_MODE };
+enum CmdType : uint8_t { CMD_TOGGLE, CMD_SET_PWM, CMD_SET_BPM, CMD_SET_MODE, CMD_SET_SHAPE,
+                         CMD_PROTO_LOAD, CMD_PROTO_START, CMD_PROTO_STOP,
+                         CMD_SET_PRESS /*i = mmHg×10*/, CMD_SET_PRESS_BEAT, CMD_PRESS_TUNE,
+                         CMD_SET_FLOW /*i = L/min×100*/, CMD_SWEEP /*i = 1 start, 0 abort*/,
+                         CMD_ILC /*i = 0 off, 1 on, 2 reset*/, CMD_ILC_TARGET, CMD_TEMPLATE_RESET,
+                         CMD_VOLUME_RESET, CMD_STATS_WINDOW /*i = slot<<24 | ms*/,
+                         CMD_FAULT_CLEAR, CMD_PROTECT_CFG,
+                         CMD_CAPTURE /*i = 0 stop, 1 arm, 2 force*/, CMD_CAPTURE_CFG,
+                         CMD_BATCH /*i = batch id*/ };
 struct Cmd { CmdType t; int i; };
 
+// One-slot mailbox for payloads too large for a Cmd. Core 0 put()s then posts the matching
+// command; Core 1 take()s when it consumes that command. put() fails while a payload is pending.
+template <typename T>
+struct Mailbox {
+  T item{};
+  std::atomic<int> full{0};
+  bool put(const T& v){ if (full.load()) return false; item = v; full.store(1); return true; }
+  bool take(T& out){ if (!full.load()) return false; out = item; full.store(0); return true; }
+  void drop(){ full.store(0); }
+};
+
+// Lock-free single-producer / single-consumer ring for per-tick sample streams (Core 1 → Core 0).
+// N must be a power of two; push() fails instead of overwriting when full.
+template <typename T, uint16_t N>
+struct SpscRing {
+  static_assert((N & (N - 1)) == 0, "N must be a power of two");
+  T buf[N];
+  std::atomic<uint16_t> head{0}, tail{0};
+  bool push(const T& v){
+    uint16_t h = head.load(std::memory_order_relaxed);
+    if ((uint16_t)(h - tail.load(std::memory_order_acquire)) >= N) return false;
+    buf[h & (N - 1)] = v; head.store(h + 1, std::memory_order_release); return true;
+  }
+  bool pop(T& v){
+    uint16_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+    v = buf[t & (N - 1)]; tail.store(t + 1, std::memory_order_release); return true;
+  }
+};
+
 QueueHandle_t shared_cmdq();            // created in shared.cpp
-void         shared_init();             // create queue, init NVS cal load
+void         shared_init();             // create queue, load the stored configuration into G
 bool         shared_post(const Cmd&);   // non-blocking
 
+// ---- Persistent configuration (one CRC-checked blob in NVS, see cfgblob.h) ----
+// Setup and the AsyncTCP task only. Load migrates the old per-key calibration once; save
+// writes the selected calibrations from G in one NVS operation, and not at all if unchanged.
+bool shared_cfg_load();
+bool shared_cfg_save(bool atr, bool vent, bool flow);
+
+// ---- Calibration profiles (same tasks). The active profile is the one published in G.cal ----
+const Config& shared_cfg();                                    // stored table, read-only
+void shared_cal_publish(const CfgCal& atr, const CfgCal& vent, const CfgCal& flow);   // live only
+bool shared_cal_activate(uint8_t idx);                         // publish + persist
+int8_t shared_cal_clone(uint8_t from, const char* to);         // calp_add() codes, −3 = NVS failed
+bool shared_cal_delete(uint8_t idx);
+
 // ---- Helpers applying calibration ----
 static inline float apply_cal(float raw, float m, float b){ return m*raw + b; }
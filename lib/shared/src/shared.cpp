@@ -1,11 +1,14 @@
 #include <Preferences.h>
 #include "shared.h"
+#include "cfgblob.h"
 
 static QueueHandle_t g_q = nullptr;
 Shared G;
 
 // NVS keys
-static const char* NS_CAL = "cal";
+static const char* NS_CAL = "cal";                 // pre-blob calibration, one float per key
+static const char* NS_CFG = "cfg";
+static const char* const CFG_SLOT_KEY[2] = { "cfg0", "cfg1" };
 
 QueueHandle_t shared_cmdq(){ return g_q; }
 
@@ -14,25 +17,141 @@ bool shared_post(const Cmd& c){
   return xQueueSend(g_q, &c, 0) == pdTRUE;
 }
 
-static void load_cal_from_nvs(){
+// ---- Persistent configuration ----
+// Every valid Config has at least one profile; atr/vent/flow mirror the active one so older
+// firmware reading this blob still finds the calibration in use.
+static void cfg_fix_profiles(Config& c){
+  if (c.nProfiles == 0 || c.nProfiles > CFG_PROFILES || c.activeProfile >= c.nProfiles){
+    memset(c.profiles, 0, sizeof(c.profiles));
+    c.nProfiles = 0;
+    calp_add(c, "default", c.atr, c.vent, c.flow);
+    c.activeProfile = 0;
+  }
+  const CfgProfile& a = c.profiles[c.activeProfile];
+  c.atr = a.atr; c.vent = a.vent; c.flow = a.flow;
+}
+
+static Config cfg_defaults(){
+  Config c{};
+  c.atr  = CfgCal{ CAL_ATR_DEFAULT.m,  CAL_ATR_DEFAULT.b };
+  c.vent = CfgCal{ CAL_VENT_DEFAULT.m, CAL_VENT_DEFAULT.b };
+  c.flow = CfgCal{ CAL_FLOW_DEFAULT.m, CAL_FLOW_DEFAULT.b };
+  cfg_fix_profiles(c);
+  return c;
+}
+
+// s_cfg mirrors the newest stored blob (defaults until the first save); saves go to the other
+// slot. Called from setup() and afterwards only from the AsyncTCP task, so no lock.
+static Config   s_cfg = cfg_defaults();
+static uint32_t s_cfgGen = 0;
+static int8_t   s_cfgSlot = -1;                    // slot holding s_cfg, -1 = nothing stored
+
+static void cfg_to_G(const Config& c){ G.cal.publish(c.profiles[c.activeProfile]); }
+
+static bool cfg_write(const Config& c){
+  uint8_t blob[CFG_BLOB_BYTES];
+  const size_t n = cfg_encode(c, s_cfgGen + 1, blob);
+  const int8_t slot = s_cfgSlot == 0 ? 1 : 0;
   Preferences p;
-  // Open NVS namespace for read/write. Using read-write here avoids an
-  // ESP-IDF-level NOT_FOUND log when the namespace hasn't been created yet
-  // (first boot). We still treat failure as non-fatal and simply return.
+  if (!p.begin(NS_CFG, false)) return false;
+  const bool ok = p.putBytes(CFG_SLOT_KEY[slot], blob, n) == n;
+  p.end();
+  if (ok){ s_cfg = c; s_cfgGen++; s_cfgSlot = slot; }
+  return ok;
+}
+
+// First boot after the blob format: take the per-key calibration over, then drop the keys
+static void cfg_migrate_keys(){
+  Preferences p;
+  // read-write avoids an ESP-IDF NOT_FOUND log when the namespace doesn't exist yet
   if (!p.begin(NS_CAL, false)) return;
-  float am = p.getFloat("atr_m",  G.atr_m.load());
-  float ab = p.getFloat("atr_b",  G.atr_b.load());
-  float vm = p.getFloat("ven_m",  G.vent_m.load());
-  float vb = p.getFloat("ven_b",  G.vent_b.load());
-  float fm = p.getFloat("flo_m",  G.flow_m.load());
-  float fb = p.getFloat("flo_b",  G.flow_b.load());
+  const bool any = p.isKey("atr_m") || p.isKey("ven_m") || p.isKey("flo_m");
+  Config c = cfg_defaults();
+  c.atr.m  = p.getFloat("atr_m", c.atr.m);  c.atr.b  = p.getFloat("atr_b", c.atr.b);
+  c.vent.m = p.getFloat("ven_m", c.vent.m); c.vent.b = p.getFloat("ven_b", c.vent.b);
+  c.flow.m = p.getFloat("flo_m", c.flow.m); c.flow.b = p.getFloat("flo_b", c.flow.b);
+  c.nProfiles = 0; cfg_fix_profiles(c);
+  if (any && cfg_write(c)) p.clear();
   p.end();
-  G.atr_m.store(am);  G.atr_b.store(ab);
-  G.vent_m.store(vm); G.vent_b.store(vb);
-  G.flow_m.store(fm); G.flow_b.store(fb);
+  if (s_cfgSlot < 0) s_cfg = c;
+  cfg_to_G(c);
+}
+
+bool shared_cfg_load(){
+  static uint8_t buf[2][512];                      // room for blobs from a newer schema
+  Config c[2] = { cfg_defaults(), cfg_defaults() };
+  CfgInfo info[2];
+  bool valid[2] = { false, false };
+  uint32_t gen[2] = { 0, 0 };
+  Preferences p;
+  if (!p.begin(NS_CFG, false)) return false;
+  for (uint8_t i=0;i<2;i++){
+    const size_t len = p.getBytesLength(CFG_SLOT_KEY[i]);
+    if (!len || len > sizeof(buf[i]) || p.getBytes(CFG_SLOT_KEY[i], buf[i], len) != len) continue;
+    valid[i] = cfg_decode(buf[i], len, c[i], info[i]); gen[i] = info[i].gen;
+  }
+  p.end();
+  const int8_t k = cfg_pick(valid, gen);
+  if (k < 0){ cfg_migrate_keys(); return true; }
+  if (info[k].schema < 2) c[k].nProfiles = 0;      // schema 1 had no profiles: wrap its calibration
+  cfg_fix_profiles(c[k]);
+  s_cfg = c[k]; s_cfgGen = gen[k]; s_cfgSlot = k;
+  cfg_to_G(s_cfg);
+  if (info[k].schema != CFG_SCHEMA) cfg_write(s_cfg);   // store once in the current layout
+  return true;
+}
+
+bool shared_cfg_save(bool atr, bool vent, bool flow){
+  CfgProfile live; G.cal.read(live);
+  Config c = s_cfg;
+  CfgProfile& a = c.profiles[c.activeProfile];
+  if (atr){ a.atr = live.atr; }
+  if (vent){ a.vent = live.vent; }
+  if (flow){ a.flow = live.flow; }
+  cfg_fix_profiles(c);
+  if (s_cfgSlot >= 0 && memcmp(&c, &s_cfg, sizeof(Config)) == 0) return true;   // unchanged: no flash write
+  return cfg_write(c);
+}
+
+// ---- Calibration profiles ----
+const Config& shared_cfg(){ return s_cfg; }
+
+void shared_cal_publish(const CfgCal& atr, const CfgCal& vent, const CfgCal& flow){
+  CfgProfile p; G.cal.read(p);
+  p.atr = atr; p.vent = vent; p.flow = flow;
+  G.cal.publish(p);
+}
+
+// Persist first, then publish: a failed write leaves the running calibration alone
+bool shared_cal_activate(uint8_t idx){
+  if (idx >= s_cfg.nProfiles) return false;
+  Config c = s_cfg;
+  c.activeProfile = idx;
+  cfg_fix_profiles(c);
+  if (!cfg_write(c)) return false;
+  cfg_to_G(s_cfg);
+  return true;
+}
+
+int8_t shared_cal_clone(uint8_t from, const char* to){
+  if (from >= s_cfg.nProfiles) return -1;
+  CfgProfile src = s_cfg.profiles[from];
+  if (from == s_cfg.activeProfile) G.cal.read(src);  // include unsaved edits of the live profile
+  Config c = s_cfg;
+  const int8_t r = calp_add(c, to, src.atr, src.vent, src.flow);
+  if (r < 0) return r;
+  return cfg_write(c) ? r : -3;
+}
+
+bool shared_cal_delete(uint8_t idx){
+  Config c = s_cfg;
+  if (!calp_remove(c, idx)) return false;
+  cfg_fix_profiles(c);
+  return cfg_write(c);
 }
 
 void shared_init(){
   if (!g_q) g_q = xQueueCreate(16, sizeof(Cmd));
-  load_cal_from_nvs();
+  cfg_to_G(s_cfg);                                 // defaults until (and unless) NVS has a blob
+  shared_cfg_load();
 }
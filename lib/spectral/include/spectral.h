@@ -0,0 +1,41 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "app_config.h"
+#include "dsp.h"
+
+/* ==========================================================================================
+   spectral.h — Background spectral analysis of the pressure channels
+   Ownership:
+     • Core 1 (control) pushes one unsmoothed calibrated sample pair per tick into an SPSC
+       ring; it never blocks and counts drops if the analyzer falls behind.
+     • A low-priority task on Core 0 drains the ring, runs a windowed SPEC_N-point FFT per
+       channel every SPEC_HOP samples and Goertzel trackers at the beat frequency and its
+       harmonics (block = one beat period from G.bpm).
+     • Readers (/api/spectrum) copy the latest SpecSnapshot under a short critical section.
+   The 10-sample moving average used for display has nulls at multiples of 60 Hz, so the
+   analyzer takes the raw ADC path instead.
+   ==========================================================================================*/
+
+static constexpr uint8_t  SPEC_CH = 2;              // 0 = atrium, 1 = ventricle
+static constexpr uint32_t SPEC_TASK_MS = 50;        // drain period (30 samples at 600 Hz)
+
+struct SpecSnapshot {
+  uint32_t seq;                                     // increments per published update
+  uint32_t frames;                                  // FFT frames computed
+  float    f0Hz;                                    // Goertzel fundamental (beat rate)
+  uint32_t period;                                  // samples per Goertzel block
+  float    mag[SPEC_CH][SPEC_BINS];                 // amplitude spectrum, mmHg
+  float    harm[SPEC_CH][SPEC_HARMONICS];           // amplitude at h·f0, mmHg
+  float    thd[SPEC_CH];
+};
+
+struct SpecCounters {
+  std::atomic<uint32_t> dropped{0};                 // samples lost to a full ring
+  std::atomic<uint32_t> frames{0};                  // FFT frames (both channels)
+};
+extern SpecCounters spec_ctr;
+
+void spectral_begin();                              // start the analysis task (Core 0)
+void spectral_push(float atr, float vent);          // Core 1, once per control tick
+void spectral_snapshot(SpecSnapshot& out);
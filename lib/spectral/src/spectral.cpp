@@ -0,0 +1,61 @@
+#include "spectral.h"
+#include "shared.h"
+
+SpecCounters spec_ctr;
+
+struct SpecSample { float v[SPEC_CH]; };
+static SpscRing<SpecSample, 512> s_ring;          // ~0.85 s of slack at 600 Hz
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static SpecSnapshot s_snap{};
+
+void spectral_push(float atr, float vent){
+  if (!s_ring.push(SpecSample{{atr, vent}})) spec_ctr.dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void spectral_snapshot(SpecSnapshot& out){
+  portENTER_CRITICAL(&s_mux);
+  out = s_snap;
+  portEXIT_CRITICAL(&s_mux);
+}
+
+static void spectral_task(void*){
+  static RealFft fft;                              // tables (~6 KB) built once
+  static SpecChannel ch[SPEC_CH];
+  static GoertzelBank gz[SPEC_CH];
+  static SpecSnapshot next{};
+  uint32_t seq = 0;
+  TickType_t wake = xTaskGetTickCount();
+  for(;;){
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(SPEC_TASK_MS));
+    int bpm = G.bpm.load(); if (bpm < BPM_MIN) bpm = BPM_MIN;
+    uint32_t period = (CONTROL_HZ * 60u + bpm/2) / bpm;
+    for (uint8_t c=0;c<SPEC_CH;c++) gz[c].setPeriod(period);
+
+    bool dirty = false;
+    SpecSample s;
+    while (s_ring.pop(s)){
+      for (uint8_t c=0;c<SPEC_CH;c++){
+        if (ch[c].push(s.v[c])){
+          ch[c].frame(fft, next.mag[c]);
+          spec_ctr.frames.fetch_add(1, std::memory_order_relaxed);
+          next.frames++; dirty = true;
+        }
+        if (gz[c].push(s.v[c])){
+          for (uint8_t h=1;h<=SPEC_HARMONICS;h++) next.harm[c][h-1] = gz[c].amplitude(h);
+          next.thd[c] = gz[c].thd(); dirty = true;
+        }
+      }
+    }
+    if (!dirty) continue;
+    next.f0Hz = (float)CONTROL_HZ / gz[0].period();
+    next.period = gz[0].period();
+    next.seq = ++seq;
+    portENTER_CRITICAL(&s_mux);
+    s_snap = next;
+    portEXIT_CRITICAL(&s_mux);
+  }
+}
+
+void spectral_begin(){
+  xTaskCreatePinnedToCore(spectral_task, "spectral", 4096, nullptr, 1, nullptr, CORE_WEB);
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <Arduino.h>
+#include "app_config.h"
+
+/* ==========================================================================================
+   sysmon.h — Low-rate task / stack / heap / CPU-load introspection
+   Ownership:
+     • A 1 Hz sampler task on Core 0 (lowest priority) builds a SysSnapshot.
+     • Readers (/api/sys, /metrics) copy the latest snapshot under a short critical section.
+   Per-core idle share:
+     • With configGENERATE_RUN_TIME_STATS: run time of each core's idle task (IDLE0/IDLE1)
+       over the elapsed run-time clock.
+     • Otherwise: idle-hook call counts against a per-core reference measured in
+       sysmon_begin(), which must run before the other tasks start. The two idle loops differ
+       (CPU0's also feeds the task watchdog), so each core gets its own reference.
+     • Values that cannot be measured in this build are flagged, never reported as 0.
+   RAM: sysmon_ram_report() runs once at the end of setup(), with WiFi up and every buffer
+   allocated, and logs .data + .bss and the free heap against RAM_STATIC_BUDGET /
+   RAM_HEAP_FLOOR (app_config.h).
+   ==========================================================================================*/
+
+static constexpr uint8_t  SYSMON_MAX_TASKS = 32;     // task table capacity (WiFi + AsyncTCP + ours ≈ 20)
+static constexpr uint32_t SYSMON_PERIOD_MS = 1000;   // sampling period
+static constexpr uint32_t SYSMON_CAL_MS    = 200;    // idle-hook reference window at boot (no run-time stats)
+
+enum SysIdleSrc : uint8_t {
+  SYS_IDLE_NONE    = 0,   // not measured (no sample yet)
+  SYS_IDLE_RUNTIME = 1,   // idle-task run-time counters
+  SYS_IDLE_HOOK    = 2,   // idle-hook counts against the boot reference
+};
+
+struct SysTask {
+  char     name[16];
+  uint8_t  core;          // 0/1, 255 = unpinned
+  uint8_t  prio;
+  uint32_t stackFree;     // stack high-water mark: minimum free bytes ever
+  float    cpuPct;        // share of its core over the last period; valid only if SysSnapshot::cpuAvail
+};
+
+struct SysSnapshot {
+  uint32_t seq;                 // increments per sample (0 = not sampled yet)
+  uint32_t uptimeMs;
+  uint8_t  idleSrc;             // SysIdleSrc: how idlePct was measured
+  float    idlePct[2];          // per-core idle share
+  bool     cpuAvail;            // tasks[].cpuPct measured (configGENERATE_RUN_TIME_STATS)
+  bool     tasksAvail;          // tasks[] filled (configUSE_TRACE_FACILITY)
+  uint32_t heapFree, heapMinFree, heapLargest;
+  uint32_t staticRam;           // .data + .bss of the image (linker symbols)
+  uint32_t heapAtBoot;          // free heap at sysmon_ram_report() (0 = not yet)
+  uint8_t  nTasks;
+  SysTask  tasks[SYSMON_MAX_TASKS];
+};
+
+void sysmon_begin();                   // idle reference (blocks SYSMON_CAL_MS without run-time stats), start sampler (Core 0)
+void sysmon_snapshot(SysSnapshot& out); // copy of the latest sample
+void sysmon_ram_report();              // end of setup(): log static RAM and free heap against the budget
@@ -0,0 +1,137 @@
+#include <esp_freertos_hooks.h>
+#include <esp_heap_caps.h>
+#include <math.h>
+#include "sysmon.h"
+
+// Idle share from the idle tasks' own run-time counters needs both the run-time clock and
+// uxTaskGetSystemState(); without them, fall back to idle-hook counts.
+#define SYSMON_RUNTIME_IDLE (configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS)
+
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static SysSnapshot s_snap{};
+static volatile uint32_t s_heapAtBoot = 0;
+
+// DRAM section bounds from the ESP32 linker script
+extern "C" { extern uint8_t _data_start, _data_end, _bss_start, _bss_end; }
+static uint32_t static_ram(){ return (uint32_t)(&_data_end - &_data_start) + (uint32_t)(&_bss_end - &_bss_start); }
+
+#if !SYSMON_RUNTIME_IDLE
+static volatile uint32_t s_idleCount[2] = {0, 0};
+static float s_idleRef[2] = {0, 0};     // hook calls per SYSMON_PERIOD_MS on an otherwise idle core
+
+// Idle hooks: return false so the idle task keeps calling us instead of sleeping until the
+// next tick; the count per period is then proportional to idle time on that core.
+static bool idle_hook_cpu0(){ s_idleCount[0]++; return false; }
+static bool idle_hook_cpu1(){ s_idleCount[1]++; return false; }
+#endif
+
+static void sysmon_task(void*){
+  static SysSnapshot next{};
+#if configUSE_TRACE_FACILITY
+  static TaskStatus_t st[SYSMON_MAX_TASKS];
+#endif
+#if SYSMON_RUNTIME_IDLE
+  static uint32_t prevRun[SYSMON_MAX_TASKS];
+  static uint32_t prevNum[SYSMON_MAX_TASKS];
+  static uint8_t  nPrev = 0;
+  uint32_t prevTotal = 0;
+#else
+  uint32_t prevIdle[2] = { s_idleCount[0], s_idleCount[1] };
+#endif
+  uint32_t seq = 0;
+  TickType_t wake = xTaskGetTickCount();
+  for(;;){
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(SYSMON_PERIOD_MS));
+
+#if !SYSMON_RUNTIME_IDLE
+    for (int c=0;c<2;c++){
+      const uint32_t now = s_idleCount[c], d = now - prevIdle[c]; prevIdle[c] = now;
+      next.idlePct[c] = fminf(100.0f, 100.0f * d / s_idleRef[c]);
+    }
+    next.idleSrc = SYS_IDLE_HOOK;
+#endif
+
+    next.heapFree    = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    next.heapMinFree = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    next.heapLargest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    next.staticRam   = static_ram();
+    next.heapAtBoot  = s_heapAtBoot;
+    next.uptimeMs    = millis();
+
+#if configUSE_TRACE_FACILITY
+    uint32_t total = 0;
+    UBaseType_t n = uxTaskGetSystemState(st, SYSMON_MAX_TASKS, &total);  // 0 if the table is too small
+#if SYSMON_RUNTIME_IDLE
+    uint32_t curRun[SYSMON_MAX_TASKS], curNum[SYSMON_MAX_TASKS];
+    // The run-time clock is shared, so a task's delta over the elapsed delta is its share of its core.
+    const uint32_t dTotal = total - prevTotal; prevTotal = total;
+    bool idleSeen[2] = { false, false };
+#endif
+    for (UBaseType_t i=0;i<n;i++){
+      SysTask& t = next.tasks[i];
+      strncpy(t.name, st[i].pcTaskName, sizeof(t.name)-1); t.name[sizeof(t.name)-1] = 0;
+      t.core = (st[i].xCoreID > 1) ? 255 : (uint8_t)st[i].xCoreID;
+      t.prio = (uint8_t)st[i].uxCurrentPriority;
+      t.stackFree = st[i].usStackHighWaterMark;   // bytes on ESP-IDF (StackType_t is uint8_t)
+      t.cpuPct = 0.0f;
+#if SYSMON_RUNTIME_IDLE
+      curRun[i] = st[i].ulRunTimeCounter; curNum[i] = st[i].xTaskNumber;
+      bool known = false;
+      for (uint8_t j=0;j<nPrev;j++){
+        if (prevNum[j] == curNum[i]){ known = true; if (dTotal) t.cpuPct = 100.0f * (curRun[i] - prevRun[j]) / dTotal; break; }
+      }
+      // Each core's idle task is pinned to it ("IDLE0"/"IDLE1"): its share is that core's idle
+      if (known && t.core < 2 && strncmp(t.name, "IDLE", 4) == 0){ next.idlePct[t.core] = t.cpuPct; idleSeen[t.core] = true; }
+#endif
+    }
+    next.nTasks = (uint8_t)n;
+    next.tasksAvail = n > 0;
+#if SYSMON_RUNTIME_IDLE
+    memcpy(prevRun, curRun, n*sizeof(uint32_t)); memcpy(prevNum, curNum, n*sizeof(uint32_t)); nPrev = (uint8_t)n;
+    next.cpuAvail = n > 0 && seq > 0;           // the first pass has no previous counters
+    next.idleSrc  = (idleSeen[0] && idleSeen[1] && dTotal) ? SYS_IDLE_RUNTIME : SYS_IDLE_NONE;
+#else
+    next.cpuAvail = false;
+#endif
+#else
+    next.nTasks = 0;
+    next.tasksAvail = false;
+    next.cpuAvail = false;
+#endif
+    next.seq = ++seq;
+
+    portENTER_CRITICAL(&s_mux);
+    s_snap = next;
+    portEXIT_CRITICAL(&s_mux);
+  }
+}
+
+void sysmon_snapshot(SysSnapshot& out){
+  portENTER_CRITICAL(&s_mux);
+  out = s_snap;
+  portEXIT_CRITICAL(&s_mux);
+}
+
+void sysmon_ram_report(){
+  const uint32_t st = static_ram(), heap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  s_heapAtBoot = heap;
+  Serial.printf("[SYS] RAM: .data+.bss %u B (budget %u), free heap %u B (floor %u), largest block %u B\n",
+    (unsigned)st, (unsigned)RAM_STATIC_BUDGET, (unsigned)heap, (unsigned)RAM_HEAP_FLOOR,
+    (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+  if (st > RAM_STATIC_BUDGET) Serial.println("[SYS] static RAM over budget");
+  if (heap < RAM_HEAP_FLOOR)  Serial.println("[SYS] free heap below floor");
+}
+
+void sysmon_begin(){
+#if !SYSMON_RUNTIME_IDLE
+  // Reference rate per core while nothing but the idle tasks runs: the caller's task is
+  // blocked here and the control/web/flow tasks are not created yet (see setup()).
+  esp_register_freertos_idle_hook_for_cpu(idle_hook_cpu0, 0);
+  esp_register_freertos_idle_hook_for_cpu(idle_hook_cpu1, 1);
+  const uint32_t c0 = s_idleCount[0], c1 = s_idleCount[1];
+  vTaskDelay(pdMS_TO_TICKS(SYSMON_CAL_MS));
+  s_idleRef[0] = fmaxf(1.0f, (float)(s_idleCount[0] - c0) * SYSMON_PERIOD_MS / SYSMON_CAL_MS);
+  s_idleRef[1] = fmaxf(1.0f, (float)(s_idleCount[1] - c1) * SYSMON_PERIOD_MS / SYSMON_CAL_MS);
+#endif
+  xTaskCreatePinnedToCore(sysmon_task, "sysmon", 3072, nullptr, 1, nullptr, CORE_WEB);
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "app_config.h"
+#include "tlmfmt.h"
+
+/* ==========================================================================================
+   telemetry.h — Binary full-rate telemetry on the USB serial port (see tlmfmt.h, tools/tlmrec)
+   Ownership:
+     • Core 1 (control) pushes one sample per tick into an SPSC ring while streaming; it never
+       blocks and counts drops if the writer falls behind.
+     • A low-priority task on Core 0 packs consecutive ticks into frames (a tick gap or a fault
+       change starts a new frame), COBS-encodes them and writes only what fits in the UART TX
+       buffer, finishing a partly written frame on the next pass.
+   Off by default (TLM_SERIAL_AUTOSTART); console text printed while streaming lands between
+   frames and is skipped by the reader.
+   ==========================================================================================*/
+
+struct TlmCounters {
+  std::atomic<uint32_t> frames{0};    // frames fully written
+  std::atomic<uint32_t> dropped{0};   // samples lost (ring full)
+  std::atomic<uint32_t> bytes{0};     // wire bytes written
+};
+extern TlmCounters tlm_ctr;
+
+void telemetry_begin();                                           // start the writer task (Core 0)
+void telemetry_push(uint32_t tick, const TlmSample& s, uint8_t fault);   // Core 1, every tick; no-op when off
+void telemetry_enable(bool on);
+bool telemetry_enabled();
@@ -0,0 +1,60 @@
+#include "telemetry.h"
+#include "shared.h"
+
+TlmCounters tlm_ctr;
+
+struct TlmTick { uint32_t tick; TlmSample s; uint8_t fault; };
+static SpscRing<TlmTick, 256> s_ring;              // ~0.4 s of slack at 600 Hz
+static std::atomic<bool> s_on{TLM_SERIAL_AUTOSTART};
+
+void telemetry_push(uint32_t tick, const TlmSample& s, uint8_t fault){
+  if (!s_on.load(std::memory_order_relaxed)) return;
+  if (!s_ring.push(TlmTick{ tick, s, fault })) tlm_ctr.dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void telemetry_enable(bool on){ s_on.store(on); }
+bool telemetry_enabled(){ return s_on.load(); }
+
+static void telemetry_task(void*){
+  static TlmFrame f;
+  static uint8_t wire[TLM_WIRE_MAX];
+  size_t len = 0, off = 0;                         // encoded frame being written
+  uint32_t seq = 0;
+  TlmTick carry; bool haveCarry = false;           // popped sample that starts the next frame
+  for(;;){
+    vTaskDelay(pdMS_TO_TICKS(TLM_TASK_MS));
+    if (!s_on.load()){
+      TlmTick t; while (s_ring.pop(t)) {}
+      f.count = 0; len = off = 0; haveCarry = false;
+      continue;
+    }
+    for(;;){
+      if (off < len){
+        int room = Serial.availableForWrite();
+        if (room <= 0) break;
+        size_t n = len - off; if (n > (size_t)room) n = (size_t)room;
+        Serial.write(wire + off, n); off += n;
+        tlm_ctr.bytes.fetch_add((uint32_t)n, std::memory_order_relaxed);
+        if (off < len) break;                      // UART full: finish next pass
+        tlm_ctr.frames.fetch_add(1, std::memory_order_relaxed);
+      }
+      bool close = false;
+      while (f.count < TLM_FRAME_SAMPLES){
+        TlmTick t;
+        if (haveCarry){ t = carry; haveCarry = false; }
+        else if (!s_ring.pop(t)) break;
+        if (f.count && (t.tick != f.firstTick + f.count || t.fault != f.fault)){ carry = t; haveCarry = true; close = true; break; }
+        if (!f.count){ f.firstTick = t.tick; f.fault = t.fault; }
+        f.s[f.count++] = t.s;
+      }
+      if (!f.count || (f.count < TLM_FRAME_SAMPLES && !close)) break;   // wait for a full frame
+      f.hz = CONTROL_HZ; f.seq = seq++;
+      len = tlm_encode(f, wire); off = 0;
+      f.count = 0;
+    }
+  }
+}
+
+void telemetry_begin(){
+  xTaskCreatePinnedToCore(telemetry_task, "tlm", 3072, nullptr, 1, nullptr, CORE_WEB);
+}
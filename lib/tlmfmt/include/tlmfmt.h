@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/* ==========================================================================================
+   tlmfmt.h — Binary serial telemetry framing (COBS + CRC-32)
+   ------------------------------------------------------------------------------------------
+   • A frame carries up to TLM_FRAME_SAMPLES consecutive control ticks. Raw layout (little
+     endian):
+       type u8 (TLM_TYPE_SAMPLES) | version u8 | hz u16 | seq u32 | firstTick u32 |
+       count u8 | fault u8 | reserved u16 | count × sample | crc32 u32
+     sample = atr i16 (mmHg×10) | vent i16 (mmHg×10) | flow i16 (L/min×100) | pwm u8 |
+              state u8 (log_state: valve | paused<<1 | mode<<3)
+     crc32 covers everything before it.
+   • On the wire each frame is COBS encoded between two 0x00 bytes, so a reader can join the
+     stream anywhere and resynchronise at the next zero, and stray console text between
+     frames only costs itself. seq increments per frame (gaps =
+     frames lost on the link); firstTick jumps when the device dropped samples itself.
+   • Pure logic (no Arduino/FreeRTOS) so it builds in host tests and the tlmrec tool.
+   ==========================================================================================*/
+
+static constexpr uint8_t  TLM_TYPE_SAMPLES  = 0x01;
+static constexpr uint8_t  TLM_VERSION       = 1;
+static constexpr uint8_t  TLM_FRAME_SAMPLES = 10;
+static constexpr uint8_t  TLM_HDR_BYTES     = 16;
+static constexpr uint8_t  TLM_SAMPLE_BYTES  = 8;
+static constexpr uint16_t TLM_RAW_MAX  = TLM_HDR_BYTES + TLM_FRAME_SAMPLES * TLM_SAMPLE_BYTES + 4;
+static constexpr uint16_t TLM_WIRE_MAX = TLM_RAW_MAX + TLM_RAW_MAX / 254 + 3;   // COBS + delimiters
+
+struct TlmSample { int16_t atr = 0, vent = 0, flow = 0; uint8_t pwm = 0, state = 0; };
+
+struct TlmFrame {
+  uint16_t  hz = 0;
+  uint32_t  seq = 0, firstTick = 0;
+  uint8_t   count = 0, fault = 0;
+  TlmSample s[TLM_FRAME_SAMPLES];
+};
+
+// COBS without the trailing delimiter. encode: out needs n + n/254 + 1 bytes. decode: returns
+// the decoded length, 0 if the input is not valid COBS or does not fit cap.
+size_t cobs_encode(const uint8_t* in, size_t n, uint8_t* out);
+size_t cobs_decode(const uint8_t* in, size_t n, uint8_t* out, size_t cap);
+
+// Frame → wire bytes (0x00, COBS, 0x00); returns the length (≤ TLM_WIRE_MAX)
+size_t tlm_encode(const TlmFrame& f, uint8_t* wire);
+
+// Byte-at-a-time stream reader: push() returns true when frame() holds a new valid frame
+class TlmDecoder {
+public:
+  bool push(uint8_t b);
+  const TlmFrame& frame() const { return f_; }
+  const uint8_t* raw() const { return enc_; }   // COBS bytes of the last frame (no delimiter)
+  size_t rawLen() const { return lastLen_; }
+  uint32_t bad() const { return bad_; }         // delimited chunks that failed COBS/CRC/layout
+
+private:
+  bool parse(const uint8_t* p, size_t n);
+  uint8_t  enc_[TLM_WIRE_MAX];
+  size_t   len_ = 0, lastLen_ = 0;
+  bool     over_ = false;
+  uint32_t bad_ = 0;
+  TlmFrame f_;
+};
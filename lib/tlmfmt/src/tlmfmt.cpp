@@ -0,0 +1,80 @@
+#include "tlmfmt.h"
+#include "crc.h"
+
+static void le16(uint8_t* p, uint16_t v){ p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void le32(uint8_t* p, uint32_t v){ for (uint8_t i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8*i)); }
+static uint16_t rd16(const uint8_t* p){ return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t rd32(const uint8_t* p){ return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+size_t cobs_encode(const uint8_t* in, size_t n, uint8_t* out){
+  size_t code_at = 0, o = 1;
+  uint8_t code = 1;
+  for (size_t i = 0; i < n; i++){
+    if (in[i]) { out[o++] = in[i]; code++; }
+    if (!in[i] || code == 0xFF){
+      out[code_at] = code; code = 1; code_at = o++;
+      if (!in[i]) continue;
+    }
+  }
+  out[code_at] = code;
+  return o;
+}
+
+size_t cobs_decode(const uint8_t* in, size_t n, uint8_t* out, size_t cap){
+  size_t i = 0, o = 0;
+  while (i < n){
+    const uint8_t code = in[i++];
+    if (!code || i + code - 1 > n) return 0;
+    for (uint8_t k = 1; k < code; k++){ if (!in[i] || o >= cap) return 0; out[o++] = in[i++]; }
+    if (code < 0xFF && i < n){ if (o >= cap) return 0; out[o++] = 0; }
+  }
+  return o;
+}
+
+size_t tlm_encode(const TlmFrame& f, uint8_t* wire){
+  uint8_t raw[TLM_RAW_MAX];
+  const uint8_t n = f.count > TLM_FRAME_SAMPLES ? TLM_FRAME_SAMPLES : f.count;
+  raw[0] = TLM_TYPE_SAMPLES; raw[1] = TLM_VERSION; le16(raw + 2, f.hz);
+  le32(raw + 4, f.seq); le32(raw + 8, f.firstTick);
+  raw[12] = n; raw[13] = f.fault; raw[14] = raw[15] = 0;
+  uint8_t* p = raw + TLM_HDR_BYTES;
+  for (uint8_t i = 0; i < n; i++, p += TLM_SAMPLE_BYTES){
+    const TlmSample& s = f.s[i];
+    le16(p, (uint16_t)s.atr); le16(p + 2, (uint16_t)s.vent); le16(p + 4, (uint16_t)s.flow); p[6] = s.pwm; p[7] = s.state;
+  }
+  le32(p, crc32(raw, p - raw)); p += 4;
+  wire[0] = 0;
+  size_t len = 1 + cobs_encode(raw, p - raw, wire + 1);
+  wire[len++] = 0;
+  return len;
+}
+
+bool TlmDecoder::parse(const uint8_t* enc, size_t n){
+  uint8_t raw[TLM_RAW_MAX];
+  const size_t len = cobs_decode(enc, n, raw, sizeof(raw));
+  if (len < TLM_HDR_BYTES + 4 || raw[0] != TLM_TYPE_SAMPLES || raw[1] != TLM_VERSION) return false;
+  const uint8_t cnt = raw[12];
+  if (cnt > TLM_FRAME_SAMPLES || len != (size_t)TLM_HDR_BYTES + cnt * TLM_SAMPLE_BYTES + 4) return false;
+  if (crc32(raw, len - 4) != rd32(raw + len - 4)) return false;
+  f_.hz = rd16(raw + 2); f_.seq = rd32(raw + 4); f_.firstTick = rd32(raw + 8);
+  f_.count = cnt; f_.fault = raw[13];
+  const uint8_t* p = raw + TLM_HDR_BYTES;
+  for (uint8_t i = 0; i < cnt; i++, p += TLM_SAMPLE_BYTES){
+    TlmSample& s = f_.s[i];
+    s.atr = (int16_t)rd16(p); s.vent = (int16_t)rd16(p + 2); s.flow = (int16_t)rd16(p + 4); s.pwm = p[6]; s.state = p[7];
+  }
+  return true;
+}
+
+bool TlmDecoder::push(uint8_t b){
+  if (b){
+    if (len_ < sizeof(enc_)) enc_[len_++] = b; else over_ = true;
+    return false;
+  }
+  const size_t n = len_; const bool over = over_;
+  len_ = 0; over_ = false;
+  if (!n) return false;                          // back-to-back delimiters
+  if (over || !parse(enc_, n)){ bad_++; return false; }
+  lastLen_ = n;
+  return true;
+}
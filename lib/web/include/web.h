@@ -1,7 +1,24 @@
 #pragma once
 #include <Arduino.h>
+#include <atomic>
 
 /* ==========================================================================================
    web.h — Core 0 Web stack (SoftAP + HTTP + SSE + UIs)
    ==========================================================================================*/
 void web_start();
+
+// ---- Counters (Core 0 writes, relaxed; read by /metrics) ----
+struct WebCounters {
+  std::atomic<uint32_t> cmdInline{0};      // post_or_inline fallbacks (queue full → applied inline)
+  std::atomic<uint32_t> sseSent{0};        // frames handed to the SSE server
+  std::atomic<uint32_t> sseFailed{0};      // frames not formatted or dropped on saturated client queues
+  std::atomic<uint32_t> sseClients{0};     // gauge: connected /stream clients (sampled each frame)
+  std::atomic<uint32_t> sseReplayed{0};    // frames re-sent to clients resuming with Last-Event-ID
+  std::atomic<uint32_t> sseGaps{0};        // gap markers sent (resume point no longer in the replay ring)
+  std::atomic<uint32_t> jsonBusy{0};       // API requests refused: every pooled JSON slot in use
+  std::atomic<uint32_t> jsonBad{0};        // request bodies rejected by the JSON reader
+  std::atomic<uint32_t> wsCmds{0};         // /ws control messages applied
+  std::atomic<uint32_t> wsDup{0};          // /ws replays already applied (acked, not re-applied)
+  std::atomic<uint32_t> wsBad{0};          // /ws messages rejected
+};
+extern WebCounters web_ctr;
@@ -0,0 +1,15 @@
+#pragma once
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+/* ==========================================================================================
+   web_capture.h — Triggered capture endpoints (/api/capture*)
+   Notes:
+     • Configuration and arm/stop/force go to Core 1 as commands; nothing here writes the
+       capture buffer.
+     • A download holds the frozen buffer (Capture::beginRead) and streams it straight from
+       it, binary or JSON, until the request is torn down; a second concurrent download gets
+       409. In auto mode a completed download lets Core 1 re-arm.
+   ==========================================================================================*/
+
+void web_capture_register(AsyncWebServer& srv);
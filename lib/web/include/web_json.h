@@ -0,0 +1,36 @@
+#pragma once
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include "jsonio.h"
+#include "app_config.h"
+
+/* ==========================================================================================
+   web_json.h — Per-request JSON state from a fixed pool (no heap, see jsonio.h)
+   Notes:
+     • AsyncTCP task only. A request claims a slot on first use and keeps it until it is torn
+       down, so a body parsed across onBody chunks never shares state with another request,
+       and a reply is sent straight from the slot buffer without a String copy.
+     • All WEB_JSON_SLOTS busy → nullptr; callers answer 503 (counted in web_ctr.jsonBusy).
+       A request whose body found no slot stays refused (its _tempObject marks it), so the
+       onRequest handler answers 503 too instead of parsing the empty remainder.
+   ==========================================================================================*/
+
+static constexpr uint8_t WEB_JSON_BODY = 64;   // largest struct a request body binds into
+
+struct WebJson {
+  JsonWriter w;                         // reply, formatted into buf
+  JsonReader rd;                        // request body, fed from onBody chunks
+  JsonBind   bind;                      // rd's callback target: fields → body
+  alignas(8) uint8_t body[WEB_JSON_BODY];
+  char       buf[WEB_JSON_BUF];
+  AsyncWebServerRequest* owner;
+};
+
+WebJson* web_json(AsyncWebServerRequest* r);                    // claim or look up r's slot
+WebJson* web_json_find(AsyncWebServerRequest* r);               // look up only
+// Claim a slot and start binding r's body (zeroed, `size` bytes) through fields: call at
+// index 0 of onBody, then feed j->rd each chunk. nullptr when no slot is free; the request
+// is then refused for good and web_json() returns nullptr for it too.
+WebJson* web_json_body(AsyncWebServerRequest* r, const JsonField* fields, uint8_t n, size_t size);
+void     web_json_send(AsyncWebServerRequest* r, WebJson* j, int code = 200);   // 500 if w is not ok()
+void     web_json_busy(AsyncWebServerRequest* r);                // 503 reply without a slot
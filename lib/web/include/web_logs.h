@@ -0,0 +1,15 @@
+#pragma once
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+/* ==========================================================================================
+   web_logs.h — Flight-recorder endpoints (/api/logs*)
+   Notes:
+     • Listing reads the recorder's slot table; a download is streamed from the memory-mapped
+       partition in TCP-sized chunks, never loaded whole into heap.
+     • Start/stop only flip the recorder's request flag; the writer task on Core 0 acts on it.
+       Start answers 409 while no slot is erased (slots are only erased with the pump paused).
+     • Decode downloads on a PC with tools/log2csv.
+   ==========================================================================================*/
+
+void web_logs_register(AsyncWebServer& srv);
@@ -0,0 +1,13 @@
+#pragma once
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+/* ==========================================================================================
+   web_metrics.h — Introspection endpoints: Prometheus scrape (/metrics), system stats (/api/sys)
+   Notes:
+     • Read-only: loads the relaxed counters owned by control, flow and web, plus heap gauges.
+     • /api/sys serves the latest sysmon snapshot (task stacks, run time, idle %, heap).
+     • Served from the AsyncTCP task on Core 0; never touches Core 1 state beyond atomics.
+   ==========================================================================================*/
+
+void web_metrics_register(AsyncWebServer& srv);
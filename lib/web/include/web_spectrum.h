@@ -0,0 +1,13 @@
+#pragma once
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+/* ==========================================================================================
+   web_spectrum.h — Pressure spectrum endpoint (/api/spectrum?ch=atr|vent)
+   Notes:
+     • Serves the latest spectral snapshot: FFT magnitudes, peak, beat fundamental, the
+       Goertzel harmonics and THD. Nothing is computed here; the spectral task on Core 0
+       publishes the snapshot and the handler copies it.
+   ==========================================================================================*/
+
+void web_spectrum_register(AsyncWebServer& srv);
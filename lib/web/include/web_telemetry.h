@@ -0,0 +1,13 @@
+#pragma once
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+/* ==========================================================================================
+   web_telemetry.h — Binary serial telemetry switch (/api/telemetry)
+   Notes:
+     • GET reports the stream state and its frame/byte/drop counters; POST on=0|1 starts or
+       stops the stream. Core 1 and the writer task act on it; nothing here touches the UART.
+     • Record the serial stream on a PC with tools/tlmrec.
+   ==========================================================================================*/
+
+void web_telemetry_register(AsyncWebServer& srv);
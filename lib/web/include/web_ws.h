@@ -0,0 +1,17 @@
+#pragma once
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include "ctlmsg.h"
+
+/* ==========================================================================================
+   web_ws.h — WebSocket control channel (/ws, message format in ctlmsg.h)
+   Notes:
+     • One persistent connection per page instead of an HTTP request per click: commands
+       arrive in the order sent and are acked with the client's sequence number.
+     • Messages are handed to the apply hook supplied by web.cpp, which posts the same Cmd
+       the HTTP routes post. Duplicates replayed after a reconnect are acked, not applied.
+     • Runs on the AsyncTCP task; web_ws_tick() drops dead clients (call about once a second).
+   ==========================================================================================*/
+
+void web_ws_register(AsyncWebServer& srv, void (*apply)(const CtlMsg&));
+void web_ws_tick();
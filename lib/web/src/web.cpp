@@ -1,11 +1,18 @@
 #include <WiFi.h>
 #include <ESPAsyncWebServer.h>
-#include <Preferences.h>
 #include "web.h"
 #include "web_cal.h"
+#include "web_metrics.h"
+#include "web_logs.h"
+#include "web_capture.h"
+#include "web_spectrum.h"
+#include "web_telemetry.h"
+#include "web_json.h"
+#include "web_ws.h"
 #include "shared.h"
 #include "app_config.h"
 #include "io.h"
+#include "control.h"
 
 // ==============================
 //  Ownership / Concurrency doc
@@ -18,6 +25,8 @@
 //    • Control loop updates atomics, executes commands.
 // ==============================
 
+WebCounters web_ctr;
+
 static AsyncWebServer server(kHttpPort);
 static AsyncEventSource sse("/stream");
 // Live smoothing settings (default values)
@@ -72,6 +81,7 @@ static const char INDEX_HTML[] PROGMEM = R"HTML(
   <div class="top">
     <div class="pill">SSE: <b id="sse">INIT</b></div>
     <div class="pill">IP: <b id="ip">—</b></div>
+    <div class="pill" id="faultPill" style="display:none;background:#3b0f0f">FAULT: <b id="fault"></b> <button id="btnFaultClr">Clear</button></div>
     <div style="flex:1"></div>
     <div class="pill">FPS: <b id="fps">—</b></div>
     <div class="pill">Loop: <b id="loop">—</b></div>
@@ -101,12 +111,12 @@ static const char INDEX_HTML[] PROGMEM = R"HTML(
     </div>
 
     <div class="col" style="grid-template-rows:repeat(5,1fr)">
-  <div class="panel big"><div class="big"><div class="muted">Blood Pressure</div><div class="val val-green" id="n-bp">N/A</div><div style="color:var(--ink);font-size:12px">mmHg</div><div class="muted">SYS/DIA</div></div></div>
+  <div class="panel big"><div class="big"><div class="muted">Blood Pressure</div><div class="val val-green" id="n-bp">N/A</div><div style="color:var(--ink);font-size:12px">mmHg</div><div class="muted">SYS/DIA</div><div class="muted" id="n-sv"></div></div></div>
 
       <div class="panel controls" style="grid-row:span 4">
   <div style="width:100%"><button id="btnToggle" class="btn btn-play btn-full">Play</button></div>
       <div class="row" style="width:100%"><label class="muted">Mode</label>
-        <div class="seg" id="modeSeg"><button data-m="0">Forward</button><button data-m="1">Reverse</button><button data-m="2">Beat</button></div>
+        <div class="seg" id="modeSeg"><button data-m="0">Forward</button><button data-m="1">Reverse</button><button data-m="2">Beat</button><button data-m="3">Pressure</button><button data-m="4">Flow</button></div>
       </div>
       <div class="row" style="width:100%"><label class="muted">POWER</label>
         <div class="ctrl">
@@ -125,13 +135,25 @@ static const char INDEX_HTML[] PROGMEM = R"HTML(
           <div style="display:flex;flex-direction:row;align-items:center;gap:8px;flex-wrap:wrap">
             <div style="display:flex;flex-direction:column;align-items:stretch;width:100%;gap:6px">
               <button id="btnBpmPlus" class="btn btn-full">+5</button>
-              <input id="bpmIn" type="number" min="1" max="60" value="30" style="width:72px;align-self:center;text-align:center;padding:6px;border-radius:6px;border:1px solid var(--grid);background:#0f1317;color:var(--ink)">
+              <input id="bpmIn" type="number" min="1" max="200" value="30" style="width:72px;align-self:center;text-align:center;padding:6px;border-radius:6px;border:1px solid var(--grid);background:#0f1317;color:var(--ink)">
               <button id="btnBpmMinus" class="btn btn-full">-5</button>
             </div>
             <div style="flex:1;min-width:8px"></div>
           </div>
         </div>
       </div>
+      <div class="row" style="width:100%"><label class="muted">Target mmHg</label>
+        <div class="ctrl" style="display:flex;align-items:center;gap:8px">
+          <input id="pressIn" type="number" min="0" max="180" step="1" value="80" style="width:72px;text-align:center;padding:6px;border-radius:6px;border:1px solid var(--grid);background:#0f1317;color:var(--ink)">
+          <label class="muted"><input id="pressBeat" type="checkbox"> beat peak</label>
+        </div>
+      </div>
+      <div class="row" style="width:100%"><label class="muted">Flow L/min</label>
+        <div class="ctrl" style="display:flex;align-items:center;gap:8px">
+          <input id="flowIn" type="number" min="-7.5" max="7.5" step="0.1" value="0" style="width:72px;text-align:center;padding:6px;border-radius:6px;border:1px solid var(--grid);background:#0f1317;color:var(--ink)">
+          <button id="btnSweep" class="btn">Sweep</button>
+        </div>
+      </div>
   <div style="margin-top:6px">
     <label class="muted" style="display:block;margin-bottom:6px">Window: <b id="winLabel">5</b>s</label>
     <input id="winRange" type="range" min="5" max="60" step="1" value="5" style="width:100%">
@@ -170,9 +192,9 @@ function makeStrip(id, cfg){ const c=$(id);
   // strip so the rest of the UI can still function without throwing.
   if (!c){
     const noop = ()=>{};
-    return { push: noop, render: noop, getSmoothed: ()=>null, setAlpha: noop };
+    return { push: noop, render: noop, getSmoothed: ()=>null, setAlpha: noop, seed: noop, merge: noop, mark: noop };
   }
-  const ctx = c.getContext && c.getContext('2d'); if(!ctx){ const noop = ()=>{}; return { push: noop, render: noop, getSmoothed: ()=>null, setAlpha: noop }; }
+  const ctx = c.getContext && c.getContext('2d'); if(!ctx){ const noop = ()=>{}; return { push: noop, render: noop, getSmoothed: ()=>null, setAlpha: noop, seed: noop, merge: noop, mark: noop }; }
   const buf=[];
   // Window length (seconds) is dynamic and read from global `window.winSec` (default 5s).
   function getWin(){ return (typeof window.winSec === 'number' && window.winSec>0) ? window.winSec : 5.0; }
@@ -219,6 +241,7 @@ function makeStrip(id, cfg){ const c=$(id);
   function alphaFromDist(d){ if (d <= gap + eraseFull) return 0; if (d >= gap + fadeEnd) return 1; return (d - (gap + eraseFull)) / (fadeEnd - eraseFull); }
     for(let i=1;i<buf.length;i++){
       const a = buf[i-1], b = buf[i]; const ta = a.t % win, tb = b.t % win;
+      if (a.v === null || b.v === null) continue;
       const xa = X(a.t), xb = X(b.t);
       // wrapped: draw a small dot at xb
       if (tb < ta){
@@ -306,7 +329,14 @@ function makeStrip(id, cfg){ const c=$(id);
   function getSmoothed(){ return _prevSmoothed; }
   function setAlpha(a){ if (typeof a === 'number'){ _alpha = Math.max(0, Math.min(1, a)); } }
   function prune(){ if(!buf.length) return; const win = getWin(); const now = buf[buf.length-1].t; while(buf.length && (now - buf[0].t) > win) buf.shift(); }
-  return { push, render, getSmoothed, setAlpha, prune }; }
+  // prepend device history (oldest first, same time base as push) ahead of the live samples
+  function seed(pts){ const t0 = buf.length ? buf[0].t : Infinity; const pre = pts.filter(p=>p.t < t0); if(!pre.length) return;
+    buf.unshift(...pre); prune(); requestStripRender(); }
+  // replayed frames after a reconnect may interleave with (or repeat) the first live ones: merge by time
+  function merge(pts){ const have = new Set(buf.map(p=>p.t)); pts = pts.filter(p=>!have.has(p.t)); if(!pts.length) return; buf.push(...pts); buf.sort((a,b)=>a.t-b.t); prune(); requestStripRender(); }
+  // break the trace at t (frames lost for good); render skips segments touching a null
+  function mark(t){ buf.push({t, v:null}); buf.sort((a,b)=>a.t-b.t); requestStripRender(); }
+  return { push, render, getSmoothed, setAlpha, prune, seed, merge, mark }; }
 
 // Apply light exponential smoothing to physiological traces so they look less noisy
 // but remain responsive. Tunable via smoothAlpha (0..1). Lower = smoother, Higher = more responsive.
@@ -325,6 +355,7 @@ try{
     window.winSec = Number(e.target.value)|0; if(_winLabel) _winLabel.textContent = window.winSec; localStorage.setItem('winSec', window.winSec);
     try{ [sAtr,sVent,sFlow,sValve,sPwm].forEach(s=> s && s.prune && s.prune()); }catch(e){}
     requestStripRender();
+    clearTimeout(window._histT); window._histT = setTimeout(()=>loadHistory(), 300);
   }); }
 }catch(e){}
 
@@ -339,7 +370,35 @@ function setNum(id,v,fix){ if(!$(id)) return; $(id).textContent = (v==null)?'—
 
 // Controls
 function post(url){ fetch(url).catch(()=>{}); }
-if($('btnToggle')) $('btnToggle').addEventListener('click',()=>post('/api/toggle'));
+// Control channel (/ws). Acked commands carry a per-tab sequence number and stay queued until
+// acked; after a reconnect the device reports the last one it applied and the rest are sent
+// again, so nothing is lost or applied twice. ff = fire-and-forget (absolute setpoints only).
+// Falls back to the GET routes while the socket is down.
+const ctl = (()=>{
+  const HTTP = { toggle:()=>'/api/toggle', pwm:v=>'/api/pwm?duty='+v, bpm:v=>'/api/bpm?b='+v, mode:v=>'/api/mode?m='+v,
+                 press:v=>'/api/press?t='+v, pressBeat:v=>'/api/press?beat='+v, flow:v=>'/api/flow?t='+v };
+  if (!('WebSocket' in window)) return (c,v)=>post(HTTP[c](v));
+  const sid = Number(sessionStorage.ctlSid) || (sessionStorage.ctlSid = 1 + Math.floor(Math.random()*0x7ffffffe));
+  let seq = Number(sessionStorage.ctlSeq) || 0, ws = null, ready = false;
+  const pending = [];
+  const drop = s=>{ while (pending.length && pending[0].s <= s) pending.shift(); };
+  function connect(){
+    try{ ws = new WebSocket((location.protocol==='https:'?'wss://':'ws://') + location.host + '/ws'); }catch(e){ setTimeout(connect, 2000); return; }
+    ws.onopen = ()=> ws.send(JSON.stringify({c:'hello', sid:Number(sid)}));
+    ws.onmessage = (ev)=>{ let m; try{ m = JSON.parse(ev.data); }catch(e){ return; }
+      if (m.t==='hello'){ ready = true; drop(m.last); pending.forEach(p=>ws.send(JSON.stringify(p))); }
+      else if (m.t==='ack' || (m.t==='err' && m.s)) drop(m.s); };
+    ws.onclose = ()=>{ ready = false; setTimeout(connect, 1000); };
+  }
+  connect();
+  return (c, v, ff)=>{
+    if (!ready){ if (!ff) post(HTTP[c](v)); return; }
+    if (ff){ ws.send(JSON.stringify({c, v})); return; }
+    const m = {s:++seq, c}; if (v!=null) m.v = v;
+    sessionStorage.ctlSeq = seq; pending.push(m); ws.send(JSON.stringify(m));
+  };
+})();
+if($('btnToggle')) $('btnToggle').addEventListener('click',()=>ctl('toggle'));
 // Apply buttons removed; inputs auto-apply via +5/-5 or on change handlers
 if($('btnPwmPlus')) $('btnPwmPlus').addEventListener('click',()=>{ adjustPwm(5); });
 if($('btnPwmMinus')) $('btnPwmMinus').addEventListener('click',()=>{ adjustPwm(-5); });
@@ -347,18 +406,35 @@ if($('btnBpmPlus')) $('btnBpmPlus').addEventListener('click',()=>{ adjustBpm(5);
 if($('btnBpmMinus')) $('btnBpmMinus').addEventListener('click',()=>{ adjustBpm(-5); });
 // auto-apply: also post when input values change
 if($('pwmIn')){
-  $('pwmIn').addEventListener('change', ()=>{ const v=Number($('pwmIn').value||0); post('/api/pwm?duty='+Math.max(0,Math.min(255,v))); });
+  $('pwmIn').addEventListener('change', ()=>{ const v=Number($('pwmIn').value||0); ctl('pwm', Math.max(0,Math.min(255,v))); });
   // allow Enter to submit while typing
-  $('pwmIn').addEventListener('keydown', (e)=>{ if(e.key==='Enter'){ e.preventDefault(); const v=Number($('pwmIn').value||0); post('/api/pwm?duty='+Math.max(0,Math.min(255,v))); $('pwmIn').blur(); } });
+  $('pwmIn').addEventListener('keydown', (e)=>{ if(e.key==='Enter'){ e.preventDefault(); const v=Number($('pwmIn').value||0); ctl('pwm', Math.max(0,Math.min(255,v))); $('pwmIn').blur(); } });
 }
 if($('bpmIn')){
-  $('bpmIn').addEventListener('change', ()=>{ const v=Number($('bpmIn').value||30); post('/api/bpm?b='+Math.max(1,Math.min(60,v))); });
-  $('bpmIn').addEventListener('keydown', (e)=>{ if(e.key==='Enter'){ e.preventDefault(); const v=Number($('bpmIn').value||30); post('/api/bpm?b='+Math.max(1,Math.min(60,v))); $('bpmIn').blur(); } });
+  $('bpmIn').addEventListener('change', ()=>{ const v=Number($('bpmIn').value||30); ctl('bpm', Math.max(1,Math.min(200,v))); });
+  $('bpmIn').addEventListener('keydown', (e)=>{ if(e.key==='Enter'){ e.preventDefault(); const v=Number($('bpmIn').value||30); ctl('bpm', Math.max(1,Math.min(200,v))); $('bpmIn').blur(); } });
 }
-document.querySelectorAll('#modeSeg button').forEach(b=> b.addEventListener('click', e=>{ post('/api/mode?m='+b.dataset.m); }));
+document.querySelectorAll('#modeSeg button').forEach(b=> b.addEventListener('click', e=>{ ctl('mode', Number(b.dataset.m)); }));
+if($('pressIn')){
+  $('pressIn').addEventListener('change', ()=>{ const v=Number($('pressIn').value||0); ctl('press', Math.max(0,Math.min(180,v))); });
+  $('pressBeat').addEventListener('change', ()=>{ ctl('pressBeat', $('pressBeat').checked?1:0); });
+}
+if($('flowIn')){
+  $('flowIn').addEventListener('change', ()=>{ const v=Number($('flowIn').value||0); ctl('flow', Math.max(-7.5,Math.min(7.5,v))); });
+  $('btnSweep').addEventListener('click', ()=>{ const run=$('btnSweep').dataset.run==='1'; fetch(run?'/api/pump/sweep/stop':'/api/pump/sweep',{method:'POST'}).catch(()=>{}); });
+}
+// Clearing is decided on Core 1 (refused while a reading is still outside): re-read the latch
+if($('btnFaultClr')) $('btnFaultClr').addEventListener('click', async ()=>{
+  try{
+    const r = await fetch('/api/fault/clear',{method:'POST'}); if(r.status!==202) return;
+    await new Promise(ok=>setTimeout(ok, 100));
+    const p = await (await fetch('/api/protect')).json();
+    if(p.fault){ const b=$('btnFaultClr'); b.textContent='Still present'; setTimeout(()=>{ b.textContent='Clear'; }, 1500); }
+  }catch(e){}
+});
 
-function adjustPwm(d){ const el=$('pwmIn'); if(!el) return; let v=Number(el.value||0); v = Math.max(0, Math.min(255, v + d)); el.value = v; post('/api/pwm?duty='+v); }
-function adjustBpm(d){ const el=$('bpmIn'); if(!el) return; let v=Number(el.value||0); v = Math.max(1, Math.min(60, v + d)); el.value = v; post('/api/bpm?b='+v); }
+function adjustPwm(d){ const el=$('pwmIn'); if(!el) return; let v=Number(el.value||0); v = Math.max(0, Math.min(255, v + d)); el.value = v; ctl('pwm', v); }
+function adjustBpm(d){ const el=$('bpmIn'); if(!el) return; let v=Number(el.value||0); v = Math.max(1, Math.min(200, v + d)); el.value = v; ctl('bpm', v); }
 
 // SSE receiver — uses server keys: atr_mmHg, vent_mmHg, flow_L_min, pwmSet, pwm, valve, mode, bpm, loopMs
 let last=performance.now(), ema=0;
@@ -367,11 +443,37 @@ const _sseArr = []; const _sseSrv = []; const _sseSkew = []; let _lastServerTs =
 // Map wall-clock epoch (Date.now) to performance.now timeline so server
 // timestamps (millis) can be converted to performance.now() seconds safely.
 const _perfEpoch = Date.now() - performance.now();
+// Fill the strips from the device's min/max history so a reload or a wider window is not empty.
+// Each point becomes its min and max, half a step apart, which draws the envelope.
+async function loadHistory(){ if (_sseOffset === null) return;
+  const c = $('cv-atr'); const pts = Math.max(100, Math.min(1000, (c && c.clientWidth) | 0 || 600));
+  for (const [s, ch] of [[sAtr,'atr'],[sVent,'vent'],[sFlow,'flow'],[sPwm,'pwm']]){
+    try{ const r = await fetch(`/api/history?ch=${ch}&span=${window.winSec}&points=${pts}`); if(!r.ok) continue; const h = await r.json();
+      const end = (h.endMs + _sseOffset - _perfEpoch) / 1000; const out = [];
+      for (let i=0;i<h.n;i++){ const t = end - (h.n - 1 - i) * h.dt; out.push({t, v:h.min[i]}); if (h.max[i] !== h.min[i]) out.push({t:t + h.dt/2, v:h.max[i]}); }
+      s.seed(out);
+    }catch(e){}
+  } }
+let _histLoaded = false;
 function stats(a){ if(!a||!a.length) return {n:0,mean:0,sd:0,max:0}; let n=a.length; let sum=0, sumsq=0, max=0; for(const v of a){ sum+=v; sumsq+=v*v; if(v>max) max=v; } const mean=sum/n; const variance = Math.max(0, (sumsq - (sum*sum)/n)/n); return {n,mean,sd:Math.sqrt(variance),max}; }
 // persistent numeric-display EMAs to avoid jitter and ensure they follow strip smoothing
 let _dispAtr = null, _dispVent = null, _dispFlow = null;
-// Blood-pressure detection state (client-side): collect max vent per valve segment
-const bpState = { lastValve: null, curMaxVent: null, systolic: null, diastolic: null, lastDisplay: null };
+// Per-beat results computed on the device from every 600 Hz sample: {seq,t,periodMs,sys,dia,map,pp,dpdtMax}
+if (es.addEventListener) es.addEventListener('beat', (ev)=>{ try{ const b=JSON.parse(ev.data);
+  if($('n-bp')) $('n-bp').textContent = Math.round(b.sys) + '/' + Math.round(b.dia);
+  if($('n-sv')) $('n-sv').textContent = 'SV ' + b.svMl.toFixed(1) + ' mL · CO ' + b.coLpm.toFixed(2) + ' L/min';
+}catch(e){} });
+// Resume after a reconnect: frames missed since Last-Event-ID ({"f":[[tsMs,atr,vent,flow,pwm,valve],...]}),
+// then a "gap" for anything the device no longer had
+const _srvSec = ms => (ms + _sseOffset - _perfEpoch) / 1000.0;
+if (es.addEventListener) es.addEventListener('replay', (ev)=>{ try{ if (_sseOffset === null) return; const f = JSON.parse(ev.data).f;
+  const col = (k, m) => f.map(r => ({t:_srvSec(r[0]), v:m ? m(r[k]) : r[k]}));
+  sAtr.merge(col(1)); sVent.merge(col(2)); sFlow.merge(col(3)); sPwm.merge(col(4)); sValve.merge(col(5, v => v ? 1 : 0));
+}catch(e){} });
+if (es.addEventListener) es.addEventListener('gap', (ev)=>{ try{ if (_sseOffset === null) return; const g = JSON.parse(ev.data);
+  const t = _srvSec(g.atMs) - 0.001; [sAtr,sVent,sFlow,sValve,sPwm].forEach(s=> s.mark(t));
+  if (g.reset){ _sseOffset = null; _lastServerTs = null; }
+}catch(e){} });
 es.onopen=()=>$('sse')? $('sse').textContent='OPEN' : null; es.onerror=()=>$('sse')? $('sse').textContent='ERR' : null;
 es.onmessage=(ev)=>{ const now=performance.now(); const dt=now-last; last=now; // arrival dt used for diagnostics only; render FPS is measured by rAF
   try{ const d=JSON.parse(ev.data);
@@ -402,6 +504,7 @@ es.onmessage=(ev)=>{ const now=performance.now(); const dt=now-last; last=now; /
   }
   sAtr.push(atrRawScaled, srvPerfSec); sVent.push(ventRawScaled, srvPerfSec); sFlow.push(flowRawScaled, srvPerfSec);
   sValve.push(d.valve?1:0, srvPerfSec); sPwm.push(Number(d.pwm)||0, srvPerfSec);
+  if (!_histLoaded && _sseOffset !== null){ _histLoaded = true; loadHistory(); }
       // If server provided smoothing settings, apply them to the strips so the smoothing is in sync
       try{ if (d.smooth){ if (sAtr.setAlpha) sAtr.setAlpha(Number(d.smooth.atr) || 0); if (sVent.setAlpha) sVent.setAlpha(Number(d.smooth.vent) || 0); if (sFlow.setAlpha) sFlow.setAlpha(Number(d.smooth.flow) || 0); } }catch(e){}
   // For numeric displays, prefer the smoothed value from the strip if available; apply a small EMA here
@@ -426,61 +529,18 @@ es.onmessage=(ev)=>{ const now=performance.now(); const dt=now-last; last=now; /
   // Display the actual PWM value from the server (do not use client smoothing)
   setNum('n-pwm', Number(d.pwm) || 0, 0);
     if($('n-valve')) $('n-valve').textContent = d.valve? '▲' : '▼';
-    // Blood pressure detection (client-side): record max ventricular pressure per valve segment
-    if($('n-bp')){
-      try{
-  const modeN = Number(d.mode);
-  const pausedN = Number(d.paused);
-  const valveN = Number(d.valve);
-  // Use the same smoothed ventricle value that is shown in the UI numeric display
-  // (_dispVent is kept in sync with the strip smoothing). Fall back to raw server value
-  // if the smoothed display value isn't available.
-  const vent = (_dispVent != null) ? _dispVent : (Number(d.vent_mmHg) || 0);
-        // Only run when in BEAT mode and unpaused
-        if (modeN===2 && pausedN===0){
-          if (bpState.lastValve === null){
-            // initialize on first beat
-            bpState.lastValve = valveN;
-            bpState.curMaxVent = vent;
-            bpState.systolic = null; bpState.diastolic = null; bpState.lastDisplay = null;
-            // remain N/A until first full pair is captured
-            $('n-bp').textContent = 'N/A';
-          } else {
-            if (valveN === bpState.lastValve){
-              // same segment: update max
-              if (vent > bpState.curMaxVent) bpState.curMaxVent = vent;
-            } else {
-              // valve changed -> finalize the just-completed segment
-              if (bpState.lastValve === 0) bpState.diastolic = bpState.curMaxVent;
-              else if (bpState.lastValve === 1) bpState.systolic = bpState.curMaxVent;
-              // start new segment
-              bpState.lastValve = valveN;
-              bpState.curMaxVent = vent;
-              // if we have both, update display and reset for next cycle
-              if (bpState.systolic != null && bpState.diastolic != null){
-                const S = Math.round(bpState.systolic), D = Math.round(bpState.diastolic);
-                // Unit ("mmHg") is already shown in the panel HTML; keep the displayed text numeric only.
-                bpState.lastDisplay = S + '/' + D;
-                $('n-bp').textContent = bpState.lastDisplay;
-                bpState.systolic = null; bpState.diastolic = null;
-              } else {
-                // keep lastDisplay (do not flash N/A between segments)
-                if (bpState.lastDisplay) $('n-bp').textContent = bpState.lastDisplay;
-              }
-            }
-          }
-        } else {
-          // not running/beat -> clear state and show N/A
-          bpState.lastValve = null; bpState.curMaxVent = null; bpState.systolic = null; bpState.diastolic = null;
-          $('n-bp').textContent = 'N/A';
-        }
-      }catch(e){ $('n-bp').textContent = 'N/A'; }
-    }
+    // Blood pressure comes from the device's per-beat analyzer ("beat" events); only clear it here
+    if($('n-bp') && !(Number(d.mode)===2 && Number(d.paused)===0)){ $('n-bp').textContent = 'N/A'; }
       document.querySelectorAll('#modeSeg button').forEach(b=> b.classList.toggle('active', Number(b.dataset.m)===Number(d.mode||0)));
       // Only update input values when the user is not actively typing in them
       const pwmEl = $('pwmIn'); const bpmEl = $('bpmIn');
       if(pwmEl && document.activeElement !== pwmEl) pwmEl.value = d.pwmSet||0;
       if(bpmEl && document.activeElement !== bpmEl) bpmEl.value = d.bpm||0;
+      if(typeof d.flowSet==='number'){ const fe=$('flowIn'); if(fe && document.activeElement !== fe) fe.value = d.flowSet; }
+      if(typeof d.fault!=='undefined' && $('faultPill')){ const f=Number(d.fault); $('faultPill').style.display=f?'':'none';
+        if(f) $('fault').textContent=['over atr','over vent','under atr','under vent','no flow'].filter((_,i)=>f&(1<<i)).join(', '); }
+      if(d.sweep && $('btnSweep')){ const b=$('btnSweep'); const run=Number(d.sweep.st)===1; b.dataset.run=run?'1':'0'; b.textContent = run ? ('Stop '+d.sweep.pct+'%') : 'Sweep'; }
+      if(d.press){ const pe=$('pressIn'); if(pe && document.activeElement !== pe) pe.value = d.press.target; if($('pressBeat')) $('pressBeat').checked = !!d.press.beat; }
       if(d.loopMs && $('loop')) $('loop').textContent = Number(d.loopMs).toFixed(2)+' ms';
     if($('btnToggle')){
       const b=$('btnToggle'); if(Number(d.paused||0)===0){ b.textContent='Pause'; b.classList.remove('btn-play'); b.classList.add('btn-pause'); } else { b.textContent='Play'; b.classList.remove('btn-pause'); b.classList.add('btn-play'); }
@@ -532,12 +592,143 @@ document.getElementById('clear').addEventListener('click', ()=> log.innerHTML=''
 </body></html>
 )HTML";
 
+// Mirrors the SSE per-client queue cap in ESPAsyncWebServer (messages beyond it are dropped)
+#ifdef SSE_MAX_QUEUED_MESSAGES
+static constexpr size_t SSE_QUEUE_LIMIT = SSE_MAX_QUEUED_MESSAGES;
+#else
+static constexpr size_t SSE_QUEUE_LIMIT = 32;
+#endif
+static_assert((SSE_REPLAY_N + SSE_REPLAY_BATCH - 1) / SSE_REPLAY_BATCH + 2 < SSE_QUEUE_LIMIT, "a full replay must fit the client queue");
+
+// ---- Resume (Last-Event-ID) ----
+// Every frame gets the next id; the chart fields of the last SSE_REPLAY_N frames are kept so a
+// client that reconnects with Last-Event-ID (EventSource does this by itself after a drop) gets
+// what it missed as "replay" events before live frames. Ids it can no longer get are reported
+// with a "gap" event. Ids start at a random base so ids from before a reboot do not replay.
+// A client being resumed gets no live frames until its replay is queued; a live id landing between
+// replay batches would move its Last-Event-ID back. sse_task holds live sends while a resume runs
+// and then broadcasts what it held as a "replay", so clients already connected miss nothing.
+struct SseFrame { uint32_t seq, tsMs; float atr, vent, flow; uint8_t pwm, valve; };
+static SseFrame     s_replay[SSE_REPLAY_N];
+static uint32_t     s_sseSeq = 0;          // id of the newest frame
+static uint8_t      s_sseJoining = 0;      // resumes in progress
+static bool         s_sseBusy = false;     // sse_task is sending a frame it recorded as live
+static portMUX_TYPE s_replayMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Returns whether the frame may go out live now; if so, a resume waits for sse_release()
+static bool sse_record(const SseFrame& f){
+  portENTER_CRITICAL(&s_replayMux);
+  s_replay[f.seq % SSE_REPLAY_N] = f; s_sseSeq = f.seq;
+  const bool live = !s_sseJoining;
+  s_sseBusy = live;
+  portEXIT_CRITICAL(&s_replayMux);
+  return live;
+}
+
+static void sse_release(){
+  portENTER_CRITICAL(&s_replayMux); s_sseBusy = false; portEXIT_CRITICAL(&s_replayMux);
+}
+
+// Holds live sends and returns the newest id. A send already in flight is waited out; the bound
+// only matters if the server keeps its client lock across onConnect, and then that send cannot
+// reach this client before the replay anyway.
+static uint32_t sse_join(){
+  uint32_t head = 0;
+  for (uint8_t i = 0;; i++){
+    portENTER_CRITICAL(&s_replayMux);
+    const bool idle = !s_sseBusy || i >= 3;
+    if (idle){ s_sseJoining++; head = s_sseSeq; }
+    portEXIT_CRITICAL(&s_replayMux);
+    if (idle) return head;
+    vTaskDelay(1);
+  }
+}
+
+static void sse_leave(){
+  portENTER_CRITICAL(&s_replayMux); s_sseJoining--; portEXIT_CRITICAL(&s_replayMux);
+}
+
+// To one client, or to all of them when c is null
+static void sse_emit(AsyncEventSourceClient* c, const char* msg, const char* event, uint32_t id){
+  if (c) c->send(msg, event, id); else sse.send(msg, event, id);
+}
+
+static void sse_gap(AsyncEventSourceClient* c, uint32_t from, uint32_t to, uint32_t atMs, bool reset){
+  char g[112];
+  snprintf(g, sizeof(g), "{\"from\":%lu,\"to\":%lu,\"atMs\":%lu,\"reset\":%d}",
+    (unsigned long)from, (unsigned long)to, (unsigned long)atMs, reset ? 1 : 0);
+  sse_emit(c, g, "gap", to);
+  web_ctr.sseGaps.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Frames after last up to head as "replay" events; f holds SSE_REPLAY_BATCH frames
+static void sse_replay(AsyncEventSourceClient* c, uint32_t last, uint32_t head, SseFrame* f, char* out, size_t cap){
+  if (last - head < 0x80000000u){                      // at or ahead of us: nothing missed, or another boot
+    if (last != head) sse_gap(c, last + 1, head, millis(), true);
+    return;
+  }
+  uint32_t from = last + 1;
+  if (head - from >= SSE_REPLAY_N){                    // older than the ring; mark where it resumes
+    from = head - SSE_REPLAY_N + 1;
+    uint32_t at;
+    portENTER_CRITICAL(&s_replayMux); at = s_replay[from % SSE_REPLAY_N].tsMs; portEXIT_CRITICAL(&s_replayMux);
+    sse_gap(c, last + 1, from - 1, at, from - last >= 0x40000000u);
+  }
+  while (from - head - 1 >= 0x80000000u){              // from <= head
+    uint32_t n = head - from + 1; if (n > SSE_REPLAY_BATCH) n = SSE_REPLAY_BATCH;
+    portENTER_CRITICAL(&s_replayMux);
+    for (uint32_t i=0;i<n;i++) f[i] = s_replay[(from + i) % SSE_REPLAY_N];
+    portEXIT_CRITICAL(&s_replayMux);
+    int w = snprintf(out, cap, "{\"f\":[");
+    uint32_t k = 0, at = 0;
+    for (uint32_t i=0;i<n;i++){
+      if (f[i].seq != from + i) continue;              // overwritten while we were replaying
+      if (!k) at = f[i].tsMs;
+      w += snprintf(out + w, cap - w, "%s[%lu,%.2f,%.2f,%.3f,%u,%u]", k++ ? "," : "",
+        (unsigned long)f[i].tsMs, (double)f[i].atr, (double)f[i].vent, (double)f[i].flow, (unsigned)f[i].pwm, (unsigned)f[i].valve);
+    }
+    if (k < n) sse_gap(c, from, from + (n - k) - 1, k ? at : millis(), false);
+    snprintf(out + w, cap - w, "]}");
+    if (k) sse_emit(c, out, "replay", from + n - 1);
+    web_ctr.sseReplayed.fetch_add(k, std::memory_order_relaxed);
+    from += n;
+  }
+}
+
+static constexpr size_t SSE_REPLAY_OUT = SSE_REPLAY_BATCH * 80 + 32;
+
+// Runs on the AsyncTCP task once the client is added; live sends are held until it returns
+static void sse_resume(AsyncEventSourceClient* c){
+  const uint32_t last = c->lastId();
+  if (!last) return;                                   // fresh connection
+  static SseFrame f[SSE_REPLAY_BATCH];
+  static char out[SSE_REPLAY_OUT];
+  const uint32_t head = sse_join();
+  sse_replay(c, last, head, f, out, sizeof(out));
+  sse_leave();
+}
+
 // ---- SSE task @ 60 Hz on Core 0 ----
+// Per-beat results as "beat" events, sent once each as they complete
+static int format_beat(char* out, size_t cap, const BeatStats& b){
+  return snprintf(out, cap,
+    "{\"seq\":%lu,\"t\":%lu,\"periodMs\":%.1f,\"sys\":%.2f,\"dia\":%.2f,\"map\":%.2f,\"pp\":%.2f,\"dpdtMax\":%.1f,"
+    "\"svMl\":%.2f,\"fwdMl\":%.2f,\"revMl\":%.2f,\"coLpm\":%.3f}",
+    (unsigned long)b.seq, (unsigned long)b.tMs, (double)b.periodMs, (double)b.sys, (double)b.dia,
+    (double)b.map, (double)b.pp, (double)b.dpdtMax, (double)b.svMl, (double)b.fwdMl, (double)b.revMl, (double)b.coLpm);
+}
+
 static void sse_task(void*){
   const TickType_t per = pdMS_TO_TICKS(1000/SSE_HZ);
   TickType_t wake = xTaskGetTickCount();
-  static char buf[512];
+  static char buf[1024];
+  uint32_t beatSeq = 0, wsTickMs = 0;
+  s_sseSeq = esp_random() & 0x3FFFFFFFu;
+  uint32_t sent = s_sseSeq;                  // id of the newest frame sent live
   for(;;){
+    const uint32_t ts = millis();
+    bool live = false;
+    if (ts - wsTickMs >= 1000){ wsTickMs = ts; web_ws_tick(); control_pump_map_persist(); }
     int mode  = G.mode.load();
       int paused= G.paused.load(); if (paused==2) paused=1; // present "pending" as paused
       int pwmSet= G.pwmSet.load();
@@ -548,21 +739,66 @@ static void sse_task(void*){
       float ven = G.vent_mmHg.load();
       float fl  = G.flow_L_min.load();
       float loop= G.loopMs.load();
+      CfgProfile cal; G.cal.read(cal);
+      CaptureInfo cap; control_capture_info(cap);
 
       int n = snprintf(buf, sizeof(buf),
-        "{\"mode\":%d,\"paused\":%d,\"pwmSet\":%d,\"pwm\":%d,\"valve\":%d,\"bpm\":%d,\"loopMs\":%.3f,"
+        "{\"mode\":%d,\"paused\":%d,\"pwmSet\":%d,\"pwm\":%d,\"valve\":%d,\"bpm\":%d,\"shape\":%d,\"loopMs\":%.3f,"
+        "\"beat\":{\"periodMs\":%.1f,\"rampPct\":%.1f,\"holdPct\":%.1f,\"deadPct\":%.1f},"
+        "\"proto\":{\"st\":%d,\"step\":%d,\"iter\":%d,\"t\":%.2f,\"total\":%.2f},"
+        "\"press\":{\"target\":%.1f,\"beat\":%d,\"peak\":%.1f},"
+        "\"flowSet\":%.2f,\"sweep\":{\"st\":%d,\"pct\":%d},"
+        "\"ilc\":{\"on\":%d,\"rms\":%.2f,\"beats\":%lu},"
+        "\"fault\":%d,\"cap\":{\"st\":%d,\"seq\":%lu},"
+        "\"vol\":{\"fwdMl\":%.1f,\"revMl\":%.1f,\"coLpm\":%.3f},"
         "\"atr_mmHg\":%.3f,\"vent_mmHg\":%.3f,\"flow_L_min\":%.3f,"
         "\"atr_raw\":%d,\"vent_raw\":%d,\"flow_hz\":%.3f,"
-  "\"cal\":{\"atr_m\":%.6f,\"atr_b\":%.6f,\"vent_m\":%.6f,\"vent_b\":%.6f,\"flow_m\":%.6f,\"flow_b\":%.6f},"
+  "\"cal\":{\"atr_m\":%.6f,\"atr_b\":%.6f,\"vent_m\":%.6f,\"vent_b\":%.6f,\"flow_m\":%.6f,\"flow_b\":%.6f,\"profile\":\"%s\"},"
   "\"tsMs\":%lu,"
   "\"smooth\":{\"atr\":%.3f,\"vent\":%.3f,\"flow\":%.3f}}",
-        mode, paused, pwmSet, pwm, valve, bpm, loop,
+        mode, paused, pwmSet, pwm, valve, bpm, G.beatShape.load(), loop,
+        G.beatPeriodMs.load(), G.beatRampPct.load(), G.beatHoldPct.load(), G.beatDeadPct.load(),
+        G.protoState.load(), G.protoStep.load(), G.protoIter.load(),
+        (double)G.protoTicks.load() / CONTROL_HZ, (double)G.protoTotal.load() / CONTROL_HZ,
+        G.pressTarget.load(), G.pressBeat.load(), G.pressPeak.load(),
+        G.flowTarget.load(), G.sweepState.load(), G.sweepPct.load(),
+        G.ilcOn.load(), G.ilcRms.load(), (unsigned long)G.ilcBeats.load(),
+        G.fault.load(), (int)control_capture().state(), (unsigned long)cap.info.seq,
+        G.volFwdMl.load(), G.volRevMl.load(), G.coLpm.load(),
         atr, ven, fl,
         G.atr_raw.load(), G.vent_raw.load(), G.flow_hz.load(),
-        G.atr_m.load(), G.atr_b.load(), G.vent_m.load(), G.vent_b.load(), G.flow_m.load(), G.flow_b.load(),
-  (unsigned long)millis(),
+        cal.atr.m, cal.atr.b, cal.vent.m, cal.vent.b, cal.flow.m, cal.flow.b, cal.name,
+  (unsigned long)ts,
   (double)g_smooth_atr, (double)g_smooth_vent, (double)g_smooth_flow);
-    if (n>0) sse.send(buf, "message", millis());
+    size_t clients = sse.count();
+    web_ctr.sseClients.store((uint32_t)clients, std::memory_order_relaxed);
+    if (n<=0 || n>=(int)sizeof(buf)){
+      web_ctr.sseFailed.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      // recorded with or without clients: a dropped client is exactly who needs it
+      const uint32_t seq = s_sseSeq + 1;
+      live = sse_record(SseFrame{ seq, ts, atr, ven, fl, (uint8_t)pwm, (uint8_t)valve });
+      if (live && clients && seq - 1 != sent){
+        // frames held while a client resumed
+        static SseFrame f[SSE_REPLAY_BATCH];
+        static char out[SSE_REPLAY_OUT];
+        sse_replay(nullptr, sent, seq - 1, f, out, sizeof(out));
+      }
+      if (live) sent = seq;
+      if (live && clients){
+        // the server silently drops frames once a client's queue is full
+        if (sse.avgPacketsWaiting() >= SSE_QUEUE_LIMIT) web_ctr.sseFailed.fetch_add(1, std::memory_order_relaxed);
+        else web_ctr.sseSent.fetch_add(1, std::memory_order_relaxed);
+        sse.send(buf, "message", seq);
+      }
+    }
+    BeatStats beats[4];
+    uint8_t nb = live ? control_beats(beatSeq, beats, 4) : 0;   // beats carry the newest id too
+    for (uint8_t i=0; i<nb; i++){
+      beatSeq = beats[i].seq;
+      if (clients && format_beat(buf, sizeof(buf), beats[i]) > 0) sse.send(buf, "beat", s_sseSeq);   // keeps the client's last id
+    }
+    if (live) sse_release();
     vTaskDelayUntil(&wake, per);
   }
 }
@@ -570,53 +806,140 @@ static void sse_task(void*){
 // ---- Route helpers (Core 0 posts commands) ----
 static void post_or_inline(const Cmd& c){
   if (!shared_post(c)){
+    web_ctr.cmdInline.fetch_add(1, std::memory_order_relaxed);
     // emergency inline adjust: update atomics as if Core 1 had consumed them
     if (c.t==CMD_TOGGLE){
-      int p=G.paused.load(); G.paused.store(p?0:1);
+      int p=G.paused.load(); if (!(p && G.fault.load())) G.paused.store(p?0:1);
     } else if (c.t==CMD_SET_PWM){
       int v=c.i; if(v<0)v=0; if(v>255)v=255; G.pwmSet.store(v);
     } else if (c.t==CMD_SET_BPM){
-      int b=c.i; if(b<1)b=1; if(b>60)b=60; G.bpm.store(b);
+      int b=c.i; if(b<BPM_MIN)b=BPM_MIN; if(b>BPM_MAX)b=BPM_MAX; G.bpm.store(b);
     } else if (c.t==CMD_SET_MODE){
-      int m=c.i; if(m<MODE_FWD||m>MODE_BEAT)m=MODE_FWD; G.mode.store(m);
+      int m=c.i; if(m<MODE_FWD||m>MODE_FLOW)m=MODE_FWD; G.mode.store(m);
+    } else if (c.t==CMD_SET_PRESS){
+      float t=c.i*0.1f; if(t<0)t=0; if(t>PRESS_TARGET_MAX)t=PRESS_TARGET_MAX; G.pressTarget.store(t);
+    } else if (c.t==CMD_SET_PRESS_BEAT){
+      G.pressBeat.store(c.i?1:0);
+    } else if (c.t==CMD_SET_FLOW){
+      float t=c.i*0.01f; if(t<-FLOW_TARGET_MAX)t=-FLOW_TARGET_MAX; if(t>FLOW_TARGET_MAX)t=FLOW_TARGET_MAX; G.flowTarget.store(t);
     }
   }
 }
 
+// Setpoint commands shared by the HTTP routes and /ws, so both paths post identical Cmds
+static Cmd cmd_for(CtlOp op, float v){
+  if (!(v > -1e6f && v < 1e6f)) v = 0;             // NaN/huge: keep lroundf defined; clamped in Core 1
+  switch (op){
+    case CTL_PWM:        return Cmd{ CMD_SET_PWM, (int)lroundf(v) };
+    case CTL_BPM:        return Cmd{ CMD_SET_BPM, (int)lroundf(v) };
+    case CTL_MODE:       return Cmd{ CMD_SET_MODE, (int)lroundf(v) };
+    case CTL_PRESS:      return Cmd{ CMD_SET_PRESS, (int)lroundf(v*10.0f) };
+    case CTL_PRESS_BEAT: return Cmd{ CMD_SET_PRESS_BEAT, v != 0.0f ? 1 : 0 };
+    case CTL_FLOW:       return Cmd{ CMD_SET_FLOW, (int)lroundf(v*100.0f) };
+    case CTL_TOGGLE:
+    default:             return Cmd{ CMD_TOGGLE, 0 };
+  }
+}
+static void ctl_apply(const CtlMsg& m){ post_or_inline(cmd_for(m.op, m.v)); }
+
+// Parse "5,40,95,60" into floats in place (no substrings); empty fields are skipped
+static uint8_t parse_csv_f(const String& csv, float* out, uint8_t maxN){
+  uint8_t n = 0;
+  for (const char* p = csv.c_str(); *p && n < maxN; ){
+    char* e;
+    const float v = strtof(p, &e);
+    if (e != p) out[n++] = v;
+    while (*e && *e != ',') e++;                   // skip to the next field
+    p = *e ? e + 1 : e;
+  }
+  return n;
+}
+
+// Parse "0,0.4,1,0.7,0" (normalized 0..1) into 0..255 points; returns count (0 = invalid,
+// including more than BEAT_SHAPE_MAX_PTS points)
+static uint8_t parse_shape_pts(const String& csv, uint8_t* out){
+  float v[BEAT_SHAPE_MAX_PTS + 1];
+  const uint8_t n = parse_csv_f(csv, v, BEAT_SHAPE_MAX_PTS + 1);
+  if (n > BEAT_SHAPE_MAX_PTS) return 0;
+  for (uint8_t i=0;i<n;i++){ float x = v[i]; if (x<0) x=0; if (x>1) x=1; out[i] = (uint8_t)lroundf(x*255.0f); }
+  return (n >= 2) ? n : 0;
+}
+
 // ---- Calibration hooks wiring ----
 static void get_cals(float& am,float& ab,float& vm,float& vb,float& fm,float& fb){
-  am=G.atr_m.load(); ab=G.atr_b.load(); vm=G.vent_m.load(); vb=G.vent_b.load(); fm=G.flow_m.load(); fb=G.flow_b.load();
+  CfgProfile c; G.cal.read(c);
+  am=c.atr.m; ab=c.atr.b; vm=c.vent.m; vb=c.vent.b; fm=c.flow.m; fb=c.flow.b;
 }
+// Edits the live profile as a whole; the control loop never sees half of an update
 static void set_cals(float am,float ab,float vm,float vb,float fm,float fb){
-  G.atr_m.store(am); G.atr_b.store(ab); G.vent_m.store(vm); G.vent_b.store(vb); G.flow_m.store(fm); G.flow_b.store(fb);
+  shared_cal_publish(CfgCal{ am, ab }, CfgCal{ vm, vb }, CfgCal{ fm, fb });
 }
 // NVS helpers used by the calibration UI hooks
-static bool nvs_save_all(bool atr,bool vent,bool flow){
-  Preferences p; if(!p.begin("cal", false)) return false;
-  if (atr){ p.putFloat("atr_m", G.atr_m.load()); p.putFloat("atr_b", G.atr_b.load()); }
-  if (vent){ p.putFloat("ven_m", G.vent_m.load()); p.putFloat("ven_b", G.vent_b.load()); }
-  if (flow){ p.putFloat("flo_m", G.flow_m.load()); p.putFloat("flo_b", G.flow_b.load()); }
-  p.end(); return true;
+static bool nvs_save_all(bool atr,bool vent,bool flow){ return shared_cfg_save(atr, vent, flow); }
+static bool nvs_load_all(){ return shared_cfg_load(); }
+static void nvs_defaults_all(){
+  shared_cal_publish(CfgCal{ CAL_ATR_DEFAULT.m, CAL_ATR_DEFAULT.b }, CfgCal{ CAL_VENT_DEFAULT.m, CAL_VENT_DEFAULT.b },
+                     CfgCal{ CAL_FLOW_DEFAULT.m, CAL_FLOW_DEFAULT.b });
 }
-static bool nvs_load_all(){
-  Preferences p; if(!p.begin("cal", false)) return false;
-  float am = p.getFloat("atr_m",  G.atr_m.load());
-  float ab = p.getFloat("atr_b",  G.atr_b.load());
-  float vm = p.getFloat("ven_m",  G.vent_m.load());
-  float vb = p.getFloat("ven_b",  G.vent_b.load());
-  float fm = p.getFloat("flo_m",  G.flow_m.load());
-  float fb = p.getFloat("flo_b",  G.flow_b.load());
-  p.end();
-  G.atr_m.store(am);  G.atr_b.store(ab);
-  G.vent_m.store(vm); G.vent_b.store(vb);
-  G.flow_m.store(fm); G.flow_b.store(fb);
-  return true;
+
+// ---- Calibration profiles (/api/cal/profiles) ----
+// Handlers run on the AsyncTCP task, the only writer of G.cal and the stored table. Activation
+// swaps one pointer; the control loop picks the new profile up on its next tick without waiting.
+static void send_ok(AsyncWebServerRequest* r, bool ok, const char* err){
+  WebJson* j = web_json(r);
+  if (!j){ web_json_busy(r); return; }
+  j->w.obj().kv("ok", ok);
+  if (!ok) j->w.kv("err", err);
+  j->w.end();
+  web_json_send(r, j, ok ? 200 : (strcmp(err, "nvs") == 0 ? 500 : 400));
 }
-static void nvs_defaults_all(){
-  G.atr_m.store(CAL_ATR_DEFAULT.m); G.atr_b.store(CAL_ATR_DEFAULT.b);
-  G.vent_m.store(CAL_VENT_DEFAULT.m); G.vent_b.store(CAL_VENT_DEFAULT.b);
-  G.flow_m.store(CAL_FLOW_DEFAULT.m); G.flow_b.store(CAL_FLOW_DEFAULT.b);
+static int8_t profile_param(AsyncWebServerRequest* r, const char* key){
+  if (!r->hasParam(key, true)) return -1;
+  const String& v = r->getParam(key, true)->value();
+  return calp_valid_name(v.c_str()) ? calp_find(shared_cfg(), v.c_str()) : -1;
 }
+static void cal_profiles_register(){
+  server.on("/api/cal/profiles/activate", HTTP_POST, [](AsyncWebServerRequest* r){
+    const int8_t i = profile_param(r, "name");
+    if (i < 0){ send_ok(r, false, "unknown profile"); return; }
+    send_ok(r, shared_cal_activate((uint8_t)i), "nvs");
+  });
+  // from= defaults to the active profile, whose live (possibly unsaved) values are copied
+  server.on("/api/cal/profiles/clone", HTTP_POST, [](AsyncWebServerRequest* r){
+    const int8_t from = r->hasParam("from", true) ? profile_param(r, "from") : (int8_t)shared_cfg().activeProfile;
+    if (from < 0){ send_ok(r, false, "unknown profile"); return; }
+    if (!r->hasParam("to", true)){ send_ok(r, false, "missing to"); return; }
+    const int8_t k = shared_cal_clone((uint8_t)from, r->getParam("to", true)->value().c_str());
+    send_ok(r, k >= 0, k == -1 ? "bad or duplicate name" : (k == -2 ? "table full" : "nvs"));
+  });
+  server.on("/api/cal/profiles/delete", HTTP_POST, [](AsyncWebServerRequest* r){
+    const int8_t i = profile_param(r, "name");
+    if (i < 0){ send_ok(r, false, "unknown profile"); return; }
+    if (i == shared_cfg().activeProfile){ send_ok(r, false, "profile is active"); return; }
+    send_ok(r, shared_cal_delete((uint8_t)i), "nvs");
+  });
+  server.on("/api/cal/profiles", HTTP_GET, [](AsyncWebServerRequest* r){
+    WebJson* j = web_json(r);
+    if (!j){ web_json_busy(r); return; }
+    const Config& c = shared_cfg();
+    CfgProfile live; G.cal.read(live);
+    const CfgProfile& a = c.profiles[c.activeProfile];
+    const bool edited = memcmp(&live.atr, &a.atr, 3 * sizeof(CfgCal)) != 0;
+    JsonWriter& w = j->w;
+    w.obj().kv("active", a.name).kv("edited", edited).kv("max", (unsigned)CFG_PROFILES).key("profiles").arr();
+    for (uint8_t i = 0; i < c.nProfiles; i++){
+      const CfgProfile& p = c.profiles[i];
+      w.obj().kv("name", p.name);
+      w.key("atr").arr().num(p.atr.m, 6).num(p.atr.b, 6).end();
+      w.key("vent").arr().num(p.vent.m, 6).num(p.vent.b, 6).end();
+      w.key("flow").arr().num(p.flow.m, 6).num(p.flow.b, 6).end();
+      w.end();
+    }
+    w.end().end();
+    web_json_send(r, j);
+  });
+}
+
 static int  read_atr_raw(){ return G.atr_raw.load(); }
 static int  read_vent_raw(){ return G.vent_raw.load(); }
 static float read_flow_hz(){ return G.flow_hz.load(); }
@@ -634,28 +957,339 @@ void web_start(){
 
   // Control APIs (GET)
   server.on("/api/pwm", HTTP_GET, [](AsyncWebServerRequest* r){
-    if (r->hasParam("duty")){
-      int v=r->getParam("duty")->value().toInt();
-      post_or_inline({CMD_SET_PWM, v});
-    }
+    if (r->hasParam("duty")) post_or_inline(cmd_for(CTL_PWM, r->getParam("duty")->value().toInt()));
     r->send(204);
   });
   server.on("/api/bpm", HTTP_GET, [](AsyncWebServerRequest* r){
-    if (r->hasParam("b")){
-      int v=r->getParam("b")->value().toInt();
-      post_or_inline({CMD_SET_BPM, v});
-    }
+    if (r->hasParam("b")) post_or_inline(cmd_for(CTL_BPM, r->getParam("b")->value().toInt()));
     r->send(204);
   });
   server.on("/api/mode", HTTP_GET, [](AsyncWebServerRequest* r){
-    if (r->hasParam("m")){
-      int v=r->getParam("m")->value().toInt();
-      post_or_inline({CMD_SET_MODE, v});
+    if (r->hasParam("m")) post_or_inline(cmd_for(CTL_MODE, r->getParam("m")->value().toInt()));
+    r->send(204);
+  });
+  // Closed-loop pressure: target (mmHg) for MODE_PRESS and beat peak tracking (beat=0/1)
+  server.on("/api/press", HTTP_GET, [](AsyncWebServerRequest* r){
+    if (r->hasParam("t")) post_or_inline(cmd_for(CTL_PRESS, r->getParam("t")->value().toFloat()));
+    if (r->hasParam("beat")) post_or_inline(cmd_for(CTL_PRESS_BEAT, r->getParam("beat")->value().toInt()));
+    r->send(204);
+  });
+  // Tuning (form fields, any subset): kp, ki, kd (per tick), bkp, bki (per beat), ffg, ffo.
+  // Clamped to the PRESS_*_MAX bounds (app_config.h); a non-finite value is a 400.
+  server.on("/api/press/tune", HTTP_POST, [](AsyncWebServerRequest* r){
+    static PressTuning t;                  // last accepted tuning (defaults until the first post)
+    PressTuning n = t;
+    const char* bad = nullptr;
+    auto fld = [&](const char* k, float& v, float lo, float hi){
+      if (!r->hasParam(k, true)) return;
+      const float x = r->getParam(k, true)->value().toFloat();
+      if (!isfinite(x)){ if (!bad) bad = k; return; }
+      v = x < lo ? lo : (x > hi ? hi : x);
+    };
+    fld("kp", n.tick.kp, 0, PRESS_KP_MAX); fld("ki", n.tick.ki, 0, PRESS_KI_MAX); fld("kd", n.tick.kd, 0, PRESS_KD_MAX);
+    fld("bkp", n.beat.kp, 0, PRESS_BEAT_KP_MAX); fld("bki", n.beat.ki, 0, PRESS_BEAT_KI_MAX);
+    fld("ffg", n.ffGain, 0, PRESS_FF_GAIN_MAX); fld("ffo", n.ffOffset, -PRESS_FF_OFFSET_MAX, PRESS_FF_OFFSET_MAX);
+    if (bad){
+      char e[64]; snprintf(e, sizeof(e), "{\"ok\":false,\"err\":\"not finite\",\"field\":\"%s\"}", bad);
+      r->send(400, "application/json", e); return;
+    }
+    if (!control_post_press_tuning(n)){ r->send(503, "application/json", "{\"ok\":false,\"err\":\"busy\"}"); return; }
+    t = n;
+    char buf[192];
+    snprintf(buf, sizeof(buf), "{\"ok\":true,\"kp\":%.4f,\"ki\":%.4f,\"kd\":%.4f,\"bkp\":%.4f,\"bki\":%.4f,\"ffg\":%.4f,\"ffo\":%.2f}",
+      t.tick.kp, t.tick.ki, t.tick.kd, t.beat.kp, t.beat.ki, t.ffGain, t.ffOffset);
+    r->send(200, "application/json", buf);
+  });
+  // Beat waveform learning: target upload (form field pts = mmHg values spread over one beat,
+  // 2..64 points, optional on=1), enable/disable/reset, and per-bin read-out
+  server.on("/api/ilc/target", HTTP_POST, [](AsyncWebServerRequest* r){
+    if (!r->hasParam("pts", true)){ r->send(400); return; }
+    float pts[64]; IlcTarget t;
+    uint8_t n = parse_csv_f(r->getParam("pts", true)->value(), pts, 64);
+    if (n < 2){ r->send(400, "application/json", "{\"ok\":false,\"err\":\"pts needs 2..64 values\"}"); return; }
+    ilc_resample(pts, n, t.mmHg);
+    if (!control_post_ilc_target(t)){ r->send(503, "application/json", "{\"ok\":false,\"err\":\"busy\"}"); return; }
+    if (r->hasParam("on", true) && r->getParam("on", true)->value().toInt()) post_or_inline({CMD_ILC, 1});
+    r->send(200, "application/json", "{\"ok\":true}");
+  });
+  server.on("/api/ilc", HTTP_GET, [](AsyncWebServerRequest* r){
+    if (r->hasParam("on")){ int v=r->getParam("on")->value().toInt(); post_or_inline({CMD_ILC, v?1:0}); }
+    if (r->hasParam("reset")) post_or_inline({CMD_ILC, 2});
+    float tg[ILC_BINS], co[ILC_BINS];
+    control_ilc_bins(tg, co);
+    AsyncResponseStream* s = r->beginResponseStream("application/json");
+    s->printf("{\"on\":%d,\"rms\":%.2f,\"beats\":%lu,\"target\":[", G.ilcOn.load(), G.ilcRms.load(), (unsigned long)G.ilcBeats.load());
+    for (uint8_t b=0;b<ILC_BINS;b++) s->printf("%s%.1f", b?",":"", (double)tg[b]);
+    s->print("],\"corr\":[");
+    for (uint8_t b=0;b<ILC_BINS;b++) s->printf("%s%.1f", b?",":"", (double)co[b]);
+    s->print("]}");
+    r->send(s);
+  });
+
+  // Last completed beats (oldest first); n limits the count
+  server.on("/api/beats", HTTP_GET, [](AsyncWebServerRequest* r){
+    static BeatStats b[HEMO_RING_N];       // AsyncTCP handlers run on one task
+    uint8_t n = control_beats(0, b, HEMO_RING_N), first = 0;
+    if (r->hasParam("n")){ int k=r->getParam("n")->value().toInt(); if (k>=0 && k<n) first = n - k; }
+    AsyncResponseStream* s = r->beginResponseStream("application/json");
+    char one[256];
+    s->print("{\"beats\":[");
+    for (uint8_t i=first; i<n; i++){ format_beat(one, sizeof(one), b[i]); s->printf("%s%s", i>first?",":"", one); }
+    s->print("]}");
+    r->send(s);
+  });
+
+  // Delivered volume since boot or the last ?reset=1, and rolling cardiac output
+  server.on("/api/volume", HTTP_GET, [](AsyncWebServerRequest* r){
+    if (r->hasParam("reset")){ post_or_inline({CMD_VOLUME_RESET, 0}); r->send(204); return; }
+    float f = G.volFwdMl.load(), v = G.volRevMl.load();
+    char out[128];
+    snprintf(out, sizeof(out), "{\"fwdMl\":%.1f,\"revMl\":%.1f,\"netMl\":%.1f,\"coLpm\":%.3f}",
+      (double)f, (double)v, (double)(f - v), (double)G.coLpm.load());
+    r->send(200, "application/json", out);
+  });
+
+  // Protection limits and latched fault; POST fields over/under/hyst (mmHg), debounce (ticks),
+  // drive (PWM), noflow (ms). /api/fault/clear only succeeds once readings are back inside.
+  server.on("/api/protect", HTTP_GET, [](AsyncWebServerRequest* r){
+    ProtectInfo pi; control_protect_info(pi);
+    char out[320];
+    snprintf(out, sizeof(out), "{\"fault\":%u,\"trips\":%lu,\"latencyMs\":%.2f,\"tripRaw\":[%ld,%ld],"
+      "\"over\":%.1f,\"under\":%.1f,\"hyst\":%.1f,\"debounce\":%u,\"drive\":%u,\"noflow\":%lu}",
+      (unsigned)pi.fault, (unsigned long)pi.trips, pi.latencyTicks * 1000.0 / CONTROL_HZ,
+      (long)pi.tripRaw[PROT_ATR], (long)pi.tripRaw[PROT_VENT],
+      (double)pi.cfg.overMmHg, (double)pi.cfg.underMmHg, (double)pi.cfg.hystMmHg, (unsigned)pi.cfg.debounceTicks,
+      (unsigned)pi.cfg.drivePwm, (unsigned long)(pi.cfg.noFlowTicks * 1000 / CONTROL_HZ));
+    r->send(200, "application/json", out);
+  });
+  server.on("/api/protect", HTTP_POST, [](AsyncWebServerRequest* r){
+    ProtectInfo pi; control_protect_info(pi);
+    ProtectCfg c = pi.cfg;
+    auto fld = [&](const char* k, float& v){ if (r->hasParam(k, true)) v = r->getParam(k, true)->value().toFloat(); };
+    fld("over", c.overMmHg); fld("under", c.underMmHg); fld("hyst", c.hystMmHg);
+    if (r->hasParam("debounce", true)){ long v = r->getParam("debounce", true)->value().toInt(); c.debounceTicks = (uint16_t)(v<1 ? 1 : (v>600 ? 600 : v)); }
+    if (r->hasParam("drive", true)){ long v = r->getParam("drive", true)->value().toInt(); c.drivePwm = (uint8_t)(v<1 ? 1 : (v>255 ? 255 : v)); }
+    if (r->hasParam("noflow", true)){ long v = r->getParam("noflow", true)->value().toInt(); v = v<100 ? 100 : (v>60000 ? 60000 : v); c.noFlowTicks = (uint32_t)v * CONTROL_HZ / 1000; }
+    if (c.underMmHg + c.hystMmHg >= c.overMmHg - c.hystMmHg){ r->send(400, "application/json", "{\"ok\":false,\"err\":\"limits overlap\"}"); return; }
+    if (!control_post_protect(c)){ r->send(503, "application/json", "{\"ok\":false,\"err\":\"busy\"}"); return; }
+    r->send(200, "application/json", "{\"ok\":true}");
+  });
+  // Core 1 decides (Protection::clear() refuses while a condition is present), so this only
+  // queues the attempt: 202 with the mask now, and the caller re-reads /api/protect
+  server.on("/api/fault/clear", HTTP_POST, [](AsyncWebServerRequest* r){
+    const int f = G.fault.load();
+    if (!f){ r->send(200, "application/json", "{\"ok\":true,\"fault\":0}"); return; }
+    if (!shared_post({CMD_FAULT_CLEAR, 0})){ r->send(503, "application/json", "{\"ok\":false,\"err\":\"busy\"}"); return; }
+    char out[48];
+    snprintf(out, sizeof(out), "{\"ok\":true,\"pending\":true,\"fault\":%d}", f);
+    r->send(202, "application/json", out);
+  });
+
+  // Sliding-window statistics per channel (all control-rate samples, not the 60 Hz stream)
+  server.on("/api/stats", HTTP_GET, [](AsyncWebServerRequest* r){
+    static StatsSnapshot st;               // AsyncTCP handlers run on one task
+    control_stats(st);
+    static const char* const names[STATS_CH] = { "atr", "vent", "flow", "pwm" };
+    AsyncResponseStream* s = r->beginResponseStream("application/json");
+    s->printf("{\"seq\":%lu,\"hz\":%lu,\"windows\":[", (unsigned long)st.seq, (unsigned long)CONTROL_HZ);
+    for (uint8_t w=0;w<STATS_WINDOWS;w++){
+      s->printf("%s{\"ms\":%lu", w?",":"", (unsigned long)st.windowMs[w]);
+      for (uint8_t c=0;c<STATS_CH;c++){
+        const WinResult& v = st.r[w][c];
+        s->printf(",\"%s\":{\"n\":%lu,\"min\":%.3f,\"max\":%.3f,\"mean\":%.3f,\"sd\":%.3f}",
+          names[c], (unsigned long)v.n, (double)v.min, (double)v.max, (double)v.mean, (double)v.sd);
+      }
+      s->print("}");
     }
+    s->print("]}");
+    r->send(s);
+  });
+  // Resize one window (slot 0..STATS_WINDOWS-1, ms); its history restarts
+  server.on("/api/stats/window", HTTP_POST, [](AsyncWebServerRequest* r){
+    if (!r->hasParam("slot", true) || !r->hasParam("ms", true)){ r->send(400); return; }
+    long w = r->getParam("slot", true)->value().toInt(), ms = r->getParam("ms", true)->value().toInt();
+    if (w < 0 || w >= STATS_WINDOWS || ms <= 0 || ms > (long)STATS_WINDOW_MAX_MS){ r->send(400); return; }
+    int v = (int)((w << 24) | ms);
+    post_or_inline({CMD_STATS_WINDOW, v});
+    r->send(200, "application/json", "{\"ok\":true}");
+  });
+
+  // Min/max history for chart windows: ?ch=atr|vent|flow|pwm&span=<s>&points=<n>. Points are
+  // oldest first, each covering dt seconds; endMs is the millis() the newest one closed at.
+  server.on("/api/history", HTTP_GET, [](AsyncWebServerRequest* r){
+    static const char* const names[HIST_CH] = { "atr", "vent", "flow", "pwm" };
+    static HistPoint pts[HIST_MAX_POINTS];   // AsyncTCP handlers run on one task
+    uint8_t ch = HIST_CH;
+    if (r->hasParam("ch")) for (uint8_t c=0;c<HIST_CH;c++) if (r->getParam("ch")->value() == names[c]) ch = c;
+    float span = r->hasParam("span") ? r->getParam("span")->value().toFloat() : 5.0f;
+    long pn = r->hasParam("points") ? r->getParam("points")->value().toInt() : 600;
+    if (ch >= HIST_CH || !(span > 0) || pn <= 0){ r->send(400); return; }
+    if (pn > HIST_MAX_POINTS) pn = HIST_MAX_POINTS;
+    const History* hp = control_history();
+    if (!hp){ r->send(503, "application/json", "{\"ok\":false,\"err\":\"no history\"}"); return; }
+    const History& h = *hp;
+    // Nothing older than the coarsest tier exists; clamp before the tick count can overflow
+    const float spanMax = (float)History::tierSpanTicks(HIST_TIERS - 1) / CONTROL_HZ;
+    if (span > spanMax) span = spanMax;
+    const HistQuery q = h.query(ch, (uint32_t)(span * CONTROL_HZ + 0.5f), (uint16_t)pn, pts);
+    const uint32_t ageMs = (uint32_t)((uint64_t)(h.ticks() - q.endTick) * 1000 / CONTROL_HZ);
+    const float k = 1.0f / HIST_SCALE[ch];
+    AsyncResponseStream* s = r->beginResponseStream("application/json");
+    s->printf("{\"ch\":\"%s\",\"tier\":%u,\"n\":%u,\"dt\":%.5f,\"endMs\":%lu,\"min\":[",
+      names[ch], (unsigned)q.tier, (unsigned)q.n, (double)q.stepTicks / CONTROL_HZ, (unsigned long)(millis() - ageMs));
+    for (uint16_t i=0;i<q.n;i++) s->printf("%s%.2f", i?",":"", (double)(pts[i].lo * k));
+    s->print("],\"max\":[");
+    for (uint16_t i=0;i<q.n;i++) s->printf("%s%.2f", i?",":"", (double)(pts[i].hi * k));
+    s->print("]}");
+    r->send(s);
+  });
+
+  // Ensemble-averaged beat templates: mean and variance per phase bin (bin 0 = FWD→REV flip)
+  server.on("/api/template", HTTP_GET, [](AsyncWebServerRequest* r){
+    if (r->hasParam("reset")){ post_or_inline({CMD_TEMPLATE_RESET, 0}); r->send(204); return; }
+    static EnsembleAvg e;                  // AsyncTCP handlers run on one task
+    control_template(e);
+    static const char* const names[ENS_CH] = { "atr", "vent", "flow" };
+    AsyncResponseStream* s = r->beginResponseStream("application/json");
+    s->printf("{\"bins\":%u,\"alpha\":%.5f,\"periodMs\":%.1f,\"n\":[", (unsigned)ENS_BINS, (double)e.alpha(), (double)G.beatPeriodMs.load());
+    for (uint8_t b=0;b<ENS_BINS;b++) s->printf("%s%u", b?",":"", (unsigned)e.count(b));
+    s->print("]");
+    for (uint8_t c=0;c<ENS_CH;c++){
+      s->printf(",\"%s\":{\"mean\":[", names[c]);
+      for (uint8_t b=0;b<ENS_BINS;b++) s->printf("%s%.3f", b?",":"", (double)e.mean(c, b));
+      s->print("],\"var\":[");
+      for (uint8_t b=0;b<ENS_BINS;b++) s->printf("%s%.3f", b?",":"", (double)e.var(c, b));
+      s->print("]}");
+    }
+    s->print("}");
+    r->send(s);
+  });
+
+  // Flow setpoint for MODE_FLOW (L/min; negative = reverse)
+  server.on("/api/flow", HTTP_GET, [](AsyncWebServerRequest* r){
+    if (r->hasParam("t")) post_or_inline(cmd_for(CTL_FLOW, r->getParam("t")->value().toFloat()));
+    r->send(204);
+  });
+  // Compound run-state change (JSON body, see runbatch.h): validated whole, applied by Core 1
+  // in one tick. POST answers 202 with the batch id straight away; GET ?id= returns the state
+  // that tick produced (202 while still queued, 404 once aged out or never issued).
+  server.on("/api/batch", HTTP_GET, [](AsyncWebServerRequest* r){
+    const long id = r->hasParam("id") ? r->getParam("id")->value().toInt() : 0;
+    if (id <= 0){ r->send(400); return; }
+    BatchResult res;
+    const BatchStatus st = control_batch_result((uint32_t)id, res);
+    if (st == BATCH_UNKNOWN){ r->send(404, "application/json", "{\"ok\":false,\"err\":\"unknown id\"}"); return; }
+    WebJson* j = web_json(r);
+    if (!j){ web_json_busy(r); return; }
+    j->w.obj().kv("ok", true).kv("id", (unsigned long)id).kv("applied", st == BATCH_APPLIED);
+    if (st == BATCH_APPLIED){
+      const RunState& rs = res.state;
+      j->w.kv("tick", (unsigned long)res.tick).kv("mode", (long)rs.mode).kv("paused", (unsigned)rs.paused)
+          .kv("pwmSet", (long)rs.pwm).kv("bpm", (long)rs.bpm);
+      j->w.key("press").obj().kv("target", rs.press, 1).kv("beat", rs.pressBeat).end();
+      j->w.kv("flowSet", rs.flow, 2).kv("fault", rs.fault)
+          .kv("seq", (res.actions & BA_SEQ) != 0).kv("runRefused", (res.actions & BA_RUN_REFUSED) != 0);
+    }
+    j->w.end();
+    web_json_send(r, j, st == BATCH_APPLIED ? 200 : 202);
+  });
+  server.on("/api/batch", HTTP_POST,
+    [](AsyncWebServerRequest* r){
+      WebJson* j = web_json_find(r);
+      if (!j) j = web_json_body(r, BATCH_FIELDS, BATCH_NFIELDS, sizeof(RunBatch));   // no body: bad JSON below
+      if (!j){ web_json_busy(r); return; }
+      RunBatch& b = *(RunBatch*)j->body;
+      const char* field;
+      const BatchErr e = batch_check(j->rd.finish(), j->bind, control_batch_limits(), b, &field);
+      if (e != BATCH_OK){
+        if (e == BATCH_BAD_JSON) web_ctr.jsonBad.fetch_add(1, std::memory_order_relaxed);
+        j->w.obj().kv("ok", false).kv("err", batch_err_name(e));
+        if (field[0]) j->w.kv("field", field);
+        j->w.end();
+        web_json_send(r, j, 400); return;
+      }
+      const uint32_t id = control_post_batch(b);
+      if (!id){ web_json_busy(r); return; }
+      // Never wait for Core 1 here: the client reads the result with GET /api/batch?id=
+      j->w.obj().kv("ok", true).kv("id", (unsigned long)id).kv("applied", false).end();
+      web_json_send(r, j, 202);
+    },
+    nullptr,
+    [](AsyncWebServerRequest* r, uint8_t* data, size_t len, size_t index, size_t total){
+      WebJson* j = index == 0 ? web_json_body(r, BATCH_FIELDS, BATCH_NFIELDS, sizeof(RunBatch)) : web_json_find(r);
+      if (j) j->rd.feed((const char*)data, len);
+    }
+  );
+  // Pump characterization: start/abort the sweep; GET the PWM→flow map in use
+  server.on("/api/pump/sweep", HTTP_POST, [](AsyncWebServerRequest* r){
+    if (!shared_post({CMD_SWEEP, 1})){ r->send(503); return; }
     r->send(204);
   });
+  server.on("/api/pump/sweep/stop", HTTP_POST, [](AsyncWebServerRequest* r){ post_or_inline({CMD_SWEEP, 0}); r->send(204); });
+  server.on("/api/pump/map", HTTP_GET, [](AsyncWebServerRequest* r){
+    PumpMap m; control_pump_map(m);
+    char buf[640];
+    int n = snprintf(buf, sizeof(buf), "{\"measured\":%u,\"timeouts\":%u,\"sweep\":%d,\"pct\":%d,\"pwm\":[",
+      (unsigned)m.measured, (unsigned)m.timeouts, G.sweepState.load(), G.sweepPct.load());
+    for (uint8_t i=0;i<PUMPMAP_N;i++) n += snprintf(buf+n, sizeof(buf)-n, "%s%u", i?",":"", (unsigned)pumpmap_pwm(i));
+    for (uint8_t d=0; d<2; d++){
+      n += snprintf(buf+n, sizeof(buf)-n, "],\"%s\":[", d ? "rev" : "fwd");
+      for (uint8_t i=0;i<PUMPMAP_N;i++) n += snprintf(buf+n, sizeof(buf)-n, "%s%.3f", i?",":"", (double)m.lpm[d][i]);
+    }
+    snprintf(buf+n, sizeof(buf)-n, "]}");
+    r->send(200, "application/json", buf);
+  });
   server.on("/api/toggle", HTTP_GET, [](AsyncWebServerRequest* r){
-    post_or_inline({CMD_TOGGLE,0}); r->send(204);
+    post_or_inline(cmd_for(CTL_TOGGLE, 0)); r->send(204);
+  });
+
+  // Beat waveform upload (form fields): preset=trapezoid, or fwd=<csv 0..1>[&rev=<csv>][&split=10..90]
+  // Points are stretched over each powered half; dead time around valve flips is kept.
+  server.on("/api/beat/shape", HTTP_POST, [](AsyncWebServerRequest* r){
+    BeatShape sh;
+    if (r->hasParam("split", true)){
+      int sp = r->getParam("split", true)->value().toInt(); if (sp<10) sp=10; if (sp>90) sp=90; sh.splitPct = (uint8_t)sp;
+    }
+    if (r->hasParam("fwd", true)){
+      sh.kind = BEAT_SHAPE_CUSTOM;
+      sh.nFwd = parse_shape_pts(r->getParam("fwd", true)->value(), sh.fwd);
+      if (!sh.nFwd){ r->send(400, "application/json", "{\"ok\":false,\"err\":\"fwd needs 2..64 points\"}"); return; }
+      if (r->hasParam("rev", true)){
+        sh.nRev = parse_shape_pts(r->getParam("rev", true)->value(), sh.rev);
+        if (!sh.nRev){ r->send(400, "application/json", "{\"ok\":false,\"err\":\"rev needs 2..64 points\"}"); return; }
+      }
+    } else if (!r->hasParam("preset", true) || r->getParam("preset", true)->value() != "trapezoid"){
+      r->send(400); return;
+    }
+    if (!control_post_shape(sh)){ r->send(503, "application/json", "{\"ok\":false,\"err\":\"busy\"}"); return; }
+    r->send(200, "application/json", "{\"ok\":true}");
+  });
+
+  // Protocols: upload (form field "text", optional start=1), start/stop, status
+  server.on("/api/protocol", HTTP_POST, [](AsyncWebServerRequest* r){
+    if (!r->hasParam("text", true)){ r->send(400); return; }
+    static Protocol p;                     // AsyncTCP handlers run on one task
+    ProtoError e{};
+    const String& txt = r->getParam("text", true)->value();
+    char buf[160];
+    if (!protocol_parse(txt.c_str(), txt.length(), ProtoLimits{CONTROL_HZ, BPM_MIN, BPM_MAX}, p, e)){
+      snprintf(buf, sizeof(buf), "{\"ok\":false,\"line\":%u,\"err\":\"%s\"}", (unsigned)e.line, e.msg);
+      r->send(400, "application/json", buf); return;
+    }
+    if (!control_post_protocol(p)){ r->send(503, "application/json", "{\"ok\":false,\"err\":\"busy\"}"); return; }
+    if (r->hasParam("start", true) && r->getParam("start", true)->value().toInt()) post_or_inline({CMD_PROTO_START, 0});
+    snprintf(buf, sizeof(buf), "{\"ok\":true,\"steps\":%u,\"totalS\":%.3f}",
+      (unsigned)p.n, (double)protocol_total_ticks(p) / CONTROL_HZ);
+    r->send(200, "application/json", buf);
+  });
+  server.on("/api/protocol/start", HTTP_POST, [](AsyncWebServerRequest* r){ post_or_inline({CMD_PROTO_START, 0}); r->send(204); });
+  server.on("/api/protocol/stop",  HTTP_POST, [](AsyncWebServerRequest* r){ post_or_inline({CMD_PROTO_STOP, 0});  r->send(204); });
+  server.on("/api/protocol", HTTP_GET, [](AsyncWebServerRequest* r){
+    char buf[160];
+    snprintf(buf, sizeof(buf), "{\"state\":%d,\"step\":%d,\"iter\":%d,\"elapsedS\":%.3f,\"totalS\":%.3f}",
+      G.protoState.load(), G.protoStep.load(), G.protoIter.load(),
+      (double)G.protoTicks.load() / CONTROL_HZ, (double)G.protoTotal.load() / CONTROL_HZ);
+    r->send(200, "application/json", buf);
   });
 
   // Live smoothing endpoint - set smoothing alphas for atr/vent/flow (query params 'atr','vent','flow')
@@ -671,9 +1305,12 @@ void web_start(){
   });
 
   // SSE
-  sse.onConnect([](AsyncEventSourceClient* c){ c->send(": ok\n\n"); });
+  sse.onConnect([](AsyncEventSourceClient* c){ c->send(": ok\n\n"); sse_resume(c); });
   server.addHandler(&sse);
 
+  // Control channel: same commands as the GET routes above, over one persistent socket
+  web_ws_register(server, ctl_apply);
+
   // Stream viewer page - does not replace /stream (SSE) but provides a friendly UI at /stream/view
   server.on("/stream/view", HTTP_GET, [](AsyncWebServerRequest* r){ r->send_P(200, "text/html", STREAM_VIEW_HTML); });
 
@@ -684,6 +1321,14 @@ void web_start(){
     get_cals, set_cals, nvs_save_all, nvs_load_all, nvs_defaults_all
   };
   web_cal_register(server, hooks);
+  cal_profiles_register();
+
+  // Introspection: /metrics (Prometheus) and /api/sys
+  web_metrics_register(server);
+  web_logs_register(server);
+  web_capture_register(server);
+  web_spectrum_register(server);
+  web_telemetry_register(server);
 
   // Start
   DefaultHeaders::Instance().addHeader("Access-Control-Allow-Origin", "*");
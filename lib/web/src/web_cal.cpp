@@ -1,5 +1,8 @@
 #include "web_cal.h"
 #include "shared.h"
+#include "web.h"
+#include "web_json.h"
+#include <stddef.h>
 
 // Minimal in-page JS/HTML (dark theme). Main affordances: manual raw control,
 // capture averages, fit (client-side), apply/save/load/defaults via API.
@@ -480,98 +483,92 @@ void web_cal_register(AsyncWebServer& srv, const CalHooks& H){
   });
 
   // Capture N raw samples → return averaged point(s)
-    srv.on("/api/cal/capture", HTTP_POST, [=](AsyncWebServerRequest* req){
-      if (!req->hasParam("ch", true) || !req->hasParam("avgN", true)){
-        req->send(400); return;
-      }
-      String chs = req->getParam("ch", true)->value();
-      int n = req->getParam("avgN", true)->value().toInt(); if (n<1) n=1; if (n>10000) n=10000;
-      float act_mmHg = 0.0f; float act_L = 0.0f;
-      if (req->hasParam("actual_mmHg", true)) act_mmHg = req->getParam("actual_mmHg", true)->value().toFloat();
-      if (req->hasParam("actual_L_min", true)) act_L = req->getParam("actual_L_min", true)->value().toFloat();
-
-      auto avgN = [&](std::function<float(void)> fn)->float{
-        double acc=0; for (int i=0;i<n;i++){ acc+=fn(); delay(2); } return (float)(acc/n);
-      };
-
-      String out = "{\"points\": [";
-      bool first = true;
-      int start = 0;
-      while (start <= chs.length()){
-        int comma = chs.indexOf(',', start);
-        String ch = (comma == -1) ? chs.substring(start) : chs.substring(start, comma);
-        ch.trim();
-        if (ch.length()){
-          if (!first) out += ",";
-          if (ch=="atr" && H.read_atr_raw){
-            float raw = avgN([&]{ return (float)H.read_atr_raw(); });
-            out += String("{\"ch\":\"atr\",\"raw\":") + raw + ",\"actual\":" + act_mmHg + "}";
-          } else if (ch=="vent" && H.read_vent_raw){
-            float raw = avgN([&]{ return (float)H.read_vent_raw(); });
-            out += String("{\"ch\":\"vent\",\"raw\":") + raw + ",\"actual\":" + act_mmHg + "}";
-          } else if (ch=="flow" && H.read_flow_hz){
-            float rawHz = avgN([&]{ return H.read_flow_hz(); });
-            out += String("{\"ch\":\"flow\",\"raw\":") + rawHz + ",\"actual\":" + act_L + "}";
-          } else {
-            // unknown channel requested: skip
-          }
-          first = false;
-        }
-        if (comma == -1) break; start = comma + 1;
-      }
-      out += "]}";
-      req->send(200, "application/json", out);
-    });
+  srv.on("/api/cal/capture", HTTP_POST, [=](AsyncWebServerRequest* req){
+    if (!req->hasParam("ch", true) || !req->hasParam("avgN", true)){
+      req->send(400); return;
+    }
+    WebJson* j = web_json(req);
+    if (!j){ web_json_busy(req); return; }
+    const char* chs = req->getParam("ch", true)->value().c_str();
+    int n = req->getParam("avgN", true)->value().toInt(); if (n<1) n=1; if (n>10000) n=10000;
+    float act_mmHg = 0.0f; float act_L = 0.0f;
+    if (req->hasParam("actual_mmHg", true)) act_mmHg = req->getParam("actual_mmHg", true)->value().toFloat();
+    if (req->hasParam("actual_L_min", true)) act_L = req->getParam("actual_L_min", true)->value().toFloat();
+
+    auto avgN = [&](auto fn)->float{
+      double acc=0; for (int i=0;i<n;i++){ acc+=fn(); delay(2); } return (float)(acc/n);
+    };
+
+    JsonWriter& w = j->w;
+    w.obj().key("points").arr();
+    for (const char* p = chs; ; ){
+      const char* comma = strchr(p, ',');
+      size_t len = comma ? (size_t)(comma - p) : strlen(p);
+      while (len && *p == ' '){ p++; len--; }
+      while (len && p[len-1] == ' ') len--;
+      auto is = [&](const char* name){ return len == strlen(name) && strncmp(p, name, len) == 0; };
+      if (is("atr") && H.read_atr_raw){
+        w.obj().kv("ch", "atr").kv("raw", avgN([&]{ return (float)H.read_atr_raw(); }), 2).kv("actual", act_mmHg, 2).end();
+      } else if (is("vent") && H.read_vent_raw){
+        w.obj().kv("ch", "vent").kv("raw", avgN([&]{ return (float)H.read_vent_raw(); }), 2).kv("actual", act_mmHg, 2).end();
+      } else if (is("flow") && H.read_flow_hz){
+        w.obj().kv("ch", "flow").kv("raw", avgN([&]{ return H.read_flow_hz(); }), 2).kv("actual", act_L, 2).end();
+      }   // unknown channel requested: skip
+      if (!comma) break;
+      p = comma + 1;
+    }
+    w.end().end();
+    web_json_send(req, j);
+  });
 
   // Calibration state get/apply/save/load/defaults
   srv.on("/api/cal/get", HTTP_GET, [=](AsyncWebServerRequest* req){
+    WebJson* j = web_json(req);
+    if (!j){ web_json_busy(req); return; }
     float am,ab,vm,vb,fm,fb; H.get_cals(am,ab,vm,vb,fm,fb);
-    char buf[256];
-    snprintf(buf, sizeof(buf),
-      "{\"atr_m\":%.6f,\"atr_b\":%.6f,\"vent_m\":%.6f,\"vent_b\":%.6f,\"flow_m\":%.6f,\"flow_b\":%.6f}",
-      am,ab,vm,vb,fm,fb);
-    req->send(200, "application/json", buf);
+    j->w.obj().kv("atr_m", am, 6).kv("atr_b", ab, 6).kv("vent_m", vm, 6).kv("vent_b", vb, 6)
+              .kv("flow_m", fm, 6).kv("flow_b", fb, 6).end();
+    web_json_send(req, j);
   });
 
-  // Accept either a urlencoded form field named "plain" (legacy) or raw application/json body.
+  // Body: {"atr_m":…,"atr_b":…,"vent_m":…,"vent_b":…,"flow_m":…,"flow_b":…}, all six required.
+  // Raw application/json is parsed chunk by chunk in the request's own slot; a text/plain
+  // body arrives as the form field "plain" (legacy) and is parsed in one go.
+  struct CalBody { float am, ab, vm, vb, fm, fb; };
+  static const JsonField CAL_FIELDS[] = {
+    { "atr_m", JK_FLOAT, offsetof(CalBody, am), 0 }, { "atr_b", JK_FLOAT, offsetof(CalBody, ab), 0 },
+    { "vent_m", JK_FLOAT, offsetof(CalBody, vm), 0 }, { "vent_b", JK_FLOAT, offsetof(CalBody, vb), 0 },
+    { "flow_m", JK_FLOAT, offsetof(CalBody, fm), 0 }, { "flow_b", JK_FLOAT, offsetof(CalBody, fb), 0 },
+  };
   srv.on("/api/cal/apply", HTTP_POST,
-    // onRequest (we'll respond from onBody once full body is received)
+    // onRequest: runs once the whole body has been through onBody
     [=](AsyncWebServerRequest* req){
-      // if the client sent a urlencoded form field, handle it immediately
-      if (req->hasParam("plain", true)){
-        String body = req->getParam("plain", true)->value();
-        // naive parse (small JSON): look for keys
-        auto findVal=[&](const char* key)->float{
-          int i = body.indexOf(String("\"") + key + "\":"); if (i<0) return NAN;
-          i += (String("\"") + key + "\":").length();
-          return body.substring(i).toFloat();
-        };
-        float am=findVal("atr_m"),ab=findVal("atr_b"),vm=findVal("vent_m"),vb=findVal("vent_b"),fm=findVal("flow_m"),fb=findVal("flow_b");
-        if (isnan(am)||isnan(ab)||isnan(vm)||isnan(vb)||isnan(fm)||isnan(fb)){ req->send(400); return; }
-        H.set_cals(am,ab,vm,vb,fm,fb);
-        req->send(200, "application/json", "{\"ok\":true}");
+      WebJson* j = web_json_find(req);
+      if (!j && req->hasParam("plain", true)){
+        j = web_json_body(req, CAL_FIELDS, 6, sizeof(CalBody));
+        if (j){ const String& body = req->getParam("plain", true)->value(); j->rd.feed(body.c_str(), body.length()); }
+      }
+      if (!j) j = web_json(req);                    // no body at all: answered below as bad JSON
+      if (!j){ web_json_busy(req); return; }
+      if (j->rd.finish() != JSON_DONE){
+        web_ctr.jsonBad.fetch_add(1, std::memory_order_relaxed);
+        req->send(400, "application/json", "{\"ok\":false,\"err\":\"bad json\"}"); return;
+      }
+      const CalBody& b = *(const CalBody*)j->body;
+      if (j->bind.seen != 0x3F || !isfinite(b.am) || !isfinite(b.ab) || !isfinite(b.vm) || !isfinite(b.vb) ||
+          !isfinite(b.fm) || !isfinite(b.fb)){
+        req->send(400, "application/json", "{\"ok\":false,\"err\":\"need atr_m..flow_b\"}"); return;
       }
-      // otherwise we'll wait for onBody to collect the raw body
+      H.set_cals(b.am, b.ab, b.vm, b.vb, b.fm, b.fb);
+      j->w.obj().kv("ok", true).end();
+      web_json_send(req, j);
     },
     // onUpload (unused)
     nullptr,
     // onBody
     [=](AsyncWebServerRequest* req, uint8_t* data, size_t len, size_t index, size_t total){
-      static String body;
-      if (index == 0) body = String();
-      for (size_t i=0;i<len;i++) body += (char)data[i];
-      // only act when full body received
-      if (index + len < total) return;
-      // content may be JSON; attempt naive parse same as above
-      auto findVal=[&](const char* key)->float{
-        int i = body.indexOf(String("\"") + key + "\":"); if (i<0) return NAN;
-        i += (String("\"") + key + "\":").length();
-        return body.substring(i).toFloat();
-      };
-      float am=findVal("atr_m"),ab=findVal("atr_b"),vm=findVal("vent_m"),vb=findVal("vent_b"),fm=findVal("flow_m"),fb=findVal("flow_b");
-      if (isnan(am)||isnan(ab)||isnan(vm)||isnan(vb)||isnan(fm)||isnan(fb)){ req->send(400); return; }
-      H.set_cals(am,ab,vm,vb,fm,fb);
-      req->send(200, "application/json", "{\"ok\":true}");
+      WebJson* j = index == 0 ? web_json_body(req, CAL_FIELDS, 6, sizeof(CalBody)) : web_json_find(req);
+      if (j) j->rd.feed((const char*)data, len);
     }
   );
 
@@ -0,0 +1,128 @@
+#include "web_capture.h"
+#include "control.h"
+#include "shared.h"
+
+static const char* const CAP_SRC_NAMES[]   = { "valve", "vent", "atr", "mode", "fault" };
+static const char* const CAP_SLOPE_NAMES[] = { "rise", "fall", "either" };
+static const char* const CAP_STATE_NAMES[] = { "idle", "armed", "post", "frozen", "reading", "read" };
+
+// Binary blob: 28-byte little-endian header, then CAP_N × CapSample (8 bytes each)
+//   "SCAP" | ver u16 | n u16 | pre u16 | hz u16 | seq u32 | triggerTick u32 | src u8 | slope u8 |
+//   reserved u16 | level f32
+static constexpr uint16_t CAP_HDR_BYTES = 28;
+static_assert(sizeof(CapSample) == 8, "capture samples are sent as raw 8-byte records");
+
+static uint8_t s_hdr[CAP_HDR_BYTES];
+static CapInfo s_held;               // the capture being sent; fixed while it is held
+static bool    s_done = false;       // the held capture was fully sent
+static int32_t s_row = 0;            // JSON cursor: -1 header, 0..CAP_N-1 rows, CAP_N trailer
+
+static int8_t find(const char* const* names, uint8_t n, const String& v){
+  for (uint8_t i=0;i<n;i++) if (v == names[i]) return (int8_t)i;
+  return -1;
+}
+
+// Take the frozen capture for this request; released when the request is torn down
+static bool hold(AsyncWebServerRequest* r){
+  Capture& c = control_capture();
+  if (!c.beginRead()){
+    r->send(409, "application/json", c.state() == CAP_READING ? "{\"ok\":false,\"err\":\"busy\"}" : "{\"ok\":false,\"err\":\"no capture\"}");
+    return false;
+  }
+  s_done = false;
+  r->onDisconnect([](){ control_capture().endRead(s_done); });
+  return true;
+}
+
+void web_capture_register(AsyncWebServer& srv){
+  srv.on("/api/capture", HTTP_GET, [](AsyncWebServerRequest* r){
+    Capture& c = control_capture();
+    CaptureInfo ci; control_capture_info(ci);
+    const CapConfig& k = ci.cfg;
+    const CapInfo& in = ci.info;
+    char out[320];
+    snprintf(out, sizeof(out), "{\"state\":\"%s\",\"seq\":%lu,\"triggerTick\":%lu,\"n\":%u,\"hz\":%lu,"
+      "\"src\":\"%s\",\"slope\":\"%s\",\"level\":%.1f,\"hyst\":%.1f,\"preMs\":%.1f,\"mode\":\"%s\",\"holdMs\":%lu}",
+      CAP_STATE_NAMES[c.state()], (unsigned long)in.seq, (unsigned long)in.triggerTick, (unsigned)CAP_N, (unsigned long)CONTROL_HZ,
+      CAP_SRC_NAMES[k.src], CAP_SLOPE_NAMES[k.slope], (double)k.level, (double)k.hyst, k.pre * 1000.0 / CONTROL_HZ,
+      k.autoRearm ? "auto" : "single", (unsigned long)(k.holdTicks * 1000 / CONTROL_HZ));
+    r->send(200, "application/json", out);
+  });
+
+  // Fields: src (valve|vent|atr|mode|fault), slope (rise|fall|either), level, hyst (mmHg),
+  // preMs, mode (single|auto), holdMs, arm=1 to start right away
+  srv.on("/api/capture/config", HTTP_POST, [](AsyncWebServerRequest* r){
+    CaptureInfo ci; control_capture_info(ci);
+    CapConfig k = ci.cfg;
+    if (r->hasParam("src", true)){ int8_t v = find(CAP_SRC_NAMES, 5, r->getParam("src", true)->value()); if (v < 0){ r->send(400); return; } k.src = (CapSource)v; }
+    if (r->hasParam("slope", true)){ int8_t v = find(CAP_SLOPE_NAMES, 3, r->getParam("slope", true)->value()); if (v < 0){ r->send(400); return; } k.slope = (CapSlope)v; }
+    if (r->hasParam("level", true)) k.level = r->getParam("level", true)->value().toFloat();
+    if (r->hasParam("hyst", true))  k.hyst  = r->getParam("hyst", true)->value().toFloat();
+    if (r->hasParam("preMs", true)){ long ms = r->getParam("preMs", true)->value().toInt(); long n = ms * (long)CONTROL_HZ / 1000; k.pre = (uint16_t)(n < 0 ? 0 : (n >= CAP_N ? CAP_N - 1 : n)); }
+    if (r->hasParam("mode", true)) k.autoRearm = (r->getParam("mode", true)->value() == "auto");
+    if (r->hasParam("holdMs", true)){ long ms = r->getParam("holdMs", true)->value().toInt(); k.holdTicks = (uint32_t)(ms < 0 ? 0 : ms) * CONTROL_HZ / 1000; }
+    if (!control_post_capture(k)){ r->send(503, "application/json", "{\"ok\":false,\"err\":\"busy\"}"); return; }
+    if (r->hasParam("arm", true) && r->getParam("arm", true)->value().toInt()) shared_post(Cmd{CMD_CAPTURE, 1});
+    r->send(200, "application/json", "{\"ok\":true}");
+  });
+  srv.on("/api/capture/arm",   HTTP_POST, [](AsyncWebServerRequest* r){ shared_post(Cmd{CMD_CAPTURE, 1}); r->send(200, "application/json", "{\"ok\":true}"); });
+  srv.on("/api/capture/stop",  HTTP_POST, [](AsyncWebServerRequest* r){ shared_post(Cmd{CMD_CAPTURE, 0}); r->send(200, "application/json", "{\"ok\":true}"); });
+  srv.on("/api/capture/force", HTTP_POST, [](AsyncWebServerRequest* r){ shared_post(Cmd{CMD_CAPTURE, 2}); r->send(200, "application/json", "{\"ok\":true}"); });
+
+  // Frozen capture as one blob: ?fmt=bin (default) or ?fmt=json
+  srv.on("/api/capture/data", HTTP_GET, [](AsyncWebServerRequest* r){
+    bool json = r->hasParam("fmt") && r->getParam("fmt")->value() == "json";
+    if (!hold(r)) return;
+    s_held = control_capture().info();     // Core 1 leaves it alone while we hold the capture
+    const CapInfo& in = s_held;
+    if (!json){
+      uint8_t* h = s_hdr; float lv = in.level;
+      memcpy(h, "SCAP", 4);
+      uint16_t u16[4] = { 1, CAP_N, in.pre, (uint16_t)CONTROL_HZ }; memcpy(h + 4, u16, 8);
+      uint32_t u32[2] = { in.seq, in.triggerTick }; memcpy(h + 12, u32, 8);
+      h[20] = in.src; h[21] = in.slope; h[22] = h[23] = 0; memcpy(h + 24, &lv, 4);
+      const size_t total = CAP_HDR_BYTES + (size_t)CAP_N * sizeof(CapSample);
+      AsyncWebServerResponse* resp = r->beginResponse("application/octet-stream", total,
+        [total](uint8_t* buf, size_t maxLen, size_t index) -> size_t {
+          Capture& cap = control_capture();
+          size_t n = 0;
+          while (n < maxLen && index + n < total){
+            size_t at = index + n;
+            if (at < CAP_HDR_BYTES){ buf[n++] = s_hdr[at]; continue; }
+            size_t off = at - CAP_HDR_BYTES, i = off / sizeof(CapSample), b = off % sizeof(CapSample);
+            size_t k2 = sizeof(CapSample) - b; if (k2 > maxLen - n) k2 = maxLen - n;
+            memcpy(buf + n, (const uint8_t*)&cap.at((uint16_t)i) + b, k2); n += k2;
+          }
+          if (index + n >= total) s_done = true;
+          return n;
+        });
+      resp->addHeader("Content-Disposition", "attachment; filename=capture.bin");
+      r->send(resp);
+      return;
+    }
+    s_row = -1;
+    r->send(r->beginChunkedResponse("application/json", [](uint8_t* buf, size_t maxLen, size_t) -> size_t {
+      Capture& cap = control_capture();
+      const CapInfo& ci = s_held;
+      size_t n = 0;
+      while (s_row <= (int32_t)CAP_N){
+        char line[128]; int w;
+        if (s_row < 0)
+          w = snprintf(line, sizeof(line), "{\"seq\":%lu,\"hz\":%lu,\"n\":%u,\"pre\":%u,\"triggerTick\":%lu,\"src\":\"%s\","
+            "\"cols\":[\"atr\",\"vent\",\"flow\",\"pwm\",\"valve\",\"mode\"],\"data\":[",
+            (unsigned long)ci.seq, (unsigned long)CONTROL_HZ, (unsigned)CAP_N, (unsigned)ci.pre, (unsigned long)ci.triggerTick,
+            CAP_SRC_NAMES[ci.src]);
+        else if (s_row < (int32_t)CAP_N){
+          const CapSample& s = cap.at((uint16_t)s_row);
+          w = snprintf(line, sizeof(line), "%s[%.1f,%.1f,%.2f,%u,%u,%u]", s_row ? "," : "",
+            s.atr * 0.1, s.vent * 0.1, s.flow * 0.01, (unsigned)s.pwm, (unsigned)(s.state & 1), (unsigned)((s.state >> 3) & 7));
+        } else
+          w = snprintf(line, sizeof(line), "]}");
+        if (n + (size_t)w > maxLen) break;       // next call continues with this row
+        memcpy(buf + n, line, w); n += w; s_row++;
+      }
+      if (s_row > (int32_t)CAP_N) s_done = true;
+      return n;                                    // 0 ends the chunked response
+    }));
+  });
+}
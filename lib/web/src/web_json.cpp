@@ -0,0 +1,57 @@
+#include "web_json.h"
+#include "web.h"
+
+static WebJson s_slots[WEB_JSON_SLOTS];
+
+// A body that found no slot at onBody index 0 was dropped. The request is marked so a later
+// claim in onRequest gets nullptr (503) rather than an empty reader (400). The server frees
+// _tempObject with the request; if even this byte is not there the old reply stands.
+static void mark_refused(AsyncWebServerRequest* r){ if (!r->_tempObject) r->_tempObject = malloc(1); }
+
+WebJson* web_json(AsyncWebServerRequest* r){
+  if (r->_tempObject) return nullptr;   // refused at its first body chunk
+  WebJson* freeSlot = nullptr;
+  for (WebJson& j : s_slots){
+    if (j.owner == r) return &j;
+    if (!j.owner && !freeSlot) freeSlot = &j;
+  }
+  if (!freeSlot){ web_ctr.jsonBusy.fetch_add(1, std::memory_order_relaxed); return nullptr; }
+  freeSlot->owner = r;
+  freeSlot->w.begin(freeSlot->buf, sizeof(freeSlot->buf));
+  freeSlot->rd.begin(nullptr, nullptr);
+  r->onDisconnect([freeSlot](){ freeSlot->owner = nullptr; });
+  return freeSlot;
+}
+
+WebJson* web_json_find(AsyncWebServerRequest* r){
+  for (WebJson& j : s_slots) if (j.owner == r) return &j;
+  return nullptr;
+}
+
+WebJson* web_json_body(AsyncWebServerRequest* r, const JsonField* fields, uint8_t n, size_t size){
+  if (size > WEB_JSON_BODY) return nullptr;
+  WebJson* j = web_json(r);
+  if (!j){ mark_refused(r); return nullptr; }
+  memset(j->body, 0, sizeof(j->body));
+  j->bind = JsonBind{ fields, n, j->body, 0, 0, 0 };
+  j->rd.begin(json_bind_cb, &j->bind);
+  return j;
+}
+
+void web_json_send(AsyncWebServerRequest* r, WebJson* j, int code){
+  if (!j->w.ok()){ r->send(500, "application/json", "{\"ok\":false,\"err\":\"reply too large\"}"); return; }
+  const size_t len = j->w.len();
+  // read straight out of the slot; it stays claimed until the request is torn down
+  AsyncWebServerResponse* resp = r->beginResponse("application/json", len,
+    [j, len](uint8_t* out, size_t maxLen, size_t index) -> size_t {
+      const size_t n = (len - index) < maxLen ? (len - index) : maxLen;
+      memcpy(out, j->buf + index, n);
+      return n;
+    });
+  if (code != 200) resp->setCode(code);
+  r->send(resp);
+}
+
+void web_json_busy(AsyncWebServerRequest* r){
+  r->send(503, "application/json", "{\"ok\":false,\"err\":\"busy\"}");
+}
@@ -0,0 +1,50 @@
+#include "web_logs.h"
+#include "recorder.h"
+
+void web_logs_register(AsyncWebServer& srv){
+  // Recordings, oldest first, plus recorder state
+  srv.on("/api/logs", HTTP_GET, [](AsyncWebServerRequest* r){
+    RecFile files[LOG_FILES_MAX + 4];
+    uint8_t n = recorder_list(files, LOG_FILES_MAX + 4);
+    AsyncResponseStream* s = r->beginResponseStream("application/json");
+    s->printf("{\"recording\":%s,\"blockBytes\":%u,\"blocks\":%lu,\"dropped\":%lu,\"files\":[",
+      recorder_recording() ? "true" : "false", (unsigned)LOG_BLOCK_BYTES,
+      (unsigned long)rec_ctr.blocks.load(), (unsigned long)rec_ctr.dropped.load());
+    for (uint8_t i=0;i<n;i++)
+      s->printf("%s{\"name\":\"%s\",\"size\":%lu,\"blocks\":%lu,\"active\":%s}", i?",":"", files[i].name,
+        (unsigned long)files[i].size, (unsigned long)(files[i].size / LOG_BLOCK_BYTES), files[i].active ? "true" : "false");
+    s->print("]}");
+    r->send(s);
+  });
+  // Download one recording (?name=r00012.slg); the open file may still be growing
+  srv.on("/api/logs/file", HTTP_GET, [](AsyncWebServerRequest* r){
+    const uint8_t* data; uint32_t size;
+    if (!r->hasParam("name")){ r->send(404); return; }
+    const String& name = r->getParam("name")->value();
+    const int8_t pin = recorder_open(name.c_str(), &data, &size);
+    if (pin < 0){ r->send(404); return; }
+    r->onDisconnect([pin](){ recorder_close(pin); });   // the slot stays mapped and unerased until then
+    // straight from the mapped partition: reads go through the cache, no flash operation
+    AsyncWebServerResponse* resp = r->beginResponse("application/octet-stream", size,
+      [data, size](uint8_t* out, size_t maxLen, size_t index) -> size_t {
+        const size_t n = (size - index) < maxLen ? (size - index) : maxLen;
+        memcpy(out, data + index, n);
+        return n;
+      });
+    char disp[48]; snprintf(disp, sizeof(disp), "attachment; filename=%s", name.c_str());
+    resp->addHeader("Content-Disposition", disp);
+    r->send(resp);
+  });
+  srv.on("/api/logs/start", HTTP_POST, [](AsyncWebServerRequest* r){
+    if (!recorder_start()){ r->send(409, "application/json", "{\"ok\":false,\"err\":\"no erased slot: pause the pump first\"}"); return; }
+    r->send(200, "application/json", "{\"ok\":true}");
+  });
+  srv.on("/api/logs/stop", HTTP_POST, [](AsyncWebServerRequest* r){
+    recorder_stop(); r->send(200, "application/json", "{\"ok\":true}");
+  });
+  srv.on("/api/logs/delete", HTTP_POST, [](AsyncWebServerRequest* r){
+    if (!r->hasParam("name", true)){ r->send(400); return; }
+    bool ok = recorder_remove(r->getParam("name", true)->value().c_str());
+    r->send(ok ? 200 : 409, "application/json", ok ? "{\"ok\":true}" : "{\"ok\":false,\"err\":\"missing, recording or downloading\"}");
+  });
+}
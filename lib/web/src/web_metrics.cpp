@@ -0,0 +1,92 @@
+#include "web_metrics.h"
+#include "web.h"
+#include "control.h"
+#include "flow.h"
+#include "shared.h"
+#include "sysmon.h"
+#include "spectral.h"
+#include "recorder.h"
+#include "telemetry.h"
+
+static void metric(Print& out, const char* name, const char* type, const char* help, uint32_t v){
+  out.printf("# HELP %s %s\n# TYPE %s %s\n%s %lu\n", name, help, name, type, name, (unsigned long)v);
+}
+
+static SysSnapshot s_sys;                  // AsyncTCP handlers run on one task
+
+static inline uint32_t ld(const std::atomic<uint32_t>& a){ return a.load(std::memory_order_relaxed); }
+
+void web_metrics_register(AsyncWebServer& srv){
+  srv.on("/metrics", HTTP_GET, [](AsyncWebServerRequest* r){
+    AsyncResponseStream* s = r->beginResponseStream("text/plain; version=0.0.4");
+    metric(*s, "simuse_control_ticks_total",            "counter", "Control loop iterations.",                         ld(control_ctr.ticks));
+    metric(*s, "simuse_control_overruns_total",         "counter", "Control ticks that missed their deadline.",        ld(control_ctr.overruns));
+    metric(*s, "simuse_override_gate_activations_total","counter", "Calibration override gate activations.",          ld(control_ctr.overrideGates));
+    metric(*s, "simuse_protect_trips_total",            "counter", "Protection faults latched.",                       ld(control_ctr.protectTrips));
+    metric(*s, "simuse_protect_fault",                  "gauge",   "Latched protection fault bits (0 = none).",        (uint32_t)G.fault.load());
+    metric(*s, "simuse_cmd_inline_fallbacks_total",     "counter", "Commands applied inline because the queue was full.", ld(web_ctr.cmdInline));
+    metric(*s, "simuse_flow_edges_accepted_total",      "counter", "Flow sensor edges counted.",                       ld(flow_ctr.edgesAccepted));
+    metric(*s, "simuse_flow_edges_rejected_total",      "counter", "Flow sensor edges rejected by the deglitch.",      ld(flow_ctr.edgesRejected));
+    metric(*s, "simuse_sse_frames_sent_total",          "counter", "SSE frames sent.",                                 ld(web_ctr.sseSent));
+    metric(*s, "simuse_sse_frames_failed_total",        "counter", "SSE frames not formatted or dropped.",             ld(web_ctr.sseFailed));
+    metric(*s, "simuse_sse_clients",                    "gauge",   "Connected /stream clients.",                       ld(web_ctr.sseClients));
+    metric(*s, "simuse_sse_replayed_total",             "counter", "SSE frames replayed to resuming clients.",         ld(web_ctr.sseReplayed));
+    metric(*s, "simuse_sse_gaps_total",                 "counter", "SSE gap markers sent on resume.",                  ld(web_ctr.sseGaps));
+    metric(*s, "simuse_api_json_busy_total",            "counter", "API requests refused with all JSON slots in use.", ld(web_ctr.jsonBusy));
+    metric(*s, "simuse_api_json_bad_total",             "counter", "API request bodies that were not valid JSON.",     ld(web_ctr.jsonBad));
+    metric(*s, "simuse_ws_commands_total",              "counter", "WebSocket control messages applied.",              ld(web_ctr.wsCmds));
+    metric(*s, "simuse_ws_duplicates_total",            "counter", "WebSocket replays acked without re-applying.",     ld(web_ctr.wsDup));
+    metric(*s, "simuse_ws_rejected_total",              "counter", "WebSocket control messages rejected.",             ld(web_ctr.wsBad));
+    metric(*s, "simuse_spectral_frames_total",          "counter", "FFT frames computed on the pressure channels.",    ld(spec_ctr.frames));
+    metric(*s, "simuse_spectral_dropped_total",         "counter", "Pressure samples dropped before spectral analysis.", ld(spec_ctr.dropped));
+    metric(*s, "simuse_recorder_blocks_total",          "counter", "Flight-recorder blocks written to flash.",       ld(rec_ctr.blocks));
+    metric(*s, "simuse_recorder_dropped_total",         "counter", "Flight-recorder samples lost.",                  ld(rec_ctr.dropped));
+    metric(*s, "simuse_recorder_erases_total",          "counter", "Flight-recorder flash sectors erased (pump paused).", ld(rec_ctr.erases));
+    metric(*s, "simuse_recorder_write_us_max",          "gauge",   "Slowest flight-recorder block write (page programs).", ld(rec_ctr.writeUsMax));
+    metric(*s, "simuse_recorder_erase_us_max",          "gauge",   "Slowest flight-recorder sector erase.",          ld(rec_ctr.eraseUsMax));
+    metric(*s, "simuse_recorder_write_overruns_total",  "counter", "Control overruns during flight-recorder block writes.", ld(rec_ctr.writeOverruns));
+    metric(*s, "simuse_recorder_erase_overruns_total",  "counter", "Control overruns during flight-recorder sector erases.", ld(rec_ctr.eraseOverruns));
+    metric(*s, "simuse_telemetry_frames_total",         "counter", "Serial telemetry frames written.",                ld(tlm_ctr.frames));
+    metric(*s, "simuse_telemetry_dropped_total",        "counter", "Serial telemetry samples lost.",                  ld(tlm_ctr.dropped));
+    sysmon_snapshot(s_sys);
+    metric(*s, "simuse_cpu_idle_source",                "gauge",   "Per-core idle measurement: 0 unavailable, 1 run-time counters, 2 idle hooks.", s_sys.idleSrc);
+    if (s_sys.idleSrc != SYS_IDLE_NONE){         // no samples rather than a false 0
+      s->print("# HELP simuse_cpu_idle_percent Idle share of each core over the last sysmon period.\n"
+               "# TYPE simuse_cpu_idle_percent gauge\n");
+      for (uint8_t c=0;c<2;c++) s->printf("simuse_cpu_idle_percent{core=\"%u\"} %.1f\n", (unsigned)c, s_sys.idlePct[c]);
+    }
+    metric(*s, "simuse_task_cpu_available",             "gauge",   "1 if per-task CPU shares are measured (run-time stats on).", s_sys.cpuAvail ? 1 : 0);
+    metric(*s, "simuse_ram_static_bytes",               "gauge",   ".data + .bss of the firmware image.",              s_sys.staticRam);
+    metric(*s, "simuse_heap_min_free_bytes",            "gauge",   "Lowest free heap since boot.",                    s_sys.heapMinFree);
+    metric(*s, "simuse_heap_free_bytes",                "gauge",   "Free heap.",                                       ESP.getFreeHeap());
+    metric(*s, "simuse_heap_largest_block_bytes",       "gauge",   "Largest allocatable heap block (fragmentation).",  ESP.getMaxAllocHeap());
+    r->send(s);
+  });
+
+  // Task / stack / heap / CPU introspection (sampled at 1 Hz by sysmon)
+  srv.on("/api/sys", HTTP_GET, [](AsyncWebServerRequest* r){
+    SysSnapshot& snap = s_sys;
+    sysmon_snapshot(snap);
+    AsyncResponseStream* s = r->beginResponseStream("application/json");
+    s->printf("{\"seq\":%lu,\"uptimeMs\":%lu,", (unsigned long)snap.seq, (unsigned long)snap.uptimeMs);
+    // Not measurable in this build (or not sampled yet): null, not 0
+    if (snap.idleSrc != SYS_IDLE_NONE)
+      s->printf("\"idleSrc\":\"%s\",\"idlePct\":[%.1f,%.1f],", snap.idleSrc == SYS_IDLE_RUNTIME ? "runtime" : "hook",
+        snap.idlePct[0], snap.idlePct[1]);
+    else s->print("\"idleSrc\":null,\"idlePct\":null,");
+    s->printf("\"heap\":{\"free\":%lu,\"minFree\":%lu,\"largest\":%lu,\"atBoot\":%lu,\"floor\":%lu},"
+              "\"staticRam\":{\"bytes\":%lu,\"budget\":%lu},",
+      (unsigned long)snap.heapFree, (unsigned long)snap.heapMinFree, (unsigned long)snap.heapLargest,
+      (unsigned long)snap.heapAtBoot, (unsigned long)RAM_HEAP_FLOOR, (unsigned long)snap.staticRam, (unsigned long)RAM_STATIC_BUDGET);
+    if (!snap.tasksAvail){ s->print("\"tasks\":null}"); r->send(s); return; }
+    s->print("\"tasks\":[");
+    for (uint8_t i=0;i<snap.nTasks;i++){
+      const SysTask& t = snap.tasks[i];
+      s->printf("%s{\"name\":\"%s\",\"core\":%d,\"prio\":%u,\"stackFree\":%lu,\"cpuPct\":",
+        i?",":"", t.name, (t.core==255)?-1:(int)t.core, (unsigned)t.prio, (unsigned long)t.stackFree);
+      if (snap.cpuAvail) s->printf("%.1f}", t.cpuPct); else s->print("null}");
+    }
+    s->print("]}");
+    r->send(s);
+  });
+}
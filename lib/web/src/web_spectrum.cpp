@@ -0,0 +1,27 @@
+#include "web_spectrum.h"
+#include "spectral.h"
+#include "app_config.h"
+
+void web_spectrum_register(AsyncWebServer& srv){
+  // Spectrum of one pressure channel (?ch=atr|vent, default vent) plus beat harmonics
+  srv.on("/api/spectrum", HTTP_GET, [](AsyncWebServerRequest* r){
+    static SpecSnapshot snap;              // AsyncTCP handlers run on one task
+    spectral_snapshot(snap);
+    uint8_t c = (r->hasParam("ch") && r->getParam("ch")->value() == "atr") ? 0 : 1;
+    const float df = (float)CONTROL_HZ / SPEC_N;
+    uint16_t pk = 1;
+    for (uint16_t k=2;k<SPEC_BINS;k++) if (snap.mag[c][k] > snap.mag[c][pk]) pk = k;   // skip DC
+    AsyncResponseStream* s = r->beginResponseStream("application/json");
+    s->printf("{\"seq\":%lu,\"ch\":\"%s\",\"fs\":%lu,\"n\":%u,\"df\":%.4f,\"peakHz\":%.2f,\"peakAmp\":%.4f,"
+              "\"f0\":%.4f,\"thd\":%.4f,\"harm\":[",
+      (unsigned long)snap.seq, c ? "vent" : "atr", (unsigned long)CONTROL_HZ, (unsigned)SPEC_N, (double)df,
+      (double)(pk*df), (double)snap.mag[c][pk], (double)snap.f0Hz, (double)snap.thd[c]);
+    for (uint8_t h=0;h<SPEC_HARMONICS;h++) s->printf("%s%.4f", h?",":"", (double)snap.harm[c][h]);
+    s->print("],\"ratio\":[");
+    for (uint8_t h=1;h<SPEC_HARMONICS;h++) s->printf("%s%.4f", h>1?",":"", snap.harm[c][0] > 0 ? (double)(snap.harm[c][h] / snap.harm[c][0]) : 0.0);
+    s->print("],\"mag\":[");
+    for (uint16_t k=0;k<SPEC_BINS;k++) s->printf("%s%.4f", k?",":"", (double)snap.mag[c][k]);
+    s->print("]}");
+    r->send(s);
+  });
+}
@@ -0,0 +1,19 @@
+#include "web_telemetry.h"
+#include "telemetry.h"
+#include "app_config.h"
+
+void web_telemetry_register(AsyncWebServer& srv){
+  // Binary serial telemetry (tools/tlmrec on the USB port): GET state, POST on=0|1
+  srv.on("/api/telemetry", HTTP_GET, [](AsyncWebServerRequest* r){
+    char out[160];
+    snprintf(out, sizeof(out), "{\"on\":%s,\"baud\":%lu,\"frames\":%lu,\"bytes\":%lu,\"dropped\":%lu}",
+      telemetry_enabled() ? "true" : "false", (unsigned long)SERIAL_BAUD, (unsigned long)tlm_ctr.frames.load(),
+      (unsigned long)tlm_ctr.bytes.load(), (unsigned long)tlm_ctr.dropped.load());
+    r->send(200, "application/json", out);
+  });
+  srv.on("/api/telemetry", HTTP_POST, [](AsyncWebServerRequest* r){
+    if (!r->hasParam("on", true)){ r->send(400); return; }
+    telemetry_enable(r->getParam("on", true)->value().toInt() != 0);
+    r->send(200, "application/json", "{\"ok\":true}");
+  });
+}
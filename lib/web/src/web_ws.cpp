@@ -0,0 +1,96 @@
+#include "web_ws.h"
+#include "web.h"
+#include "jsonio.h"
+#include "app_config.h"
+
+static AsyncWebSocket s_ws("/ws");
+static CtlSessions    s_sessions;
+static void (*s_apply)(const CtlMsg&) = nullptr;
+
+// Which session each open connection belongs to (set by hello)
+static struct { uint32_t client, sid; } s_bind[WS_CLIENTS];
+
+static uint32_t sid_of(uint32_t client){
+  for (auto& b : s_bind) if (b.sid && b.client == client) return b.sid;
+  return 0;
+}
+static void bind(uint32_t client, uint32_t sid){
+  for (auto& b : s_bind) if (b.sid && b.client == client){ b.sid = sid; return; }
+  for (auto& b : s_bind) if (!b.sid){ b.client = client; b.sid = sid; return; }
+}
+static void unbind(uint32_t client){
+  for (auto& b : s_bind) if (b.client == client) b.sid = 0;
+}
+
+// Replies: {"t":"hello","last":n} | {"t":"ack","s":n[,"dup":true]} | {"t":"err"[,"s":n],"err":"…"}
+static void reply(AsyncWebSocketClient* c, JsonWriter& w){
+  w.end();
+  if (w.ok()) c->text(w.c_str(), w.len());
+}
+static void send_hello(AsyncWebSocketClient* c, uint32_t last){
+  char buf[48]; JsonWriter w; w.begin(buf, sizeof(buf));
+  w.obj().kv("t", "hello").kv("last", (unsigned long)last);
+  reply(c, w);
+}
+static void send_ack(AsyncWebSocketClient* c, uint32_t seq, bool dup){
+  char buf[48]; JsonWriter w; w.begin(buf, sizeof(buf));
+  w.obj().kv("t", "ack").kv("s", (unsigned long)seq);
+  if (dup) w.kv("dup", true);
+  reply(c, w);
+}
+static void send_err(AsyncWebSocketClient* c, const CtlMsg& m, const char* err){
+  char buf[80]; JsonWriter w; w.begin(buf, sizeof(buf));
+  w.obj().kv("t", "err");
+  if (m.hasSeq) w.kv("s", (unsigned long)m.seq);
+  w.kv("err", err);
+  reply(c, w);
+}
+
+static void on_message(AsyncWebSocketClient* c, const char* p, size_t n){
+  CtlMsg m;
+  const CtlErr e = ctl_parse(p, n, m);
+  if (e != CTL_OK){
+    web_ctr.wsBad.fetch_add(1, std::memory_order_relaxed);
+    send_err(c, m, ctl_err_name(e));
+    return;
+  }
+  if (m.op == CTL_HELLO){
+    bind(c->id(), m.sid);
+    send_hello(c, s_sessions.hello(m.sid, millis()));
+    return;
+  }
+  const uint32_t sid = sid_of(c->id());
+  if (m.hasSeq && !sid){
+    // without a session the seq cannot be de-duplicated, so a replay would apply twice
+    web_ctr.wsBad.fetch_add(1, std::memory_order_relaxed);
+    send_err(c, m, "need hello");
+    return;
+  }
+  if (m.hasSeq && !s_sessions.accept(sid, m.seq, millis())){
+    web_ctr.wsDup.fetch_add(1, std::memory_order_relaxed);
+    send_ack(c, m.seq, true);                        // applied before the reconnect
+    return;
+  }
+  s_apply(m);
+  web_ctr.wsCmds.fetch_add(1, std::memory_order_relaxed);
+  if (m.hasSeq) send_ack(c, m.seq, false);
+}
+
+void web_ws_register(AsyncWebServer& srv, void (*apply)(const CtlMsg&)){
+  s_apply = apply;
+  s_ws.onEvent([](AsyncWebSocket*, AsyncWebSocketClient* c, AwsEventType type, void* arg, uint8_t* data, size_t len){
+    if (type == WS_EVT_DISCONNECT){ unbind(c->id()); return; }
+    if (type != WS_EVT_DATA) return;
+    const AwsFrameInfo* info = (const AwsFrameInfo*)arg;
+    // control messages are tiny: only whole single-frame text messages are accepted
+    if (info->final && info->index == 0 && info->len == len && info->opcode == WS_TEXT){
+      on_message(c, (const char*)data, len);
+    } else {
+      web_ctr.wsBad.fetch_add(1, std::memory_order_relaxed);
+      c->text("{\"t\":\"err\",\"err\":\"fragmented\"}");
+    }
+  });
+  srv.addHandler(&s_ws);
+}
+
+void web_ws_tick(){ s_ws.cleanupClients(WS_CLIENTS); }
@@ -0,0 +1,53 @@
+#pragma once
+#include <stdint.h>
+
+/* ==========================================================================================
+   winstats.h — Sliding-window statistics at full control rate
+   ------------------------------------------------------------------------------------------
+   • Each WindowStats covers one channel over one window length. Samples are folded into
+     blocks of windowTicks / WSTATS_BLOCKS ticks with Welford's update (O(1) per sample);
+     completed blocks enter a ring of WSTATS_BLOCKS, merged into the window aggregate with
+     Chan's combine and removed again by its inverse when they age out.
+   • min/max come from monotonic deques of block positions (O(1) amortized per block).
+   • A result covers the last WSTATS_BLOCKS complete blocks plus the block in progress, i.e.
+     between 1 and 1 + 1/WSTATS_BLOCKS windows of samples; every sample in it counts exactly.
+   • The removal path is resynced from the ring once per ring cycle so float error cannot
+     accumulate.
+   • Pure logic (no Arduino/FreeRTOS) so it also builds in host tests.
+   ==========================================================================================*/
+
+static constexpr uint8_t WSTATS_BLOCKS = 64;
+
+struct WinResult {
+  uint32_t n = 0;            // samples covered
+  float    mean = 0, sd = 0, min = 0, max = 0;
+};
+
+class WindowStats {
+public:
+  void configure(uint32_t windowTicks);    // also resets
+  void reset();
+  void push(float x);
+  WinResult result() const;
+  uint32_t windowTicks() const { return blockTicks_ * WSTATS_BLOCKS; }
+
+private:
+  struct Block { uint32_t n; float mean, m2, min, max; };
+  struct Deque {                           // ring positions, values looked up in ring_
+    uint8_t pos[WSTATS_BLOCKS]; uint8_t head = 0, count = 0;
+    uint8_t front() const { return pos[head]; }
+    uint8_t back() const { return pos[(head + count - 1) % WSTATS_BLOCKS]; }
+    void popFront(){ head = (head + 1) % WSTATS_BLOCKS; count--; }
+    void popBack(){ count--; }
+    void pushBack(uint8_t p){ pos[(head + count) % WSTATS_BLOCKS] = p; count++; }
+  };
+  void closeBlock();
+  void resync();
+
+  Block    ring_[WSTATS_BLOCKS];
+  uint8_t  head_ = 0, count_ = 0, sinceSync_ = 0;   // head_ = next write (= oldest once full)
+  Block    cur_{0, 0, 0, 0, 0};
+  uint32_t blockTicks_ = 1;
+  double   n_ = 0, mean_ = 0, m2_ = 0;              // aggregate of the complete blocks
+  Deque    minQ_, maxQ_;
+};
@@ -0,0 +1,88 @@
+#include "winstats.h"
+#include <math.h>
+
+void WindowStats::configure(uint32_t windowTicks){
+  blockTicks_ = (windowTicks + WSTATS_BLOCKS - 1) / WSTATS_BLOCKS;
+  if (!blockTicks_) blockTicks_ = 1;
+  reset();
+}
+
+void WindowStats::reset(){
+  head_ = 0; count_ = 0; sinceSync_ = 0;
+  cur_ = Block{0, 0, 0, 0, 0};
+  n_ = 0; mean_ = 0; m2_ = 0;
+  minQ_.head = minQ_.count = 0; maxQ_.head = maxQ_.count = 0;
+}
+
+void WindowStats::push(float x){
+  if (!cur_.n){ cur_.min = x; cur_.max = x; }
+  if (x < cur_.min) cur_.min = x;
+  if (x > cur_.max) cur_.max = x;
+  cur_.n++;
+  float d = x - cur_.mean;
+  cur_.mean += d / cur_.n;
+  cur_.m2 += d * (x - cur_.mean);
+  if (cur_.n >= blockTicks_) closeBlock();
+}
+
+void WindowStats::closeBlock(){
+  const Block b = cur_;
+  cur_ = Block{0, 0, 0, 0, 0};
+  if (count_ == WSTATS_BLOCKS){                   // age out the oldest block (inverse Chan)
+    const Block& o = ring_[head_];
+    double n = n_ - o.n;
+    if (n > 0){
+      double mean = (n_ * mean_ - (double)o.n * o.mean) / n;
+      double d = (double)o.mean - mean;
+      m2_ -= o.m2 + d * d * n * o.n / n_;
+      mean_ = mean; n_ = n;
+      if (m2_ < 0) m2_ = 0;
+    } else { n_ = 0; mean_ = 0; m2_ = 0; }
+    if (minQ_.count && minQ_.front() == head_) minQ_.popFront();
+    if (maxQ_.count && maxQ_.front() == head_) maxQ_.popFront();
+  } else {
+    count_++;
+  }
+  ring_[head_] = b;
+  double n = n_ + b.n, d = (double)b.mean - mean_;  // Chan's parallel combine
+  mean_ += d * b.n / n;
+  m2_ += b.m2 + d * d * n_ * b.n / n;
+  n_ = n;
+  while (minQ_.count && ring_[minQ_.back()].min >= b.min) minQ_.popBack();
+  minQ_.pushBack(head_);
+  while (maxQ_.count && ring_[maxQ_.back()].max <= b.max) maxQ_.popBack();
+  maxQ_.pushBack(head_);
+  head_ = (head_ + 1) % WSTATS_BLOCKS;
+  if (++sinceSync_ >= WSTATS_BLOCKS) resync();
+}
+
+void WindowStats::resync(){
+  sinceSync_ = 0;
+  double n = 0, mean = 0, m2 = 0;
+  for (uint8_t i = 0; i < count_; i++){
+    const Block& b = ring_[i];
+    double t = n + b.n, d = (double)b.mean - mean;
+    mean += d * b.n / t; m2 += b.m2 + d * d * n * b.n / t; n = t;
+  }
+  n_ = n; mean_ = mean; m2_ = m2;
+}
+
+WinResult WindowStats::result() const {
+  WinResult r;
+  double n = n_, mean = mean_, m2 = m2_;
+  if (cur_.n){
+    double t = n + cur_.n, d = (double)cur_.mean - mean;
+    mean += d * cur_.n / t; m2 += cur_.m2 + d * d * n * cur_.n / t; n = t;
+  }
+  if (n <= 0) return r;
+  r.n = (uint32_t)n;
+  r.mean = (float)mean;
+  r.sd = n > 1 ? (float)sqrt(m2 / (n - 1)) : 0.0f;
+  bool any = false;
+  if (count_){ r.min = ring_[minQ_.front()].min; r.max = ring_[maxQ_.front()].max; any = true; }
+  if (cur_.n){
+    if (!any || cur_.min < r.min) r.min = cur_.min;
+    if (!any || cur_.max > r.max) r.max = cur_.max;
+  }
+  return r;
+}
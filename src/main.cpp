@@ -6,20 +6,30 @@
 #include "flow.h"
 #include "control.h"
 #include "web.h"
+#include "sysmon.h"
+#include "spectral.h"
+#include "recorder.h"
+#include "telemetry.h"
 
 void setup(){
-  Serial.begin(921600);
+  Serial.setTxBufferSize(SERIAL_TX_BUFFER);
+  Serial.begin(SERIAL_BAUD);
   delay(100);
   Serial.println("\n[BOOT] SimUse ESP32");
 
   shared_init();
   io_begin();
   buttons_init();
+  sysmon_begin();          // idle reference before any other task runs, then 1 Hz sampler (Core 0)
   flow_begin();            // ISR + windowing task (Core 1)
 
   // Start tasks
   control_start();         // 600 Hz on Core 1
   web_start();             // Web/SSE on Core 0
+  spectral_begin();        // FFT + Goertzel on the pressure channels (Core 0)
+  recorder_begin();        // flight recorder writer, "reclog" partition (Core 0)
+  telemetry_begin();       // binary serial telemetry writer (Core 0)
+  sysmon_ram_report();     // WiFi up, all buffers allocated: RAM against the budget
 }
 
 void loop(){
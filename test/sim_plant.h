@@ -0,0 +1,29 @@
+#pragma once
+// Simulated ventricle for host-side control tests (header-only, no Arduino).
+// First-order pressure response to pump drive with a dead band, a passive leak toward 0 when
+// the valve is reversed, small deterministic sensor noise and the firmware's 10-sample MA.
+#include <stdint.h>
+
+struct SimPlant {
+  float gain     = 0.8f;    // mmHg per PWM count above the dead band (FWD)
+  float deadband = 40.0f;   // PWM counts before the pump moves fluid
+  float tauS     = 0.25f;   // time constant of the chamber
+  float revMmHg  = -5.0f;   // level approached while pumping in REV
+  float p        = 0.0f;    // true pressure
+  float raw      = 0.0f;    // last unsmoothed measurement (true pressure + noise)
+  uint32_t rng   = 12345;
+  float ma[10]{}; uint8_t idx = 0; float sum = 0;
+
+  // advance dt seconds with drive pwm (0..255) and valve (0=FWD,1=REV); returns the
+  // smoothed measurement the controller would see
+  float step(float pwm, uint8_t valve, float dt){
+    float drive = pwm > deadband ? (pwm - deadband) : 0.0f;
+    float ss = valve ? revMmHg * drive / (255.0f - deadband) : gain * drive;
+    p += (ss - p) * (dt / tauS);
+    rng = rng * 1664525u + 1013904223u;
+    float noise = ((int32_t)(rng >> 24) - 128) / 256.0f;    // ±0.5 mmHg
+    raw = p + noise;
+    sum -= ma[idx]; ma[idx] = raw; sum += ma[idx]; idx = (idx + 1) % 10;
+    return sum / 10.0f;
+  }
+};
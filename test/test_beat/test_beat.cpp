@@ -0,0 +1,162 @@
+#include <unity.h>
+#include "beat.h"
+
+// Host-runnable checks for the table-driven beat engine (pio test -e native).
+
+static const uint32_t HZ = 600;
+
+static BeatTiming timing(uint32_t bpm){ return BeatTiming{bpm, HZ, 150, 100}; }
+
+void test_phase_inc_period(){
+  // 30 BPM @ 600 Hz = 1200 ticks per beat
+  BeatEngine e; BeatShape s; e.prepare(s, timing(30)); e.restart();
+  uint32_t wraps = 0, ticks = 0, last = 0;
+  for (ticks=1; ticks<=12002; ticks++){ uint32_t p = e.phase(); e.step(); if (e.phase() < p){ wraps++; last = ticks; } }
+  TEST_ASSERT_EQUAL_UINT32(10, wraps);
+  TEST_ASSERT_UINT32_WITHIN(1, 12000, last);
+}
+
+void test_trapezoid_levels(){
+  BeatShape s; BeatTable t; beat_build_table(s, timing(30), t);
+  // 2000 ms beat: FWD 0..1000 ms; dead/2 = 50 ms, ramp 150 ms → full drive at 200..750 ms
+  TEST_ASSERT_EQUAL_UINT8(0,   t.step[0].level);
+  TEST_ASSERT_EQUAL_UINT8(255, t.step[BEAT_TABLE_N * 400 / 2000].level);
+  TEST_ASSERT_EQUAL_UINT8(0,   t.step[BEAT_TABLE_N * 990 / 2000].level);
+  TEST_ASSERT_EQUAL_UINT8(0,   t.step[BEAT_TABLE_N * 400 / 2000].valve);
+  TEST_ASSERT_EQUAL_UINT8(1,   t.step[BEAT_TABLE_N * 1400 / 2000].valve);
+  TEST_ASSERT_EQUAL_UINT8(255, t.step[BEAT_TABLE_N * 1400 / 2000].level);
+  TEST_ASSERT_EQUAL_UINT32((uint32_t)(BEAT_TABLE_N/2) << (32 - BEAT_TABLE_BITS), t.splitPhase);
+}
+
+void test_flips_only_at_zero_drive(){
+  BeatShape s; BeatEngine e;
+  for (uint32_t bpm=1; bpm<=200; bpm+=7){
+    e.prepare(s, timing(bpm)); e.restart();
+    uint32_t flips = 0;
+    for (uint32_t i=0; i<2*60*HZ/bpm; i++){
+      BeatOut o = e.step();
+      if (o.flipped){ flips++; TEST_ASSERT_EQUAL_UINT8(0, o.level); }
+    }
+    TEST_ASSERT_UINT32_WITHIN(1, 4, flips);     // two flips per beat, two beats
+  }
+}
+
+// Zero drive for dead/2 on each side of every flip (the flip tick counts as the first tick
+// after it), at every BPM — including low rates where one table step outlasts dead/2
+void test_dead_window_all_bpm(){
+  BeatShape s; BeatEngine e;
+  for (uint32_t bpm=1; bpm<=200; bpm++){
+    e.prepare(s, timing(bpm)); e.restart();
+    const BeatDuty& d = e.active().duty;
+    const uint32_t half = (uint32_t)(d.deadPct * d.periodMs / 200.0f * HZ / 1000.0f / 2.0f + 1e-3f);  // ticks per dead/2
+    const uint32_t n = 2*60*HZ/bpm + 2;
+    static uint8_t lv[72002]; static uint8_t fl[72002];
+    for (uint32_t i=0; i<n; i++){ BeatOut o = e.step(); lv[i] = o.level; fl[i] = o.flipped; }
+    uint32_t flips = 0;
+    for (uint32_t i=0; i<n; i++){
+      if (!fl[i]) continue;
+      flips++;
+      for (uint32_t k=0; k<half && i+k<n; k++) TEST_ASSERT_EQUAL_UINT8(0, lv[i+k]);
+      for (uint32_t k=1; k<=half && k<=i; k++) TEST_ASSERT_EQUAL_UINT8(0, lv[i-k]);
+    }
+    TEST_ASSERT_UINT32_WITHIN(1, 4, flips);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, half);
+  }
+}
+
+void test_custom_shape_and_split(){
+  BeatShape s; s.kind = BEAT_SHAPE_CUSTOM; s.splitPct = 40;
+  s.nFwd = 3; s.fwd[0] = 0; s.fwd[1] = 255; s.fwd[2] = 0;     // triangle
+  s.nRev = 2; s.rev[0] = 64; s.rev[1] = 64;                   // flat low REV stroke
+  BeatTable t; beat_build_table(s, timing(60), t);
+  // 1000 ms beat: FWD 0..400 ms, powered 50..350 → apex at 200 ms
+  TEST_ASSERT_INT_WITHIN(3, 255, t.step[BEAT_TABLE_N * 200 / 1000].level);
+  TEST_ASSERT_INT_WITHIN(3, 128, t.step[BEAT_TABLE_N * 125 / 1000].level);
+  TEST_ASSERT_EQUAL_UINT8(64, t.step[BEAT_TABLE_N * 700 / 1000].level);
+  TEST_ASSERT_EQUAL_UINT8(1,  t.step[BEAT_TABLE_N * 700 / 1000].valve);
+  TEST_ASSERT_UINT32_WITHIN(1u << (32 - BEAT_TABLE_BITS), (uint32_t)(0.4 * 4294967296.0), t.splitPhase);
+}
+
+void test_swap_waits_for_flip(){
+  BeatShape trap, custom; custom.kind = BEAT_SHAPE_CUSTOM; custom.nFwd = 2; custom.fwd[0] = custom.fwd[1] = 100;
+  BeatEngine e; e.prepare(trap, timing(30)); e.restart();
+  for (int i=0;i<300;i++) e.step();                  // mid FWD stroke
+  e.prepare(custom, timing(60));
+  uint32_t inc30 = e.active().inc;
+  bool swapped = false;
+  for (int i=0;i<1200 && !swapped;i++){
+    BeatOut o = e.step();
+    if (e.active().inc != inc30){
+      swapped = true;
+      TEST_ASSERT_TRUE(o.flipped);
+      TEST_ASSERT_EQUAL_UINT8(0, o.level);
+      TEST_ASSERT_EQUAL_UINT8(1, o.valve);          // first flip after mid-FWD is into REV
+    } else {
+      TEST_ASSERT_TRUE(e.pending());
+    }
+  }
+  TEST_ASSERT_TRUE(swapped);
+  TEST_ASSERT_EQUAL_UINT32(beat_phase_inc(60, HZ), e.active().inc);
+}
+
+void test_period_accuracy_all_bpm(){
+  // every integer BPM: each beat boundary lands within one tick of k·60·HZ/bpm
+  BeatShape s; BeatEngine e;
+  for (uint32_t bpm=1; bpm<=200; bpm++){
+    e.prepare(s, timing(bpm)); e.restart();
+    double ideal = 60.0 * HZ / bpm;
+    uint32_t beats = 0;
+    for (uint32_t tick=1; beats<3; tick++){
+      uint32_t p = e.phase(); e.step();
+      if (e.phase() < p){ beats++; TEST_ASSERT_FLOAT_WITHIN(1.0, beats * ideal, (double)tick); }
+    }
+  }
+}
+
+void test_high_rate_scaling(){
+  BeatShape s; BeatTable t;
+  beat_build_table(s, timing(60), t);                  // 500 ms halves: 150+100+150 fits
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 1000.0, t.duty.periodMs);
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 60.0, t.duty.rampPct);
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 20.0, t.duty.holdPct);
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 20.0, t.duty.deadPct);
+  beat_build_table(s, timing(75), t);                  // exactly 400 ms halves: hold → 0
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 0.0, t.duty.holdPct);
+  beat_build_table(s, timing(200), t);                 // 150 ms halves: everything ×0.375
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 0.0, t.duty.holdPct);
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 75.0, t.duty.rampPct);
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 25.0, t.duty.deadPct);
+
+  // still a full-height stroke in each half, flips only at zero drive
+  BeatEngine e; e.prepare(s, timing(200)); e.restart();
+  uint8_t peak[2] = {0, 0}; uint32_t flips = 0;
+  for (uint32_t i=0; i<2*180; i++){
+    BeatOut o = e.step();
+    if (o.flipped){ flips++; TEST_ASSERT_EQUAL_UINT8(0, o.level); }
+    if (o.level > peak[o.valve]) peak[o.valve] = o.level;
+  }
+  TEST_ASSERT_UINT32_WITHIN(1, 4, flips);
+  TEST_ASSERT_GREATER_THAN(240, peak[0]);
+  TEST_ASSERT_GREATER_THAN(240, peak[1]);
+}
+
+static int run_tests(){
+  UNITY_BEGIN();
+  RUN_TEST(test_phase_inc_period);
+  RUN_TEST(test_trapezoid_levels);
+  RUN_TEST(test_flips_only_at_zero_drive);
+  RUN_TEST(test_dead_window_all_bpm);
+  RUN_TEST(test_custom_shape_and_split);
+  RUN_TEST(test_swap_waits_for_flip);
+  RUN_TEST(test_period_accuracy_all_bpm);
+  RUN_TEST(test_high_rate_scaling);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup(){ delay(2000); run_tests(); }
+void loop(){}
+#else
+int main(int, char**){ return run_tests(); }
+#endif
@@ -0,0 +1,94 @@
+#include <unity.h>
+#include <string.h>
+#include <thread>
+#include "calprof.h"
+
+// Host-runnable checks of the calibration pool and profile table: publication, torn-read
+// freedom under a concurrent writer, and add/find/remove rules (pio test -e native).
+
+static CfgProfile prof(const char* name, float k){
+  CfgProfile p; memset(&p, 0, sizeof(p));
+  strncpy(p.name, name, CFG_NAME_LEN - 1);
+  p.atr = CfgCal{ k, -k }; p.vent = CfgCal{ 2 * k, -2 * k }; p.flow = CfgCal{ 3 * k, -3 * k };
+  return p;
+}
+
+void test_publish_read(){
+  static CalPool pool;
+  TEST_ASSERT_EQUAL_UINT32(0, pool.version());
+  for (int i = 1; i <= 10; i++){
+    pool.publish(prof("rig", (float)i));
+    CfgProfile r; pool.read(r);
+    TEST_ASSERT_EQUAL_FLOAT((float)i, r.atr.m);
+    TEST_ASSERT_EQUAL_FLOAT(-3.0f * i, r.flow.b);
+    TEST_ASSERT_EQUAL_STRING("rig", r.name);
+    TEST_ASSERT_EQUAL_UINT32(i, pool.version());
+  }
+}
+
+void test_no_torn_reads(){
+  static CalPool pool;
+  pool.publish(prof("a", 1.0f));
+  std::atomic<bool> stop{false};
+  std::thread w([&]{ for (int i = 2; i < 200000; i++) pool.publish(prof(i & 1 ? "odd" : "even", (float)i)); stop = true; });
+  unsigned long reads = 0, torn = 0;
+  while (!stop.load()){
+    CfgProfile r; pool.read(r);
+    const float k = r.atr.m;
+    if (r.atr.b != -k || r.vent.m != 2 * k || r.vent.b != -2 * k || r.flow.m != 3 * k || r.flow.b != -3 * k) torn++;
+    if (k > 1.0f && strcmp(r.name, ((long)k & 1) ? "odd" : "even") != 0) torn++;
+    reads++;
+  }
+  w.join();
+  TEST_ASSERT_GREATER_THAN(0, reads);
+  TEST_ASSERT_EQUAL_UINT32(0, torn);
+}
+
+void test_names(){
+  TEST_ASSERT_TRUE(calp_valid_name("rig-2 bench_A.1"));
+  TEST_ASSERT_FALSE(calp_valid_name(""));
+  TEST_ASSERT_FALSE(calp_valid_name("quote\"d"));
+  TEST_ASSERT_FALSE(calp_valid_name("0123456789abcdef"));      // 16 chars: no room for the terminator
+  TEST_ASSERT_TRUE(calp_valid_name("0123456789abcde"));
+}
+
+void test_add_find_remove(){
+  Config c{};
+  const CfgCal a{ 1, 2 }, v{ 3, 4 }, f{ 5, 6 };
+  TEST_ASSERT_EQUAL_INT(0, calp_add(c, "default", a, v, f));
+  TEST_ASSERT_EQUAL_INT(-1, calp_add(c, "default", a, v, f));      // duplicate
+  TEST_ASSERT_EQUAL_INT(-1, calp_add(c, "bad/name", a, v, f));
+  for (int i = 1; i < CFG_PROFILES; i++){ char n[8]; snprintf(n, sizeof(n), "p%d", i); TEST_ASSERT_EQUAL_INT(i, calp_add(c, n, a, v, f)); }
+  TEST_ASSERT_EQUAL_INT(-2, calp_add(c, "extra", a, v, f));        // full
+  TEST_ASSERT_EQUAL_INT(3, calp_find(c, "p3"));
+  TEST_ASSERT_EQUAL_INT(-1, calp_find(c, "p9"));
+  TEST_ASSERT_EQUAL_FLOAT(5.0f, c.profiles[3].flow.m);
+
+  c.activeProfile = 4;
+  TEST_ASSERT_FALSE(calp_remove(c, 4));                            // active
+  TEST_ASSERT_FALSE(calp_remove(c, CFG_PROFILES));
+  TEST_ASSERT_TRUE(calp_remove(c, 2));
+  TEST_ASSERT_EQUAL_UINT8(CFG_PROFILES - 1, c.nProfiles);
+  TEST_ASSERT_EQUAL_UINT8(3, c.activeProfile);                     // still points at "p4"
+  TEST_ASSERT_EQUAL_STRING("p4", c.profiles[c.activeProfile].name);
+  TEST_ASSERT_EQUAL_INT(-1, calp_find(c, "p2"));
+  const CfgProfile zero{};
+  TEST_ASSERT_EQUAL_MEMORY(&zero, &c.profiles[CFG_PROFILES - 1], sizeof(CfgProfile));
+}
+
+int run_tests(){
+  UNITY_BEGIN();
+  RUN_TEST(test_publish_read);
+  RUN_TEST(test_no_torn_reads);
+  RUN_TEST(test_names);
+  RUN_TEST(test_add_find_remove);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup(){ delay(2000); run_tests(); }
+void loop(){}
+#else
+int main(int, char**){ return run_tests(); }
+#endif
@@ -0,0 +1,124 @@
+#include <unity.h>
+#include <math.h>
+#include "capture.h"
+
+// Host-runnable checks of the triggered capture engine (pio test -e native). Samples carry
+// their tick number in `flow` so positions in the frozen buffer can be checked exactly.
+
+static Capture s_cap;                      // 16 KB: keep off the stack
+
+static CapSample smp(uint32_t t, uint8_t valve, float vent = 0, uint8_t mode = 2){
+  return CapSample{ 0, (int16_t)lroundf(vent * 10), (int16_t)(t & 0x7FFF), 0, (uint8_t)((valve & 1) | (mode << 3)) };
+}
+
+void test_valve_edge_pre_and_post(){
+  CapConfig c; c.src = CAP_SRC_VALVE; c.slope = CAP_RISING; c.pre = 512;
+  Capture& k = s_cap; k.configure(c); k.arm();
+  uint32_t t = 0;
+  for (; t < 1000; t++) k.tick(smp(t, 0), 0, t);
+  TEST_ASSERT_EQUAL_UINT8(CAP_ARMED, k.state());
+  for (; t < 1000 + CAP_N; t++) k.tick(smp(t, 1), 0, t);
+  TEST_ASSERT_EQUAL_UINT8(CAP_FROZEN, k.state());
+  TEST_ASSERT_EQUAL_UINT32(1000, k.info().triggerTick);
+  TEST_ASSERT_EQUAL_UINT32(1, k.info().seq);
+  TEST_ASSERT_TRUE(k.beginRead());
+  TEST_ASSERT_EQUAL_INT16(1000, k.at(512).flow);            // trigger sample at index pre
+  TEST_ASSERT_EQUAL_UINT8(0, k.at(511).state & 1);
+  TEST_ASSERT_EQUAL_INT16(1000 - 512, k.at(0).flow);
+  TEST_ASSERT_EQUAL_INT16(1000 + CAP_N - 513, k.at(CAP_N - 1).flow);
+  k.endRead(true);
+}
+
+void test_needs_pre_history(){
+  CapConfig c; c.src = CAP_SRC_VALVE; c.pre = 512;
+  Capture& k = s_cap; k.configure(c); k.arm();
+  uint32_t t = 0; uint8_t v = 0;
+  for (; t < 3000; t++){ if (t == 100 || t == 700) v ^= 1; k.tick(smp(t, v), 0, t); }
+  TEST_ASSERT_EQUAL_UINT8(CAP_FROZEN, k.state());
+  TEST_ASSERT_EQUAL_UINT32(700, k.info().triggerTick);       // the edge at 100 had too little history
+}
+
+void test_level_crossing_slope_and_hysteresis(){
+  CapConfig c; c.src = CAP_SRC_VENT; c.slope = CAP_FALLING; c.level = 80; c.hyst = 3; c.pre = 100;
+  Capture& k = s_cap; k.configure(c); k.arm();
+  uint32_t t = 0;
+  // chatter ±1 mmHg around the level first: never far enough above to arm the falling edge
+  for (; t < 400; t++) k.tick(smp(t, 0, 80.0f + ((t & 1) ? 1.0f : -1.0f)), 0, t);
+  TEST_ASSERT_EQUAL_UINT8(CAP_ARMED, k.state());
+  // then a 1 Hz pressure wave 40..120 mmHg: trigger on the first falling crossing
+  for (; t < 6000 && k.state() != CAP_FROZEN; t++) k.tick(smp(t, 0, 80.0f + 40.0f * sinf(6.2831853f * t / 600.0f)), 0, t);
+  TEST_ASSERT_EQUAL_UINT8(CAP_FROZEN, k.state());
+  TEST_ASSERT_TRUE(k.beginRead());
+  TEST_ASSERT_TRUE(k.at(100).vent < 800);
+  TEST_ASSERT_TRUE(k.at(99).vent >= 800);
+  TEST_ASSERT_EQUAL_UINT32(901, k.info().triggerTick);       // first falling crossing after 400
+  k.configure(CapConfig{});                                  // a new config does not rewrite the held one
+  TEST_ASSERT_EQUAL_UINT8(CAP_SRC_VENT, k.info().src);
+  TEST_ASSERT_EQUAL_UINT8(CAP_FALLING, k.info().slope);
+  TEST_ASSERT_EQUAL_FLOAT(80.0f, k.info().level);
+  k.endRead(false);
+}
+
+void test_single_holds_auto_rearms(){
+  CapConfig c; c.src = CAP_SRC_MODE; c.pre = 10;
+  Capture& k = s_cap; k.configure(c); k.arm();
+  const uint32_t s0 = k.info().seq;                          // seq counts captures since boot
+  uint32_t t = 0; uint8_t m = 0;
+  auto run = [&](uint32_t n){ for (uint32_t e = t + n; t < e; t++){ if (t % 3000 == 1500) m = (m + 1) & 7; k.tick(smp(t, 0, 0, m), 0, t); } };
+  run(9000);
+  TEST_ASSERT_EQUAL_UINT32(s0 + 1, k.info().seq);            // single: later mode changes ignored
+  TEST_ASSERT_EQUAL_UINT8(CAP_FROZEN, k.state());
+  c.autoRearm = true; c.holdTicks = 100000; k.configure(c); k.arm();
+  run(4000);
+  TEST_ASSERT_EQUAL_UINT32(s0 + 2, k.info().seq);
+  run(6000);
+  TEST_ASSERT_EQUAL_UINT32(s0 + 2, k.info().seq);            // unread and inside the hold time
+  TEST_ASSERT_TRUE(k.beginRead()); k.endRead(true);
+  run(3000);
+  TEST_ASSERT_EQUAL_UINT32(s0 + 3, k.info().seq);            // re-armed after the read
+  c.holdTicks = 100; k.configure(c); k.arm();
+  run(9000);
+  TEST_ASSERT_TRUE(k.info().seq >= s0 + 5);                       // unread: re-armed after holdTicks
+}
+
+void test_reader_lock_defers_arm(){
+  CapConfig c; c.src = CAP_SRC_FAULT; c.pre = 10;
+  Capture& k = s_cap; k.configure(c); k.arm();
+  uint32_t t = 0;
+  for (; t < 50; t++) k.tick(smp(t, 0), 0, t);
+  for (; t < 50 + CAP_N; t++) k.tick(smp(t, 0), 0x02, t);
+  TEST_ASSERT_EQUAL_UINT8(CAP_FROZEN, k.state());
+  TEST_ASSERT_EQUAL_UINT32(50, k.info().triggerTick);
+  TEST_ASSERT_TRUE(k.beginRead());
+  TEST_ASSERT_FALSE(k.beginRead());                          // one reader at a time
+  k.arm();
+  for (uint32_t e = t + 100; t < e; t++) k.tick(smp(t, 0), 0x02, t);
+  TEST_ASSERT_EQUAL_UINT8(CAP_READING, k.state());
+  TEST_ASSERT_EQUAL_INT16(50, k.at(10).flow);                // buffer untouched while read
+  k.endRead(false);
+  k.tick(smp(t, 0), 0x02, t); t++;
+  TEST_ASSERT_EQUAL_UINT8(CAP_ARMED, k.state());             // pending arm applied
+  for (uint32_t e = t + 20; t < e; t++) k.tick(smp(t, 0), 0x02, t);
+  k.force();
+  k.tick(smp(t, 0), 0x02, t);
+  TEST_ASSERT_EQUAL_UINT8(CAP_POST, k.state());
+  TEST_ASSERT_EQUAL_UINT32(t, k.info().triggerTick);
+}
+
+static int run_tests(){
+  UNITY_BEGIN();
+  RUN_TEST(test_valve_edge_pre_and_post);
+  RUN_TEST(test_needs_pre_history);
+  RUN_TEST(test_level_crossing_slope_and_hysteresis);
+  RUN_TEST(test_single_holds_auto_rearms);
+  RUN_TEST(test_reader_lock_defers_arm);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup(){ delay(2000); run_tests(); }
+void loop(){}
+#else
+int main(int, char**){ return run_tests(); }
+#endif
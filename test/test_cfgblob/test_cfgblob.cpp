@@ -0,0 +1,105 @@
+#include <unity.h>
+#include <string.h>
+#include "cfgblob.h"
+#include "crc.h"
+
+// Host-runnable checks of the configuration blob: round trip, corruption, schema migration
+// in both directions and slot selection (pio test -e native).
+
+static Config defaults(){
+  Config c{};
+  c.atr = { 0.12f, -177.8f }; c.vent = { 0.13f, -171.3f }; c.flow = { 0.04f, 0.0f };
+  return c;
+}
+
+// Hand-built blob with an arbitrary schema and payload, CRC as the firmware computes it
+static size_t make_blob(uint8_t* out, uint16_t schema, const void* payload, uint16_t size, uint32_t gen){
+  uint32_t v[4] = { CFG_MAGIC, (uint32_t)schema | ((uint32_t)size << 16), gen, 0 };
+  memcpy(out, v, CFG_HDR_BYTES);
+  memcpy(out + CFG_HDR_BYTES, payload, size);
+  uint32_t c = crc32(out, CFG_HDR_BYTES + size);
+  memcpy(out + 12, &c, 4);
+  return CFG_HDR_BYTES + size;
+}
+
+void test_roundtrip(){
+  uint8_t b[CFG_BLOB_BYTES];
+  Config c = defaults(); c.vent.m = 0.5f; c.flow.b = -0.25f;
+  TEST_ASSERT_EQUAL_UINT32(CFG_BLOB_BYTES, cfg_encode(c, 41, b));
+  Config d = defaults(); CfgInfo in;
+  TEST_ASSERT_TRUE(cfg_decode(b, sizeof(b), d, in));
+  TEST_ASSERT_EQUAL_MEMORY(&c, &d, sizeof(Config));
+  TEST_ASSERT_EQUAL_UINT16(CFG_SCHEMA, in.schema);
+  TEST_ASSERT_EQUAL_UINT32(41, in.gen);
+}
+
+void test_corruption_rejected(){
+  uint8_t b[CFG_BLOB_BYTES];
+  const Config c = defaults();
+  cfg_encode(c, 1, b);
+  Config d; CfgInfo in;
+  for (size_t i=0;i<sizeof(b);i++){
+    for (uint8_t bit=0;bit<8;bit+=3){
+      b[i] ^= (uint8_t)(1u << bit);
+      d = defaults(); d.atr.m = 99.0f;
+      TEST_ASSERT_FALSE(cfg_decode(b, sizeof(b), d, in));
+      TEST_ASSERT_EQUAL_FLOAT(99.0f, d.atr.m);            // untouched on failure
+      b[i] ^= (uint8_t)(1u << bit);
+    }
+  }
+  TEST_ASSERT_FALSE(cfg_decode(b, sizeof(b) - 1, d, in));  // truncated
+  TEST_ASSERT_FALSE(cfg_decode(b, 4, d, in));
+}
+
+void test_older_schema_keeps_new_defaults(){
+  // an older layout that only had atrial calibration
+  const CfgCal old = { 2.0f, 3.0f };
+  uint8_t b[64];
+  size_t n = make_blob(b, 1, &old, sizeof(old), 7);
+  Config d = defaults(); CfgInfo in;
+  TEST_ASSERT_TRUE(cfg_decode(b, n, d, in));
+  TEST_ASSERT_EQUAL_FLOAT(2.0f, d.atr.m); TEST_ASSERT_EQUAL_FLOAT(3.0f, d.atr.b);
+  TEST_ASSERT_EQUAL_FLOAT(defaults().vent.m, d.vent.m);
+  TEST_ASSERT_EQUAL_FLOAT(defaults().flow.m, d.flow.m);
+}
+
+void test_newer_schema_prefix(){
+  // blob from a newer firmware: our fields first, then settings we don't know
+  uint8_t payload[sizeof(Config) + 12];
+  Config c = defaults(); c.flow.m = 9.0f;
+  memcpy(payload, &c, sizeof(c)); memset(payload + sizeof(c), 0xAB, 12);
+  uint8_t b[sizeof(payload) + CFG_HDR_BYTES];
+  size_t n = make_blob(b, CFG_SCHEMA + 3, payload, sizeof(payload), 8);
+  Config d = defaults(); CfgInfo in;
+  TEST_ASSERT_TRUE(cfg_decode(b, n, d, in));
+  TEST_ASSERT_EQUAL_MEMORY(&c, &d, sizeof(Config));
+  TEST_ASSERT_EQUAL_UINT16(CFG_SCHEMA + 3, in.schema);
+}
+
+void test_slot_pick(){
+  bool v[2]; uint32_t g[2] = { 0, 0 };
+  v[0] = false; v[1] = false; TEST_ASSERT_EQUAL_INT(-1, cfg_pick(v, g));
+  v[0] = true;  g[0] = 5;     TEST_ASSERT_EQUAL_INT(0, cfg_pick(v, g));
+  v[1] = true;  g[1] = 6;     TEST_ASSERT_EQUAL_INT(1, cfg_pick(v, g));
+  g[0] = 7;                   TEST_ASSERT_EQUAL_INT(0, cfg_pick(v, g));
+  g[0] = 0xFFFFFFFFu; g[1] = 0; TEST_ASSERT_EQUAL_INT(1, cfg_pick(v, g));   // generation wrap
+  v[1] = false;               TEST_ASSERT_EQUAL_INT(0, cfg_pick(v, g));
+}
+
+int run_tests(){
+  UNITY_BEGIN();
+  RUN_TEST(test_roundtrip);
+  RUN_TEST(test_corruption_rejected);
+  RUN_TEST(test_older_schema_keeps_new_defaults);
+  RUN_TEST(test_newer_schema_prefix);
+  RUN_TEST(test_slot_pick);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup(){ delay(2000); run_tests(); }
+void loop(){}
+#else
+int main(int, char**){ return run_tests(); }
+#endif
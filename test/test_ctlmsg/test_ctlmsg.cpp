@@ -0,0 +1,80 @@
+#include <unity.h>
+#include <string.h>
+#include "ctlmsg.h"
+
+// Host-runnable checks of the WebSocket control messages: parsing, validation, and replay
+// protection across reconnects (pio test -e native).
+
+static CtlErr parse(const char* s, CtlMsg& m){ return ctl_parse(s, strlen(s), m); }
+
+void test_parse(){
+  CtlMsg m;
+  TEST_ASSERT_EQUAL_INT(CTL_OK, parse("{\"s\":12,\"c\":\"pwm\",\"v\":120}", m));
+  TEST_ASSERT_EQUAL_INT(CTL_PWM, m.op); TEST_ASSERT_TRUE(m.hasSeq); TEST_ASSERT_EQUAL_UINT32(12, m.seq);
+  TEST_ASSERT_EQUAL_FLOAT(120.0f, m.v);
+
+  TEST_ASSERT_EQUAL_INT(CTL_OK, parse("{\"c\":\"flow\",\"v\":-2.5}", m));   // fire-and-forget
+  TEST_ASSERT_EQUAL_INT(CTL_FLOW, m.op); TEST_ASSERT_FALSE(m.hasSeq); TEST_ASSERT_EQUAL_FLOAT(-2.5f, m.v);
+
+  TEST_ASSERT_EQUAL_INT(CTL_OK, parse("{\"c\":\"hello\",\"sid\":77}", m));
+  TEST_ASSERT_EQUAL_INT(CTL_HELLO, m.op); TEST_ASSERT_EQUAL_UINT32(77, m.sid);
+
+  TEST_ASSERT_EQUAL_INT(CTL_OK, parse("{\"s\":3,\"c\":\"toggle\"}", m));
+  TEST_ASSERT_EQUAL_INT(CTL_TOGGLE, m.op);
+}
+
+void test_parse_rejects(){
+  CtlMsg m;
+  TEST_ASSERT_EQUAL_INT(CTL_BAD_JSON,   parse("{\"s\":1,\"c\":\"pwm\",\"v\":1", m));
+  TEST_ASSERT_EQUAL_INT(CTL_BAD_JSON,   parse("{\"s\":1.5,\"c\":\"pwm\",\"v\":1}", m));
+  TEST_ASSERT_EQUAL_INT(CTL_BAD_JSON,   parse("{\"s\":1,\"c\":\"pwm\",\"v\":\"1\"}", m));
+  TEST_ASSERT_EQUAL_INT(CTL_BAD_OP,     parse("{\"s\":1,\"c\":\"reboot\"}", m));
+  TEST_ASSERT_EQUAL_INT(CTL_BAD_OP,     parse("{\"s\":1,\"v\":1}", m));
+  TEST_ASSERT_EQUAL_INT(CTL_NEED_VALUE, parse("{\"s\":1,\"c\":\"bpm\"}", m));
+  TEST_ASSERT_EQUAL_INT(CTL_NEED_VALUE, parse("{\"s\":1,\"c\":\"bpm\",\"v\":1e999}", m));
+  TEST_ASSERT_EQUAL_INT(CTL_NEED_VALUE, parse("{\"c\":\"hello\"}", m));
+  TEST_ASSERT_EQUAL_INT(CTL_BAD_SEQ,    parse("{\"c\":\"toggle\"}", m));         // toggle must be acked
+  TEST_ASSERT_EQUAL_INT(CTL_BAD_SEQ,    parse("{\"s\":0,\"c\":\"pwm\",\"v\":1}", m));
+  char big[CTL_MSG_MAX + 8]; memset(big, ' ', sizeof(big)); memcpy(big, "{}", 2);
+  TEST_ASSERT_EQUAL_INT(CTL_BAD_JSON, ctl_parse(big, sizeof(big), m));
+}
+
+void test_replay_after_reconnect(){
+  static CtlSessions ss;
+  TEST_ASSERT_EQUAL_UINT32(0, ss.hello(1001, 0));
+  int toggles = 0;
+  for (uint32_t s = 1; s <= 5; s++) if (ss.accept(1001, s, s)) toggles++;
+  // connection drops after the device applied 5 but before the client saw acks 4 and 5
+  TEST_ASSERT_EQUAL_UINT32(5, ss.hello(1001, 10));
+  for (uint32_t s = 4; s <= 7; s++) if (ss.accept(1001, s, 10 + s)) toggles++;   // client replays 4..7
+  TEST_ASSERT_EQUAL_INT(7, toggles);
+  TEST_ASSERT_FALSE(ss.accept(1001, 6, 30));                                     // late duplicate
+  TEST_ASSERT_EQUAL_UINT32(0, ss.hello(2002, 31));                                // other tab: own sequence
+  TEST_ASSERT_TRUE(ss.accept(2002, 1, 32));
+}
+
+void test_session_eviction(){
+  static CtlSessions ss;
+  for (uint32_t i = 1; i <= CTL_SESSIONS; i++){ ss.hello(i, i); ss.accept(i, 10, i); }
+  ss.hello(1, 100);                                    // 1 recently used, 2 is now the oldest
+  TEST_ASSERT_EQUAL_UINT32(0, ss.hello(99, 101));      // evicts 2
+  TEST_ASSERT_EQUAL_UINT32(10, ss.hello(1, 102));
+  TEST_ASSERT_EQUAL_UINT32(0, ss.hello(2, 103));       // forgotten: starts over
+}
+
+int run_tests(){
+  UNITY_BEGIN();
+  RUN_TEST(test_parse);
+  RUN_TEST(test_parse_rejects);
+  RUN_TEST(test_replay_after_reconnect);
+  RUN_TEST(test_session_eviction);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup(){ delay(2000); run_tests(); }
+void loop(){}
+#else
+int main(int, char**){ return run_tests(); }
+#endif
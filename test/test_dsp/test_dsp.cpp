@@ -0,0 +1,124 @@
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include "dsp.h"
+
+// Host-runnable accuracy checks with synthetic tones plus a small benchmark of the spectral
+// engine (pio test -e native). Sample rate matches the control loop.
+
+static const float FS = 600.0f, PI2 = 6.28318530718f;
+static RealFft s_fft;                      // tables built once, as on the device
+
+static float bin_hz(uint16_t k){ return k * FS / SPEC_N; }
+
+static void fill_channel(SpecChannel& ch, float* mag, float (*sig)(uint32_t)){
+  for (uint32_t i = 0; i < SPEC_N; i++) ch.push(sig(i));
+  ch.frame(s_fft, mag);
+}
+
+static uint16_t peak_bin(const float* mag){
+  uint16_t p = 1; for (uint16_t k = 1; k < SPEC_BINS; k++) if (mag[k] > mag[p]) p = k;
+  return p;
+}
+
+void test_fft_matches_naive_dft(){
+  float x[SPEC_N], mag[SPEC_BINS];
+  uint32_t r = 5;
+  for (uint16_t i = 0; i < SPEC_N; i++){ r = r*1664525u + 1013904223u; x[i] = (int32_t)(r >> 16) / 32768.0f - 1.0f; }
+  s_fft.magnitude(x, mag);
+  for (uint16_t k = 0; k < SPEC_BINS; k += 17){
+    double re = 0, im = 0;
+    for (uint16_t n = 0; n < SPEC_N; n++){ re += x[n]*cos(PI2*(double)k*n/SPEC_N); im -= x[n]*sin(PI2*(double)k*n/SPEC_N); }
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f * SPEC_N, (float)sqrt(re*re + im*im), mag[k]);
+  }
+}
+
+static float tone_on_bin(uint32_t i){ return 3.0f * sinf(PI2 * bin_hz(40) * i / FS); }
+static float tone_off_bin(uint32_t i){ return 3.0f * sinf(PI2 * (bin_hz(100) + 0.5f*FS/SPEC_N) * i / FS); }
+static float dc_plus_tone(uint32_t i){ return 50.0f + 1.0f * sinf(PI2 * bin_hz(200) * i / FS); }
+
+void test_tone_amplitude_on_bin(){
+  SpecChannel ch; float mag[SPEC_BINS];
+  fill_channel(ch, mag, tone_on_bin);
+  TEST_ASSERT_EQUAL_UINT16(40, peak_bin(mag));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f * 3.0f, 3.0f, mag[40]);
+  TEST_ASSERT_TRUE(mag[45] < 1e-3f);                   // Hann sidelobes fall off fast
+}
+
+void test_tone_between_bins_scallop(){
+  SpecChannel ch; float mag[SPEC_BINS];
+  fill_channel(ch, mag, tone_off_bin);
+  uint16_t p = peak_bin(mag);
+  TEST_ASSERT_TRUE(p == 100 || p == 101);
+  // Hann worst-case scalloping is 1.42 dB → ≥ 0.849 of the amplitude
+  TEST_ASSERT_FLOAT_WITHIN(0.03f, 3.0f * 0.849f, mag[p]);
+}
+
+void test_dc_and_small_tone(){
+  SpecChannel ch; float mag[SPEC_BINS];
+  fill_channel(ch, mag, dc_plus_tone);
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 50.0f, mag[0]);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.0f, mag[200]);
+}
+
+void test_channel_hop(){
+  SpecChannel ch; int frames = 0;
+  for (uint32_t i = 0; i < SPEC_N + 3*SPEC_HOP; i++) frames += ch.push(0.0f);
+  TEST_ASSERT_EQUAL_INT(4, frames);
+}
+
+void test_goertzel_harmonics(){
+  // 72 BPM beat → 500 samples per period; fundamental 10, 2nd 4, 3rd 1 mmHg
+  GoertzelBank g; g.setPeriod(500);
+  bool done = false;
+  for (uint32_t i = 0; i < 500; i++){
+    float t = PI2 * i / 500.0f;
+    done = g.push(80.0f + 10.0f*sinf(t) + 4.0f*sinf(2*t + 0.3f) + 1.0f*cosf(3*t));
+  }
+  TEST_ASSERT_TRUE(done);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 10.0f, g.amplitude(1));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 4.0f,  g.amplitude(2));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.0f,  g.amplitude(3));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f,  g.amplitude(4));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.4f,  g.ratio(2));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, sqrtf(17.0f)/10.0f, g.thd());
+}
+
+void test_benchmark(){
+  SpecChannel ch; float mag[SPEC_BINS];
+  for (uint32_t i = 0; i < SPEC_N; i++) ch.push(tone_on_bin(i));
+  const int N = 2000;
+  clock_t t0 = clock();
+  for (int i = 0; i < N; i++) ch.frame(s_fft, mag);
+  double usFrame = 1e6 * (double)(clock() - t0) / CLOCKS_PER_SEC / N;
+  GoertzelBank g; g.setPeriod(600);
+  t0 = clock();
+  for (int i = 0; i < 600 * 200; i++) g.push((float)(i & 7));
+  double nsSample = 1e9 * (double)(clock() - t0) / CLOCKS_PER_SEC / (600 * 200);
+  char msg[96];
+  snprintf(msg, sizeof(msg), "%u-pt windowed frame: %.1f us, Goertzel x%u: %.1f ns/sample",
+           (unsigned)SPEC_N, usFrame, (unsigned)SPEC_HARMONICS, nsSample);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_TRUE(mag[40] > 2.9f);                    // keep the loop from being optimized out
+}
+
+static int run_tests(){
+  UNITY_BEGIN();
+  RUN_TEST(test_fft_matches_naive_dft);
+  RUN_TEST(test_tone_amplitude_on_bin);
+  RUN_TEST(test_tone_between_bins_scallop);
+  RUN_TEST(test_dc_and_small_tone);
+  RUN_TEST(test_channel_hop);
+  RUN_TEST(test_goertzel_harmonics);
+  RUN_TEST(test_benchmark);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup(){ delay(2000); run_tests(); }
+void loop(){}
+#else
+int main(int, char**){ return run_tests(); }
+#endif
@@ -0,0 +1,88 @@
+#include <unity.h>
+#include <math.h>
+#include "ensemble.h"
+#include "beat.h"
+
+// Host-runnable checks for the beat-synchronous templates (pio test -e native).
+
+static const uint32_t HZ = 600;
+static const float PI2 = 6.2831853f;
+
+static uint32_t s_rng = 99;
+static float noise(float amp){                     // uniform ±amp, variance amp²/3
+  s_rng = s_rng * 1664525u + 1013904223u;
+  return ((int32_t)(s_rng >> 8) / 8388608.0f - 1.0f) * amp;
+}
+
+// Feed `beats` beats of channel c = (c+1)·amp·sin(phase from flip) + noise
+static void feed(EnsembleAvg& e, uint32_t bpm, uint32_t split, int beats, float amp, float nz){
+  uint32_t inc = beat_phase_inc(bpm, HZ), ph = 0;
+  for (uint32_t t = 0; t < (uint32_t)beats * HZ * 60 / bpm; t++, ph += inc){
+    uint32_t rel = ph - split;
+    float s = sinf(PI2 * (rel / 4294967296.0f));
+    float x[ENS_CH] = { amp*s + noise(nz), 2*amp*s + noise(nz), 3*amp*s + noise(nz) };
+    e.sample(rel, x);
+  }
+}
+
+static float bin_centre_sin(uint8_t b){ return sinf(PI2 * (b + 0.5f) / ENS_BINS); }
+
+void test_mean_and_variance_converge(){
+  EnsembleAvg e; e.configure(16, HZ * 60.0f / 60);
+  feed(e, 60, 0, 80, 10.0f, 3.0f);
+  for (uint8_t b = 0; b < ENS_BINS; b++){
+    TEST_ASSERT_FLOAT_WITHIN(1.2f, 20.0f * bin_centre_sin(b), e.mean(1, b));
+    TEST_ASSERT_FLOAT_WITHIN(2.0f, 30.0f * bin_centre_sin(b), e.mean(2, b));
+    TEST_ASSERT_TRUE(e.count(b) > 0);
+  }
+  // variance ≈ noise (3) + in-bin spread of the curve; averaged over bins
+  float v = 0; for (uint8_t b = 0; b < ENS_BINS; b++) v += e.var(0, b);
+  TEST_ASSERT_FLOAT_WITHIN(1.5f, 3.0f + 0.6f, v / ENS_BINS);
+}
+
+void test_aligned_on_flip(){
+  // same waveform relative to the flip, different flip phases → same template
+  EnsembleAvg a, b; a.configure(8, 600); b.configure(8, 600);
+  feed(a, 60, 0, 30, 10.0f, 0.0f);
+  feed(b, 60, 0x60000000u, 30, 10.0f, 0.0f);
+  for (uint8_t k = 0; k < ENS_BINS; k++) TEST_ASSERT_FLOAT_WITHIN(0.05f, a.mean(1, k), b.mean(1, k));
+}
+
+void test_forgetting_tracks_change(){
+  EnsembleAvg e; e.configure(8, HZ * 60.0f / 120);
+  feed(e, 120, 0, 60, 10.0f, 0.0f);
+  feed(e, 120, 0, 40, 5.0f, 0.0f);                 // ~5 memories later
+  TEST_ASSERT_FLOAT_WITHIN(0.2f, 10.0f * bin_centre_sin(ENS_BINS/4), e.mean(1, ENS_BINS/4));
+}
+
+void test_every_bin_hit_at_max_bpm(){
+  EnsembleAvg e; e.configure(16, HZ * 60.0f / 200);
+  feed(e, 200, 0, 1, 1.0f, 0.0f);
+  for (uint8_t b = 0; b < ENS_BINS; b++) TEST_ASSERT_TRUE(e.count(b) >= 1);
+}
+
+void test_reset(){
+  EnsembleAvg e; e.configure(4, 600);
+  feed(e, 60, 0, 2, 10.0f, 1.0f);
+  e.reset();
+  TEST_ASSERT_EQUAL_UINT16(0, e.count(3));
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, e.mean(1, 3));
+}
+
+static int run_tests(){
+  UNITY_BEGIN();
+  RUN_TEST(test_mean_and_variance_converge);
+  RUN_TEST(test_aligned_on_flip);
+  RUN_TEST(test_forgetting_tracks_change);
+  RUN_TEST(test_every_bin_hit_at_max_bpm);
+  RUN_TEST(test_reset);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup(){ delay(2000); run_tests(); }
+void loop(){}
+#else
+int main(int, char**){ return run_tests(); }
+#endif
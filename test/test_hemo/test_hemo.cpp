@@ -0,0 +1,127 @@
+#include <unity.h>
+#include <math.h>
+#include "hemo.h"
+
+// Host-runnable checks for the per-beat analyzer and its ring (pio test -e native).
+
+static const uint32_t HZ = 600;
+static const float PI2 = 6.2831853f;
+
+// One beat of 80 ± 40 mmHg sine at bpm, sampled at HZ
+static bool sine_beat(BeatAnalyzer& a, uint32_t bpm, uint32_t& t, BeatStats& out){
+  uint32_t n = HZ * 60 / bpm;
+  for (uint32_t i = 0; i < n; i++, t++) a.sample(80.0f + 40.0f * sinf(PI2 * t / n));
+  return a.endBeat(t * 1000 / HZ, out);
+}
+
+void test_sine_60bpm(){
+  BeatAnalyzer a; a.begin(HZ); BeatStats s; uint32_t t = 0;
+  TEST_ASSERT_TRUE(sine_beat(a, 60, t, s));
+  TEST_ASSERT_EQUAL_UINT32(1, s.seq);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 1000.0f, s.periodMs);
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 120.0f, s.sys);
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 40.0f, s.dia);
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 80.0f, s.map);
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, 80.0f, s.pp);
+  TEST_ASSERT_FLOAT_WITHIN(2.0f, 40.0f * PI2, s.dpdtMax);      // peak slope A·ω
+}
+
+void test_sine_150bpm_sequence(){
+  BeatAnalyzer a; a.begin(HZ); BeatStats s; uint32_t t = 0;
+  for (int k = 0; k < 5; k++) TEST_ASSERT_TRUE(sine_beat(a, 150, t, s));
+  TEST_ASSERT_EQUAL_UINT32(5, s.seq);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 400.0f, s.periodMs);
+  TEST_ASSERT_FLOAT_WITHIN(5.0f, 40.0f * PI2 * 2.5f, s.dpdtMax);
+}
+
+void test_partial_beat_rejected(){
+  BeatAnalyzer a; a.begin(HZ); BeatStats s;
+  a.sample(10.0f);
+  TEST_ASSERT_FALSE(a.endBeat(0, s));
+  a.sample(1.0f); a.sample(2.0f); a.clear();
+  TEST_ASSERT_FALSE(a.endBeat(0, s));
+}
+
+void test_ring_since_and_wrap(){
+  BeatRing<4> r; BeatStats b, out[4];
+  TEST_ASSERT_EQUAL_UINT32(0, r.lastSeq());
+  for (uint32_t s = 1; s <= 6; s++){ b.seq = s; r.push(b); }
+  TEST_ASSERT_EQUAL_UINT8(4, r.size());
+  TEST_ASSERT_EQUAL_UINT32(3, r.at(0).seq);
+  TEST_ASSERT_EQUAL_UINT32(6, r.lastSeq());
+  TEST_ASSERT_EQUAL_UINT8(2, r.since(4, out, 4));
+  TEST_ASSERT_EQUAL_UINT32(5, out[0].seq);
+  TEST_ASSERT_EQUAL_UINT8(4, r.since(0, out, 4));               // older ones are gone
+  TEST_ASSERT_EQUAL_UINT8(1, r.since(0, out, 1));
+  TEST_ASSERT_EQUAL_UINT32(3, out[0].seq);
+}
+
+// Synthetic flow pulse train: edges (both counted) at pulseHz on a cumulative counter
+struct PulseGen {
+  uint32_t count = 0; double acc = 0;
+  uint32_t tick(float pulseHz){ acc += 2.0 * pulseHz / HZ; uint32_t e = (uint32_t)acc; acc -= e; count += e; return count; }
+};
+static const FlowCal CAL{ 1.0f / 23.6f, 0.0f };                 // L/min = Hz / 23.6
+
+void test_totalizer_constant_flow(){
+  FlowTotalizer v; v.begin(HZ, 2, 100); PulseGen g; VolumeSeg seg;
+  for (int s = 0; s < 60; s++){                                  // 1 L/min for a minute, 1 s slices
+    for (uint32_t i = 0; i < HZ; i++) v.sample(g.tick(23.6f), 0);
+    seg = v.endSegment(CAL);
+  }
+  TEST_ASSERT_EQUAL_UINT32(g.count, (uint32_t)v.edges(0));       // every edge integrated exactly
+  TEST_ASSERT_FLOAT_WITHIN(1.0f, 1000.0f, v.totalMl(0, CAL));
+  TEST_ASSERT_FLOAT_WITHIN(0.5f, 16.67f, seg.fwdMl);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.0f, v.coLpm());
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, v.totalMl(1, CAL));
+}
+
+void test_totalizer_direction_split(){
+  // 60 bpm beat: 0.6 s forward at 5 L/min, 0.4 s reverse at 1 L/min
+  FlowTotalizer v; v.begin(HZ, 2, 100); PulseGen g; VolumeSeg seg;
+  for (int b = 0; b < 10; b++){
+    for (uint32_t i = 0; i < HZ; i++){ bool rev = i >= HZ * 6 / 10; v.sample(g.tick(rev ? 23.6f : 118.0f), rev); }
+    seg = v.endSegment(CAL);
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.3f, 50.0f, seg.fwdMl);               // 5 L/min × 0.6 s
+  TEST_ASSERT_FLOAT_WITHIN(0.3f, 6.67f, seg.revMl);               // 1 L/min × 0.4 s
+  TEST_ASSERT_FLOAT_WITHIN(0.5f, 43.33f, seg.netMl);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.0f, seg.periodS);
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 2.6f, v.coLpm());               // 43.3 mL/beat × 60 bpm
+  TEST_ASSERT_FLOAT_WITHIN(3.0f, 433.3f, v.netMl(CAL));
+}
+
+void test_totalizer_offset_gated_and_wrap(){
+  FlowCal cal{ 1.0f / 23.6f, 0.5f };
+  FlowTotalizer v; v.begin(HZ, 2, 100);
+  uint32_t c = 0xFFFFFF00u;                                      // counter wraps mid-run
+  for (uint32_t i = 0; i < 10 * HZ; i++) v.sample(c, 0);         // stopped pump: no offset volume
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, v.totalMl(0, cal));
+  for (uint32_t i = 0; i < HZ; i++){ if (i % 6 == 0) c += 1; v.sample(c, 0); }   // 50 Hz pulses
+  TEST_ASSERT_EQUAL_UINT32(100, (uint32_t)v.edges(0));
+  // 50 pulses × m + 0.5 L/min × ~1 s
+  TEST_ASSERT_FLOAT_WITHIN(0.2f, (50.0f / 23.6f + 0.5f) / 60.0f * 1000.0f, v.totalMl(0, cal));
+  v.reset();
+  TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)v.edges(0));
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, v.coLpm());
+}
+
+static int run_tests(){
+  UNITY_BEGIN();
+  RUN_TEST(test_sine_60bpm);
+  RUN_TEST(test_sine_150bpm_sequence);
+  RUN_TEST(test_partial_beat_rejected);
+  RUN_TEST(test_ring_since_and_wrap);
+  RUN_TEST(test_totalizer_constant_flow);
+  RUN_TEST(test_totalizer_direction_split);
+  RUN_TEST(test_totalizer_offset_gated_and_wrap);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup(){ delay(2000); run_tests(); }
+void loop(){}
+#else
+int main(int, char**){ return run_tests(); }
+#endif
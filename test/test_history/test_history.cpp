@@ -0,0 +1,122 @@
+#include <unity.h>
+#include <stdio.h>
+#include <time.h>
+#include "history.h"
+
+// Host-runnable checks of the min/max history tiers against brute force over the raw ticks,
+// plus a benchmark of the per-tick push (pio test -e native).
+
+static History s_h;                         // ~80 KB, keep off the stack
+static int16_t s_raw[HIST_CH][200000];      // every pushed tick, for brute force
+static uint32_t s_n = 0;
+
+static int16_t wave(uint8_t c, uint32_t i){
+  uint32_t r = (i * 2654435761u) >> 24;     // deterministic jitter 0..255
+  return (int16_t)((int32_t)((i / (7 + c)) % 400) - 200 + (int32_t)(r % 16) * (c + 1));
+}
+
+static void feed(uint32_t n){
+  for (uint32_t k=0;k<n;k++){
+    int16_t v[HIST_CH];
+    for (uint8_t c=0;c<HIST_CH;c++){ v[c] = wave(c, s_n); s_raw[c][s_n] = v[c]; }
+    s_h.push(v); s_n++;
+  }
+}
+
+static void reset(){ s_h.reset(); s_n = 0; }
+
+// Every point must equal min/max of the raw ticks it claims to cover
+static void check(uint8_t ch, uint32_t span, uint16_t maxPts){
+  static HistPoint out[2000];
+  HistQuery q = s_h.query(ch, span, maxPts, out);
+  TEST_ASSERT_TRUE(q.n > 0);
+  TEST_ASSERT_TRUE(q.n <= maxPts);
+  TEST_ASSERT_EQUAL_UINT32(s_h.ticks() / History::tierTicks(q.tier) * History::tierTicks(q.tier), q.endTick);
+  for (uint16_t p=0;p<q.n;p++){
+    uint32_t hi = q.endTick - (uint32_t)(q.n - 1 - p) * q.stepTicks;
+    uint32_t lo = hi >= q.stepTicks ? hi - q.stepTicks : 0;
+    if (p == 0){                            // oldest point may be partial; check it is inside its bucket
+      uint32_t covered = (uint32_t)q.n * q.stepTicks;
+      if (covered > span + q.stepTicks) TEST_FAIL_MESSAGE("span overshoot");
+    }
+    int16_t mn = 32767, mx = -32768;
+    for (uint32_t i=lo;i<hi;i++){ if (s_raw[ch][i] < mn) mn = s_raw[ch][i]; if (s_raw[ch][i] > mx) mx = s_raw[ch][i]; }
+    if (p == 0){ TEST_ASSERT_TRUE(out[p].lo >= mn); TEST_ASSERT_TRUE(out[p].hi <= mx); }
+    else { TEST_ASSERT_EQUAL_INT16(mn, out[p].lo); TEST_ASSERT_EQUAL_INT16(mx, out[p].hi); }
+  }
+}
+
+void test_tier0_exact(){
+  reset(); feed(1000);
+  static HistPoint out[600];
+  HistQuery q = s_h.query(1, 600, 600, out);
+  TEST_ASSERT_EQUAL_UINT8(0, q.tier);
+  TEST_ASSERT_EQUAL_UINT16(600, q.n);
+  TEST_ASSERT_EQUAL_UINT32(1, q.stepTicks);
+  TEST_ASSERT_EQUAL_UINT32(1000, q.endTick);
+  for (uint16_t i=0;i<600;i++){ TEST_ASSERT_EQUAL_INT16(s_raw[1][400 + i], out[i].lo); TEST_ASSERT_EQUAL_INT16(out[i].lo, out[i].hi); }
+}
+
+void test_minmax_matches_brute_force(){
+  reset(); feed(150000);                    // wraps tiers 0 and 1
+  check(0, 3000, 500);         // tier 0, merged 6:1
+  check(1, 36000, 1000);                    // 60 s → tier 1
+  check(2, 20000, 333);                     // odd grouping
+  check(3, 150000, 400);                    // everything → tier 2
+}
+
+void test_tier_choice_and_bounds(){
+  reset(); feed(200000);
+  static HistPoint out[1000];
+  TEST_ASSERT_EQUAL_UINT8(0, s_h.query(0, 5 * 600, 1000, out).tier);
+  TEST_ASSERT_EQUAL_UINT8(1, s_h.query(0, 60 * 600, 1000, out).tier);
+  HistQuery q = s_h.query(0, 3600u * 600u, 1000, out);
+  TEST_ASSERT_EQUAL_UINT8(2, q.tier);
+  TEST_ASSERT_TRUE(q.n <= 1000);
+  // only 200000 ticks stored: clipped to what tier 2 holds
+  TEST_ASSERT_UINT32_WITHIN(History::tierTicks(2), 200000, (uint32_t)q.n * q.stepTicks);
+  TEST_ASSERT_EQUAL_UINT16(0, s_h.query(HIST_CH, 600, 100, out).n);
+  TEST_ASSERT_EQUAL_UINT16(0, s_h.query(0, 600, 0, out).n);
+}
+
+void test_short_history_clips(){
+  reset(); feed(50);
+  static HistPoint out[100];
+  HistQuery q = s_h.query(0, 6000, 100, out);
+  TEST_ASSERT_EQUAL_UINT8(1, q.tier);
+  TEST_ASSERT_EQUAL_UINT16(2, q.n);         // two complete 20-tick buckets
+  q = s_h.query(0, 30, 100, out);
+  TEST_ASSERT_EQUAL_UINT16(30, q.n);
+  reset();
+  TEST_ASSERT_EQUAL_UINT16(0, s_h.query(0, 30, 100, out).n);
+}
+
+void test_push_benchmark(){
+  reset();
+  const uint32_t N = 600000;
+  int16_t v[HIST_CH] = { 0, 0, 0, 0 };
+  clock_t t0 = clock();
+  for (uint32_t i=0;i<N;i++){ v[0] = (int16_t)i; v[1] = (int16_t)(i * 3); v[2] = (int16_t)(i >> 2); v[3] = (int16_t)(i & 255); s_h.push(v); }
+  double ns = (double)(clock() - t0) / CLOCKS_PER_SEC * 1e9 / N;
+  char msg[96]; snprintf(msg, sizeof(msg), "push: %.1f ns/tick (%u channels)", ns, (unsigned)HIST_CH);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_EQUAL_UINT32(N, s_h.ticks());
+}
+
+int run_tests(){
+  UNITY_BEGIN();
+  RUN_TEST(test_tier0_exact);
+  RUN_TEST(test_minmax_matches_brute_force);
+  RUN_TEST(test_tier_choice_and_bounds);
+  RUN_TEST(test_short_history_clips);
+  RUN_TEST(test_push_benchmark);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup(){ delay(2000); run_tests(); }
+void loop(){}
+#else
+int main(int, char**){ return run_tests(); }
+#endif
@@ -0,0 +1,127 @@
+#include <unity.h>
+#include <math.h>
+#include "ilc.h"
+#include "beat.h"
+#include "../sim_plant.h"
+
+// Host-runnable convergence checks for the beat ILC against the simulated ventricle
+// (pio test -e native). The target is a pressure curve the plant really produced with a
+// different drive shape, so it is reachable; the learner starts from the plain trapezoid.
+
+static const uint32_t HZ = 600;
+static const IlcConfig CFG{ 0.3f, 0.002f, 40.0f, 96 };
+
+struct Rig {
+  BeatEngine be; SimPlant pl; float meas = 0; uint8_t scale;
+  Rig(const BeatShape& sh, uint32_t bpm, uint8_t sc) : scale(sc) {
+    be.prepare(sh, BeatTiming{bpm, HZ, 150, 100}); be.restart();
+  }
+  // one beat; with ilc != nullptr the correction is added on powered ticks and learned from
+  void beat(IlcTable* ilc, float* binMean){
+    float sum[ILC_BINS]{}; uint16_t n[ILC_BINS]{};
+    uint32_t prev = be.phase();
+    for (;;){
+      uint32_t ph = be.phase();
+      BeatOut o = be.step();
+      int pwm = (o.level * scale + 127) / 255;
+      if (ilc && o.level) pwm += ilc->correction(ph);
+      pwm = pwm < 0 ? 0 : (pwm > 255 ? 255 : pwm);
+      meas = pl.step((float)pwm, o.valve, 1.0f / HZ);
+      if (ilc) ilc->sample(ph, meas);
+      sum[ph >> (32 - ILC_BITS)] += meas; n[ph >> (32 - ILC_BITS)]++;
+      if (be.phase() < prev) break;
+      prev = be.phase();
+    }
+    if (ilc) ilc->endBeat();
+    if (binMean) for (uint8_t b = 0; b < ILC_BINS; b++) binMean[b] = n[b] ? sum[b] / n[b] : 0;
+  }
+};
+
+static void make_target(uint32_t bpm, float* target){
+  BeatShape sh; sh.kind = BEAT_SHAPE_CUSTOM; sh.nFwd = 4;
+  sh.fwd[0] = 80; sh.fwd[1] = 255; sh.fwd[2] = 180; sh.fwd[3] = 120;
+  sh.nRev = 2; sh.rev[0] = 120; sh.rev[1] = 120;
+  Rig r(sh, bpm, 230);
+  for (int i = 0; i < 10; i++) r.beat(nullptr, target);    // periodic steady state
+}
+
+static float converge(uint32_t bpm, int beats, float* firstRms){
+  float target[ILC_BINS]; make_target(bpm, target);
+  BeatShape trap;
+  Rig r(trap, bpm, 180);
+  IlcTable ilc; ilc.configure(CFG); ilc.setTarget(target);
+  BeatTable t; beat_build_table(trap, BeatTiming{bpm, HZ, 150, 100}, t); ilc.setBeat(t, HZ);
+  for (int i = 0; i < 5; i++) r.beat(nullptr, nullptr);      // settle without learning
+  ilc.reset();
+  *firstRms = -1;
+  for (int i = 0; i < beats; i++){
+    r.beat(&ilc, nullptr);
+    if (*firstRms < 0 && ilc.beats()) *firstRms = ilc.rms();
+  }
+  return ilc.rms();
+}
+
+void test_resample_and_bins(){
+  float pts[3] = { 0, 100, 0 }, out[ILC_BINS];
+  ilc_resample(pts, 3, out);
+  TEST_ASSERT_FLOAT_WITHIN(2.0f, 1.6f, out[0]);
+  TEST_ASSERT_FLOAT_WITHIN(2.0f, 98.4f, out[ILC_BINS/2]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, out[1], out[ILC_BINS - 2]);
+}
+
+void test_dead_time_masked(){
+  BeatShape trap; BeatTable t; beat_build_table(trap, BeatTiming{60, HZ, 150, 100}, t);
+  IlcTable ilc; ilc.configure(CFG);
+  float flat[ILC_BINS]; for (auto& v : flat) v = 500.0f;    // unreachable: saturate corrections
+  ilc.setTarget(flat); ilc.setBeat(t, HZ);
+  for (int k = 0; k < 20; k++){
+    for (uint32_t i = 0; i < 600; i++) ilc.sample(i * t.inc, 0.0f);
+    TEST_ASSERT_TRUE(ilc.endBeat());
+  }
+  TEST_ASSERT_EQUAL_INT16(0, ilc.correction(0));             // mid dead time around the wrap
+  TEST_ASSERT_EQUAL_INT16(0, ilc.correction(t.splitPhase));  // and around the flip
+  TEST_ASSERT_EQUAL_INT16(CFG.limit, ilc.correction(t.splitPhase / 2));       // FWD: more drive
+  TEST_ASSERT_EQUAL_INT16(-CFG.limit, ilc.correction(t.splitPhase + (0u - t.splitPhase) / 2));
+}
+
+void test_incomplete_beat_ignored(){
+  IlcTable ilc; float z[ILC_BINS]{}; ilc.setTarget(z);
+  ilc.sample(0, 10.0f);
+  TEST_ASSERT_FALSE(ilc.endBeat());
+  TEST_ASSERT_EQUAL_UINT32(0, ilc.beats());
+}
+
+void test_converges_60bpm(){
+  float first, last = converge(60, 40, &first);
+  TEST_ASSERT_TRUE(first > 5.0f);
+  TEST_ASSERT_TRUE(last < 0.25f * first);
+}
+
+void test_converges_120bpm(){
+  float first, last = converge(120, 40, &first);
+  TEST_ASSERT_TRUE(last < 0.35f * first);
+}
+
+void test_stays_bounded(){
+  float first, last = converge(60, 300, &first);
+  TEST_ASSERT_TRUE(last < 0.25f * first);                     // no slow divergence
+}
+
+static int run_tests(){
+  UNITY_BEGIN();
+  RUN_TEST(test_resample_and_bins);
+  RUN_TEST(test_dead_time_masked);
+  RUN_TEST(test_incomplete_beat_ignored);
+  RUN_TEST(test_converges_60bpm);
+  RUN_TEST(test_converges_120bpm);
+  RUN_TEST(test_stays_bounded);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup(){ delay(2000); run_tests(); }
+void loop(){}
+#else
+int main(int, char**){ return run_tests(); }
+#endif
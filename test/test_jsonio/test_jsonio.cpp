@@ -0,0 +1,129 @@
+#include <unity.h>
+#include <string.h>
+#include <stddef.h>
+#include "jsonio.h"
+
+// Host-runnable checks of the streaming JSON reader and the fixed-buffer writer: every
+// chunk split gives the same result, malformed input is rejected, binding into a struct,
+// and writer escaping/overflow (pio test -e native).
+
+// Flattens callbacks into "depth:key=value;" text for comparison
+struct Trace { char s[512]; size_t n; };
+static void trace_cb(void* ctx, uint8_t depth, const char* key, const JsonValue& v){
+  Trace& t = *(Trace*)ctx;
+  char val[80];
+  switch (v.type){
+    case JSON_NULL:   snprintf(val, sizeof(val), "null"); break;
+    case JSON_BOOL:   snprintf(val, sizeof(val), "%s", v.b ? "T" : "F"); break;
+    case JSON_NUM:    snprintf(val, sizeof(val), "%g", v.num); break;
+    case JSON_STR:    snprintf(val, sizeof(val), "'%s'", v.str); break;
+    case JSON_OBJECT: snprintf(val, sizeof(val), "{"); break;
+    case JSON_ARRAY:  snprintf(val, sizeof(val), "["); break;
+    case JSON_END:    snprintf(val, sizeof(val), "end"); break;
+  }
+  t.n += snprintf(t.s + t.n, sizeof(t.s) - t.n, "%u:%s=%s;", depth, key, val);
+}
+
+static const char* DOC = " {\"a\": -1.5e2, \"s\":\"x\\\"y\\u00e9\\n\", \"arr\":[1, true,null,{\"k\":false}], \"e\":{}, \"z\":[]} ";
+static const char* EXPECT =
+  "0:={;1:a=-150;1:s='x\"y\xc3\xa9\n';1:arr=[;2:=1;2:=T;2:=null;2:={;3:k=F;2:=end;1:=end;1:e={;1:=end;1:z=[;1:=end;0:=end;";
+
+void test_reader_any_split(){
+  const size_t n = strlen(DOC);
+  for (size_t cut1 = 0; cut1 <= n; cut1++){
+    for (size_t cut2 = cut1; cut2 <= n; cut2 += 7){
+      Trace t{}; JsonReader r; r.begin(trace_cb, &t);
+      r.feed(DOC, cut1);
+      r.feed(DOC + cut1, cut2 - cut1);
+      r.feed(DOC + cut2, n - cut2);
+      TEST_ASSERT_EQUAL_INT(JSON_DONE, r.finish());
+      TEST_ASSERT_EQUAL_STRING(EXPECT, t.s);
+    }
+  }
+  // a bare top-level number only completes at end of input
+  Trace t{}; JsonReader r; r.begin(trace_cb, &t);
+  TEST_ASSERT_EQUAL_INT(JSON_MORE, r.feed("42", 2));
+  TEST_ASSERT_EQUAL_INT(JSON_DONE, r.finish());
+  TEST_ASSERT_EQUAL_STRING("0:=42;", t.s);
+}
+
+void test_reader_rejects(){
+  static const char* bad[] = {
+    "{\"a\":1,}", "{\"a\" 1}", "[1 2]", "{\"a\":01.}", "{\"a\":-}", "{\"a\":1e}", "{\"a\":tru}", "{\"a\":\"x",
+    "{\"a\":1}x", "{\"a\":\"\\q\"}", "{\"a\":\"\x01\"}", "{a:1}", "[[[[[[[[[1]]]]]]]]]", "{\"a\":1]", "",
+    "{\"0123456789012345678901234\":1}",
+    "\"0123456789012345678901234567890123456789012345678901234567890123456789\"",
+  };
+  for (const char* s : bad){
+    JsonReader r; r.begin(nullptr, nullptr);
+    r.feed(s, strlen(s));
+    TEST_ASSERT_EQUAL_INT(JSON_ERROR, r.finish());
+  }
+}
+
+void test_bind(){
+  struct Body { float am, ab; int32_t n; bool on; char name[8]; } v{};
+  static const JsonField f[] = {
+    { "atr_m", JK_FLOAT, offsetof(Body, am), 0 }, { "atr_b", JK_FLOAT, offsetof(Body, ab), 0 },
+    { "n", JK_INT, offsetof(Body, n), 0 }, { "on", JK_BOOL, offsetof(Body, on), 0 },
+    { "name", JK_STR, offsetof(Body, name), sizeof(v.name) }, { "missing", JK_INT, offsetof(Body, n), 0 },
+  };
+  JsonBind b{ f, 6, &v, 0, 0, 0 };
+  const char* body = "{\"atr_m\":0.125,\"nested\":{\"n\":5},\"atr_b\":-177,\"n\":12.5,\"on\":true,\"name\":\"rig1\"}";
+  TEST_ASSERT_EQUAL_INT(JSON_DONE, json_bind(b, body, strlen(body)));
+  TEST_ASSERT_EQUAL_FLOAT(0.125f, v.am);
+  TEST_ASSERT_EQUAL_FLOAT(-177.0f, v.ab);
+  TEST_ASSERT_EQUAL_INT(0, v.n);                                  // nested "n" ignored, 12.5 not an int
+  TEST_ASSERT_TRUE(v.on);
+  TEST_ASSERT_EQUAL_STRING("rig1", v.name);
+  TEST_ASSERT_EQUAL_HEX32(0x1B, b.seen);
+  TEST_ASSERT_EQUAL_HEX32(0x04, b.bad);
+  TEST_ASSERT_EQUAL_UINT8(1, b.other);                            // "nested"
+
+  JsonBind b2{ f, 6, &v, 0, 0, 0 };
+  const char* longName = "{\"name\":\"too-long-name\"}";
+  TEST_ASSERT_EQUAL_INT(JSON_DONE, json_bind(b2, longName, strlen(longName)));
+  TEST_ASSERT_EQUAL_HEX32(0x10, b2.bad);
+  TEST_ASSERT_EQUAL_UINT8(0, b2.other);
+  TEST_ASSERT_EQUAL_STRING("rig1", v.name);
+}
+
+void test_writer(){
+  char buf[128]; JsonWriter w; w.begin(buf, sizeof(buf));
+  w.obj().kv("a", 1.25, 2).kv("n", -3).kv("u", 7u).kv("t", true).kv("s", "q\"\\\n\x01");
+  w.key("arr").arr().num(1).obj().end().arr().end().null().end();
+  w.key("e").obj().end();
+  w.end();
+  TEST_ASSERT_TRUE(w.ok());
+  TEST_ASSERT_EQUAL_STRING("{\"a\":1.25,\"n\":-3,\"u\":7,\"t\":true,\"s\":\"q\\\"\\\\\\n\\u0001\",\"arr\":[1,{},[],null],\"e\":{}}", buf);
+  TEST_ASSERT_EQUAL_UINT32(strlen(buf), w.len());
+
+  // the writer's output parses back
+  Trace t{}; JsonReader r; r.begin(trace_cb, &t);
+  r.feed(buf, w.len());
+  TEST_ASSERT_EQUAL_INT(JSON_DONE, r.finish());
+
+  char small[16]; w.begin(small, sizeof(small));
+  w.obj().kv("key", "a long value").end();
+  TEST_ASSERT_TRUE(w.overflow());
+  TEST_ASSERT_FALSE(w.ok());
+  TEST_ASSERT_EQUAL_UINT32(strlen(small), w.len());              // truncated but terminated
+  TEST_ASSERT_LESS_THAN(sizeof(small), w.len());
+}
+
+int run_tests(){
+  UNITY_BEGIN();
+  RUN_TEST(test_reader_any_split);
+  RUN_TEST(test_reader_rejects);
+  RUN_TEST(test_bind);
+  RUN_TEST(test_writer);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup(){ delay(2000); run_tests(); }
+void loop(){}
+#else
+int main(int, char**){ return run_tests(); }
+#endif
@@ -0,0 +1,112 @@
+#include <unity.h>
+#include <string.h>
+#include "logfmt.h"
+#include "crc.h"
+
+// Host-runnable round-trip and integrity checks of the flight-recorder block format and its
+// CRC (pio test -e native).
+
+static uint32_t s_rng = 7;
+static int32_t rnd(int32_t span){ s_rng = s_rng*1664525u + 1013904223u; return (int32_t)((s_rng >> 8) % (2*span + 1)) - span; }
+
+static const LogCal CAL{ 0.1227f, -177.81f, 0.1236f, -171.28f, 1.0f/23.6f, 0.0f };
+
+// Fill one block with a plausible run (noisy pressures, flow edges, a mode change, a gap)
+static uint16_t fill(LogBlockWriter& w, LogSample* ref, uint16_t max){
+  LogSample s; s.tick = 1000; s.atr = 1450; s.vent = 1700; s.state = log_state(0, 0, 2);
+  uint16_t n = 0;
+  while (n < max){
+    s.tick += (n == 500) ? 7 : 1;                           // dropped ticks survive
+    s.atr = (int16_t)(s.atr + rnd(6)); s.vent = (int16_t)(s.vent + rnd(12));
+    if (n % 5 == 0) s.edges++;
+    s.pwm = (uint8_t)((n / 50) % 2 ? 200 : 0);
+    if (n == 800) s.state = log_state(1, 0, 2);
+    if (n == 900) s.fault = 0x02;
+    if (!w.add(s)) break;
+    ref[n++] = s;
+  }
+  return n;
+}
+
+void test_crc32_reference(){
+  TEST_ASSERT_EQUAL_HEX32(0xCBF43926u, crc32("123456789", 9));
+  TEST_ASSERT_EQUAL_HEX32(crc32("123456789", 9), crc32_update(crc32("1234", 4), "56789", 5));
+}
+
+void test_round_trip(){
+  static LogSample ref[2000];
+  LogBlockWriter w; w.begin(42, 600, CAL, 123456);
+  uint16_t n = fill(w, ref, 2000);
+  TEST_ASSERT_TRUE(n > 900);                                // < 4.5 bytes per tick
+  const uint8_t* b = w.seal();
+  LogBlockReader r;
+  TEST_ASSERT_TRUE(r.open(b, LOG_BLOCK_BYTES));
+  TEST_ASSERT_EQUAL_UINT32(42, r.info().seq);
+  TEST_ASSERT_EQUAL_UINT16(n, r.info().count);
+  TEST_ASSERT_EQUAL_UINT32(ref[0].tick, r.info().firstTick);
+  TEST_ASSERT_EQUAL_UINT32(123456, r.info().tMs);
+  TEST_ASSERT_EQUAL_FLOAT(CAL.vent_m, r.info().cal.vent_m);
+  LogSample s; uint16_t k = 0;
+  while (r.next(s)){
+    TEST_ASSERT_EQUAL_UINT32(ref[k].tick, s.tick);
+    TEST_ASSERT_EQUAL_INT16(ref[k].atr, s.atr);
+    TEST_ASSERT_EQUAL_INT16(ref[k].vent, s.vent);
+    TEST_ASSERT_EQUAL_UINT32(ref[k].edges, s.edges);
+    TEST_ASSERT_EQUAL_UINT8(ref[k].pwm, s.pwm);
+    TEST_ASSERT_EQUAL_UINT8(ref[k].state, s.state);
+    TEST_ASSERT_EQUAL_UINT8(ref[k].fault, s.fault);
+    k++;
+  }
+  TEST_ASSERT_EQUAL_UINT16(n, k);
+}
+
+void test_full_block_rejects_and_restarts(){
+  static LogSample ref[2000];
+  LogBlockWriter w; w.begin(1, 600, CAL, 0);
+  uint16_t n = fill(w, ref, 2000);
+  LogSample extra = ref[n - 1]; extra.tick += 1; extra.atr = -30000;
+  TEST_ASSERT_FALSE(w.add(extra));                          // caller seals and starts a new block
+  w.seal(); w.begin(2, 600, CAL, 0);
+  TEST_ASSERT_TRUE(w.add(extra));
+  LogBlockReader r; LogSample s;
+  TEST_ASSERT_TRUE(r.open(w.seal(), LOG_BLOCK_BYTES));
+  TEST_ASSERT_TRUE(r.next(s));                              // each block decodes on its own
+  TEST_ASSERT_EQUAL_INT16(-30000, s.atr);
+  TEST_ASSERT_EQUAL_UINT32(extra.tick, s.tick);
+  TEST_ASSERT_FALSE(r.next(s));
+}
+
+void test_corruption_detected(){
+  static LogSample ref[100];
+  static uint8_t copy[LOG_BLOCK_BYTES];
+  LogBlockWriter w; w.begin(3, 600, CAL, 0);
+  fill(w, ref, 100);
+  memcpy(copy, w.seal(), LOG_BLOCK_BYTES);
+  LogBlockReader r;
+  TEST_ASSERT_TRUE(r.open(copy, LOG_BLOCK_BYTES));
+  copy[LOG_HDR_BYTES + 20] ^= 0x10;                         // payload bit flip
+  TEST_ASSERT_FALSE(r.open(copy, LOG_BLOCK_BYTES));
+  copy[LOG_HDR_BYTES + 20] ^= 0x10; copy[9] ^= 1;            // header bit flip
+  TEST_ASSERT_FALSE(r.open(copy, LOG_BLOCK_BYTES));
+  copy[9] ^= 1;
+  TEST_ASSERT_FALSE(r.open(copy, 100));                      // truncated
+  memset(copy, 0xFF, LOG_BLOCK_BYTES);                       // erased flash
+  TEST_ASSERT_FALSE(r.open(copy, LOG_BLOCK_BYTES));
+}
+
+static int run_tests(){
+  UNITY_BEGIN();
+  RUN_TEST(test_crc32_reference);
+  RUN_TEST(test_round_trip);
+  RUN_TEST(test_full_block_rejects_and_restarts);
+  RUN_TEST(test_corruption_detected);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup(){ delay(2000); run_tests(); }
+void loop(){}
+#else
+int main(int, char**){ return run_tests(); }
+#endif
@@ -0,0 +1,102 @@
+#include <unity.h>
+#include <stdlib.h>
+#include "motion.h"
+
+// Host-runnable checks for the PWM ramp generator (pio test -e native).
+
+static const uint32_t N = 90;   // RAMP_MS=150 @ 600 Hz
+
+// Run a ramp to completion; return how many ticks it stayed active and the largest
+// single-tick change of the output.
+static uint32_t run_ramp(MotionProfile& m, uint8_t target, uint32_t ticks, RampShape sh, int* maxStep){
+  m.start(target, ticks, sh);
+  uint32_t n = 0; int prev = m.value(), big = 0;
+  while (m.active()){ int v = m.step(); n++; if (abs(v-prev) > big) big = abs(v-prev); prev = v; }
+  if (maxStep) *maxStep = big;
+  return n;
+}
+
+void test_ms_to_ticks(){
+  TEST_ASSERT_EQUAL_UINT32(90, motion_ms_to_ticks(150, 600));
+  TEST_ASSERT_EQUAL_UINT32(60, motion_ms_to_ticks(100, 600));
+}
+
+void test_linear_exact_duration(){
+  MotionProfile m; m.reset(0);
+  m.start(255, N, RAMP_LINEAR);
+  for (uint32_t i=1;i<N;i++){ m.step(); TEST_ASSERT_TRUE(m.value() < 255); }
+  TEST_ASSERT_EQUAL_UINT8(255, m.step());
+  TEST_ASSERT_FALSE(m.active());
+}
+
+void test_scurve_exact_duration_all_lengths(){
+  // every length incl. non-multiples of 4 (coast ticks) and the <4 linear fallback
+  for (uint32_t t=1; t<=200; t++){
+    MotionProfile m; m.reset(10);
+    TEST_ASSERT_EQUAL_UINT32(t, run_ramp(m, 240, t, RAMP_SCURVE, nullptr));
+    TEST_ASSERT_EQUAL_UINT8(240, m.value());
+    TEST_ASSERT_EQUAL_UINT32(t, run_ramp(m, 0, t, RAMP_SCURVE, nullptr));
+    TEST_ASSERT_EQUAL_UINT8(0, m.value());
+  }
+}
+
+void test_scurve_monotonic_and_gentle(){
+  MotionProfile m; m.reset(0);
+  m.start(255, N, RAMP_SCURVE);
+  int prev = 0;
+  for (uint32_t i=0;i<N;i++){
+    int v = m.step();
+    TEST_ASSERT_TRUE(v >= prev);
+    if (i < 5) TEST_ASSERT_TRUE(v <= 1);           // starts with near-zero slope
+    prev = v;
+  }
+  // peak slope of the S-curve is 2x the linear average (255/90 ≈ 2.8 → ≤ 6 counts/tick)
+  int big = 0; m.reset(0); run_ramp(m, 255, N, RAMP_SCURVE, &big);
+  TEST_ASSERT_TRUE(big <= 6);
+}
+
+void test_scurve_symmetric(){
+  MotionProfile up, dn; up.reset(0); dn.reset(200);
+  up.start(200, N, RAMP_SCURVE); dn.start(0, N, RAMP_SCURVE);
+  for (uint32_t i=0;i<N;i++){
+    int a = up.step(), b = dn.step();
+    TEST_ASSERT_INT_WITHIN(1, 200, a + b);
+  }
+}
+
+void test_retarget_mid_ramp(){
+  MotionProfile m; m.reset(0);
+  m.start(200, N, RAMP_LINEAR);
+  for (int i=0;i<45;i++) m.step();
+  TEST_ASSERT_INT_WITHIN(1, 100, m.value());
+  // retarget restarts a full-duration ramp from the current position
+  TEST_ASSERT_EQUAL_UINT32(N, run_ramp(m, 50, N, RAMP_SCURVE, nullptr));
+  TEST_ASSERT_EQUAL_UINT8(50, m.value());
+}
+
+void test_zero_length_and_noop(){
+  MotionProfile m; m.reset(120);
+  m.start(120, N, RAMP_SCURVE); TEST_ASSERT_FALSE(m.active());
+  m.start(30, 0, RAMP_LINEAR);  TEST_ASSERT_FALSE(m.active());
+  TEST_ASSERT_EQUAL_UINT8(30, m.value());
+}
+
+static int run_tests(){
+  UNITY_BEGIN();
+  RUN_TEST(test_ms_to_ticks);
+  RUN_TEST(test_linear_exact_duration);
+  RUN_TEST(test_scurve_exact_duration_all_lengths);
+  RUN_TEST(test_scurve_monotonic_and_gentle);
+  RUN_TEST(test_scurve_symmetric);
+  RUN_TEST(test_retarget_mid_ramp);
+  RUN_TEST(test_zero_length_and_noop);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup(){ delay(2000); run_tests(); }
+void loop(){}
+#else
+int main(int, char**){ return run_tests(); }
+#endif
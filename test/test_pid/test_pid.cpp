@@ -0,0 +1,137 @@
+#include <unity.h>
+#include <math.h>
+#include "pid.h"
+#include "beat.h"
+#include "../sim_plant.h"
+
+// Host-runnable tuning checks for the pressure loop against a simulated ventricle
+// (pio test -e native). Gains and feed-forward mirror the app_config defaults.
+
+static const float HZ = 600.0f, DT = 1.0f / 600.0f;
+static const PidGains TICK{ 4.0f, 16.0f, 0.0f };
+static const PidGains BEAT{ 0.6f, 0.6f, 0.0f };
+static int32_t ff(float mmHg){ return pid_q16(1.25f * mmHg + 40.0f); }   // assumes gain 0.8
+
+struct Run { float settleS, overshoot, final; };
+
+// Regulate toward target for secs; settle = last time the error left ±tol
+static Run regulate(PidQ& pid, SimPlant& pl, float& meas, float target, float secs, float tol){
+  Run r{0, 0, 0};
+  for (uint32_t i = 0; i < (uint32_t)(secs * HZ); i++){
+    int32_t u = pid.step(pid_q8(target), pid_q8(meas), ff(target));
+    meas = pl.step((float)((u + 0x8000) >> 16), 0, DT);
+    if (fabsf(pl.p - target) > tol) r.settleS = (i + 1) * DT;
+    if (pl.p - target > r.overshoot) r.overshoot = pl.p - target;
+  }
+  r.final = pl.p;
+  return r;
+}
+
+void test_fixed_point_matches_float(){
+  PidQ pid; pid.configure(PidGains{2.0f, 3.0f, 0.01f}, DT, 0, 255);
+  float integ = 0, prev = 10.0f;
+  pid.reset(0, pid_q8(10.0f), pid_q8(10.0f), 0);
+  for (int i = 0; i < 2000; i++){
+    float sp = 50.0f, meas = 10.0f + 35.0f * (1.0f - expf(-i / 300.0f)) + 2.0f * sinf(i * 0.05f);
+    float e = sp - meas;
+    integ += 3.0f * DT * e;
+    float u = 2.0f * e + integ - 0.01f / DT * (meas - prev); prev = meas;
+    u = u < 0 ? 0 : (u > 255 ? 255 : u);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, u, pid_from_q16(pid.step(pid_q8(sp), pid_q8(meas), 0)));
+  }
+}
+
+void test_step_settles_with_model_error(){
+  // the plant is 20% weaker than the feed-forward assumes; the integrator closes the gap
+  SimPlant pl; pl.gain = 0.64f; float meas = 0;
+  PidQ pid; pid.configure(TICK, DT, 0, 255); pid.reset(0, pid_q8(80), 0, ff(80));
+  Run r = regulate(pid, pl, meas, 80.0f, 3.0f, 2.0f);
+  TEST_ASSERT_TRUE(r.settleS < 1.0f);
+  TEST_ASSERT_TRUE(r.overshoot < 6.0f);
+  TEST_ASSERT_FLOAT_WITHIN(1.0f, 80.0f, r.final);
+}
+
+void test_setpoint_change_tracks(){
+  SimPlant pl; float meas = 0;
+  PidQ pid; pid.configure(TICK, DT, 0, 255); pid.reset(0, pid_q8(60), 0, ff(60));
+  regulate(pid, pl, meas, 60.0f, 2.0f, 2.0f);
+  Run r = regulate(pid, pl, meas, 100.0f, 3.0f, 2.0f);
+  TEST_ASSERT_TRUE(r.settleS < 1.0f);
+  TEST_ASSERT_FLOAT_WITHIN(1.0f, 100.0f, r.final);
+}
+
+void test_anti_windup_recovers_from_saturation(){
+  // PWM ceiling 100 → plant tops out at 48 mmHg; ask for 120 for 5 s, then drop to 30
+  SimPlant pl; float meas = 0;
+  PidQ pid; pid.configure(TICK, DT, 0, 255); pid.setLimits(0, pid_q16(100)); pid.reset(0, pid_q8(120), 0, ff(120));
+  regulate(pid, pl, meas, 120.0f, 5.0f, 2.0f);
+  TEST_ASSERT_EQUAL_INT32(pid_q16(100), pid.output());
+  TEST_ASSERT_TRUE(pid.integrator() <= 0);       // ff alone saturates; nothing wound up
+  Run r = regulate(pid, pl, meas, 30.0f, 3.0f, 2.0f);
+  TEST_ASSERT_TRUE(r.settleS < 1.2f);
+  TEST_ASSERT_FLOAT_WITHIN(1.0f, 30.0f, r.final);
+}
+
+void test_bumpless_reset(){
+  PidQ pid; pid.configure(TICK, DT, 0, 255);
+  pid.reset(pid_q16(150), pid_q8(70), pid_q8(65), ff(70));
+  int32_t u = pid.step(pid_q8(70), pid_q8(65), ff(70));
+  TEST_ASSERT_INT32_WITHIN(pid_q16(0.5f), pid_q16(150), u);   // only one tick of I
+}
+
+void test_out_of_range_gains_saturate(){
+  // kp·2^16, kd/dt·2^16 and a per-beat ki·2^24 all past int32, and a NaN: the output stays
+  // inside the limits and finite gains still push the right way
+  PidQ pid; pid.configure(PidGains{ 1e6f, 1e6f, 1e6f }, DT, 0, 255);
+  TEST_ASSERT_EQUAL_INT32(pid_q16(255), pid.step(pid_q8(80), pid_q8(40), 0));
+  TEST_ASSERT_EQUAL_INT32(0, pid.step(pid_q8(40), pid_q8(80), 0));
+  PidQ beat; beat.configure(PidGains{ 0.0f, 1000.0f, 0.0f }, 1.0f, 0, 255);
+  TEST_ASSERT_EQUAL_INT32(pid_q16(255), beat.step(pid_q8(80), pid_q8(78), 0));
+  PidQ nan; nan.configure(PidGains{ NAN, NAN, NAN }, DT, 0, 255);
+  TEST_ASSERT_EQUAL_INT32(pid_q16(100), nan.step(pid_q8(80), pid_q8(40), pid_q16(100)));   // ff only
+}
+
+void test_beat_peak_tracking(){
+  // 60 BPM trapezoid: the chamber never reaches steady state within a stroke, so the
+  // feed-forward alone undershoots; one PID update per beat steers the peak to target.
+  BeatEngine be; BeatShape sh; be.prepare(sh, BeatTiming{60, 600, 150, 100}); be.restart();
+  SimPlant pl; float meas = 0;
+  const float target = 90.0f;
+  PidQ pid; pid.configure(BEAT, 1.0f, 0, 255); pid.reset(ff(target), pid_q8(target), 0, ff(target));
+  int32_t drive = ff(target);
+  float peak = 0, firstPeak = -1, lastPeak = 0; uint32_t prevPhase = 0;
+  for (int beat = 0; beat < 30; ){
+    BeatOut o = be.step();
+    if (be.phase() < prevPhase){           // wrap → beat complete
+      if (firstPeak < 0) firstPeak = peak;
+      drive = pid.step(pid_q8(target), pid_q8(peak), ff(target));
+      lastPeak = peak; peak = 0; beat++;
+    }
+    prevPhase = be.phase();
+    float pwm = (float)o.level * (float)((drive + 0x8000) >> 16) / 255.0f;
+    meas = pl.step(pwm, o.valve, DT);
+    if (meas > peak) peak = meas;
+  }
+  TEST_ASSERT_TRUE(firstPeak < target - 5.0f);   // open loop misses
+  TEST_ASSERT_FLOAT_WITHIN(2.0f, target, lastPeak);
+}
+
+static int run_tests(){
+  UNITY_BEGIN();
+  RUN_TEST(test_fixed_point_matches_float);
+  RUN_TEST(test_step_settles_with_model_error);
+  RUN_TEST(test_setpoint_change_tracks);
+  RUN_TEST(test_anti_windup_recovers_from_saturation);
+  RUN_TEST(test_bumpless_reset);
+  RUN_TEST(test_out_of_range_gains_saturate);
+  RUN_TEST(test_beat_peak_tracking);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup(){ delay(2000); run_tests(); }
+void loop(){}
+#else
+int main(int, char**){ return run_tests(); }
+#endif
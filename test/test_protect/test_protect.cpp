@@ -0,0 +1,131 @@
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include "protect.h"
+#include "sim_plant.h"
+
+// Host-runnable checks of the protection layer, driven by the simulated ventricle for trip
+// latency (pio test -e native). Raw counts use the default vent calibration.
+
+static const uint32_t HZ = 600;
+static const float DT = 1.0f / HZ;
+static const float M = 0.1236f, B = -171.28f;
+
+static int32_t counts(float mmHg){ return (int32_t)lroundf((mmHg - B) / M); }
+
+static Protection make(const ProtectCfg& c){
+  Protection p; p.configure(c);
+  for (uint8_t ch = 0; ch < PROT_CH; ch++) p.setCal(ch, M, B);
+  return p;
+}
+
+// Simulated run: pump at pwm, a flow edge every edgeEvery ticks while moving fluid; kinkAt
+// multiplies the chamber gain (outflow occluded) and stops flow. Returns the trip tick or -1.
+struct Run { int32_t tripTick = -1, firstOver = -1; uint8_t fault = 0; float peak = 0; };
+static Run simulate(Protection& p, uint8_t pwm, uint32_t ticks, int32_t kinkAt, float overMmHg){
+  SimPlant plant; Run r; uint32_t edges = 0; uint8_t out = pwm;
+  for (uint32_t t = 0; t < ticks; t++){
+    if ((int32_t)t == kinkAt) plant.gain *= 3.0f;
+    plant.step(out, 0, DT);
+    bool kinked = kinkAt >= 0 && (int32_t)t >= kinkAt;
+    if (!kinked && out > plant.deadband && t % 4 == 0) edges++;
+    if (plant.p > r.peak) r.peak = plant.p;
+    if (r.firstOver < 0 && plant.p >= overMmHg) r.firstOver = (int32_t)t;
+    int32_t raw[PROT_CH] = { counts(plant.raw * 0.2f), counts(plant.raw) };   // atrium follows weakly
+    uint8_t f = p.step(raw, out, edges);
+    if (f && r.tripTick < 0){ r.tripTick = (int32_t)t; r.fault = f; out = 0; }   // outputs off this tick
+  }
+  return r;
+}
+
+void test_no_false_trip_at_steady_drive(){
+  ProtectCfg c; Protection p = make(c);
+  Run r = simulate(p, 240, 10 * HZ, -1, c.overMmHg);             // ≈ 160 mmHg with noise
+  TEST_ASSERT_EQUAL_INT32(-1, r.tripTick);
+  TEST_ASSERT_EQUAL_UINT8(0, p.latched());
+}
+
+void test_kink_trips_within_debounce(){
+  ProtectCfg c; Protection p = make(c);
+  Run r = simulate(p, 240, 6 * HZ, 2 * HZ, c.overMmHg);
+  TEST_ASSERT_TRUE(r.tripTick >= 0);
+  TEST_ASSERT_EQUAL_UINT8(PF_OVER_VENT, r.fault);
+  TEST_ASSERT_EQUAL_UINT32(c.debounceTicks, p.latencyTicks());
+  int32_t lat = r.tripTick - r.firstOver;                        // vs the true pressure crossing
+  char msg[64]; snprintf(msg, sizeof(msg), "trip latency %ld ticks (%.2f ms)", (long)lat, lat * 1000.0 / HZ);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_TRUE(lat >= 0 && lat <= c.debounceTicks + 2);      // ±0.5 mmHg noise at the edge
+  TEST_ASSERT_TRUE(r.peak < c.overMmHg + 5.0f);                  // pressure stops rising at once
+  TEST_ASSERT_EQUAL_UINT8(PF_OVER_VENT, p.latched());
+  TEST_ASSERT_TRUE(p.clear());                                   // pressure has decayed since
+  TEST_ASSERT_EQUAL_UINT8(0, p.latched());
+}
+
+void test_hysteresis_debounce_and_clear(){
+  ProtectCfg c; c.debounceTicks = 4; Protection p = make(c);
+  const int32_t on = counts(c.overMmHg), band = counts(c.overMmHg - 5.0f), in = counts(100.0f);
+  int32_t raw[PROT_CH] = { in, on };
+  // beyond / in-band alternating: the band holds the count, so 4 beyond samples trip
+  uint8_t f = 0;
+  for (int i = 0; i < 3; i++){ raw[1] = on; f |= p.step(raw, 0, 0); raw[1] = band; f |= p.step(raw, 0, 0); }
+  TEST_ASSERT_EQUAL_UINT8(0, f);
+  raw[1] = on; TEST_ASSERT_EQUAL_UINT8(PF_OVER_VENT, p.step(raw, 0, 0));
+  TEST_ASSERT_EQUAL_UINT8(0, p.step(raw, 0, 0));                 // reported once
+  raw[1] = band; p.step(raw, 0, 0);
+  TEST_ASSERT_FALSE(p.clear());                                  // not back inside yet
+  raw[1] = in; p.step(raw, 0, 0);
+  TEST_ASSERT_TRUE(p.clear());
+  // a sample inside resets the debounce count
+  for (int i = 0; i < 10; i++){ raw[1] = i % 3 == 2 ? in : on; TEST_ASSERT_EQUAL_UINT8(0, p.step(raw, 0, 0)); }
+  TEST_ASSERT_EQUAL_UINT32(1, p.trips());
+}
+
+void test_no_flow_while_driving(){
+  ProtectCfg c; c.noFlowTicks = 300; Protection p = make(c);
+  int32_t raw[PROT_CH] = { counts(5.0f), counts(60.0f) };
+  uint32_t e = 0;
+  // beat-like drive with a few edges per stroke never trips; idle gaps do not count
+  for (uint32_t t = 0; t < 20 * HZ; t++){
+    bool stroke = (t % 600) < 250;
+    if (stroke && t % 600 == 200) e++;
+    TEST_ASSERT_EQUAL_UINT8(0, p.step(raw, stroke ? 200 : 0, e));
+  }
+  // edges stop while driving: trips after exactly noFlowTicks
+  uint32_t t = 0; uint8_t f = 0;
+  while (!f && t < 1000){ f = p.step(raw, 200, e); t++; }
+  TEST_ASSERT_EQUAL_UINT8(PF_NO_FLOW, f);
+  TEST_ASSERT_TRUE(t <= c.noFlowTicks);
+  TEST_ASSERT_TRUE(p.clear());
+}
+
+void test_under_pressure_negative_slope(){
+  ProtectCfg c; Protection p; p.configure(c);
+  p.setCal(PROT_ATR, -0.1f, 300.0f); p.setCal(PROT_VENT, M, B);   // inverted sensor on the atrium
+  int32_t raw[PROT_CH] = { (int32_t)lroundf((100.0f - 300.0f) / -0.1f), counts(100.0f) };
+  for (int i = 0; i < 10; i++) TEST_ASSERT_EQUAL_UINT8(0, p.step(raw, 0, 0));
+  raw[PROT_ATR] = (int32_t)lroundf((-60.0f - 300.0f) / -0.1f);   // −60 mmHg = more counts
+  uint8_t f = 0; for (int i = 0; i < 3; i++) f |= p.step(raw, 0, 0);
+  TEST_ASSERT_EQUAL_UINT8(PF_UNDER_ATR, f);
+  raw[PROT_ATR] = (int32_t)lroundf((250.0f - 300.0f) / -0.1f);
+  f = 0; for (int i = 0; i < 3; i++) f |= p.step(raw, 0, 0);
+  TEST_ASSERT_EQUAL_UINT8(PF_OVER_ATR, f);
+  TEST_ASSERT_EQUAL_UINT8(PF_UNDER_ATR | PF_OVER_ATR, p.latched());
+}
+
+static int run_tests(){
+  UNITY_BEGIN();
+  RUN_TEST(test_no_false_trip_at_steady_drive);
+  RUN_TEST(test_kink_trips_within_debounce);
+  RUN_TEST(test_hysteresis_debounce_and_clear);
+  RUN_TEST(test_no_flow_while_driving);
+  RUN_TEST(test_under_pressure_negative_slope);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup(){ delay(2000); run_tests(); }
+void loop(){}
+#else
+int main(int, char**){ return run_tests(); }
+#endif
@@ -0,0 +1,95 @@
+#include <unity.h>
+#include <string.h>
+#include "protocol.h"
+
+// Host-runnable checks for the protocol parser and runner (pio test -e native).
+
+static const ProtoLimits LIM{600, 1, 200};
+
+static bool parse(const char* txt, Protocol& p, ProtoError& e){ return protocol_parse(txt, strlen(txt), LIM, p, e); }
+
+void test_parse_basic(){
+  Protocol p; ProtoError e{};
+  TEST_ASSERT_TRUE(parse("# warmup\nfwd 180 10s\nbeat 200 90 1.5m ; rev 120 500ms\npause 2\n", p, e));
+  TEST_ASSERT_EQUAL_UINT8(4, p.n);
+  TEST_ASSERT_EQUAL_UINT8(PROTO_SEG, p.step[0].op);
+  TEST_ASSERT_EQUAL_UINT32(6000, p.step[0].ticks);
+  TEST_ASSERT_EQUAL_UINT8(2, p.step[1].mode);
+  TEST_ASSERT_EQUAL_UINT16(90, p.step[1].bpm);
+  TEST_ASSERT_EQUAL_UINT32(54000, p.step[1].ticks);
+  TEST_ASSERT_EQUAL_UINT8(1, p.step[2].mode);
+  TEST_ASSERT_EQUAL_UINT32(300, p.step[2].ticks);
+  TEST_ASSERT_EQUAL_UINT8(PROTO_PAUSE, p.step[3].op);
+  TEST_ASSERT_EQUAL_UINT32(1200, p.step[3].ticks);
+}
+
+void test_parse_errors(){
+  Protocol p; ProtoError e{};
+  TEST_ASSERT_FALSE(parse("fwd 180 10s\nfwd 300 1s\n", p, e));
+  TEST_ASSERT_EQUAL_UINT16(2, e.line);
+  TEST_ASSERT_FALSE(parse("beat 100 250 10s", p, e));      // bpm range
+  TEST_ASSERT_FALSE(parse("fwd 100 10x", p, e));           // unit
+  TEST_ASSERT_FALSE(parse("loop 2\nfwd 100 1s\n", p, e));  // unterminated
+  TEST_ASSERT_FALSE(parse("end", p, e));
+  TEST_ASSERT_FALSE(parse("loop 2\nend", p, e));           // empty loop
+  TEST_ASSERT_FALSE(parse("# nothing\n", p, e));
+  TEST_ASSERT_FALSE(parse("jump 1", p, e));
+}
+
+void test_total_ticks_with_nested_loops(){
+  Protocol p; ProtoError e{};
+  TEST_ASSERT_TRUE(parse("fwd 100 1s\nloop 3\n beat 150 60 2s\n loop 2\n  pause 500ms\n end\nend\nrev 90 1s", p, e));
+  // 600 + 3*(1200 + 2*300) + 600
+  TEST_ASSERT_EQUAL_UINT32(600 + 3*(1200 + 600) + 600, (uint32_t)protocol_total_ticks(p));
+}
+
+void test_runner_tick_exact(){
+  Protocol p; ProtoError e{};
+  TEST_ASSERT_TRUE(parse("fwd 100 10ms; loop 2; beat 150 60 20ms; end; rev 90 5ms", p, e));
+  // 10ms=6 ticks, 20ms=12, 5ms=3 → enter at ticks 1, 7, 19, 31; done at 34
+  ProtoRunner r; r.start(&p);
+  uint32_t enters[8]; uint8_t ne = 0; uint32_t doneAt = 0;
+  for (uint32_t t=1; t<100 && !doneAt; t++){
+    ProtoStep seg; ProtoEvent ev = r.tick(seg);
+    if (ev == PROTO_ENTER) enters[ne++] = t;
+    if (ev == PROTO_DONE) doneAt = t;
+  }
+  TEST_ASSERT_EQUAL_UINT8(4, ne);
+  TEST_ASSERT_EQUAL_UINT32(1, enters[0]);
+  TEST_ASSERT_EQUAL_UINT32(7, enters[1]);
+  TEST_ASSERT_EQUAL_UINT32(19, enters[2]);
+  TEST_ASSERT_EQUAL_UINT32(31, enters[3]);
+  TEST_ASSERT_EQUAL_UINT32(34, doneAt);
+  TEST_ASSERT_FALSE(r.running());
+  TEST_ASSERT_EQUAL_UINT32(33, (uint32_t)r.elapsed());
+  TEST_ASSERT_EQUAL_UINT32(33, (uint32_t)r.total());
+}
+
+void test_runner_progress(){
+  Protocol p; ProtoError e{};
+  TEST_ASSERT_TRUE(parse("loop 3\nfwd 100 1s\nend", p, e));
+  ProtoRunner r; r.start(&p); ProtoStep seg;
+  for (int i=0;i<600;i++) r.tick(seg);
+  TEST_ASSERT_EQUAL_UINT16(1, r.iteration());
+  r.tick(seg);
+  TEST_ASSERT_EQUAL_UINT16(2, r.iteration());
+  TEST_ASSERT_EQUAL_UINT8(1, r.stepIndex());
+}
+
+static int run_tests(){
+  UNITY_BEGIN();
+  RUN_TEST(test_parse_basic);
+  RUN_TEST(test_parse_errors);
+  RUN_TEST(test_total_ticks_with_nested_loops);
+  RUN_TEST(test_runner_tick_exact);
+  RUN_TEST(test_runner_progress);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup(){ delay(2000); run_tests(); }
+void loop(){}
+#else
+int main(int, char**){ return run_tests(); }
+#endif
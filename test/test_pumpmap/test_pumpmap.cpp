@@ -0,0 +1,118 @@
+#include <unity.h>
+#include <math.h>
+#include "pumpmap.h"
+
+// Host-runnable checks for the PWM→flow table and the characterization sweep
+// (pio test -e native). The simulated pump has a dead band, a curved response, a weaker
+// reverse direction, first-order lag, sensor noise and a flow estimate that only refreshes
+// every 50 ms like the windowed edge counter.
+
+static float true_flow(uint8_t valve, float pwm){
+  if (pwm <= 35) return 0;
+  float f = 7.0f * powf((pwm - 35) / 220.0f, 0.8f);
+  return valve ? 0.8f * f : f;
+}
+
+struct SimPump {
+  float q = 0, held = 0; uint32_t n = 0, rng = 777;
+  float step(float pwm, uint8_t valve){
+    q += (true_flow(valve, pwm) - q) * (1.0f / 600.0f / 0.3f);
+    if (++n % 30 == 0){
+      rng = rng * 1664525u + 1013904223u;
+      held = q + ((int32_t)(rng >> 24) - 128) / 128.0f * 0.02f;   // ±0.02 L/min
+      if (held < 0) held = 0;
+    }
+    return held;
+  }
+};
+
+static const SweepCfg CFG{ 480, 300, 3000, 0.05f, 0.02f };   // 0.8 s, 0.5 s, 5 s @ 600 Hz
+
+void test_monotonic_pava(){
+  float y[PUMPMAP_N] = { -0.1f, 0, 0.2f, 0.1f, 0.6f, 0.5f, 0.4f, 1.0f, 1.2f, 1.1f, 1.5f, 2, 2.5f, 3, 3.5f, 4 };
+  pumpmap_monotonic(y, PUMPMAP_N);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, y[0]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, 0.15f, y[2]); TEST_ASSERT_FLOAT_WITHIN(1e-5f, 0.15f, y[3]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, 0.5f, y[4]);  TEST_ASSERT_FLOAT_WITHIN(1e-5f, 0.5f, y[6]);
+  for (uint8_t i = 1; i < PUMPMAP_N; i++) TEST_ASSERT_TRUE(y[i] >= y[i-1]);
+}
+
+void test_inverse_roundtrip(){
+  PumpMap m; pumpmap_default(m, 6.0f, 40);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, pumpmap_pwm_for(m, 0, 0.0f));
+  TEST_ASSERT_EQUAL_FLOAT(255.0f, pumpmap_pwm_for(m, 0, 9.0f));
+  for (float l = 0.1f; l < 6.0f; l += 0.37f){
+    float p = pumpmap_pwm_for(m, 0, l);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, l, pumpmap_flow(m, 0, p));
+  }
+  // smallest flow starts just past the dead band instead of at PWM 0
+  TEST_ASSERT_TRUE(pumpmap_pwm_for(m, 0, 0.01f) > 34.0f);
+}
+
+void test_sweep_builds_accurate_map(){
+  PumpSweep sw; sw.start(CFG);
+  SimPump pump; SweepOut o{0, 0};
+  float flow = 0; uint8_t lastValve = 0; uint32_t ticks = 0;
+  SweepEvent ev = SWEEP_RUN;
+  while (ev != SWEEP_DONE && ticks < 600u * 400u){
+    ev = sw.tick(flow, o);
+    if (o.valve != lastValve){ TEST_ASSERT_EQUAL_UINT8(0, o.pwm); lastValve = o.valve; }
+    flow = pump.step(o.pwm, o.valve);
+    ticks++;
+  }
+  TEST_ASSERT_EQUAL(SWEEP_DONE, ev);
+  TEST_ASSERT_FALSE(sw.running());
+  TEST_ASSERT_TRUE(ticks < 600u * 60u);                 // settles well before the timeouts
+  const PumpMap& m = sw.result();
+  TEST_ASSERT_EQUAL_UINT8(1, m.measured);
+  TEST_ASSERT_EQUAL_UINT8(0, m.timeouts);
+  for (uint8_t d = 0; d < 2; d++)
+    for (uint8_t i = 0; i < PUMPMAP_N; i++){
+      TEST_ASSERT_FLOAT_WITHIN(0.12f, true_flow(d, pumpmap_pwm(i)), m.lpm[d][i]);
+      if (i) TEST_ASSERT_TRUE(m.lpm[d][i] >= m.lpm[d][i-1]);
+    }
+  // feed-forward from the measured map lands within 0.15 L/min of a requested flow
+  for (float l = 0.5f; l < 5.5f; l += 0.5f)
+    TEST_ASSERT_FLOAT_WITHIN(0.15f, l, true_flow(0, pumpmap_pwm_for(m, 0, l)));
+}
+
+void test_sweep_times_out_on_noisy_flow(){
+  PumpSweep sw; sw.start(CFG);
+  SweepOut o{0, 0}; uint32_t rng = 1, ticks = 0;
+  while (sw.running() && ticks < 600u * 400u){
+    rng = rng * 1664525u + 1013904223u;
+    sw.tick(1.0f + (rng >> 31), o);                      // 1 or 2 L/min, never quiet
+    ticks++;
+  }
+  TEST_ASSERT_FALSE(sw.running());
+  TEST_ASSERT_EQUAL_UINT8(2 * PUMPMAP_N, sw.result().timeouts);
+}
+
+void test_sweep_stop_and_progress(){
+  PumpSweep sw; SweepOut o{0, 0};
+  TEST_ASSERT_EQUAL(SWEEP_IDLE, sw.tick(0, o));
+  sw.start(CFG);
+  TEST_ASSERT_EQUAL_UINT8(0, sw.progressPct());
+  for (int i = 0; i < 2000; i++) sw.tick(0, o);          // zero flow settles immediately
+  TEST_ASSERT_TRUE(sw.progressPct() > 0);
+  sw.stop();
+  TEST_ASSERT_EQUAL(SWEEP_IDLE, sw.tick(0, o));
+}
+
+static int run_tests(){
+  UNITY_BEGIN();
+  RUN_TEST(test_monotonic_pava);
+  RUN_TEST(test_inverse_roundtrip);
+  RUN_TEST(test_sweep_builds_accurate_map);
+  RUN_TEST(test_sweep_times_out_on_noisy_flow);
+  RUN_TEST(test_sweep_stop_and_progress);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup(){ delay(2000); run_tests(); }
+void loop(){}
+#else
+int main(int, char**){ return run_tests(); }
+#endif
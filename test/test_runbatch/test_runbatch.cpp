@@ -0,0 +1,180 @@
+#include <unity.h>
+#include <string.h>
+#include "runbatch.h"
+
+// Host-runnable checks of the compound run-state command: body validation, the plan rules,
+// and a tick model of control_task showing a batch never exposes a half-applied state to the
+// outputs (pio test -e native).
+
+static const BatchLimits LIM{ 4, 1, 200, 180.0f, 7.5f };
+static const char* s_field;
+static BatchErr parse(const char* s, RunBatch& b){ return batch_parse(s, strlen(s), LIM, b, &s_field); }
+
+// What one tick computes its outputs from (after the command loop, as in control_task)
+struct Out { int32_t mode, pwm, bpm; bool rev; };
+static bool same(const Out& a, const Out& b){ return a.mode == b.mode && a.pwm == b.pwm && a.bpm == b.bpm && a.rev == b.rev; }
+
+struct TickModel {
+  RunState s;
+  uint8_t  seq = 0;             // ticks left in the direction-change seq
+  uint32_t seqStarts = 0, rebuilds = 0;
+  Out      written[64];
+  uint8_t  n = 0;
+
+  void tick(const RunBatch* cmds, uint8_t nCmds){
+    for (uint8_t i = 0; i < nCmds; i++){
+      const uint8_t act = batch_plan(cmds[i], s);
+      if (act & BA_SEQ){ seq = 6; seqStarts++; }
+      if (act & BA_REBUILD_BEAT) rebuilds++;
+    }
+    const bool rev = s.mode == 1 || (s.mode == BATCH_MODE_FLOW && s.flow < 0);
+    written[n++] = Out{ s.mode, s.pwm, s.bpm, rev };
+    if (seq) seq--;
+  }
+};
+
+static RunState running(int32_t mode, int32_t pwm, int32_t bpm, float flow){
+  RunState s; s.mode = mode; s.pwm = pwm; s.bpm = bpm; s.flow = flow; s.paused = 0; return s;
+}
+
+void test_parse(){
+  RunBatch b;
+  TEST_ASSERT_EQUAL_INT(BATCH_OK, parse("{\"mode\":2,\"pwm\":180,\"bpm\":60,\"press\":90.5,\"pressBeat\":true,\"flow\":-3.5,\"run\":true}", b));
+  TEST_ASSERT_EQUAL_HEX8(0x7F, b.has);
+  TEST_ASSERT_EQUAL_INT(2, b.mode); TEST_ASSERT_EQUAL_INT(180, b.pwm); TEST_ASSERT_EQUAL_INT(60, b.bpm);
+  TEST_ASSERT_EQUAL_FLOAT(90.5f, b.press); TEST_ASSERT_EQUAL_FLOAT(-3.5f, b.flow);
+  TEST_ASSERT_TRUE(b.pressBeat); TEST_ASSERT_TRUE(b.run);
+
+  TEST_ASSERT_EQUAL_INT(BATCH_OK, parse("{\"run\":false}", b));
+  TEST_ASSERT_EQUAL_HEX8(RB_RUN, b.has); TEST_ASSERT_FALSE(b.run);
+
+  // the same body fed in two-byte chunks through the bind table
+  const char* body = "{\"pwm\":90,\"mode\":4,\"flow\":2.25}";
+  RunBatch c; JsonBind bind{ BATCH_FIELDS, BATCH_NFIELDS, &c, 0, 0, 0 };
+  JsonReader r; r.begin(json_bind_cb, &bind);
+  for (size_t i = 0; i < strlen(body); i += 2) r.feed(body + i, strlen(body) - i < 2 ? 1 : 2);
+  TEST_ASSERT_EQUAL_INT(BATCH_OK, batch_check(r.finish(), bind, LIM, c, &s_field));
+  TEST_ASSERT_EQUAL_HEX8(RB_PWM | RB_MODE | RB_FLOW, c.has);
+  TEST_ASSERT_EQUAL_INT(90, c.pwm); TEST_ASSERT_EQUAL_INT(4, c.mode); TEST_ASSERT_EQUAL_FLOAT(2.25f, c.flow);
+}
+
+void test_parse_rejects(){
+  RunBatch b;
+  TEST_ASSERT_EQUAL_INT(BATCH_EMPTY, parse("{}", b));
+  TEST_ASSERT_EQUAL_INT(BATCH_BAD_JSON, parse("{\"pwm\":1", b));
+  TEST_ASSERT_EQUAL_INT(BATCH_UNKNOWN_KEY, parse("{\"pwm\":1,\"pmw\":2}", b));
+  TEST_ASSERT_EQUAL_INT(BATCH_BAD_JSON, parse("{\"pwm\":12.5}", b));
+  TEST_ASSERT_EQUAL_STRING("pwm", s_field);
+  TEST_ASSERT_EQUAL_INT(BATCH_BAD_JSON, parse("{\"run\":1}", b));
+  TEST_ASSERT_EQUAL_STRING("run", s_field);
+
+  // out of range is an error, not a clamp; the first offending field is named
+  TEST_ASSERT_EQUAL_INT(BATCH_RANGE, parse("{\"pwm\":256}", b));          TEST_ASSERT_EQUAL_STRING("pwm", s_field);
+  TEST_ASSERT_EQUAL_INT(BATCH_RANGE, parse("{\"mode\":5,\"bpm\":0}", b));  TEST_ASSERT_EQUAL_STRING("mode", s_field);
+  TEST_ASSERT_EQUAL_INT(BATCH_RANGE, parse("{\"bpm\":201}", b));          TEST_ASSERT_EQUAL_STRING("bpm", s_field);
+  TEST_ASSERT_EQUAL_INT(BATCH_RANGE, parse("{\"press\":-1}", b));         TEST_ASSERT_EQUAL_STRING("press", s_field);
+  TEST_ASSERT_EQUAL_INT(BATCH_RANGE, parse("{\"flow\":-7.6}", b));        TEST_ASSERT_EQUAL_STRING("flow", s_field);
+  TEST_ASSERT_EQUAL_INT(BATCH_OK, parse("{\"flow\":-7.5,\"bpm\":1,\"mode\":0,\"pwm\":0}", b));
+}
+
+void test_plan_rules(){
+  RunBatch b;
+  // from a full pause: opens directly in the new mode, no seq
+  RunState s; s.mode = 0; s.pwm = 100; s.bpm = 30;
+  parse("{\"mode\":2,\"bpm\":60,\"run\":true}", b);
+  TEST_ASSERT_EQUAL_HEX8(BA_UNPAUSE | BA_REBUILD_BEAT, batch_plan(b, s));
+  TEST_ASSERT_EQUAL_INT(0, s.paused); TEST_ASSERT_EQUAL_INT(2, s.mode);
+
+  // still ramping down to pause: back in through the seq
+  s.paused = 2;
+  parse("{\"run\":true}", b);
+  TEST_ASSERT_EQUAL_HEX8(BA_UNPAUSE | BA_SEQ, batch_plan(b, s));
+
+  // pausing with a mode change: ramp down only; same mode and BPM change nothing
+  parse("{\"mode\":0,\"run\":false}", b);
+  TEST_ASSERT_EQUAL_HEX8(BA_PAUSE, batch_plan(b, s));
+  TEST_ASSERT_EQUAL_INT(2, s.paused);
+  s = running(2, 100, 60, 0);
+  parse("{\"mode\":2,\"bpm\":60,\"pressBeat\":true}", b);
+  TEST_ASSERT_EQUAL_HEX8(BA_RESTART_PEAK, batch_plan(b, s));
+  TEST_ASSERT_EQUAL_HEX8(0, batch_plan(b, s));                     // pressBeat already on
+
+  // latched fault: run refused, setpoints still applied
+  s = RunState{}; s.fault = true; s.pwm = 100;
+  parse("{\"pwm\":150,\"run\":true}", b);
+  TEST_ASSERT_EQUAL_HEX8(BA_RUN_REFUSED, batch_plan(b, s));
+  TEST_ASSERT_EQUAL_INT(1, s.paused); TEST_ASSERT_EQUAL_INT(150, s.pwm);
+
+  // flow sign flip in FLOW while running: one seq; same sign: none
+  s = running(BATCH_MODE_FLOW, 100, 30, 2.0f);
+  parse("{\"flow\":-2}", b);
+  TEST_ASSERT_EQUAL_HEX8(BA_SEQ, batch_plan(b, s));
+  parse("{\"flow\":-4}", b);
+  TEST_ASSERT_EQUAL_HEX8(0, batch_plan(b, s));
+}
+
+void test_no_intermediate_outputs(){
+  // Running FWD at 100 PWM / 30 BPM; target: BEAT at 180 PWM / 60 BPM
+  const Out before{ 0, 100, 30, false }, after{ 2, 180, 60, false };
+  RunBatch all, mode, pwm, bpm;
+  parse("{\"mode\":2,\"pwm\":180,\"bpm\":60}", all);
+  parse("{\"mode\":2}", mode); parse("{\"pwm\":180}", pwm); parse("{\"bpm\":60}", bpm);
+
+  TickModel one; one.s = running(0, 100, 30, 0);
+  for (uint8_t t = 0; t < 20; t++) one.tick(&all, t == 5 ? 1 : 0);
+  for (uint8_t t = 0; t < one.n; t++) TEST_ASSERT_TRUE(same(one.written[t], t < 5 ? before : after));
+  TEST_ASSERT_EQUAL_UINT32(1, one.seqStarts);
+  TEST_ASSERT_EQUAL_UINT32(1, one.rebuilds);
+
+  // the same changes as three requests landing on consecutive ticks: the new mode runs at
+  // the old PWM and BPM for a tick, then at the new PWM with the old BPM
+  TickModel sep; sep.s = running(0, 100, 30, 0);
+  const RunBatch* byTick[20] = {};
+  byTick[5] = &mode; byTick[6] = &pwm; byTick[7] = &bpm;
+  uint8_t mixed = 0;
+  for (uint8_t t = 0; t < 20; t++){
+    sep.tick(byTick[t], byTick[t] ? 1 : 0);
+    const Out& o = sep.written[t];
+    if (!same(o, before) && !same(o, after)) mixed++;
+  }
+  TEST_ASSERT_EQUAL_UINT8(2, mixed);
+  TEST_ASSERT_TRUE(same(sep.written[19], after));
+}
+
+void test_single_seq_for_mode_and_flow(){
+  // Running FWD; switch to FLOW reversed: one seq as a batch, two as separate commands
+  RunBatch all, mode, flow;
+  parse("{\"mode\":4,\"flow\":-3}", all);
+  parse("{\"mode\":4}", mode); parse("{\"flow\":-3}", flow);
+
+  TickModel one; one.s = running(0, 120, 30, 2.0f);
+  for (uint8_t t = 0; t < 12; t++) one.tick(&all, t == 3 ? 1 : 0);
+  TEST_ASSERT_EQUAL_UINT32(1, one.seqStarts);
+  for (uint8_t t = 3; t < one.n; t++) TEST_ASSERT_TRUE(one.written[t].rev);   // never forward in FLOW
+
+  TickModel sep; sep.s = running(0, 120, 30, 2.0f);
+  for (uint8_t t = 0; t < 12; t++){
+    const RunBatch* c = t == 3 ? &mode : (t == 5 ? &flow : nullptr);
+    sep.tick(c, c ? 1 : 0);
+  }
+  TEST_ASSERT_EQUAL_UINT32(2, sep.seqStarts);                    // restarted mid-seq
+  TEST_ASSERT_FALSE(sep.written[3].rev);                          // FLOW ran forward in between
+}
+
+int run_tests(){
+  UNITY_BEGIN();
+  RUN_TEST(test_parse);
+  RUN_TEST(test_parse_rejects);
+  RUN_TEST(test_plan_rules);
+  RUN_TEST(test_no_intermediate_outputs);
+  RUN_TEST(test_single_seq_for_mode_and_flow);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup(){ delay(2000); run_tests(); }
+void loop(){}
+#else
+int main(int, char**){ return run_tests(); }
+#endif
@@ -0,0 +1,119 @@
+#include <unity.h>
+#include <string.h>
+#include "tlmfmt.h"
+
+// Host-runnable checks of the serial telemetry framing: COBS edge cases, frame round trip,
+// and stream resynchronisation after garbage and corruption (pio test -e native).
+
+static uint32_t s_rng = 7;
+static uint8_t rnd(){ s_rng = s_rng*1664525u + 1013904223u; return (uint8_t)(s_rng >> 24); }
+
+static void roundtrip(const uint8_t* in, size_t n){
+  static uint8_t enc[2048], dec[2048];
+  size_t e = cobs_encode(in, n, enc);
+  TEST_ASSERT_TRUE(e <= n + n/254 + 1);
+  for (size_t i=0;i<e;i++) TEST_ASSERT_TRUE(enc[i] != 0);
+  TEST_ASSERT_EQUAL_UINT32(n, cobs_decode(enc, e, dec, sizeof(dec)));
+  TEST_ASSERT_EQUAL_MEMORY(in, dec, n);
+}
+
+void test_cobs_edge_cases(){
+  static uint8_t b[1200];
+  const uint8_t z[] = { 0 }, zz[] = { 0, 0 }, one[] = { 0x11 }, mix[] = { 0x11, 0, 0, 0x22, 0 };
+  roundtrip(z, 1); roundtrip(zz, 2); roundtrip(one, 1); roundtrip(mix, sizeof(mix));
+  static const size_t lens[] = { 253, 254, 255, 508, 1000 };
+  for (size_t n : lens){
+    for (size_t i=0;i<n;i++) b[i] = (uint8_t)(i % 255 + 1);          // no zeros: 0xFF blocks
+    roundtrip(b, n);
+    b[n/2] = 0; roundtrip(b, n);
+  }
+  for (int k=0;k<200;k++){ size_t n = rnd() * 4 + 1; for (size_t i=0;i<n;i++) b[i] = (rnd() & 3) ? rnd() : 0; roundtrip(b, n); }
+  // malformed: embedded zero, code running past the end, output too small
+  const uint8_t bad1[] = { 0x03, 0x11, 0x00 }, bad2[] = { 0x05, 0x11 };
+  uint8_t o[8];
+  TEST_ASSERT_EQUAL_UINT32(0, cobs_decode(bad1, sizeof(bad1), o, sizeof(o)));
+  TEST_ASSERT_EQUAL_UINT32(0, cobs_decode(bad2, sizeof(bad2), o, sizeof(o)));
+  const uint8_t ok[] = { 0x03, 0x11, 0x22, 0x02, 0x33 };
+  TEST_ASSERT_EQUAL_UINT32(0, cobs_decode(ok, sizeof(ok), o, 3));
+  TEST_ASSERT_EQUAL_UINT32(4, cobs_decode(ok, sizeof(ok), o, sizeof(o)));
+}
+
+static TlmFrame make(uint32_t seq, uint8_t n){
+  TlmFrame f; f.hz = 600; f.seq = seq; f.firstTick = seq * TLM_FRAME_SAMPLES; f.count = n; f.fault = (uint8_t)(seq & 3);
+  for (uint8_t i=0;i<n;i++){ f.s[i].atr = (int16_t)(seq * 7 + i - 300); f.s[i].vent = (int16_t)-i; f.s[i].flow = 0; f.s[i].pwm = (uint8_t)(i * 25); f.s[i].state = i & 1; }
+  return f;
+}
+
+static void same(const TlmFrame& a, const TlmFrame& b){
+  TEST_ASSERT_EQUAL_UINT16(a.hz, b.hz); TEST_ASSERT_EQUAL_UINT32(a.seq, b.seq); TEST_ASSERT_EQUAL_UINT32(a.firstTick, b.firstTick);
+  TEST_ASSERT_EQUAL_UINT8(a.count, b.count); TEST_ASSERT_EQUAL_UINT8(a.fault, b.fault);
+  for (uint8_t i=0;i<a.count;i++){
+    TEST_ASSERT_EQUAL_INT16(a.s[i].atr, b.s[i].atr); TEST_ASSERT_EQUAL_INT16(a.s[i].vent, b.s[i].vent); TEST_ASSERT_EQUAL_INT16(a.s[i].flow, b.s[i].flow);
+    TEST_ASSERT_EQUAL_UINT8(a.s[i].pwm, b.s[i].pwm); TEST_ASSERT_EQUAL_UINT8(a.s[i].state, b.s[i].state);
+  }
+}
+
+void test_frame_roundtrip(){
+  uint8_t wire[TLM_WIRE_MAX];
+  for (uint8_t n=0;n<=TLM_FRAME_SAMPLES;n++){
+    TlmFrame f = make(1000 + n, n);
+    size_t len = tlm_encode(f, wire);
+    TEST_ASSERT_TRUE(len <= TLM_WIRE_MAX);
+    TEST_ASSERT_EQUAL_UINT8(0, wire[len - 1]);
+    TlmDecoder d; bool got = false;
+    for (size_t i=0;i<len;i++) got = d.push(wire[i]);
+    TEST_ASSERT_TRUE(got);
+    same(f, d.frame());
+    TEST_ASSERT_EQUAL_UINT8(0, wire[0]);
+    TEST_ASSERT_EQUAL_UINT32(len - 2, d.rawLen());
+    TEST_ASSERT_EQUAL_MEMORY(wire + 1, d.raw(), len - 2);
+  }
+}
+
+void test_stream_resync(){
+  static uint8_t stream[8192];
+  uint8_t wire[TLM_WIRE_MAX];
+  size_t n = 0;
+  for (int i=0;i<37;i++) stream[n++] = rnd();                 // join mid-frame
+  size_t corrupt = 0;
+  for (uint32_t s=0;s<40;s++){
+    if (s == 12){ const char* txt = "[WEB] AP up\n"; memcpy(stream + n, txt, strlen(txt)); n += strlen(txt); }
+    size_t len = tlm_encode(make(s, TLM_FRAME_SAMPLES), wire);
+    memcpy(stream + n, wire, len);
+    if (s == 20){ corrupt = n + 9; stream[corrupt] ^= 0x40; if (!stream[corrupt]) stream[corrupt] = 1; }
+    n += len;
+  }
+  TlmDecoder d; uint32_t frames = 0, last = 0;
+  for (size_t i=0;i<n;i++) if (d.push(stream[i])){ frames++; TEST_ASSERT_TRUE(d.frame().seq != 20); last = d.frame().seq; same(make(last, TLM_FRAME_SAMPLES), d.frame()); }
+  TEST_ASSERT_EQUAL_UINT32(39, frames);                       // all but the corrupted one
+  TEST_ASSERT_EQUAL_UINT32(39, last);
+  TEST_ASSERT_EQUAL_UINT32(3, d.bad());                       // leading junk, banner, frame 20
+}
+
+void test_overlong_chunk_rejected(){
+  TlmDecoder d;
+  for (int i=0;i<TLM_WIRE_MAX * 3;i++) TEST_ASSERT_FALSE(d.push(0x42));
+  TEST_ASSERT_FALSE(d.push(0));
+  TEST_ASSERT_EQUAL_UINT32(1, d.bad());
+  uint8_t wire[TLM_WIRE_MAX]; size_t len = tlm_encode(make(5, 3), wire);
+  bool got = false; for (size_t i=0;i<len;i++) got = d.push(wire[i]);
+  TEST_ASSERT_TRUE(got);
+  TEST_ASSERT_EQUAL_UINT32(5, d.frame().seq);
+}
+
+int run_tests(){
+  UNITY_BEGIN();
+  RUN_TEST(test_cobs_edge_cases);
+  RUN_TEST(test_frame_roundtrip);
+  RUN_TEST(test_stream_resync);
+  RUN_TEST(test_overlong_chunk_rejected);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup(){ delay(2000); run_tests(); }
+void loop(){}
+#else
+int main(int, char**){ return run_tests(); }
+#endif
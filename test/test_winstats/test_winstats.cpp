@@ -0,0 +1,106 @@
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include "winstats.h"
+
+// Host-runnable checks of the sliding-window statistics against brute force, plus a
+// benchmark of one control tick's worth of updates (pio test -e native).
+
+static uint32_t s_rng = 1;
+static float noise(){ s_rng = s_rng*1664525u + 1013904223u; return (int32_t)(s_rng >> 8) / 8388608.0f - 1.0f; }
+
+// Brute-force stats over the last n entries of x[0..len)
+static WinResult naive(const float* x, uint32_t len, uint32_t n){
+  WinResult r; r.n = n;
+  double s = 0; r.min = r.max = x[len - n];
+  for (uint32_t i = len - n; i < len; i++){ s += x[i]; if (x[i] < r.min) r.min = x[i]; if (x[i] > r.max) r.max = x[i]; }
+  double m = s / n, v = 0;
+  for (uint32_t i = len - n; i < len; i++) v += (x[i] - m) * (x[i] - m);
+  r.mean = (float)m; r.sd = (float)sqrt(v / (n - 1));
+  return r;
+}
+
+void test_matches_brute_force(){
+  static float x[20000];
+  WindowStats w; w.configure(640);                          // 10-tick blocks
+  for (uint32_t i = 0; i < 20000; i++){
+    x[i] = 80.0f + 30.0f * sinf(i * 0.013f) + 5.0f * noise();
+    w.push(x[i]);
+    if (i % 997 == 0 && i > 700){
+      WinResult a = w.result(), e = naive(x, i + 1, a.n);
+      TEST_ASSERT_TRUE(a.n >= 640 && a.n < 650);
+      TEST_ASSERT_FLOAT_WITHIN(1e-3f, e.mean, a.mean);
+      TEST_ASSERT_FLOAT_WITHIN(1e-3f, e.sd, a.sd);
+      TEST_ASSERT_EQUAL_FLOAT(e.min, a.min);
+      TEST_ASSERT_EQUAL_FLOAT(e.max, a.max);
+    }
+  }
+}
+
+void test_partial_window_and_reset(){
+  WindowStats w; w.configure(6000);
+  TEST_ASSERT_EQUAL_UINT32(0, w.result().n);
+  for (int i = 1; i <= 5; i++) w.push((float)i);
+  WinResult r = w.result();
+  TEST_ASSERT_EQUAL_UINT32(5, r.n);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 3.0f, r.mean);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, 1.5811388f, r.sd);
+  TEST_ASSERT_EQUAL_FLOAT(1.0f, r.min);
+  TEST_ASSERT_EQUAL_FLOAT(5.0f, r.max);
+  w.reset();
+  TEST_ASSERT_EQUAL_UINT32(0, w.result().n);
+}
+
+void test_extremes_age_out(){
+  WindowStats w; w.configure(600);
+  w.push(500.0f); w.push(-500.0f);
+  for (int i = 0; i < 598; i++) w.push(1.0f);
+  TEST_ASSERT_EQUAL_FLOAT(500.0f, w.result().max);
+  for (int i = 0; i < 610; i++) w.push(2.0f);
+  WinResult r = w.result();
+  TEST_ASSERT_EQUAL_FLOAT(2.0f, r.max);
+  TEST_ASSERT_TRUE(r.min >= 1.0f);
+}
+
+void test_long_run_no_drift(){
+  // an hour at 600 Hz of a 1000 mmHg offset with ±0.5 noise: variance must not drift
+  WindowStats w; w.configure(6000);
+  for (uint32_t i = 0; i < 600u * 3600u; i++) w.push(1000.0f + 0.5f * noise());
+  WinResult r = w.result();
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 1000.0f, r.mean);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.2887f, r.sd);             // uniform ±0.5 → 1/√12
+}
+
+void test_benchmark(){
+  // the firmware runs 4 channels × 3 windows per 1.67 ms control tick
+  static WindowStats w[12];
+  const uint32_t win[3] = { 600, 6000, 36000 };
+  for (int i = 0; i < 12; i++) w[i].configure(win[i % 3]);
+  const int N = 600 * 100;
+  clock_t t0 = clock();
+  for (int t = 0; t < N; t++){ float x = (float)(t & 255); for (int i = 0; i < 12; i++) w[i].push(x + i); }
+  double nsTick = 1e9 * (double)(clock() - t0) / CLOCKS_PER_SEC / N;
+  char msg[64];
+  snprintf(msg, sizeof(msg), "12 windowed channels: %.1f ns/tick", nsTick);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_TRUE(nsTick < 20000.0);                        // ≪ 1667 µs even at ~50× host speed
+}
+
+static int run_tests(){
+  UNITY_BEGIN();
+  RUN_TEST(test_matches_brute_force);
+  RUN_TEST(test_partial_window_and_reset);
+  RUN_TEST(test_extremes_age_out);
+  RUN_TEST(test_long_run_no_drift);
+  RUN_TEST(test_benchmark);
+  return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup(){ delay(2000); run_tests(); }
+void loop(){}
+#else
+int main(int, char**){ return run_tests(); }
+#endif
@@ -0,0 +1,56 @@
+/* ==========================================================================================
+   log2csv — convert flight-recorder logs (/api/logs/file) to CSV on a PC
+   Build (from the repo root):
+     g++ -std=gnu++14 -O2 -Ilib/logfmt/include -Ilib/crc/include \
+         tools/log2csv.cpp lib/logfmt/src/logfmt.cpp lib/crc/src/crc.cpp -o log2csv
+   Usage:
+     ./log2csv r00012.slg [r00013.slg ...] > run.csv
+   Pressures are calibrated with the coefficients stored in each block; flow is the edge rate
+   over the last 100 ms through the stored flow calibration. Corrupt blocks are skipped and
+   reported on stderr.
+   ==========================================================================================*/
+#include <stdio.h>
+#include <stdint.h>
+#include "logfmt.h"
+
+static const uint32_t FLOW_WIN_MS = 100;
+
+int main(int argc, char** argv){
+  if (argc < 2){ fprintf(stderr, "usage: %s file.slg [...] > out.csv\n", argv[0]); return 2; }
+  static uint8_t block[LOG_BLOCK_BYTES];
+  static uint32_t edgeHist[1024];                  // ring of cumulative edges for the flow window
+  uint32_t hIdx = 0, hN = 0;
+  unsigned long bad = 0, rows = 0;
+  printf("tick,t_ms,atr_raw,vent_raw,atr_mmHg,vent_mmHg,edges,flow_L_min,pwm,valve,paused,mode,fault\n");
+  for (int a = 1; a < argc; a++){
+    FILE* f = fopen(argv[a], "rb");
+    if (!f){ fprintf(stderr, "%s: cannot open\n", argv[a]); return 1; }
+    for (unsigned long b = 0; fread(block, 1, LOG_BLOCK_BYTES, f) == LOG_BLOCK_BYTES; b++){
+      LogBlockReader r;
+      if (!r.open(block, LOG_BLOCK_BYTES)){ fprintf(stderr, "%s: block %lu corrupt, skipped\n", argv[a], b); bad++; hN = 0; continue; }
+      const LogBlockInfo& in = r.info();
+      const LogCal& c = in.cal;
+      uint32_t win = in.hz ? in.hz * FLOW_WIN_MS / 1000 : 1;
+      if (win < 1) win = 1;
+      if (win > 1023) win = 1023;
+      LogSample s;
+      while (r.next(s)){
+        edgeHist[hIdx] = s.edges; hIdx = (hIdx + 1) % 1024; if (hN < 1024) hN++;
+        float lpm = 0;
+        if (hN > win){
+          uint32_t old = edgeHist[(hIdx + 1024 - 1 - win) % 1024];
+          float hz = (float)(s.edges - old) * 0.5f * in.hz / win;   // both edges counted
+          lpm = c.flow_m * hz + c.flow_b; if (lpm < 0) lpm = 0;
+        }
+        double tMs = in.tMs + (double)(s.tick - in.firstTick) * 1000.0 / (in.hz ? in.hz : 600);
+        printf("%lu,%.2f,%d,%d,%.3f,%.3f,%lu,%.3f,%u,%u,%u,%u,%u\n",
+          (unsigned long)s.tick, tMs, s.atr, s.vent, c.atr_m * s.atr + c.atr_b, c.vent_m * s.vent + c.vent_b,
+          (unsigned long)s.edges, lpm, s.pwm, s.state & 1, (s.state >> 1) & 3, (s.state >> 3) & 7, s.fault);
+        rows++;
+      }
+    }
+    fclose(f);
+  }
+  fprintf(stderr, "%lu samples, %lu corrupt blocks\n", rows, bad);
+  return bad ? 3 : 0;
+}
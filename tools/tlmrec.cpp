@@ -0,0 +1,117 @@
+/* ==========================================================================================
+   tlmrec — record the binary serial telemetry stream (tlmfmt.h) on a PC
+   Build (from the repo root; Linux/macOS):
+     g++ -std=gnu++14 -O2 -Ilib/tlmfmt/include -Ilib/crc/include \
+         tools/tlmrec.cpp lib/tlmfmt/src/tlmfmt.cpp lib/crc/src/crc.cpp -o tlmrec
+   Usage:
+     ./tlmrec [-b baud] [-f csv|bin] [-o out] /dev/ttyUSB0     live, until Ctrl-C
+     ./tlmrec -f csv -o run.csv capture.bin                    re-decode a binary recording
+   Turn the stream on first: curl -X POST -d on=1 http://192.168.4.1/api/telemetry
+   csv writes one row per control tick; bin keeps every valid frame exactly as received, so
+   it can be fed back through tlmrec later. Frames lost on the link (seq gaps), ticks the
+   device dropped (firstTick gaps) and corrupt chunks are counted and reported on stderr.
+   ==========================================================================================*/
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include "tlmfmt.h"
+
+static volatile sig_atomic_t s_stop = 0;
+static void on_sigint(int){ s_stop = 1; }
+
+static speed_t baud_const(long b){
+  switch (b){
+    case 115200: return B115200;
+    case 230400: return B230400;
+#ifdef B460800
+    case 460800: return B460800;
+#endif
+#ifdef B921600
+    case 921600: return B921600;
+#endif
+    default: return 0;
+  }
+}
+
+static bool set_raw(int fd, long baud){
+  struct termios t;
+  if (tcgetattr(fd, &t) != 0) return false;
+  cfmakeraw(&t);
+  t.c_cflag |= CLOCAL | CREAD;
+  t.c_cc[VMIN] = 0; t.c_cc[VTIME] = 2;             // read() returns after 200 ms idle
+  speed_t sp = baud_const(baud);
+  if (!sp){ fprintf(stderr, "unsupported baud %ld\n", baud); return false; }
+  cfsetispeed(&t, sp); cfsetospeed(&t, sp);
+  return tcsetattr(fd, TCSANOW, &t) == 0;
+}
+
+struct Stats { unsigned long frames = 0, rows = 0, lostFrames = 0, lostTicks = 0, bad = 0; };
+
+static void report(const Stats& s, const char* tag){
+  fprintf(stderr, "%s frames=%lu ticks=%lu lost_frames=%lu lost_ticks=%lu bad=%lu\n",
+    tag, s.frames, s.rows, s.lostFrames, s.lostTicks, s.bad);
+}
+
+int main(int argc, char** argv){
+  long baud = 921600; bool csv = true; const char* outPath = nullptr;
+  int opt;
+  while ((opt = getopt(argc, argv, "b:f:o:")) != -1){
+    if (opt == 'b') baud = atol(optarg);
+    else if (opt == 'f') csv = strcmp(optarg, "bin") != 0;
+    else if (opt == 'o') outPath = optarg;
+    else { fprintf(stderr, "usage: %s [-b baud] [-f csv|bin] [-o out] <tty|file>\n", argv[0]); return 2; }
+  }
+  if (optind >= argc){ fprintf(stderr, "usage: %s [-b baud] [-f csv|bin] [-o out] <tty|file>\n", argv[0]); return 2; }
+  const char* in = argv[optind];
+  int fd = open(in, O_RDONLY | O_NOCTTY);
+  if (fd < 0){ perror(in); return 1; }
+  const bool tty = isatty(fd);
+  if (tty && !set_raw(fd, baud)){ fprintf(stderr, "%s: cannot configure port\n", in); return 1; }
+  FILE* out = outPath ? fopen(outPath, csv ? "w" : "wb") : stdout;
+  if (!out){ perror(outPath); return 1; }
+  signal(SIGINT, on_sigint);
+
+  if (csv) fprintf(out, "tick,t_s,atr_mmHg,vent_mmHg,flow_L_min,pwm,valve,paused,mode,fault\n");
+  TlmDecoder dec;
+  Stats st;
+  bool have = false; uint32_t nextSeq = 0, nextTick = 0;
+  time_t lastReport = time(nullptr);
+  uint8_t buf[4096];
+  static const uint8_t zero = 0;
+  while (!s_stop){
+    ssize_t n = read(fd, buf, sizeof(buf));
+    if (n < 0){ perror("read"); break; }
+    if (n == 0){ if (!tty) break; continue; }          // file: EOF; tty: idle timeout
+    for (ssize_t i = 0; i < n; i++){
+      if (!dec.push(buf[i])) continue;
+      const TlmFrame& f = dec.frame();
+      if (have){
+        if (f.seq != nextSeq) st.lostFrames += (uint32_t)(f.seq - nextSeq);
+        if (f.firstTick != nextTick) st.lostTicks += (uint32_t)(f.firstTick - nextTick);
+      }
+      have = true; nextSeq = f.seq + 1; nextTick = f.firstTick + f.count;
+      st.frames++;
+      if (!csv){ fwrite(&zero, 1, 1, out); fwrite(dec.raw(), 1, dec.rawLen(), out); fwrite(&zero, 1, 1, out); st.rows += f.count; continue; }
+      for (uint8_t k = 0; k < f.count; k++, st.rows++){
+        const TlmSample& s = f.s[k];
+        const uint32_t tick = f.firstTick + k;
+        fprintf(out, "%lu,%.6f,%.1f,%.1f,%.2f,%u,%u,%u,%u,%u\n", (unsigned long)tick, f.hz ? (double)tick / f.hz : 0.0,
+          s.atr * 0.1, s.vent * 0.1, s.flow * 0.01, (unsigned)s.pwm,
+          (unsigned)(s.state & 1), (unsigned)((s.state >> 1) & 3), (unsigned)((s.state >> 3) & 7), (unsigned)f.fault);
+      }
+    }
+    st.bad = dec.bad();
+    if (tty && time(nullptr) != lastReport){ lastReport = time(nullptr); report(st, "[tlmrec]"); }
+  }
+  st.bad = dec.bad();
+  report(st, "[tlmrec] done:");
+  if (out != stdout) fclose(out);
+  close(fd);
+  return 0;
+}